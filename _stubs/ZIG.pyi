@@ -3,7 +3,7 @@ Main Zigbee module for MicroPython
 Auto-generated stub file for IDE support
 """
 
-from typing import Union, Optional, Callable, Tuple, Any
+from typing import Union, Optional, Callable, Tuple, Iterable, Any
 
 class MSG:
     """Zigbee message types"""
@@ -13,6 +13,13 @@ class MSG:
     RAW: int
     CL_CUSTOM_CMD: int
     REPORT_ATTR_CB: int
+    RETRY: int
+    RETRY_GIVE_UP: int
+    INTERVIEW: int
+    BINDING_TABLE: int
+    SCAN: int
+    TOPOLOGY: int
+    CHANNEL: int
     
     @staticmethod
     def get_type_name(msg_type: int) -> str:
@@ -24,10 +31,52 @@ class MSG:
         """Get app signal name"""
         ...
 
+class Request:
+    """Pending request returned by ZIG.request()
+
+    Awaiting it returns (signal_type, status, [payload, ...]), payloads as delivered
+    by recv(). Raises OSError(ETIMEDOUT) when no response arrived in time.
+    """
+    tsn: int
+    addr: int
+    attempt: int
+    def done(self) -> bool: ...
+    def result(self) -> Optional[Tuple[int, int, list]]: ...
+    def cancel(self) -> None: ...
+
 class ZIG:
     """Main Zigbee class"""
     
     MSG = MSG
+
+    # send_command(mode=...) and broadcast addresses
+    UNICAST: int
+    GROUP: int
+    BROADCAST: int
+    BROADCAST_ALL: int      # 0xFFFF
+    BROADCAST_RX_ON: int    # 0xFFFD
+    BROADCAST_ROUTERS: int  # 0xFFFC
+
+    # cover(action=...)
+    COVER_OPEN: int
+    COVER_CLOSE: int
+    COVER_STOP: int
+
+    # retries() steps, signal_type of MSG.RETRY / MSG.RETRY_GIVE_UP
+    RETRY_ACTIVE_EP: int
+    RETRY_SIMPLE_DESC: int
+    RETRY_BIND: int
+
+    # Interview steps, signal_type of MSG.INTERVIEW
+    INTERVIEW_ACTIVE_EP: int
+    INTERVIEW_IDENTIFY: int
+    INTERVIEW_VERIFY: int
+    INTERVIEW_SIMPLE_DESC: int
+    INTERVIEW_BASIC_READ: int
+    INTERVIEW_BIND: int
+    INTERVIEW_REPORT: int
+    INTERVIEW_DONE: int
+    INTERVIEW_FAILED: int
     
     def init(self) -> None: ...
     def get_info(self) -> Any: ...
@@ -36,14 +85,98 @@ class ZIG:
     def close_network(self) -> None: ...
     def get_network_info(self) -> Any: ...
     def update_network_status(self) -> None: ...
-    def scan_networks(self) -> list: ...
 
-    def __init__(self, start: bool = True, storage: Optional[Any] = None):
+    # scan_networks(channel_mask=...)
+    CHANNEL_MASK_ALL: int   # 0x07FFF800, channels 11-26
+
+    def scan_networks(self, channel_mask: int = 0x07FFF800, duration: int = 3) -> bool:
+        """Scan for networks one channel at a time, MSG.SCAN follows
+
+        Args:
+            channel_mask: Channels to scan, bit n = channel n
+            duration: Beacon wait per channel, 0-14 ((2^n + 1) * 15.36 ms)
+
+        Returns:
+            False if a scan is running already
+        """
+        ...
+
+    def scan_results(self) -> list:
+        """Networks found by the last scan
+
+        Returns:
+            Dicts with pan_id, extended_pan_id, channel, permit_join,
+            router_capacity, end_device_capacity
+        """
+        ...
+
+    # Link relationship in topology()
+    TOPOLOGY_PARENT: int
+    TOPOLOGY_CHILD: int
+    TOPOLOGY_SIBLING: int
+    TOPOLOGY_NONE: int
+    TOPOLOGY_PREV_CHILD: int
+
+    def change_channel(self, channel: Optional[int] = None) -> bool:
+        """Move the running network to another channel (Mgmt_NWK_Update_req)
+
+        Args:
+            channel: 11-26, or None to pick the quietest channel of channel_mask;
+                MSG.CHANNEL follows the energy detect scan
+
+        Returns:
+            False if a scan is running
+        """
+        ...
+
+    def route_stats(self, clear: bool = False) -> dict:
+        """Concentrator state and route failures from NLME status indications
+
+        Returns:
+            {"concentrator": bool, "interval": s, "requests", "repairs", "no_route",
+             "link_failures", "source_route_failures", "many_to_one_failures",
+             "address_conflicts", "other", "failures": {addr: count},
+             "last": (status, addr, age_ms) or None}
+        """
+        ...
+
+    def crawl_topology(self, interval: int = 1000, *, routes: bool = True, period: int = 0, stop: bool = False) -> bool:
+        """Read neighbour (and routing) tables of every router, MSG.TOPOLOGY follows
+
+        Args:
+            interval: Milliseconds between two requests, 100-60000
+            routes: Read routing tables too (Mgmt_Rtg_req)
+            period: Seconds until the next crawl after one finishes, 0 = once
+            stop: Stop the running crawl and any repeat
+
+        Returns:
+            False if a crawl is running already; with stop, whether one was running
+        """
+        ...
+
+    def topology(self) -> dict:
+        """Map of the last crawl
+
+        Returns:
+            {"links": [(src, dst, lqi, depth, relationship, device_type)],
+             "routes": [(router, dst, next_hop, status)],
+             "failed": [router], "running": bool, "age": ms or None}
+        """
+        ...
+
+    def __init__(self, start: bool = True, storage: Optional[Any] = None, volatile_interval: int = 600,
+                 channel_mask: int = 1 << 13, energy_scan: bool = False,
+                 concentrator: bool = False, discovery_interval: int = 60):
         """Initialize Zigbee module
         
         Args:
             start: Whether to start immediately
-            storage: Storage handler for device data
+            storage: Storage handler for device data, or "nvs" for the built-in NVS backend
+            volatile_interval: Seconds between volatile state flushes (0 = on demand only)
+            channel_mask: Channels a new network may be formed on, bit n = channel n
+            energy_scan: Form on the quietest channel of the mask (energy detect scan)
+            concentrator: Many-to-one routing with source routes from the gateway
+            discovery_interval: Seconds between many-to-one route requests, 10-86400
         """
         ...
     
@@ -51,14 +184,32 @@ class ZIG:
         """Start Zigbee network"""
         ...
     
-    def recv(self) -> Optional[Tuple[int, int, int, int, int, bytes]]:
+    def recv(self, timeout: int = 0, list: Optional[list] = None, *, tsn: bool = False) -> Optional[Tuple]:
         """Receive Zigbee message
         
+        Args:
+            timeout: Milliseconds to wait, 0 returns None at once
+            list: Preallocated list (data element a bytearray memoryview) to fill instead of a new tuple
+            tsn: Append ZCL transaction sequence number (-1 if none) as 7th element
+
         Returns:
-            Tuple of (msg_type, signal_type, src_addr, endpoint, cluster_id, data)
+            Tuple of (msg_type, signal_type, src_addr, endpoint, cluster_id, data[, tsn])
             or None if no message available
         """
         ...
+
+    def request(self, send: Callable[..., int], *args: Any, timeout: int = 3000, retries: int = 0, **kwargs: Any) -> "Request":
+        """Send and track the response by (addr, TSN)
+
+        Args:
+            send: Bound method returning one TSN (send_command, read_attr, write_attr, configure_report)
+            timeout: Milliseconds to wait for the response, doubled on every retry
+            retries: Times to resend when no response arrives (0-5)
+
+        Returns:
+            Request, awaitable from asyncio
+        """
+        ...
     
     def any(self) -> bool:
         """Check if any messages are available
@@ -78,22 +229,64 @@ class ZIG:
         ...
         
     def send_command(self, addr: int, endpoint: int, cluster_id: int, 
-                        cmd_id: int, data: bytes) -> None:
+                        cmd_id: int, data: bytes, *, mode: int = UNICAST) -> int:
         """Send Zigbee command
 
         Args:
-            addr: Target device address
-            endpoint: Target endpoint
+            addr: Target device address, group id (mode=GROUP) or broadcast address (mode=BROADCAST)
+            endpoint: Target endpoint, ignored for groups
             cluster_id: Cluster ID
             cmd_id: Command ID
             data: Command data
+            mode: UNICAST, GROUP or BROADCAST
+        """
+        ...
+    def bind_cluster(self, addr: int, ep: int, cl: int, dst_addr: int = 0, dst_ep: int = 1, *, force: bool = False) -> bool: ...
+    def unbind_cluster(self, addr: int, ep: int, cl: int, dst_addr: int = 0, dst_ep: int = 1, *, force: bool = False) -> bool: ...
+    def get_binding_table(self, addr: int, start_index: int = 0) -> None: ...
+    def bindings(self, addr: Optional[int] = None) -> Union[dict, list]: ...
+    def configure_report(self, addr: int, ep: int, cl: int, attr: Optional[int] = None, direction: int = 0, attr_type: int = -1, min_int: int = 300, max_int: int = 3600, reportable_change: int = -1, timeout: int = 0xFFFF, *, records: Optional[Iterable[Tuple]] = None) -> Union[int, Tuple[int, ...]]: ...
+    def set_report_config(self, addr: int, ep: int, cl: int, attr: int, direction: int = 0, attr_type: int = -1, min_int: int = 0, max_int: int = 30, reportable_change: int = 0xFFFFFFFF, timeout: int = 0xFFFF) -> bool: ...
+    def remove_report_config(self, addr: int, ep: int = -1, cl: int = -1, attr: int = -1, direction: int = -1) -> int: ...
+    def report_configs(self, addr: int, ep: int = -1, cl: int = -1) -> list: ...
+    def verify_reporting(self, addr: int, ep: int = -1, cl: int = -1, *, fix: bool = True) -> Tuple[int, ...]: ...
+    def read_attr(self, addr: int, endpoint: int, cluster_id: int, attr_id: Optional[int] = None, *, attrs: Optional[Iterable[int]] = None, manuf_code: int = 0) -> Union[int, Tuple[int, ...]]: ...
+    def write_attr(self, addr: int, endpoint: int, cluster_id: int, attr_id: Optional[int] = None, attr_type: Optional[int] = None, value: Any = None, *, attrs: Optional[Iterable[Tuple[int, int, Any]]] = None, manuf_code: int = 0) -> Union[int, Tuple[int, ...]]: ...
+    def batch(self, calls: Iterable[Tuple]) -> list:
+        """Run [("command", args), ("command", args, kwargs), ...] under one stack lock acquisition
+
+        command names a ZIG send method (send_command, read_attr, write_attr, on_off, ...).
+
+        Returns:
+            List of call results (TSNs for the command methods)
+        """
+        ...
+    def lock_stats(self, reset: bool = False) -> dict: ...
+    def post(self, send: Callable[..., Any], *args: Any, ttl: int = 600, priority: int = 0, **kwargs: Any) -> Any:
+        """Send now, or hold for a sleepy device until it is heard from
+
+        Returns:
+            Result of send when sent at once, None when held
         """
         ...
-    def bind_cluster(self, addr: int, endpoint: int, cluster_id: int) -> None: ...
-    def configure_report(self, addr: int, endpoint: int, cluster_id: int, attr_id: int, min_int: int, max_int: int, change: Any) -> None: ...
-    def set_report_config(self, addr: int, endpoint: int, cluster_id: int, attr_id: int, config: Any) -> None: ...
-    def read_attr(self, addr: int, endpoint: int, cluster_id: int, attr_id: int) -> Any: ...
-    def write_attr(self, addr: int, endpoint: int, cluster_id: int, attr_id: int, value: Any) -> None: ...
+    def mailbox(self, clear: Optional[int] = None) -> dict: ...
+    def add_group(self, addr: int, ep: int, group_id: int) -> int: ...
+    def remove_group(self, addr: int, ep: int, group_id: int = -1) -> int: ...
+    def view_group(self, addr: int, ep: int, group_id: int = -1) -> int: ...
+    def groups(self, group_id: Optional[int] = None) -> Union[dict, list]: ...
+    def retries(self, reset: bool = False) -> dict: ...
+    def interview(self, addr: int) -> None: ...
+    def interviews(self, limit: Optional[int] = None) -> dict: ...
+    def fingerprints(self, clear: bool = False) -> list: ...
+    def on_off(self, addr: int, ep: int, on: Optional[bool] = None, *, mode: int = UNICAST) -> int: ...
+    def level(self, addr: int, ep: int, level: int, transition: int = 0, *, on_off: bool = True, mode: int = UNICAST) -> int: ...
+    def color_xy(self, addr: int, ep: int, x: Union[int, float], y: Union[int, float], transition: int = 0, *, mode: int = UNICAST) -> int: ...
+    def color_temp(self, addr: int, ep: int, mireds: int, transition: int = 0, *, mode: int = UNICAST) -> int: ...
+    def cover(self, addr: int, ep: int, action: Optional[int] = None, *, lift: Optional[int] = None, tilt: Optional[int] = None, mode: int = UNICAST) -> int: ...
+    def storage_stats(self) -> dict: ...
+    def flush_storage(self) -> bool: ...
+    def export_snapshot(self, stream: Any = None, *, zb_storage: bool = False) -> Union[bytes, int]: ...
+    def import_snapshot(self, src: Any, *, zb_storage: bool = True) -> dict: ...
 
     # Message type constants
     #
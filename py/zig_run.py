@@ -320,6 +320,23 @@ def on_msg(any):
                     except Exception as e:
                         print(f"      Exception in parse_attribute: {e}")
 
+                # Per-attribute status for ESP_ZB_CORE_CMD_WRITE_ATTR_RESP_CB_ID
+                elif signal_type == ZCL_ACTION_CALLBACK.ESP_ZB_CORE_CMD_WRITE_ATTR_RESP_CB_ID: # 4097
+                    print("  Write Attribute Response:")
+                    for i in range(0, len(data) - 2, 3):
+                        status = data[i]
+                        attr_id = data[i + 1] | (data[i + 2] << 8)
+                        status_str = "SUCCESS" if status == 0 else f"FAILED(0x{status:02x})"
+                        print(f"    Attribute 0x{attr_id:04x}: {status_str}")
+
+                # Groups cluster responses, the membership mirror is updated in C
+                elif signal_type == ZCL_ACTION_CALLBACK.ESP_ZB_CORE_CMD_OPERATE_GROUP_RESP_CB_ID: # 4112
+                    op = "Add" if data[1] == 0x00 else "Remove"
+                    print(f"  {op} Group 0x{data[2] | (data[3] << 8):04x}: status 0x{data[0]:02x}")
+                elif signal_type == ZCL_ACTION_CALLBACK.ESP_ZB_CORE_CMD_GET_GROUP_MEMBERSHIP_RESP_CB_ID: # 4114
+                    groups = [data[i] | (data[i + 1] << 8) for i in range(2, len(data) - 1, 2)]
+                    print(f"  Groups: {[hex(g) for g in groups]}, capacity {data[0]}")
+
                 # Parse command response for ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID
                 elif signal_type == ZCL_ACTION_CALLBACK.ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID: # 4101
                     print("  Command Response Details:")
@@ -334,6 +351,34 @@ def on_msg(any):
             if msg_py == ZIG.MSG.RAW:
                 handle_raw_command(data)
 
+            elif msg_py in (ZIG.MSG.RETRY, ZIG.MSG.RETRY_GIVE_UP):
+                given_up = msg_py == ZIG.MSG.RETRY_GIVE_UP
+                print(f"  Step {signal_type} {'given up' if given_up else 'retry'}: attempt {data[0]}, status {data[1]}")
+
+            elif msg_py == ZIG.MSG.INTERVIEW:
+                step_ms = int.from_bytes(data[1:5], "little")
+                total_ms = int.from_bytes(data[5:9], "little")
+                print(f"  Interview step {signal_type}: result {data[0]}, {step_ms} ms (total {total_ms} ms)")
+
+            elif msg_py == ZIG.MSG.BINDING_TABLE:
+                print(f"  Binding table: status {signal_type}, {data[1]} of {data[0]} entries: {zig.bindings(src)}")
+
+            elif msg_py == ZIG.MSG.SCAN:
+                print(f"  Scan finished: status {signal_type}, {data[0]} networks")
+                for net in zig.scan_results():
+                    print(f"    PAN 0x{net['pan_id']:04x} ch {net['channel']} join {net['permit_join']}")
+
+            elif msg_py == ZIG.MSG.TOPOLOGY:
+                took_ms = int.from_bytes(data[6:10], "little")
+                print(f"  Topology: {data[0]} routers ({data[1]} failed) in {took_ms} ms")
+                for s, d, lqi, depth, rel, dev_type in zig.topology()["links"]:
+                    if lqi < 80:
+                        print(f"    Weak link 0x{s:04x} -> 0x{d:04x}: lqi {lqi}")
+
+            elif msg_py == ZIG.MSG.CHANNEL:
+                energy = data[1] - 256 if data[1] > 127 else data[1]
+                print(f"  Channel {data[0]} selected ({energy} dBm): {zig.get_network_info()['energy']}")
+
             elif msg_py == ZIG.MSG.CL_CUSTOM_CMD:
                 print("Custom action received")
                 tuya_dp_data = tuya_moes.parse_tuya_message(data)
@@ -16,6 +16,31 @@ class ZigbeeStorage:
         except OSError:
             return False
 
+    def sync(self):
+        sync = getattr(os, "sync", None)
+        if sync:
+            sync()
+
+    def remove_file(self, path):
+        try:
+            os.remove(path)
+            return True
+        except OSError:
+            return False
+
+    def read_file(self, filename):
+        # Use simple string concatenation
+        filepath = self.storage_path + "/" + filename
+        # First, check if the file exists
+        if not self.file_exists(filepath):
+            return None
+        # File exists, read it
+        try:
+            with open(filepath) as f:
+                return f.read()
+        except OSError:
+            return None
+
     def storage_handler(self, cmd, *args):
         """Callback for saving/loading devices"""
 
@@ -25,32 +50,33 @@ class ZigbeeStorage:
             filename, data = args
             # В MicroPython use simple string concatenation
             filepath = self.storage_path + "/" + filename
+            tmppath = filepath + ".tmp"
             try:
                 # В MicroPython not os.makedirs  exist_ok
                 try:
                     os.mkdir(self.storage_path)
                 except OSError:
                     pass
-                with open(filepath, 'w') as f:
+                # Write to temp file, flush to flash, then replace the record.
+                # A power cut leaves either the old record or a complete .tmp copy;
+                # the loader keeps the newest valid generation of both.
+                with open(tmppath, 'w') as f:
                     f.write(data)
+                    f.flush()
+                self.sync()
+                os.rename(tmppath, filepath)
+                self.sync()
                 return True
             except OSError as e:
                 print("Failed to save device", filename, ":", e)
                 return None
-                
+
         elif cmd == "load":
-            filename = args[0]
-            # Use simple string concatenation
-            filepath = self.storage_path + "/" + filename
-            # First, check if the file exists
-            if not self.file_exists(filepath):
-                return None
-            # File exists, read it
-            try:
-                with open(filepath) as f:
-                    return f.read()
-            except OSError:
-                return None
+            return self.read_file(args[0])
+
+        elif cmd == "load_many":
+            # Bulk read for startup: one entry per filename, None if unreadable
+            return [self.read_file(filename) for filename in args[0]]
                 
         elif cmd == "list":
             # First, check if the directory exists
@@ -60,12 +86,18 @@ class ZigbeeStorage:
                 # In MicroPython os.listdir returns only file names
                 files = []
                 for f in os.listdir(self.storage_path):
-                    # Check file extension
-                    if len(f) > 5 and f[-5:] == '.json':
+                    # Check file extension (.json.tmp is a candidate left by an interrupted save)
+                    if f.endswith('.json') or f.endswith('.json.tmp'):
                         # Check if file really exists
                         if self.file_exists(self.storage_path + "/" + f):
                             files.append(f)
                 return files
             except OSError:
                 return []
+
+        elif cmd == "remove":
+            filepath = self.storage_path + "/" + args[0]
+            removed = self.remove_file(filepath)
+            self.remove_file(filepath + ".tmp")
+            return True if removed else None
         return None
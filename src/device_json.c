@@ -1,21 +1,29 @@
 // Copyright (c) 2025 Viktor Vorobjov
+// Device record JSON: streaming writer and pull parser (no cJSON tree)
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <ctype.h>
 #include "esp_log.h"
+#include "py/runtime.h"
 #include "device_json.h"
 #include "device_manager.h"
 #include "mod_zig_core.h" // For zigbee_format_ieee_addr_to_str and zigbee_parse_ieee_str_to_addr
 
 #define LOG_TAG "DEVICE_JSON"
 
+#define JSON_KEY_MAX 32       // Longest key in the device format is 21 chars
+#define JSON_NUMBER_MAX 32    // Longest accepted number literal
+#define JSON_MAX_DEPTH 8      // Nesting limit when skipping unknown values
+
 // Function for cleaning control characters from string
 static void clean_string(char *str) {
     if (!str) return;
-    
+
 // Skip leading control characters
     char *src = str;
     while (*src && !isprint((unsigned char)*src)) src++;
-    
+
 // Copy only printable characters
     char *dst = str;
     while (*src) {
@@ -28,332 +36,634 @@ static void clean_string(char *str) {
     *dst = '\0';
 }
 
-// Convert device to JSON object
-cJSON* device_to_json(const zigbee_device_t *device) {
+/* ---------- Writer ---------- */
+
+// Output cursor: writes while there is room, always counts the full length
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+} json_writer_t;
+
+static void jw_putc(json_writer_t *w, char c) {
+    if (w->len + 1 < w->size) {
+        w->buf[w->len] = c;
+    }
+    w->len++;
+}
+
+static void jw_puts(json_writer_t *w, const char *s) {
+    while (*s) {
+        jw_putc(w, *s++);
+    }
+}
+
+// Integers are printed the way cJSON prints whole-number values
+static void jw_uint(json_writer_t *w, uint32_t v) {
+    char tmp[11];
+    snprintf(tmp, sizeof(tmp), "%lu", (unsigned long)v);
+    jw_puts(w, tmp);
+}
+
+// String with the same escaping as cJSON print_string_ptr
+static void jw_str(json_writer_t *w, const char *s) {
+    jw_putc(w, '"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        switch (c) {
+            case '"':  jw_puts(w, "\\\""); break;
+            case '\\': jw_puts(w, "\\\\"); break;
+            case '\b': jw_puts(w, "\\b"); break;
+            case '\f': jw_puts(w, "\\f"); break;
+            case '\n': jw_puts(w, "\\n"); break;
+            case '\r': jw_puts(w, "\\r"); break;
+            case '\t': jw_puts(w, "\\t"); break;
+            default:
+                if (c < 32) {
+                    char esc[7];
+                    snprintf(esc, sizeof(esc), "\\u%04x", c);
+                    jw_puts(w, esc);
+                } else {
+                    jw_putc(w, (char)c);
+                }
+                break;
+        }
+    }
+    jw_putc(w, '"');
+}
+
+// "key": prefix, with a comma unless it is the first member
+static void jw_key(json_writer_t *w, const char *key, bool first) {
+    if (!first) {
+        jw_putc(w, ',');
+    }
+    jw_str(w, key);
+    jw_putc(w, ':');
+}
+
+// Serialize device straight into buf, same layout as the former cJSON_PrintUnformatted output
+size_t device_to_json(const zigbee_device_t *device, char *buf, size_t size) {
+    json_writer_t w = { .buf = buf, .size = buf ? size : 0, .len = 0 };
+
     if (!device) {
         ESP_LOGE(LOG_TAG, "NULL device pointer");
-        return NULL;
+        if (w.size) buf[0] = '\0';
+        return 0;
     }
 
-    ESP_LOGI(LOG_TAG, "Creating JSON for device 0x%04x", device->short_addr);
-    
-    cJSON *json = cJSON_CreateObject();
-    if (!json) {
-        ESP_LOGE(LOG_TAG, "Failed to create JSON object");
-        return NULL;
-    }
-    
+    jw_putc(&w, '{');
+
     // Add basic device info - short address as hex string
     char short_addr_str[8];
     snprintf(short_addr_str, sizeof(short_addr_str), "0x%04x", device->short_addr);
-    cJSON_AddStringToObject(json, "short_addr", short_addr_str);
-    
-    // IEEE address as hex string - now directly use the pre-formatted string from the device struct
+    jw_key(&w, "short_addr", true);
+    jw_str(&w, short_addr_str);
+
+    // IEEE address as hex string - use the pre-formatted string from the device struct
+    jw_key(&w, "ieee_addr", false);
     if (device->ieee_addr_str[0] == '\0') {
         // Fallback if string is not formatted (should not happen with new logic but good for safety)
         ESP_LOGW(LOG_TAG, "IEEE string for 0x%04x is not pre-formatted, formatting now.", device->short_addr);
         char temp_ieee_str[24];
         zigbee_format_ieee_addr_to_str(device->ieee_addr, temp_ieee_str, sizeof(temp_ieee_str));
-        cJSON_AddStringToObject(json, "ieee_addr", temp_ieee_str);
+        jw_str(&w, temp_ieee_str);
     } else {
-        cJSON_AddStringToObject(json, "ieee_addr", device->ieee_addr_str);
+        jw_str(&w, device->ieee_addr_str);
     }
-    
-    // // Add other device properties
-    // cJSON_AddBoolToObject(json, "active", device->active);
-    // cJSON_AddNumberToObject(json, "last_seen", device->last_seen);
-    
+
 // Clean strings from control characters before adding to JSON
     char clean_device_name[32];
     char clean_manufacturer_name[32];
-    
+
     strncpy(clean_device_name, device->device_name, sizeof(clean_device_name)-1);
     clean_device_name[sizeof(clean_device_name)-1] = '\0';
     clean_string(clean_device_name);
-    
+
     strncpy(clean_manufacturer_name, device->manufacturer_name, sizeof(clean_manufacturer_name)-1);
     clean_manufacturer_name[sizeof(clean_manufacturer_name)-1] = '\0';
     clean_string(clean_manufacturer_name);
-    
-    cJSON_AddStringToObject(json, "device_name", clean_device_name);
-    cJSON_AddStringToObject(json, "manufacturer_name", clean_manufacturer_name);
-    cJSON_AddNumberToObject(json, "manufacturer_code", device->manufacturer_code);
-    // cJSON_AddNumberToObject(json, "power_source", device->power_source);
-    // cJSON_AddNumberToObject(json, "battery_voltage", device->battery_voltage);
-    // cJSON_AddNumberToObject(json, "battery_percentage", device->battery_percentage);
-    // cJSON_AddNumberToObject(json, "firmware_version", device->firmware_version);
-
-    // Add endpoints array
-    cJSON *endpoints = cJSON_AddArrayToObject(json, "endpoints");
-    if (!endpoints) {
-        ESP_LOGE(LOG_TAG, "Failed to create endpoints array");
-        cJSON_Delete(json);
-        return NULL;
-    }
-
-    // Add each endpoint
-    for (int i = 0; i < device->endpoint_count; i++) {
-        cJSON *ep = cJSON_CreateObject();
-        if (!ep) {
-            ESP_LOGE(LOG_TAG, "Failed to create endpoint object");
-            cJSON_Delete(json);
-            return NULL;
+
+    jw_key(&w, "device_name", false);
+    jw_str(&w, clean_device_name);
+    jw_key(&w, "manufacturer_name", false);
+    jw_str(&w, clean_manufacturer_name);
+    jw_key(&w, "manufacturer_code", false);
+    jw_uint(&w, device->manufacturer_code);
+
+    // Interview state: a rejoin of a complete device skips discovery
+    jw_key(&w, "interview_complete", false);
+    jw_puts(&w, device->interview_complete ? "true" : "false");
+    jw_key(&w, "desc_hash", false);
+    jw_uint(&w, device->desc_hash);
+    jw_key(&w, "bind_hash", false);
+    jw_uint(&w, device->bind_hash);
+
+    // Endpoints array
+    jw_key(&w, "endpoints", false);
+    jw_putc(&w, '[');
+    for (int i = 0; i < device->endpoint_count && i < MAX_ENDPOINTS; i++) {
+        const zigbee_endpoint_t *ep = &device->endpoints[i];
+        if (i) jw_putc(&w, ',');
+        jw_putc(&w, '{');
+        jw_key(&w, "endpoint", true);
+        jw_uint(&w, ep->endpoint);
+        jw_key(&w, "profile_id", false);
+        jw_uint(&w, ep->profile_id);
+        jw_key(&w, "device_id", false);
+        jw_uint(&w, ep->device_id);
+        jw_key(&w, "clusters", false);
+        jw_putc(&w, '[');
+        for (int j = 0; j < ep->cluster_count && j < MAX_CLUSTERS; j++) {
+            if (j) jw_putc(&w, ',');
+            jw_uint(&w, ep->cluster_list[j]);
         }
+        jw_putc(&w, ']');
+        jw_putc(&w, '}');
+    }
+    jw_putc(&w, ']');
+
+    // Report configurations array
+    jw_key(&w, "reports", false);
+    jw_putc(&w, '[');
+    bool first_report = true;
+    for (int i = 0; i < MAX_REPORT_CFGS; i++) {
+        const report_cfg_t *cfg = &device->report_cfgs[i];
+        if (!cfg->in_use) continue;
 
-        cJSON_AddNumberToObject(ep, "endpoint", device->endpoints[i].endpoint);
-        cJSON_AddNumberToObject(ep, "profile_id", device->endpoints[i].profile_id);
-        cJSON_AddNumberToObject(ep, "device_id", device->endpoints[i].device_id);
+        if (!first_report) jw_putc(&w, ',');
+        first_report = false;
+        jw_putc(&w, '{');
 
-        // Add clusters array
-        cJSON *clusters = cJSON_AddArrayToObject(ep, "clusters");
-        if (!clusters) {
-            ESP_LOGE(LOG_TAG, "Failed to create clusters array");
-            cJSON_Delete(json);
-            return NULL;
+        // Common fields
+        jw_key(&w, "direction", true);
+        jw_uint(&w, cfg->direction);
+        jw_key(&w, "ep", false);
+        jw_uint(&w, cfg->ep);
+        jw_key(&w, "cluster_id", false);
+        jw_uint(&w, cfg->cluster_id);
+        jw_key(&w, "attr_id", false);
+        jw_uint(&w, cfg->attr_id);
+
+        if (cfg->direction == REPORT_CFG_DIRECTION_SEND) {
+            jw_key(&w, "attr_type", false);
+            jw_uint(&w, cfg->send_cfg.attr_type);
+            jw_key(&w, "min_int", false);
+            jw_uint(&w, cfg->send_cfg.min_int);
+            jw_key(&w, "max_int", false);
+            jw_uint(&w, cfg->send_cfg.max_int);
+            // Only add reportable_change_val if it's not the 'unused' marker
+            if (cfg->send_cfg.reportable_change_val != 0xFFFFFFFF) {
+                jw_key(&w, "reportable_change_val", false);
+                jw_uint(&w, cfg->send_cfg.reportable_change_val);
+            }
+        } else if (cfg->direction == REPORT_CFG_DIRECTION_RECV) {
+            jw_key(&w, "timeout_period", false);
+            jw_uint(&w, cfg->recv_cfg.timeout_period);
         }
 
-        // Add each cluster
-        for (int j = 0; j < device->endpoints[i].cluster_count; j++) {
-            cJSON_AddItemToArray(clusters, cJSON_CreateNumber(device->endpoints[i].cluster_list[j]));
+        jw_putc(&w, '}');
+    }
+    jw_putc(&w, ']');
+
+    jw_putc(&w, '}');
+
+    // Terminate what fits, like snprintf
+    if (w.size) {
+        w.buf[w.len < w.size ? w.len : w.size - 1] = '\0';
+    }
+
+    ESP_LOGD(LOG_TAG, "Serialized device 0x%04x (%u bytes)", device->short_addr, (unsigned)w.len);
+    return w.len;
+}
+
+// Serialize device into a Python str: exact-size GC buffer, no intermediate copy
+mp_obj_t device_to_json_str(const zigbee_device_t *device) {
+    size_t len = device_to_json(device, NULL, 0);
+    if (len == 0) {
+        return mp_const_none;
+    }
+
+    vstr_t vstr;
+    vstr_init_len(&vstr, len);
+    device_to_json(device, vstr.buf, len + 1);
+    return mp_obj_new_str_from_vstr(&vstr);
+}
+
+/* ---------- Pull parser ---------- */
+
+typedef struct {
+    const char *p;
+    const char *end;
+    bool error;
+} json_reader_t;
+
+static void jr_skip_ws(json_reader_t *r) {
+    while (r->p < r->end && (*r->p == ' ' || *r->p == '\t' || *r->p == '\n' || *r->p == '\r')) {
+        r->p++;
+    }
+}
+
+static char jr_peek(json_reader_t *r) {
+    jr_skip_ws(r);
+    return (r->p < r->end) ? *r->p : '\0';
+}
+
+static bool jr_expect(json_reader_t *r, char c) {
+    if (jr_peek(r) != c) {
+        r->error = true;
+        return false;
+    }
+    r->p++;
+    return true;
+}
+
+static int jr_hex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Read string value into out (truncated to out_size-1). out may be NULL to skip.
+// \uXXXX escapes above ASCII are replaced with '?', the device fields are ASCII only.
+static bool jr_string(json_reader_t *r, char *out, size_t out_size) {
+    size_t n = 0;
+    if (!jr_expect(r, '"')) return false;
+
+    while (r->p < r->end && *r->p != '"') {
+        char c = *r->p++;
+        if (c == '\\') {
+            if (r->p >= r->end) break;
+            char e = *r->p++;
+            switch (e) {
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u': {
+                    if (r->end - r->p < 4) {
+                        r->error = true;
+                        return false;
+                    }
+                    int cp = 0;
+                    for (int i = 0; i < 4; i++) {
+                        int h = jr_hex(r->p[i]);
+                        if (h < 0) {
+                            r->error = true;
+                            return false;
+                        }
+                        cp = (cp << 4) | h;
+                    }
+                    r->p += 4;
+                    c = (cp < 0x80) ? (char)cp : '?';
+                    break;
+                }
+                default: c = e; break;   // \" \\ \/
+            }
         }
+        if (out && n + 1 < out_size) {
+            out[n++] = c;
+        }
+    }
 
-        cJSON_AddItemToArray(endpoints, ep);
+    if (out && out_size) {
+        out[n] = '\0';
     }
+    return jr_expect(r, '"');
+}
 
-    // Add report configurations array
-    cJSON *reports = cJSON_AddArrayToObject(json, "reports");
-    if (!reports) {
-        ESP_LOGE(LOG_TAG, "Failed to create reports array");
-        cJSON_Delete(json);
-        return NULL;
+static bool jr_number(json_reader_t *r, double *out) {
+    char tmp[JSON_NUMBER_MAX];
+    size_t n = 0;
+
+    jr_skip_ws(r);
+    while (r->p < r->end && n + 1 < sizeof(tmp) && strchr("+-0123456789.eE", *r->p)) {
+        tmp[n++] = *r->p++;
     }
+    tmp[n] = '\0';
 
-    // Add each report configuration
-    for (int i = 0; i < MAX_REPORT_CFGS; i++) {
-        if (device->report_cfgs[i].in_use) {
-            cJSON *report = cJSON_CreateObject();
-            if (!report) {
-                ESP_LOGE(LOG_TAG, "Failed to create report object");
-                cJSON_Delete(json);
-                return NULL;
+    char *endp = NULL;
+    double v = strtod(tmp, &endp);
+    if (n == 0 || endp != tmp + n) {
+        r->error = true;
+        return false;
+    }
+    if (out) *out = v;
+    return true;
+}
+
+static bool jr_literal(json_reader_t *r, const char *lit) {
+    size_t len = strlen(lit);
+    jr_skip_ws(r);
+    if ((size_t)(r->end - r->p) < len || memcmp(r->p, lit, len) != 0) {
+        r->error = true;
+        return false;
+    }
+    r->p += len;
+    return true;
+}
+
+// Iterate object members: true when a key was read and the value is next
+static bool jr_object_next(json_reader_t *r, char *key, size_t key_size, bool *first) {
+    if (r->error) return false;
+    if (*first) {
+        *first = false;
+        if (!jr_expect(r, '{')) return false;
+        if (jr_peek(r) == '}') {
+            r->p++;
+            return false;
+        }
+    } else {
+        char c = jr_peek(r);
+        if (c == '}') {
+            r->p++;
+            return false;
+        }
+        if (!jr_expect(r, ',')) return false;
+    }
+    return jr_string(r, key, key_size) && jr_expect(r, ':');
+}
+
+// Iterate array elements: true when an element is next
+static bool jr_array_next(json_reader_t *r, bool *first) {
+    if (r->error) return false;
+    if (*first) {
+        *first = false;
+        if (!jr_expect(r, '[')) return false;
+        if (jr_peek(r) == ']') {
+            r->p++;
+            return false;
+        }
+        return true;
+    }
+    char c = jr_peek(r);
+    if (c == ']') {
+        r->p++;
+        return false;
+    }
+    return jr_expect(r, ',');
+}
+
+// Skip any value (used for unknown keys and unexpected element types)
+static bool jr_skip(json_reader_t *r, int depth) {
+    if (depth > JSON_MAX_DEPTH) {
+        r->error = true;
+        return false;
+    }
+    char key[JSON_KEY_MAX];
+    bool first = true;
+
+    switch (jr_peek(r)) {
+        case '"': return jr_string(r, NULL, 0);
+        case '{':
+            while (jr_object_next(r, key, sizeof(key), &first)) {
+                if (!jr_skip(r, depth + 1)) return false;
             }
+            return !r->error;
+        case '[':
+            while (jr_array_next(r, &first)) {
+                if (!jr_skip(r, depth + 1)) return false;
+            }
+            return !r->error;
+        case 't': return jr_literal(r, "true");
+        case 'f': return jr_literal(r, "false");
+        case 'n': return jr_literal(r, "null");
+        default:  return jr_number(r, NULL);
+    }
+}
+
+// Read a number if the value is one, otherwise skip it. Returns true if a number was read.
+static bool jr_opt_number(json_reader_t *r, double *out) {
+    char c = jr_peek(r);
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        return jr_number(r, out);
+    }
+    jr_skip(r, 0);
+    return false;
+}
+
+// Read a string if the value is one, otherwise skip it. Returns true if a string was read.
+static bool jr_opt_string(json_reader_t *r, char *out, size_t out_size) {
+    if (jr_peek(r) == '"') {
+        return jr_string(r, out, out_size);
+    }
+    jr_skip(r, 0);
+    return false;
+}
+
+static void parse_endpoint(json_reader_t *r, zigbee_device_t *device, int index) {
+    char key[JSON_KEY_MAX];
+    bool first = true;
+    bool has_ep = false, has_profile = false, has_dev = false;
+    double ep_v = 0, profile_v = 0, dev_v = 0;
+    zigbee_endpoint_t ep = {0};
 
-            // Common fields
-            cJSON_AddNumberToObject(report, "direction", device->report_cfgs[i].direction);
-            cJSON_AddNumberToObject(report, "ep", device->report_cfgs[i].ep);
-            cJSON_AddNumberToObject(report, "cluster_id", device->report_cfgs[i].cluster_id);
-            cJSON_AddNumberToObject(report, "attr_id", device->report_cfgs[i].attr_id);
-
-            if (device->report_cfgs[i].direction == REPORT_CFG_DIRECTION_SEND) {
-                cJSON_AddNumberToObject(report, "attr_type", device->report_cfgs[i].send_cfg.attr_type);
-                cJSON_AddNumberToObject(report, "min_int", device->report_cfgs[i].send_cfg.min_int);
-                cJSON_AddNumberToObject(report, "max_int", device->report_cfgs[i].send_cfg.max_int);
-                // Only add reportable_change_val if it's not the 'unused' marker
-                if (device->report_cfgs[i].send_cfg.reportable_change_val != 0xFFFFFFFF) {
-                    cJSON_AddNumberToObject(report, "reportable_change_val", device->report_cfgs[i].send_cfg.reportable_change_val);
+    if (jr_peek(r) != '{') {
+        jr_skip(r, 0);
+        return;
+    }
+
+    while (jr_object_next(r, key, sizeof(key), &first)) {
+        if (strcmp(key, "endpoint") == 0) {
+            has_ep = jr_opt_number(r, &ep_v);
+        } else if (strcmp(key, "profile_id") == 0) {
+            has_profile = jr_opt_number(r, &profile_v);
+        } else if (strcmp(key, "device_id") == 0) {
+            has_dev = jr_opt_number(r, &dev_v);
+        } else if (strcmp(key, "clusters") == 0 && jr_peek(r) == '[') {
+            bool first_cluster = true;
+            while (jr_array_next(r, &first_cluster)) {
+                double cluster_v;
+                if (jr_opt_number(r, &cluster_v) && ep.cluster_count < MAX_CLUSTERS) {
+                    ep.cluster_list[ep.cluster_count++] = (uint16_t)cluster_v;
                 }
-            } else if (device->report_cfgs[i].direction == REPORT_CFG_DIRECTION_RECV) {
-                cJSON_AddNumberToObject(report, "timeout_period", device->report_cfgs[i].recv_cfg.timeout_period);
             }
+        } else {
+            jr_skip(r, 0);
+        }
+    }
+
+    if (r->error) return;
+    if (!has_ep || !has_profile || !has_dev) {
+        ESP_LOGW(LOG_TAG, "Invalid endpoint %d data", index);
+        return;
+    }
+
+    ep.endpoint = (uint8_t)ep_v;
+    ep.profile_id = (uint16_t)profile_v;
+    ep.device_id = (uint16_t)dev_v;
+    device->endpoints[device->endpoint_count++] = ep;
+}
 
-            cJSON_AddItemToArray(reports, report);
+static void parse_report(json_reader_t *r, zigbee_device_t *device, int index) {
+    char key[JSON_KEY_MAX];
+    bool first = true;
+    enum { F_DIR, F_EP, F_CLUSTER, F_ATTR, F_TYPE, F_MIN, F_MAX, F_CHANGE, F_TIMEOUT, F_COUNT };
+    static const char *const names[F_COUNT] = {
+        "direction", "ep", "cluster_id", "attr_id", "attr_type",
+        "min_int", "max_int", "reportable_change_val", "timeout_period"
+    };
+    double v[F_COUNT] = {0};
+    bool has[F_COUNT] = {0};
+
+    if (jr_peek(r) != '{') {
+        jr_skip(r, 0);
+        return;
+    }
+
+    while (jr_object_next(r, key, sizeof(key), &first)) {
+        int f = 0;
+        while (f < F_COUNT && strcmp(key, names[f]) != 0) f++;
+        if (f < F_COUNT) {
+            has[f] = jr_opt_number(r, &v[f]);
+        } else {
+            jr_skip(r, 0);
         }
     }
 
-    ESP_LOGI(LOG_TAG, "Successfully created JSON for device 0x%04x", device->short_addr);
-    return json;
+    if (r->error) return;
+    if (!has[F_EP] || !has[F_CLUSTER] || !has[F_ATTR] || !has[F_DIR]) {
+        ESP_LOGW(LOG_TAG, "Invalid common report config fields for report %d", index);
+        return;
+    }
+
+    report_cfg_t *cfg = &device->report_cfgs[index];
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->direction = (uint8_t)v[F_DIR];
+    cfg->ep = (uint8_t)v[F_EP];
+    cfg->cluster_id = (uint16_t)v[F_CLUSTER];
+    cfg->attr_id = (uint16_t)v[F_ATTR];
+
+    if (cfg->direction == REPORT_CFG_DIRECTION_SEND) {
+        if (!has[F_TYPE] || !has[F_MIN] || !has[F_MAX]) {
+            ESP_LOGW(LOG_TAG, "Invalid send_cfg fields for report %d", index);
+            return;
+        }
+        cfg->send_cfg.attr_type = (uint8_t)v[F_TYPE];
+        cfg->send_cfg.min_int = (uint16_t)v[F_MIN];
+        cfg->send_cfg.max_int = (uint16_t)v[F_MAX];
+        cfg->send_cfg.reportable_change_val = has[F_CHANGE] ? (uint32_t)v[F_CHANGE] : 0xFFFFFFFF;
+    } else if (cfg->direction == REPORT_CFG_DIRECTION_RECV) {
+        if (!has[F_TIMEOUT]) {
+            ESP_LOGW(LOG_TAG, "Invalid recv_cfg fields for report %d", index);
+            return;
+        }
+        cfg->recv_cfg.timeout_period = (uint16_t)v[F_TIMEOUT];
+    } else {
+        ESP_LOGW(LOG_TAG, "Unknown direction %d for report %d", cfg->direction, index);
+        return;
+    }
+    cfg->in_use = true;
 }
 
-// Parse device from JSON object
-esp_err_t device_from_json(const cJSON *json, zigbee_device_t *device, mp_obj_t zig_obj_mp) {
+// Parse device record in one pass over the text
+esp_err_t device_from_json(const char *json, size_t len, zigbee_device_t *device) {
     if (!json || !device) {
         ESP_LOGE(LOG_TAG, "NULL parameters");
         return ESP_ERR_INVALID_ARG;
     }
-    
+
     // Clear device structure
     memset(device, 0, sizeof(zigbee_device_t));
-    
-    // Get short address as hex string
-    cJSON *short_addr_item = cJSON_GetObjectItem(json, "short_addr"); // Renamed for clarity
-    if (!cJSON_IsString(short_addr_item)) {
+
+    json_reader_t r = { .p = json, .end = json + len, .error = false };
+    char key[JSON_KEY_MAX];
+    char short_addr_str[16] = {0};
+    char ieee_str[32] = {0};
+    bool has_short = false, has_ieee = false, has_endpoints = false;
+    bool first = true;
+    int report_index = 0;
+
+    while (jr_object_next(&r, key, sizeof(key), &first)) {
+        if (strcmp(key, "short_addr") == 0) {
+            has_short = jr_opt_string(&r, short_addr_str, sizeof(short_addr_str));
+        } else if (strcmp(key, "ieee_addr") == 0) {
+            has_ieee = jr_opt_string(&r, ieee_str, sizeof(ieee_str));
+        } else if (strcmp(key, "device_name") == 0) {
+            jr_opt_string(&r, device->device_name, sizeof(device->device_name));
+        } else if (strcmp(key, "manufacturer_name") == 0) {
+            jr_opt_string(&r, device->manufacturer_name, sizeof(device->manufacturer_name));
+        } else if (strcmp(key, "manufacturer_code") == 0) {
+            double v;
+            if (jr_opt_number(&r, &v)) {
+                device->manufacturer_code = (uint16_t)v;
+            }
+        } else if (strcmp(key, "interview_complete") == 0) {
+            if (jr_peek(&r) == 't') {
+                device->interview_complete = jr_literal(&r, "true");
+            } else {
+                jr_skip(&r, 0);
+            }
+        } else if (strcmp(key, "desc_hash") == 0) {
+            double v;
+            if (jr_opt_number(&r, &v)) {
+                device->desc_hash = (uint32_t)v;
+            }
+        } else if (strcmp(key, "bind_hash") == 0) {
+            double v;
+            if (jr_opt_number(&r, &v)) {
+                device->bind_hash = (uint32_t)v;
+            }
+        } else if (strcmp(key, "endpoints") == 0 && jr_peek(&r) == '[') {
+            bool first_ep = true;
+            int i = 0;
+            has_endpoints = true;
+            while (jr_array_next(&r, &first_ep)) {
+                if (device->endpoint_count < MAX_ENDPOINTS) {
+                    parse_endpoint(&r, device, i);
+                } else {
+                    jr_skip(&r, 0);
+                }
+                i++;
+            }
+        } else if (strcmp(key, "reports") == 0 && jr_peek(&r) == '[') {
+            bool first_report = true;
+            while (jr_array_next(&r, &first_report)) {
+                if (report_index < MAX_REPORT_CFGS) {
+                    parse_report(&r, device, report_index);
+                } else {
+                    jr_skip(&r, 0);
+                }
+                report_index++;
+            }
+        } else {
+            jr_skip(&r, 0);
+        }
+    }
+
+    if (r.error) {
+        ESP_LOGE(LOG_TAG, "Malformed JSON at offset %d", (int)(r.p - json));
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!has_short) {
         ESP_LOGE(LOG_TAG, "Invalid short_addr type, expected string");
         return ESP_ERR_INVALID_ARG;
     }
-    // Temporarily store parsed short_addr for logging before assigning to device->short_addr
     uint16_t parsed_short_addr_val = 0;
-    if (sscanf(short_addr_item->valuestring, "0x%hx", &parsed_short_addr_val) != 1) {
-        ESP_LOGE(LOG_TAG, "Failed to parse short_addr string: '%s'", short_addr_item->valuestring);
+    if (sscanf(short_addr_str, "0x%hx", &parsed_short_addr_val) != 1) {
+        ESP_LOGE(LOG_TAG, "Failed to parse short_addr string: '%s'", short_addr_str);
         return ESP_ERR_INVALID_ARG;
     }
-    device->short_addr = parsed_short_addr_val; // Assign after successful parse
-    
-    // Get IEEE address as MAC-style string with colons
-    cJSON *ieee_addr_item = cJSON_GetObjectItem(json, "ieee_addr"); 
-    if (!cJSON_IsString(ieee_addr_item)) {
+    device->short_addr = parsed_short_addr_val;
+
+    if (!has_ieee) {
         ESP_LOGE(LOG_TAG, "Invalid ieee_addr type for 0x%04x, expected string", device->short_addr);
         return ESP_ERR_INVALID_ARG;
     }
-
-    ESP_LOGI(LOG_TAG, "JSON PARSE: Attempting to process device from JSON: short_addr_str='%s' (parsed 0x%04x), ieee_addr_str='%s'", 
-             short_addr_item->valuestring, device->short_addr, ieee_addr_item->valuestring);
-
     // Parse MAC address format (xx:xx:xx:xx:xx:xx:xx:xx)
-    if (!zigbee_parse_ieee_str_to_addr(ieee_addr_item->valuestring, device->ieee_addr)) {
-        ESP_LOGE(LOG_TAG, "Failed to parse ieee_addr string: '%s' for short_addr 0x%04x", 
-                 ieee_addr_item->valuestring, device->short_addr);
+    if (!zigbee_parse_ieee_str_to_addr(ieee_str, device->ieee_addr)) {
+        ESP_LOGE(LOG_TAG, "Failed to parse ieee_addr string: '%s' for short_addr 0x%04x",
+                 ieee_str, device->short_addr);
         return ESP_ERR_INVALID_ARG;
     }
-    
-    //probaly check max device available
-    
-    // Get string fields with bounds checking
-    cJSON *device_name = cJSON_GetObjectItem(json, "device_name");
-    
-    if (cJSON_IsString(device_name)) {
-        strncpy(device->device_name, device_name->valuestring, sizeof(device->device_name)-1);
-        device->device_name[sizeof(device->device_name)-1] = '\0';
-    }
-    
-    cJSON *manufacturer_name = cJSON_GetObjectItem(json, "manufacturer_name");
-    if (cJSON_IsString(manufacturer_name)) {
-        strncpy(device->manufacturer_name, manufacturer_name->valuestring, 
-                sizeof(device->manufacturer_name)-1);
-        device->manufacturer_name[sizeof(device->manufacturer_name)-1] = '\0';
-    }
-    
-    // Get numeric fields with validation
-    cJSON *manufacturer_code = cJSON_GetObjectItem(json, "manufacturer_code");
-    device->manufacturer_code = cJSON_IsNumber(manufacturer_code) ? 
-                              (uint16_t)manufacturer_code->valuedouble : 0;
-    
-    // cJSON *power_source = cJSON_GetObjectItem(json, "power_source");
-    // device->power_source = cJSON_IsNumber(power_source) ? 
-    //                       (uint8_t)power_source->valuedouble : 0;
-    
-    // cJSON *battery_voltage = cJSON_GetObjectItem(json, "battery_voltage");
-    // device->battery_voltage = cJSON_IsNumber(battery_voltage) ? 
-    //                         (uint16_t)battery_voltage->valuedouble : 0;
-    
-    // cJSON *battery_percentage = cJSON_GetObjectItem(json, "battery_percentage");
-    // device->battery_percentage = cJSON_IsNumber(battery_percentage) ? 
-    //                            (uint8_t)battery_percentage->valuedouble : 0;
-    
-    // cJSON *firmware_version = cJSON_GetObjectItem(json, "firmware_version");
-    // device->firmware_version = cJSON_IsNumber(firmware_version) ? 
-    //                          (uint32_t)firmware_version->valuedouble : 0;
-    
-    // Get endpoints
-    cJSON *endpoints = cJSON_GetObjectItem(json, "endpoints");
-    if (!cJSON_IsArray(endpoints)) {
+
+    if (!has_endpoints) {
         ESP_LOGE(LOG_TAG, "Invalid endpoints array");
         return ESP_ERR_INVALID_ARG;
     }
-    
-    device->endpoint_count = 0;
-    int ep_count = cJSON_GetArraySize(endpoints);
-    
-    for (int i = 0; i < ep_count && i < MAX_ENDPOINTS; i++) {
-        cJSON *ep = cJSON_GetArrayItem(endpoints, i);
-        if (!cJSON_IsObject(ep)) continue;
-        
-        cJSON *endpoint = cJSON_GetObjectItem(ep, "endpoint");
-        cJSON *profile_id = cJSON_GetObjectItem(ep, "profile_id");
-        cJSON *device_id = cJSON_GetObjectItem(ep, "device_id");
-        
-        if (!cJSON_IsNumber(endpoint) || !cJSON_IsNumber(profile_id) || 
-            !cJSON_IsNumber(device_id)) {
-            ESP_LOGW(LOG_TAG, "Invalid endpoint %d data", i);
-            continue;
-        }
-        
-        device->endpoints[i].endpoint = (uint8_t)endpoint->valuedouble;
-        device->endpoints[i].profile_id = (uint16_t)profile_id->valuedouble;
-        device->endpoints[i].device_id = (uint16_t)device_id->valuedouble;
-        
-        // Get clusters
-        cJSON *clusters = cJSON_GetObjectItem(ep, "clusters");
-        if (cJSON_IsArray(clusters)) {
-            device->endpoints[i].cluster_count = 0;
-            int cluster_count = cJSON_GetArraySize(clusters);
-            
-            for (int j = 0; j < cluster_count && j < 32; j++) {
-                cJSON *cluster = cJSON_GetArrayItem(clusters, j);
-                if (cJSON_IsNumber(cluster)) {
-                    device->endpoints[i].cluster_list[j] = (uint16_t)cluster->valuedouble;
-                    device->endpoints[i].cluster_count++;
-                }
-            }
-        }
-        
-        device->endpoint_count++;
-    }
-    
-    // Get report configurations
-    cJSON *reports = cJSON_GetObjectItem(json, "reports");
-    if (cJSON_IsArray(reports)) {
-        // Reset all configs
-        for (int i = 0; i < MAX_REPORT_CFGS; i++) {
-            device->report_cfgs[i].in_use = false;
-        }
-        
-        int report_count = cJSON_GetArraySize(reports);
-        for (int i = 0; i < report_count && i < MAX_REPORT_CFGS; i++) {
-            cJSON *report = cJSON_GetArrayItem(reports, i);
-            if (!cJSON_IsObject(report)) continue;
-            
-            cJSON *ep_json = cJSON_GetObjectItem(report, "ep");
-            cJSON *cluster_id_json = cJSON_GetObjectItem(report, "cluster_id");
-            cJSON *attr_id_json = cJSON_GetObjectItem(report, "attr_id");
-            cJSON *direction_json = cJSON_GetObjectItem(report, "direction");
-
-            if (!cJSON_IsNumber(ep_json) || !cJSON_IsNumber(cluster_id_json) || 
-                !cJSON_IsNumber(attr_id_json) || !cJSON_IsNumber(direction_json)) {
-                ESP_LOGW(LOG_TAG, "Invalid common report config fields for report %d", i);
-                continue;
-            }
-            
-            device->report_cfgs[i].in_use = true;
-            device->report_cfgs[i].direction = (uint8_t)direction_json->valuedouble;
-            device->report_cfgs[i].ep = (uint8_t)ep_json->valuedouble;
-            device->report_cfgs[i].cluster_id = (uint16_t)cluster_id_json->valuedouble;
-            device->report_cfgs[i].attr_id = (uint16_t)attr_id_json->valuedouble;
-
-            if (device->report_cfgs[i].direction == REPORT_CFG_DIRECTION_SEND) {
-                cJSON *attr_type_json = cJSON_GetObjectItem(report, "attr_type");
-                cJSON *min_int_json = cJSON_GetObjectItem(report, "min_int");
-                cJSON *max_int_json = cJSON_GetObjectItem(report, "max_int");
-                cJSON *rc_val_json = cJSON_GetObjectItem(report, "reportable_change_val"); // Optional
-
-                if (!cJSON_IsNumber(attr_type_json) || !cJSON_IsNumber(min_int_json) || !cJSON_IsNumber(max_int_json)) {
-                    ESP_LOGW(LOG_TAG, "Invalid send_cfg fields for report %d", i);
-                    device->report_cfgs[i].in_use = false; // Mark as invalid
-                    continue;
-                }
-                device->report_cfgs[i].send_cfg.attr_type = (uint8_t)attr_type_json->valuedouble;
-                device->report_cfgs[i].send_cfg.min_int = (uint16_t)min_int_json->valuedouble;
-                device->report_cfgs[i].send_cfg.max_int = (uint16_t)max_int_json->valuedouble;
-                if (rc_val_json && cJSON_IsNumber(rc_val_json)) {
-                    device->report_cfgs[i].send_cfg.reportable_change_val = (uint32_t)rc_val_json->valuedouble;
-                } else {
-                    device->report_cfgs[i].send_cfg.reportable_change_val = 0xFFFFFFFF; // Mark as not set
-                }
-            } else if (device->report_cfgs[i].direction == REPORT_CFG_DIRECTION_RECV) {
-                cJSON *timeout_json = cJSON_GetObjectItem(report, "timeout_period");
-                if (!cJSON_IsNumber(timeout_json)) {
-                    ESP_LOGW(LOG_TAG, "Invalid recv_cfg fields for report %d", i);
-                    device->report_cfgs[i].in_use = false; // Mark as invalid
-                    continue;
-                }
-                device->report_cfgs[i].recv_cfg.timeout_period = (uint16_t)timeout_json->valuedouble;
-            } else {
-                ESP_LOGW(LOG_TAG, "Unknown direction %d for report %d", device->report_cfgs[i].direction, i);
-                device->report_cfgs[i].in_use = false; // Mark as invalid
-                continue;
-            }
-        }
-    }
-    
-    ESP_LOGI(LOG_TAG, "Successfully parsed device 0x%04x from JSON", device->short_addr);
+
+    ESP_LOGD(LOG_TAG, "Parsed device 0x%04x from JSON", device->short_addr);
     return ESP_OK;
 }
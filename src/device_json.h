@@ -4,24 +4,41 @@
 
 #include "esp_err.h"
 #include "mod_zig_types.h"
-#include "cJSON.h"
 
 /**
- * @brief Serialize device to JSON
- * 
+ * @brief Serialize device to JSON text
+ *
+ * Writes directly from zigbee_device_t, no intermediate object tree.
+ * Works like snprintf: output is truncated to size-1 bytes and
+ * NUL-terminated, the return value is the full length. Call with
+ * buf=NULL to get the required size.
+ *
  * @param device Pointer to device structure
- * @return cJSON* JSON object or NULL in case of error
+ * @param buf Output buffer or NULL
+ * @param size Size of buf in bytes
+ * @return size_t Length of the JSON text (without NUL), 0 on error
  */
-cJSON* device_to_json(const zigbee_device_t *device);
+size_t device_to_json(const zigbee_device_t *device, char *buf, size_t size);
 
 /**
- * @brief Deserialize device from JSON
- * 
- * @param json JSON object with device data
+ * @brief Serialize device to a Python str
+ *
+ * @param device Pointer to device structure
+ * @return mp_obj_t str object or None in case of error
+ */
+mp_obj_t device_to_json_str(const zigbee_device_t *device);
+
+/**
+ * @brief Deserialize device from JSON text
+ *
+ * Single-pass pull parser, no intermediate object tree.
+ * Unknown keys are skipped.
+ *
+ * @param json JSON text (need not be NUL-terminated)
+ * @param len Length of json in bytes
  * @param device Pointer to structure for filling
- * @param zig_obj_mp mp_obj_t representing the main zigbee object, for operations like adding to device_manager
  * @return esp_err_t in case of success
  */
-esp_err_t device_from_json(const cJSON *json, zigbee_device_t *device, mp_obj_t zig_obj_mp);
+esp_err_t device_from_json(const char *json, size_t len, zigbee_device_t *device);
 
 #endif
@@ -24,8 +24,8 @@ static int find_endpoint(zigbee_device_t *device, uint8_t endpoint) {
     return -1;
 }
 
-// Helper function to find a device by its IEEE address
-static zigbee_device_t* device_manager_find_by_ieee(const uint8_t ieee_addr[8]) {
+// Find a device by its IEEE address
+zigbee_device_t* device_manager_find_by_ieee(const uint8_t ieee_addr[8]) {
     for (int i = 0; i < device_list.device_count; i++) {
         if (memcmp(device_list.devices[i].ieee_addr, ieee_addr, 8) == 0) {
             return &device_list.devices[i];
@@ -51,6 +51,7 @@ static esp_err_t _create_device_internal(uint16_t new_short_addr, const uint8_t
     zigbee_device_t *new_dev = &device_list.devices[device_list.device_count];
     memset(new_dev, 0, sizeof(zigbee_device_t));
     new_dev->short_addr = new_short_addr;
+    new_dev->stored_addr = new_short_addr;
     memcpy(new_dev->ieee_addr, ieee_addr, sizeof(new_dev->ieee_addr));
     zigbee_format_ieee_addr_to_str(new_dev->ieee_addr, new_dev->ieee_addr_str, sizeof(new_dev->ieee_addr_str));
     new_dev->active = true;
@@ -75,20 +76,30 @@ esp_err_t device_manager_add(uint16_t new_short_addr, const uint8_t ieee_addr[8]
     if (device) {
         // Update existing device
         if (device->short_addr != new_short_addr) {
+            uint16_t old_short_addr = device->short_addr;
             zigbee_device_t *conflict = device_manager_get(new_short_addr);
             if (conflict && conflict != device) {
                 if (self && self->storage_cb != mp_const_none) {
                     device_storage_remove(self, conflict->short_addr);
                 }
                 device_manager_remove(conflict->short_addr);
+                // Removal shifts the list, look the device up again
+                device = device_manager_find_by_ieee(ieee_addr);
             }
             device->short_addr = new_short_addr;
+
+            // Address is part of the record and its file name: the save files it under the new
+            // address and then drops the old file (stored_addr). An index-only entry is read
+            // from the old file first, so the record is moved, not replaced by a skeleton.
+            if (self && self->storage_cb != mp_const_none) {
+                ESP_LOGD(LOG_TAG, "Device 0x%04x rejoined as 0x%04x%s", old_short_addr, new_short_addr,
+                         device->detail_pending ? ", record not read yet" : "");
+                device_storage_save(self, new_short_addr);
+            }
         }
+        // Plain rejoin only touches runtime state, nothing to persist
         device->active = true;
         device_manager_update_timestamp(new_short_addr);
-        if (self && self->storage_cb != mp_const_none) {
-            device_storage_save(self, new_short_addr);
-        }
         return ESP_OK;
     }
 
@@ -104,6 +115,66 @@ esp_err_t device_manager_add_new_device(uint16_t new_short_addr, const uint8_t i
     return _create_device_internal(new_short_addr, ieee_addr, NULL);
 }
 
+// Take over what a stored record holds, keep the live address and runtime state
+static void device_merge_record(zigbee_device_t *device, const zigbee_device_t *record) {
+    device->endpoint_count = record->endpoint_count;
+    memcpy(device->endpoints, record->endpoints, sizeof(device->endpoints));
+    memcpy(device->report_cfgs, record->report_cfgs, sizeof(device->report_cfgs));
+    memcpy(device->manufacturer_name, record->manufacturer_name, sizeof(device->manufacturer_name));
+    memcpy(device->model, record->model, sizeof(device->model));
+    memcpy(device->device_name, record->device_name, sizeof(device->device_name));
+    device->manufacturer_code = record->manufacturer_code;
+    device->prod_config_version = record->prod_config_version;
+    device->interview_complete = record->interview_complete;
+    device->desc_hash = record->desc_hash;
+    device->bind_hash = record->bind_hash;
+    device->storage_gen = record->storage_gen;
+
+    // Index-only entry: keep the volatile state applied at boot
+    if (!device->detail_pending) {
+        device->firmware_version = record->firmware_version;
+        device->power_source = record->power_source;
+        device->battery_voltage = record->battery_voltage;
+        device->battery_percentage = record->battery_percentage;
+        device->last_lqi = record->last_lqi;
+        device->last_rssi = record->last_rssi;
+    }
+}
+
+esp_err_t device_manager_restore(const zigbee_device_t *record) {
+    if (!record) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Known device: merge, its address may have changed by a rejoin since the record was written
+    zigbee_device_t *device = device_manager_find_by_ieee(record->ieee_addr);
+    if (device) {
+        device_merge_record(device, record);
+        device->detail_pending = record->detail_pending;
+        device->stored_addr = record->short_addr;
+        ESP_LOGD(LOG_TAG, "Restored device 0x%04x (gen %lu, filed as 0x%04x)", device->short_addr,
+                 (unsigned long)device->storage_gen, device->stored_addr);
+        return ESP_OK;
+    }
+
+    // New device, or a different device at this address: the record replaces the entry
+    device = device_manager_get(record->short_addr);
+    if (!device) {
+        if (device_list.device_count >= MAX_DEVICES) {
+            ESP_LOGE(LOG_TAG, "Restore failed: list full. Cannot add 0x%04x", record->short_addr);
+            return ESP_ERR_NO_MEM;
+        }
+        device = &device_list.devices[device_list.device_count++];
+    }
+    *device = *record;
+    device->stored_addr = record->short_addr;
+    zigbee_format_ieee_addr_to_str(device->ieee_addr, device->ieee_addr_str, sizeof(device->ieee_addr_str));
+    device->active = true;
+    device->last_seen = esp_timer_get_time() / 1000;
+    ESP_LOGD(LOG_TAG, "Restored device 0x%04x (gen %lu)", device->short_addr, (unsigned long)device->storage_gen);
+    return ESP_OK;
+}
+
 esp_err_t device_manager_remove(uint16_t short_addr) {
     // Find device
     int idx = -1;
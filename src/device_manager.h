@@ -33,6 +33,29 @@ esp_err_t device_manager_add(uint16_t new_short_addr, const uint8_t ieee_addr[8]
  */
 esp_err_t device_manager_add_new_device(uint16_t new_short_addr, const uint8_t ieee_addr[8], mp_obj_t zig_obj_mp);
 
+/**
+ * @brief Install a full device record loaded from storage
+ *
+ * A device with the same IEEE address takes over only what the record holds
+ * (endpoints, report configurations, names, interview state, generation) and
+ * keeps its current short address; stored_addr notes the address the record
+ * was filed under. An index-only entry (detail_pending) keeps its volatile
+ * fields. Otherwise the record replaces the entry with the same short address,
+ * or is added. Does not persist.
+ *
+ * @param record Device record parsed from storage
+ * @return esp_err_t ESP_ERR_NO_MEM if the list is full
+ */
+esp_err_t device_manager_restore(const zigbee_device_t *record);
+
+/**
+ * @brief Find a device by IEEE address
+ *
+ * @param ieee_addr IEEE address of device
+ * @return zigbee_device_t* Pointer to data structure or NULL
+ */
+zigbee_device_t* device_manager_find_by_ieee(const uint8_t ieee_addr[8]);
+
 /**
  * @brief Delete device
  * 
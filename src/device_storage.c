@@ -8,11 +8,15 @@
 #include "py/mpstate.h"
 #include "py/gc.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "esp_zigbee_core.h"
 
 #include "device_storage.h"
 #include "device_manager.h"
 #include "device_json.h"
-#include "cJSON.h"
+#include "device_storage_nvs.h"
+#include "main.h"
 
 // Safety macros
 #define CHECK_NULL(ptr, msg) do { \
@@ -56,16 +60,52 @@
 #define LOG_TAG "DEVICE_STORAGE"
 #define MAX_FILENAME_LEN 32
 #define MAX_SCHEDULE_RETRIES 5
+#define VOLATILE_FILENAME "volatile.dat"
+#define VOLATILE_LINE_MAX 64
+#define VOLATILE_BODY_MAX(count) (3 + (count) * VOLATILE_LINE_MAX)
+#define INDEX_FILENAME "index.dat"
 
 // Use external global pointer declared in main.h
 // This pointer is already registered as GC root in main.h
 // and protects the entire zigbee object and its callbacks from garbage collection
 extern mp_obj_t global_esp32_zig_obj_ptr;
 
+// Address a device's record is filed under; differs from short_addr after a rejoin until it is saved again
+static uint16_t record_addr(uint16_t short_addr) {
+    const zigbee_device_t *device = device_manager_get(short_addr);
+    return device ? device->stored_addr : short_addr;
+}
+
+// Install a loaded record. Once the stack runs, the Zigbee task updates the same entry (rejoins),
+// and a record filed under an old address is written again under the current one.
+static esp_err_t restore_record(const zigbee_device_t *record) {
+    bool locked = esp_zb_is_started();
+    if (locked) {
+        ZB_LOCK();
+    }
+    esp_err_t err = device_manager_restore(record);
+    uint16_t moved_addr = 0xFFFF;
+    const zigbee_device_t *device = device_manager_find_by_ieee(record->ieee_addr);
+    if (err == ESP_OK && device && !device->detail_pending && device->stored_addr != device->short_addr) {
+        moved_addr = device->short_addr;
+    }
+    if (locked) {
+        ZB_UNLOCK();
+    }
+    if (moved_addr != 0xFFFF) {
+        ESP_LOGI(LOG_TAG, "Record of 0x%04x filed as 0x%04x, moving", moved_addr, record->short_addr);
+        device_storage_save((esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr), moved_addr);
+    }
+    return err;
+}
+
 // Forward declarations
 static mp_obj_t do_device_save_handler(mp_obj_t short_addr_obj);
 static mp_obj_t do_device_remove_handler(mp_obj_t short_addr_obj);
 static mp_obj_t do_load_all_handler(mp_obj_t ctx_in);
+static void volatile_load(mp_obj_t storage_cb);
+static size_t index_load(mp_obj_t storage_cb);
+static void index_save(mp_obj_t storage_cb);
 void device_storage_update_callback(void);
 
 // Declare function objects after forward declarations
@@ -81,8 +121,13 @@ typedef struct {
     size_t file_count;
     size_t current_index;
     int retry_count;
+    int64_t start_us;      // esp_timer timestamp when loading started
+    bool index_ready;      // Devices known from the index, files only add detail
 } load_all_ctx_t;
 
+// File list of a running load; ctx is malloc'ed, so the list is kept reachable for GC here
+MP_REGISTER_ROOT_POINTER(mp_obj_t zig_storage_files);
+
 // Add structure for save event
 typedef struct {
     uint16_t short_addr;
@@ -95,6 +140,125 @@ static QueueHandle_t save_event_queue = NULL;
 // Add semaphore for device loading synchronization
 static SemaphoreHandle_t device_load_complete_semaphore = NULL;
 
+// Statistics of the last startup load
+static device_storage_stats_t storage_stats = {0};
+
+// storage="nvs": records go to the NVS backend, storage_cb only marks storage as enabled
+static bool storage_nvs = false;
+
+// Device index changed since it was last written (written with the volatile flush)
+static bool index_dirty = false;
+
+// Per-save latency, callback or NVS, for comparing the backends
+static void save_stats_account(int64_t start_us) {
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start_us);
+    storage_stats.save_count++;
+    storage_stats.save_us_total += us;
+    if (us > storage_stats.save_us_max) {
+        storage_stats.save_us_max = us;
+    }
+}
+
+// Record envelope: "ZR1 <generation> <crc32 hex> <json length>\n{json}".
+// Files starting with '{' are legacy records without envelope (generation 0).
+#define RECORD_MAGIC "ZR1"
+#define RECORD_HEADER_MAX 40
+
+// Validate envelope and return pointer to the JSON body, NULL if truncated or corrupt
+static const char *device_record_unwrap(const char *data, size_t len, uint32_t *gen, size_t *json_len) {
+    if (len > 0 && data[0] == '{') {
+        *gen = 0;
+        *json_len = len;
+        return data;
+    }
+
+    unsigned long hdr_gen, hdr_crc;
+    unsigned int hdr_len;
+    int consumed = 0;
+    if (len < sizeof(RECORD_MAGIC) ||
+        sscanf(data, RECORD_MAGIC " %lu %lx %u\n%n", &hdr_gen, &hdr_crc, &hdr_len, &consumed) != 3 ||
+        consumed == 0 || consumed > RECORD_HEADER_MAX) {
+        return NULL;
+    }
+
+    const char *body = data + consumed;
+    if ((size_t)consumed + hdr_len != len) {
+        ESP_LOGW(LOG_TAG, "Record length mismatch: header %u, body %u", hdr_len, (unsigned)(len - consumed));
+        return NULL;
+    }
+    if (esp_rom_crc32_le(0, (const uint8_t *)body, hdr_len) != (uint32_t)hdr_crc) {
+        return NULL;
+    }
+
+    *gen = (uint32_t)hdr_gen;
+    *json_len = hdr_len;
+    return body;
+}
+
+// Put the envelope header in front of a body written at vstr.buf + RECORD_HEADER_MAX
+static mp_obj_t record_seal(vstr_t *vstr, size_t body_len, uint32_t gen) {
+    char *body = vstr->buf + RECORD_HEADER_MAX;
+    char header[RECORD_HEADER_MAX + 1];
+    int hdr_len = snprintf(header, sizeof(header), RECORD_MAGIC " %lu %08lx %u\n",
+                           (unsigned long)gen,
+                           (unsigned long)esp_rom_crc32_le(0, (const uint8_t *)body, body_len),
+                           (unsigned)body_len);
+
+    memmove(vstr->buf + hdr_len, body, body_len);
+    memcpy(vstr->buf, header, hdr_len);
+    vstr->len = hdr_len + body_len;
+    return mp_obj_new_str_from_vstr(vstr);
+}
+
+// Serialize device inside the envelope straight into a Python string
+static mp_obj_t device_record_wrap(const zigbee_device_t *device) {
+    size_t json_len = device_to_json(device, NULL, 0);
+    if (json_len == 0) {
+        return mp_const_none;
+    }
+
+    // JSON is written after a reserved header area, then the real header is placed in front of it
+    vstr_t vstr;
+    vstr_init_len(&vstr, RECORD_HEADER_MAX + json_len);
+    device_to_json(device, vstr.buf + RECORD_HEADER_MAX, json_len + 1);
+    return record_seal(&vstr, json_len, device->storage_gen);
+}
+
+// Read a single-file record and its .tmp sibling, return the body of the newest valid one.
+// The body points into *keep, which the caller holds on to while using it.
+static const char *record_load_newest(mp_obj_t storage_cb, const char *name, const char *magic,
+                                      size_t *len, uint32_t *gen, mp_obj_t *keep) {
+    const char *best_body = NULL;
+    size_t magic_len = strlen(magic);
+
+    for (int i = 0; i < 2; i++) {
+        char filename[MAX_FILENAME_LEN];
+        snprintf(filename, sizeof(filename), i ? "%s.tmp" : "%s", name);
+
+        mp_obj_t args[2] = {mp_obj_new_str("load", 4), mp_obj_new_str(filename, strlen(filename))};
+        mp_obj_t data = mp_call_function_n_kw(storage_cb, 2, 0, args);
+        if (data == mp_const_none || !MP_OBJ_IS_STR(data)) {
+            continue;
+        }
+
+        size_t record_len, body_len;
+        uint32_t body_gen;
+        const char *record = mp_obj_str_get_data(data, &record_len);
+        const char *body = device_record_unwrap(record, record_len, &body_gen, &body_len);
+        if (!body || body_len < magic_len || memcmp(body, magic, magic_len) != 0) {
+            ESP_LOGW(LOG_TAG, "Ignoring corrupt record %s", filename);
+            continue;
+        }
+        if (!best_body || body_gen > *gen) {
+            *keep = data;
+            best_body = body;
+            *len = body_len;
+            *gen = body_gen;
+        }
+    }
+    return best_body;
+}
+
 // Initialize event queue
 esp_err_t device_storage_init(void) {
     // Initialize queue if not already initialized
@@ -300,18 +464,29 @@ static mp_obj_t do_device_save_handler(mp_obj_t short_addr_obj) {
         return mp_const_none;
     }
 
-    // Create JSON
-    cJSON *json = device_to_json(dev);
-    if (!json) {
-        ESP_LOGE(LOG_TAG, "Failed to create JSON for device 0x%04x", (uint16_t)short_addr);
+    // Never overwrite a record with an index-only entry: read the detail first, from wherever it is filed
+    if (dev->detail_pending && device_storage_ensure_detail(dev->short_addr) != ESP_OK) {
+        ESP_LOGW(LOG_TAG, "Device 0x%04x has no stored detail, saving what is known", (uint16_t)short_addr);
+        dev->detail_pending = false;
+    }
+
+    // Every save gets a new generation so the newest copy wins at load time
+    dev->storage_gen++;
+
+    int64_t start_us = esp_timer_get_time();
+    if (storage_nvs) {
+        // Keyed by IEEE address, a rejoin leaves nothing behind
+        if (device_storage_nvs_save(dev) == ESP_OK) {
+            dev->stored_addr = dev->short_addr;
+        }
+        save_stats_account(start_us);
         return mp_const_none;
     }
 
-    char *json_str = cJSON_PrintUnformatted(json);
-    cJSON_Delete(json);
-    
-    if (!json_str) {
-        ESP_LOGE(LOG_TAG, "Failed to print JSON for device 0x%04x", (uint16_t)short_addr);
+    // Create record straight into a Python string
+    mp_obj_t json_str = device_record_wrap(dev);
+    if (json_str == mp_const_none) {
+        ESP_LOGE(LOG_TAG, "Failed to create JSON for device 0x%04x", (uint16_t)short_addr);
         return mp_const_none;
     }
 
@@ -323,15 +498,27 @@ static mp_obj_t do_device_save_handler(mp_obj_t short_addr_obj) {
     mp_obj_t args[3] = {
         mp_obj_new_str("save", 4),
         mp_obj_new_str(filename, strlen(filename)),
-        mp_obj_new_str(json_str, strlen(json_str))
+        json_str
     };
 
     // Call callback
     mp_obj_t result = mp_call_function_n_kw(zig_self->storage_cb, 3, 0, args);
-    SAFE_FREE(json_str);
+    save_stats_account(start_us);
+    index_dirty = true;
 
     if (result == mp_const_none) {
         ESP_LOGW(LOG_TAG, "Storage callback returned None for device 0x%04x", (uint16_t)short_addr);
+        return mp_const_none;
+    }
+
+    // Rejoined at a new address: drop the file under the old one, unless another device holds it by now
+    dev = device_manager_get((uint16_t)short_addr);
+    if (dev && dev->stored_addr != dev->short_addr) {
+        uint16_t old_addr = dev->stored_addr;
+        dev->stored_addr = dev->short_addr;
+        if (!device_manager_get(old_addr)) {
+            device_storage_remove_now(old_addr);
+        }
     }
 
     return mp_const_none;
@@ -356,6 +543,15 @@ void device_storage_update_callback(void) {
 
 // Function to set callback
 void device_storage_set_callback(mp_obj_t cb) {
+    storage_nvs = mp_obj_is_str(cb) && strcmp(mp_obj_str_get_str(cb), "nvs") == 0;
+    if (storage_nvs && device_storage_nvs_open() != ESP_OK) {
+        storage_nvs = false;
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Failed to open NVS device storage"));
+    }
+    if (cb != mp_const_none && !storage_nvs && !mp_obj_is_callable(cb)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("storage must be a callable or \"nvs\""));
+    }
+
     if (cb != mp_const_none) {
         esp32_zig_obj_t *zig_self = (esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr);
         if (zig_self) {
@@ -364,7 +560,131 @@ void device_storage_set_callback(mp_obj_t cb) {
     }
 }
 
-// Single handler for loading all devices
+// Unwrap and parse one stored record into device (generation included)
+static esp_err_t parse_device_record(const char *filename, mp_obj_t json_str, zigbee_device_t *device) {
+    if (json_str == mp_const_none || !MP_OBJ_IS_STR(json_str)) {
+        ESP_LOGE(LOG_TAG, "No JSON data in %s", filename);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    size_t record_len;
+    const char *record = mp_obj_str_get_data(json_str, &record_len);
+
+    uint32_t gen = 0;
+    size_t json_len = 0;
+    const char *json_data = device_record_unwrap(record, record_len, &gen, &json_len);
+    if (!json_data) {
+        ESP_LOGE(LOG_TAG, "Corrupt record %s (bad header, length or CRC)", filename);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    esp_err_t err = device_from_json(json_data, json_len, device);
+    if (err != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Failed to parse JSON in %s", filename);
+        return err;
+    }
+    device->storage_gen = gen;
+    return ESP_OK;
+}
+
+// Parse one stored record and register the device without persisting it again.
+// Returns ESP_ERR_INVALID_VERSION when a newer copy of the device is already loaded.
+static esp_err_t load_device_record(const char *filename, mp_obj_t json_str, mp_obj_t zig_obj_mp) {
+    (void)zig_obj_mp;
+    uint16_t short_addr;
+    if (sscanf(filename, "%04hx.json", &short_addr) != 1) {
+        ESP_LOGW(LOG_TAG, "Invalid filename format: %s", filename);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    zigbee_device_t device = {0};
+    esp_err_t err = parse_device_record(filename, json_str, &device);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Newest valid copy wins (file and its .tmp sibling may both exist after a power cut)
+    // An index-only entry is always replaced by the first valid record. Looked up by IEEE:
+    // the device may have rejoined at another address while records were still loading.
+    zigbee_device_t *existing = device_manager_find_by_ieee(device.ieee_addr);
+    if (existing && !existing->detail_pending && existing->storage_gen >= device.storage_gen) {
+        ESP_LOGD(LOG_TAG, "Skipping %s: gen %lu, loaded gen %lu", filename,
+                 (unsigned long)device.storage_gen, (unsigned long)existing->storage_gen);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    err = restore_record(&device);
+    if (err != ESP_OK) {
+        return err;
+    }
+    ESP_LOGD(LOG_TAG, "Loaded device 0x%04x gen %lu from %s", short_addr,
+             (unsigned long)device.storage_gen, filename);
+    return ESP_OK;
+}
+
+// Count the outcome of one load attempt in the startup statistics
+static void load_stats_account(esp_err_t err) {
+    if (err == ESP_OK) {
+        storage_stats.load_ok++;
+    } else if (err == ESP_ERR_INVALID_VERSION) {
+        storage_stats.load_stale++;
+    } else {
+        storage_stats.load_failed++;
+    }
+}
+
+// Devices are known: apply volatile state and let the commissioning task go on
+static void load_index_ready(load_all_ctx_t *ctx) {
+    if (storage_stats.load_ok > 0 || storage_stats.index_records > 0) {
+        volatile_load(ctx->storage_cb_obj);
+    }
+
+    storage_stats.index_ms = (uint32_t)((esp_timer_get_time() - ctx->start_us) / 1000);
+    ctx->index_ready = true;
+
+    // Semaphore is kept alive: the commissioning task may still be blocked on it
+    if (device_load_complete_semaphore) {
+        xSemaphoreGive(device_load_complete_semaphore);
+    }
+}
+
+// Record timing, signal the commissioning task and release the context
+static mp_obj_t load_all_finish(load_all_ctx_t *ctx) {
+    if (!ctx->index_ready) {
+        load_index_ready(ctx);
+        index_dirty = !storage_nvs && storage_stats.load_ok > 0;
+    } else {
+        // Index entries without a loadable record are dropped, as a missing file always was
+        size_t count;
+        zigbee_device_t *devices = device_manager_get_list(&count);
+        for (size_t i = count; i-- > 0;) {
+            if (devices[i].detail_pending) {
+                ESP_LOGW(LOG_TAG, "Device 0x%04x listed in index has no record, dropped", devices[i].short_addr);
+                device_manager_remove(devices[i].short_addr);
+                index_dirty = true;
+            }
+        }
+    }
+    if (index_dirty) {
+        index_save(ctx->storage_cb_obj);
+    }
+
+    storage_stats.load_ms = (uint32_t)((esp_timer_get_time() - ctx->start_us) / 1000);
+    storage_stats.load_done = true;
+    ESP_LOGI(LOG_TAG, "Startup load: %u/%u devices in %u ms (%u failed, index %u in %u ms)",
+             (unsigned)storage_stats.load_ok, (unsigned)storage_stats.load_records,
+             (unsigned)storage_stats.load_ms, (unsigned)storage_stats.load_failed,
+             (unsigned)storage_stats.index_records, (unsigned)storage_stats.index_ms);
+
+    MP_STATE_PORT(zig_storage_files) = MP_OBJ_NULL;
+    ctx->storage_cb_obj = ctx->zig_obj_mp = NULL;
+    SAFE_FREE(ctx);
+    return mp_const_none;
+}
+
+// Single handler for loading all devices.
+// First run lists the files and asks the callback for all of them at once ("load_many").
+// Callbacks without "load_many" fall back to one "load" per scheduler round.
 static mp_obj_t do_load_all_handler(mp_obj_t ctx_in) {
     // Check input parameter
     if (ctx_in == mp_const_none) {
@@ -386,12 +706,13 @@ static mp_obj_t do_load_all_handler(mp_obj_t ctx_in) {
     
     // Update pointer to current callback location
     device_storage_update_callback();
-    
-    bool success = false;
-    cJSON *json = NULL;
-    mp_obj_t *files = NULL;
-    size_t file_count = 0;
-    
+
+    // NVS backend: iterate the namespace directly, no file list
+    if (storage_nvs) {
+        storage_stats.load_ok = device_storage_nvs_load_all(&storage_stats.load_records, &storage_stats.load_failed);
+        return load_all_finish(ctx);
+    }
+
     // Get file list on first run
     if (ctx->current_index == 0 && ctx->retry_count == 0) {
         mp_obj_t list_cmd = mp_obj_new_str("list", 4);
@@ -400,19 +721,53 @@ static mp_obj_t do_load_all_handler(mp_obj_t ctx_in) {
 
         if (file_list == mp_const_none) {
             ESP_LOGE(LOG_TAG, "Failed to get file list");
-            ctx->storage_cb_obj = ctx->zig_obj_mp = NULL;
-            SAFE_FREE(ctx);
-            return mp_const_none;
+            return load_all_finish(ctx);
         }
 
+        size_t file_count = 0;
+        mp_obj_t *files = NULL;
         mp_obj_get_array(file_list, &file_count, &files);
+        storage_stats.load_records = file_count;
         if (file_count == 0) {
             ESP_LOGD(LOG_TAG, "No files to load");
-            ctx->storage_cb_obj = ctx->zig_obj_mp = NULL;
-            SAFE_FREE(ctx);
-            return mp_const_none;
+            return load_all_finish(ctx);
+        }
+        MP_STATE_PORT(zig_storage_files) = file_list;
+
+        // Index first: the network can start right away, records follow one per scheduler round
+        storage_stats.index_records = index_load(ctx->storage_cb_obj);
+        if (storage_stats.index_records > 0) {
+            load_index_ready(ctx);
+        }
+
+        // No index: bulk read, all records in one callback, parsed in one pass
+        mp_obj_t records = mp_const_none;
+        if (!ctx->index_ready) {
+            mp_obj_t many_args[2] = {mp_obj_new_str("load_many", 9), file_list};
+            records = mp_call_function_n_kw(ctx->storage_cb_obj, 2, 0, many_args);
+        }
+        if (records != mp_const_none) {
+            size_t record_count = 0;
+            mp_obj_t *items = NULL;
+            mp_obj_get_array(records, &record_count, &items);
+            if (record_count != file_count) {
+                ESP_LOGW(LOG_TAG, "load_many returned %u records for %u files",
+                         (unsigned)record_count, (unsigned)file_count);
+            }
+            for (size_t i = 0; i < file_count; i++) {
+                mp_obj_t data = i < record_count ? items[i] : mp_const_none;
+                if (MP_OBJ_IS_STR(files[i])) {
+                    load_stats_account(load_device_record(mp_obj_str_get_str(files[i]), data, ctx->zig_obj_mp));
+                } else {
+                    storage_stats.load_failed++;
+                }
+            }
+            return load_all_finish(ctx);
         }
 
+        if (!ctx->index_ready) {
+            ESP_LOGD(LOG_TAG, "Storage callback has no load_many, loading files one by one");
+        }
         // Save the list of files in the context
         ctx->files = files;
         ctx->file_count = file_count;
@@ -420,77 +775,35 @@ static mp_obj_t do_load_all_handler(mp_obj_t ctx_in) {
 
     // If there is a file to load
     if (ctx->current_index < ctx->file_count) {
-        // Add GC protection for the file object
         mp_obj_t file_obj = ctx->files[ctx->current_index];
         if (!MP_OBJ_IS_STR(file_obj)) {
             ESP_LOGE(LOG_TAG, "Invalid file object type at index %d", ctx->current_index);
+            storage_stats.load_failed++;
             goto next_file;
         }
         
         const char *filename = mp_obj_str_get_str(file_obj);
-        if (!filename) {
-            ESP_LOGE(LOG_TAG, "Invalid filename at index %d", ctx->current_index);
-            goto next_file;
-        }
-
-        uint16_t short_addr;
-        if (sscanf(filename, "%04hx.json", &short_addr) != 1) {
-            ESP_LOGW(LOG_TAG, "Invalid filename format: %s", filename);
-            goto next_file;
-        }
 
         // Load device
-        mp_obj_t load_cmd = mp_obj_new_str("load", 4);
-        mp_obj_t fname = mp_obj_new_str(filename, strlen(filename));
-        if (!load_cmd || !fname) {
-            ESP_LOGE(LOG_TAG, "Failed to create command objects");
-            goto next_file;
-        }
-        
-        mp_obj_t load_args[2] = {load_cmd, fname};
+        mp_obj_t load_args[2] = {mp_obj_new_str("load", 4), mp_obj_new_str(filename, strlen(filename))};
         mp_obj_t json_str = mp_call_function_n_kw(ctx->storage_cb_obj, 2, 0, load_args);
 
-        if (json_str != mp_const_none) {
-            if (!MP_OBJ_IS_STR(json_str)) {
-                ESP_LOGE(LOG_TAG, "Invalid JSON string type for device 0x%04x", short_addr);
-                goto next_file;
-            }
-            
-            const char *json_data = mp_obj_str_get_str(json_str);
-            if (!json_data) {
-                ESP_LOGE(LOG_TAG, "Invalid JSON data for device 0x%04x", short_addr);
-                goto next_file;
-            }
-
-            json = cJSON_Parse(json_data);
-            if (!json) {
-                ESP_LOGE(LOG_TAG, "Failed to parse JSON for device 0x%04x", short_addr);
-                goto next_file;
-            }
-            
-            zigbee_device_t device = {0};
-            if (device_from_json(json, &device, ctx->zig_obj_mp) == ESP_OK) {
-                device_manager_add_new_device(device.short_addr, device.ieee_addr, ctx->zig_obj_mp);
-                device_manager_update(&device);
-                success = true;
-                ESP_LOGD(LOG_TAG, "Loaded device 0x%04x from %s", short_addr, filename);
-            }
-            cJSON_Delete(json);
-        }
-
-        if (!success) {
+        esp_err_t err = load_device_record(filename, json_str, ctx->zig_obj_mp);
+        if (err != ESP_ERR_NOT_FOUND) {
+            // Parsed, stale or corrupt: retrying will not change the outcome
+            load_stats_account(err);
+        } else {
             ctx->retry_count++;
             if (ctx->retry_count < MAX_SCHEDULE_RETRIES) {
                 ESP_LOGW(LOG_TAG, "Load failed for %s, retry %d/%d", filename, ctx->retry_count, MAX_SCHEDULE_RETRIES);
                 if (!mp_sched_schedule((mp_obj_t)&do_load_all_handler_obj, MP_OBJ_FROM_PTR(ctx))) {
                     ESP_LOGE(LOG_TAG, "Failed to schedule retry for %s", filename);
-                    ctx->storage_cb_obj = ctx->zig_obj_mp = NULL;
-                    SAFE_FREE(ctx);
-                    return mp_const_none;
+                    return load_all_finish(ctx);
                 }
                 return mp_const_none;
             }
             ESP_LOGE(LOG_TAG, "Failed to load %s after %d retries", filename, MAX_SCHEDULE_RETRIES);
+            storage_stats.load_failed++;
         }
 
 next_file:
@@ -502,28 +815,14 @@ next_file:
         if (ctx->current_index < ctx->file_count) {
             if (!mp_sched_schedule((mp_obj_t)&do_load_all_handler_obj, MP_OBJ_FROM_PTR(ctx))) {
                 ESP_LOGE(LOG_TAG, "Failed to schedule next file load");
-                ctx->storage_cb_obj = ctx->zig_obj_mp = NULL;
-                SAFE_FREE(ctx);
-                return mp_const_none;
+                return load_all_finish(ctx);
             }
             return mp_const_none;
         }
     }
 
     ESP_LOGD(LOG_TAG, "Load all completed");
-    // Signal that loading is complete and delete semaphore
-    if (device_load_complete_semaphore) {
-        xSemaphoreGive(device_load_complete_semaphore);
-        ESP_LOGD(LOG_TAG, "Device load complete semaphore given");
-        vSemaphoreDelete(device_load_complete_semaphore);
-        device_load_complete_semaphore = NULL;
-        ESP_LOGD(LOG_TAG, "Device load semaphore deleted");
-    }
-
-    // Clear the context
-    ctx->storage_cb_obj = ctx->zig_obj_mp = NULL;
-    SAFE_FREE(ctx);
-    return mp_const_none;
+    return load_all_finish(ctx);
 }
 
 esp_err_t device_storage_load_all(esp32_zig_obj_t *self) {
@@ -564,6 +863,10 @@ esp_err_t device_storage_load_all(esp32_zig_obj_t *self) {
     ctx->file_count = 0;
     ctx->current_index = 0;
     ctx->retry_count = 0;
+    ctx->start_us = esp_timer_get_time();
+
+    memset(&storage_stats, 0, sizeof(storage_stats));
+    xSemaphoreTake(device_load_complete_semaphore, 0);  // Drop a stale completion from a previous run
 
     // Schedule loading
     if (!mp_sched_schedule((mp_obj_t)&do_load_all_handler_obj, MP_OBJ_FROM_PTR(ctx))) {
@@ -606,6 +909,11 @@ static mp_obj_t do_device_remove_handler(mp_obj_t short_addr_obj) {
         return mp_const_none;
     }
     
+    if (storage_nvs) {
+        device_storage_nvs_remove((uint16_t)short_addr);
+        return mp_const_none;
+    }
+
     char filename[MAX_FILENAME_LEN];
     snprintf(filename, sizeof(filename), "%04hx.json", (uint16_t)short_addr);
     
@@ -614,6 +922,7 @@ static mp_obj_t do_device_remove_handler(mp_obj_t short_addr_obj) {
     
     mp_obj_t args[2] = {remove_cmd, filename_obj};
     mp_obj_t result = mp_call_function_n_kw(zig_self->storage_cb, 2, 0, args);
+    index_dirty = true;
     
     if (result == mp_const_none) {
         ESP_LOGW(LOG_TAG, "Remove callback returned None for device 0x%04x", (uint16_t)short_addr);
@@ -636,8 +945,8 @@ esp_err_t device_storage_remove(esp32_zig_obj_t *self, uint16_t short_addr) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Schedule execution in Python context with just short_addr
-    mp_obj_t short_addr_obj = mp_obj_new_int(short_addr);
+    // Schedule execution in Python context with the address the record is filed under
+    mp_obj_t short_addr_obj = mp_obj_new_int(record_addr(short_addr));
     if (!short_addr_obj) {
         ESP_LOGE(LOG_TAG, "Failed to create short_addr object");
         return ESP_ERR_NO_MEM;
@@ -652,6 +961,21 @@ esp_err_t device_storage_remove(esp32_zig_obj_t *self, uint16_t short_addr) {
     return ESP_OK;
 }
 
+// Synchronous variants for callers already in Python context (snapshot import):
+// a bulk restore would overflow the save queue and the scheduler
+esp_err_t device_storage_save_now(uint16_t short_addr) {
+    if (!device_manager_get(short_addr)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    do_device_save_handler(mp_obj_new_int(short_addr));
+    return ESP_OK;
+}
+
+esp_err_t device_storage_remove_now(uint16_t short_addr) {
+    do_device_remove_handler(mp_obj_new_int(record_addr(short_addr)));
+    return ESP_OK;
+}
+
 // Function to load a single device from storage callback
 esp_err_t device_storage_load(esp32_zig_obj_t *self, uint16_t short_addr) {
     // Check input parameters
@@ -665,70 +989,489 @@ esp_err_t device_storage_load(esp32_zig_obj_t *self, uint16_t short_addr) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Generate filename
-    char filename[MAX_FILENAME_LEN];
-    snprintf(filename, sizeof(filename), "%04hx.json", short_addr);
+    // A known device is only given its own record, wherever it is filed
+    const zigbee_device_t *known = device_manager_get(short_addr);
+    uint8_t known_ieee[8];
+    if (known) {
+        memcpy(known_ieee, known->ieee_addr, sizeof(known_ieee));
+    }
+    uint16_t file_addr = known ? known->stored_addr : short_addr;
 
-    // Load file through callback
-    mp_obj_t load_cmd = mp_obj_new_str("load", 4);
-    mp_obj_t fname = mp_obj_new_str(filename, strlen(filename));
-    if (!load_cmd || !fname) {
-        ESP_LOGE(LOG_TAG, "Failed to create command objects");
-        return ESP_ERR_NO_MEM;
+    zigbee_device_t device = {0};
+    if (storage_nvs) {
+        esp_err_t err = device_storage_nvs_load(short_addr, &device);
+        if (err == ESP_OK) {
+            err = restore_record(&device);
+        }
+        return err;
     }
 
-    mp_obj_t args[2] = {load_cmd, fname};
-    mp_obj_t json_str = mp_call_function_n_kw(self->storage_cb, 2, 0, args);
+    // The record and its .tmp sibling (left by an interrupted save) are both candidates
+    static const char *const patterns[] = { "%04hx.json", "%04hx.json.tmp" };
+    mp_obj_t candidates[2] = { mp_const_none, mp_const_none };
+    int best = -1;
+    uint32_t best_gen = 0;
+
+    for (int i = 0; i < 2; i++) {
+        char filename[MAX_FILENAME_LEN];
+        snprintf(filename, sizeof(filename), patterns[i], file_addr);
+
+        // Load file through callback
+        mp_obj_t args[2] = {mp_obj_new_str("load", 4), mp_obj_new_str(filename, strlen(filename))};
+        candidates[i] = mp_call_function_n_kw(self->storage_cb, 2, 0, args);
+        if (candidates[i] == mp_const_none) {
+            continue;
+        }
 
-    if (json_str == mp_const_none) {
-        ESP_LOGE(LOG_TAG, "Failed to load device 0x%04x", short_addr);
-        return ESP_ERR_NOT_FOUND;
+        if (parse_device_record(filename, candidates[i], &device) == ESP_OK &&
+            (!known || memcmp(device.ieee_addr, known_ieee, sizeof(known_ieee)) == 0) &&
+            (best < 0 || device.storage_gen > best_gen)) {
+            best = i;
+            best_gen = device.storage_gen;
+        }
     }
 
-    // Parse JSON
-    const char *json_data = mp_obj_str_get_str(json_str);
-    if (!json_data) {
-        ESP_LOGE(LOG_TAG, "Invalid JSON data for device 0x%04x", short_addr);
-        return ESP_ERR_INVALID_STATE;
+    if (best < 0) {
+        ESP_LOGE(LOG_TAG, "Failed to load device 0x%04x", short_addr);
+        return ESP_ERR_NOT_FOUND;
     }
 
-    cJSON *json = cJSON_Parse(json_data);
-    if (!json) {
-        ESP_LOGE(LOG_TAG, "Failed to parse JSON for device 0x%04x", short_addr);
-        return ESP_ERR_INVALID_STATE;
+    // Re-parse the winner (device holds the last parsed candidate)
+    char filename[MAX_FILENAME_LEN];
+    snprintf(filename, sizeof(filename), patterns[best], file_addr);
+    esp_err_t err = parse_device_record(filename, candidates[best], &device);
+    if (err != ESP_OK) {
+        return err;
     }
 
-    // Create temporary device and fill it with data
-    zigbee_device_t device = {0};
-    esp_err_t err = device_from_json(json, &device, MP_OBJ_FROM_PTR(self));
-    cJSON_Delete(json);
-
+    // Install full record in manager
+    err = restore_record(&device);
     if (err != ESP_OK) {
-        ESP_LOGE(LOG_TAG, "Failed to parse device data for 0x%04x: %s",
-                 short_addr, esp_err_to_name(err));
         return err;
     }
-
-    // Update device in manager
-    device_manager_update(&device);
-    ESP_LOGD(LOG_TAG, "Device 0x%04x loaded successfully", short_addr);
+    ESP_LOGD(LOG_TAG, "Device 0x%04x loaded successfully (gen %lu)", short_addr, (unsigned long)best_gen);
     return ESP_OK;
 }
 
-// Function to wait for device loading to complete
+// Statistics of the last startup load
+const device_storage_stats_t *device_storage_get_stats(void) {
+    storage_stats.nvs = storage_nvs;
+    return &storage_stats;
+}
+
+// Time budget for the startup load: fixed base plus a per-record allowance
+TickType_t device_storage_load_budget(TickType_t base) {
+    return base + pdMS_TO_TICKS(storage_stats.load_records * DEVICE_STORAGE_LOAD_MS_PER_RECORD);
+}
+
+// Function to wait for device loading to complete.
+// The deadline grows once the file list is known, so large tables are not cut off.
 esp_err_t device_storage_wait_load_complete(TickType_t timeout) {
     if (!device_load_complete_semaphore) {
         ESP_LOGE(LOG_TAG, "Device load semaphore not initialized");
         return ESP_ERR_INVALID_STATE;
     }
 
-    if (xSemaphoreTake(device_load_complete_semaphore, timeout) != pdTRUE) {
-        ESP_LOGW(LOG_TAG, "Timeout waiting for device load to complete");
-        return ESP_ERR_TIMEOUT;
+    TickType_t start = xTaskGetTickCount();
+    while ((xTaskGetTickCount() - start) < device_storage_load_budget(timeout)) {
+        if (xSemaphoreTake(device_load_complete_semaphore, pdMS_TO_TICKS(100)) == pdTRUE) {
+            ESP_LOGD(LOG_TAG, "Device load complete semaphore taken");
+            return ESP_OK;
+        }
+    }
+
+    ESP_LOGW(LOG_TAG, "Timeout waiting for device load to complete (%u records known)",
+             (unsigned)storage_stats.load_records);
+    return ESP_ERR_TIMEOUT;
+}
+
+// ---------------------------------------------------------------------------
+// Volatile state tier.
+// Battery, power source, firmware and link quality change often and are kept out
+// of the device record. They are collected in one compact record that is written
+// on a timer (or on demand), using the same envelope as device records:
+//   V1\n
+//   <ieee hex> <power_source> <firmware> <bat_voltage> <bat_percent> <lqi> <rssi>\n ...
+// last_seen/active are uptime based and stay in RAM only.
+// ---------------------------------------------------------------------------
+
+static esp_timer_handle_t volatile_timer = NULL;
+static uint32_t volatile_gen = 0;
+
+static mp_obj_t do_volatile_flush_handler(mp_obj_t force_obj);
+static MP_DEFINE_CONST_FUN_OBJ_1(do_volatile_flush_handler_obj, do_volatile_flush_handler);
+
+void device_storage_mark_volatile(uint16_t short_addr) {
+    zigbee_device_t *device = device_manager_get(short_addr);
+    if (device) {
+        device->volatile_dirty = true;
+    }
+}
+
+// Python context; the Zigbee task marks devices dirty once the stack runs
+static bool volatile_any_dirty(void) {
+    if (index_dirty) {
+        return true;
+    }
+    bool dirty = false;
+    bool locked = esp_zb_is_started();
+    if (locked) {
+        ZB_LOCK();
+    }
+    size_t count;
+    zigbee_device_t *devices = device_manager_get_list(&count);
+    for (size_t i = 0; i < count && !dirty; i++) {
+        dirty = devices[i].volatile_dirty;
+    }
+    if (locked) {
+        ZB_UNLOCK();
+    }
+    return dirty;
+}
+
+// esp_timer task context: only hand over to the MicroPython scheduler,
+// the handler checks for dirty devices itself
+static void volatile_timer_cb(void *arg) {
+    (void)arg;
+    mp_sched_schedule((mp_obj_t)&do_volatile_flush_handler_obj, mp_const_false);
+}
+
+size_t device_storage_volatile_size(void) {
+    size_t count;
+    device_manager_get_list(&count);
+    return VOLATILE_BODY_MAX(count);
+}
+
+size_t device_storage_volatile_write(char *body, size_t cap) {
+    size_t count;
+    const zigbee_device_t *devices = device_manager_get_list(&count);
+    size_t len = snprintf(body, cap, "V1\n");
+
+    for (size_t i = 0; i < count && len < cap; i++) {
+        const zigbee_device_t *d = &devices[i];
+        len += snprintf(body + len, cap - len,
+                        "%02x%02x%02x%02x%02x%02x%02x%02x %u %u %u %u %u %d\n",
+                        d->ieee_addr[7], d->ieee_addr[6], d->ieee_addr[5], d->ieee_addr[4],
+                        d->ieee_addr[3], d->ieee_addr[2], d->ieee_addr[1], d->ieee_addr[0],
+                        d->power_source, d->firmware_version, d->battery_voltage,
+                        d->battery_percentage, d->last_lqi, d->last_rssi);
+    }
+    return len < cap ? len : cap - 1;
+}
+
+size_t device_storage_volatile_apply(const char *body, size_t body_len) {
+    if (body_len < 3 || memcmp(body, "V1\n", 3) != 0) {
+        return 0;
+    }
+
+    size_t count;
+    zigbee_device_t *devices = device_manager_get_list(&count);
+    size_t applied = 0;
+    const char *line = body + 3;
+    const char *end = body + body_len;
+
+    while (line < end) {
+        const char *eol = memchr(line, '\n', end - line);
+        if (!eol) {
+            break;
+        }
+
+        char buf[VOLATILE_LINE_MAX];
+        size_t n = eol - line;
+        if (n < sizeof(buf)) {
+            memcpy(buf, line, n);
+            buf[n] = '\0';
+
+            uint8_t ieee[8];
+            unsigned power, fw, bat_v, bat_p, lqi;
+            int rssi;
+            if (sscanf(buf, "%2hhx%2hhx%2hhx%2hhx%2hhx%2hhx%2hhx%2hhx %u %u %u %u %u %d",
+                       &ieee[7], &ieee[6], &ieee[5], &ieee[4], &ieee[3], &ieee[2], &ieee[1], &ieee[0],
+                       &power, &fw, &bat_v, &bat_p, &lqi, &rssi) == 14) {
+                for (size_t i = 0; i < count; i++) {
+                    if (memcmp(devices[i].ieee_addr, ieee, sizeof(ieee)) == 0) {
+                        devices[i].power_source = power;
+                        devices[i].firmware_version = fw;
+                        devices[i].battery_voltage = bat_v;
+                        devices[i].battery_percentage = bat_p;
+                        devices[i].last_lqi = lqi;
+                        devices[i].last_rssi = rssi;
+                        applied++;
+                        break;
+                    }
+                }
+            }
+        }
+        line = eol + 1;
+    }
+    return applied;
+}
+
+static mp_obj_t do_volatile_flush_handler(mp_obj_t force_obj) {
+    bool force = mp_obj_is_true(force_obj);
+
+    esp32_zig_obj_t *zig_self = (esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr);
+    if (!zig_self || !zig_self->storage_cb || zig_self->storage_cb == mp_const_none) {
+        return mp_const_false;
+    }
+
+    if (!force && !volatile_any_dirty()) {
+        return mp_const_true;
+    }
+    if (index_dirty) {
+        index_save(zig_self->storage_cb);
+    }
+
+    // Body is written after the reserved header area, see record_seal()
+    size_t cap = device_storage_volatile_size();
+    vstr_t vstr;
+    vstr_init_len(&vstr, RECORD_HEADER_MAX + cap);
+
+    bool locked = esp_zb_is_started();
+    if (locked) {
+        ZB_LOCK();
+    }
+    size_t count;
+    zigbee_device_t *devices = device_manager_get_list(&count);
+
+    // Cleared before the write: a change arriving meanwhile marks it again
+    for (size_t i = 0; i < count; i++) {
+        devices[i].volatile_dirty = false;
+    }
+    size_t len = device_storage_volatile_write(vstr.buf + RECORD_HEADER_MAX, cap + 1);
+    if (locked) {
+        ZB_UNLOCK();
+    }
+
+    bool saved;
+    if (storage_nvs) {
+        saved = device_storage_nvs_save_volatile(vstr.buf + RECORD_HEADER_MAX, len) == ESP_OK;
+        vstr_clear(&vstr);
+    } else {
+        mp_obj_t args[3] = {
+            mp_obj_new_str("save", 4),
+            mp_obj_new_str(VOLATILE_FILENAME, strlen(VOLATILE_FILENAME)),
+            record_seal(&vstr, len, ++volatile_gen)
+        };
+        saved = mp_call_function_n_kw(zig_self->storage_cb, 3, 0, args) != mp_const_none;
+    }
+
+    if (!saved) {
+        ESP_LOGW(LOG_TAG, "Volatile state save failed, will retry on next flush");
+        if (locked) {
+            ZB_LOCK();
+        }
+        for (size_t i = 0; i < count; i++) {
+            devices[i].volatile_dirty = true;
+        }
+        if (locked) {
+            ZB_UNLOCK();
+        }
+        storage_stats.volatile_failed++;
+        return mp_const_false;
+    }
+
+    storage_stats.volatile_flushes++;
+    ESP_LOGD(LOG_TAG, "Volatile state of %u devices saved (gen %lu, %u bytes)",
+             (unsigned)count, (unsigned long)volatile_gen, (unsigned)len);
+    return mp_const_true;
+}
+
+// Apply the newest valid volatile record to loaded devices (Python context)
+static void volatile_load(mp_obj_t storage_cb) {
+    if (storage_nvs) {
+        size_t len = 0;
+        char *body = device_storage_nvs_load_volatile(&len);
+        if (body) {
+            size_t applied = device_storage_volatile_apply(body, len);
+            ESP_LOGI(LOG_TAG, "Volatile state applied to %u devices (NVS)", (unsigned)applied);
+            free(body);
+        }
+        return;
+    }
+
+    size_t best_len = 0;
+    uint32_t best_gen = 0;
+    mp_obj_t record = mp_const_none;
+    const char *best_body = record_load_newest(storage_cb, VOLATILE_FILENAME, "V1\n", &best_len, &best_gen, &record);
+    if (!best_body) {
+        return;
+    }
+    volatile_gen = best_gen;
+
+    size_t applied = device_storage_volatile_apply(best_body, best_len);
+    ESP_LOGI(LOG_TAG, "Volatile state applied to %u devices (gen %lu)", (unsigned)applied, (unsigned long)best_gen);
+    (void)record;
+}
+
+esp_err_t device_storage_set_volatile_interval(uint32_t seconds) {
+    if (volatile_timer) {
+        esp_timer_stop(volatile_timer);
+        esp_timer_delete(volatile_timer);
+        volatile_timer = NULL;
+    }
+
+    if (seconds == 0) {
+        ESP_LOGI(LOG_TAG, "Volatile state flush on demand only");
+        return ESP_OK;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = volatile_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "zig_volatile",
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &volatile_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Failed to create volatile flush timer: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = esp_timer_start_periodic(volatile_timer, (uint64_t)seconds * 1000000ULL);
+    if (err != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Failed to start volatile flush timer: %s", esp_err_to_name(err));
+        esp_timer_delete(volatile_timer);
+        volatile_timer = NULL;
+        return err;
     }
 
-    ESP_LOGD(LOG_TAG, "Device load complete semaphore taken");
+    ESP_LOGI(LOG_TAG, "Volatile state flush every %lu s", (unsigned long)seconds);
     return ESP_OK;
 }
 
+esp_err_t device_storage_flush_volatile(void) {
+    return do_volatile_flush_handler(mp_const_true) == mp_const_true ? ESP_OK : ESP_FAIL;
+}
+
+/* ---------- Device index ---------- */
+
+// "I1\n" + one line per device: <ieee16hex>\t<short>\t<gen>\t<manuf_code>\t<name>\t<manufacturer>\t<complete>\n
+// The interview column is optional: older indexes end after the manufacturer.
+// Read at boot instead of all records; endpoints, clusters and reports follow in the background.
+
+// Names are free text: keep tabs and line breaks out of the index
+static void index_add_name(vstr_t *vstr, const char *name, size_t max) {
+    for (size_t i = 0; i < max && name[i]; i++) {
+        char c = name[i];
+        vstr_add_char(vstr, (c == '\t' || c == '\n' || c == '\r') ? ' ' : c);
+    }
+}
+
+static const char *index_get_name(const char *p, const char *eol, char *out, size_t max) {
+    const char *end = memchr(p, '\t', eol - p);
+    if (!end) {
+        end = eol;
+    }
+    size_t n = end - p;
+    if (n >= max) {
+        n = max - 1;
+    }
+    memcpy(out, p, n);
+    out[n] = '\0';
+    return end < eol ? end + 1 : eol;
+}
+
+// Generation of the last index written, continued from the one read at boot
+static uint32_t index_gen = 0;
+
+static void index_save(mp_obj_t storage_cb) {
+    if (storage_nvs || !storage_cb || storage_cb == mp_const_none) {
+        return;
+    }
+
+    size_t count;
+    const zigbee_device_t *devices = device_manager_get_list(&count);
+
+    // Body is written after the reserved header area, see record_seal()
+    vstr_t vstr;
+    vstr_init_len(&vstr, RECORD_HEADER_MAX);
+    vstr_add_str(&vstr, "I1\n");
+    for (size_t i = 0; i < count; i++) {
+        const zigbee_device_t *d = &devices[i];
+        vstr_printf(&vstr, "%02x%02x%02x%02x%02x%02x%02x%02x\t%04x\t%lu\t%04x\t",
+                    d->ieee_addr[7], d->ieee_addr[6], d->ieee_addr[5], d->ieee_addr[4],
+                    d->ieee_addr[3], d->ieee_addr[2], d->ieee_addr[1], d->ieee_addr[0],
+                    d->short_addr, (unsigned long)d->storage_gen, d->manufacturer_code);
+        index_add_name(&vstr, d->device_name, sizeof(d->device_name));
+        vstr_add_char(&vstr, '\t');
+        index_add_name(&vstr, d->manufacturer_name, sizeof(d->manufacturer_name));
+        vstr_printf(&vstr, "\t%u\n", d->interview_complete);
+    }
+
+    index_dirty = false;
+    mp_obj_t args[3] = {
+        mp_obj_new_str("save", 4),
+        mp_obj_new_str(INDEX_FILENAME, strlen(INDEX_FILENAME)),
+        record_seal(&vstr, vstr.len - RECORD_HEADER_MAX, ++index_gen)
+    };
+    if (mp_call_function_n_kw(storage_cb, 3, 0, args) == mp_const_none) {
+        ESP_LOGW(LOG_TAG, "Index save failed, will retry on next flush");
+        index_dirty = true;
+        return;
+    }
+    ESP_LOGD(LOG_TAG, "Index of %u devices saved (gen %lu)", (unsigned)count, (unsigned long)index_gen);
+}
+
+// Register index-only entries (detail_pending) for devices not known yet
+static size_t index_load(mp_obj_t storage_cb) {
+    size_t len = 0;
+    uint32_t gen = 0;
+    mp_obj_t record = mp_const_none;
+    const char *body = record_load_newest(storage_cb, INDEX_FILENAME, "I1\n", &len, &gen, &record);
+    if (!body) {
+        return 0;
+    }
+    // Next save must outrank the copy just read, or the older sibling wins the next boot
+    index_gen = gen;
+
+    size_t restored = 0;
+    zigbee_device_t device;
+    const char *line = body + 3;
+    const char *end = body + len;
+
+    while (line < end) {
+        const char *eol = memchr(line, '\n', end - line);
+        if (!eol) {
+            break;
+        }
 
+        memset(&device, 0, sizeof(device));
+        unsigned long dev_gen;
+        int consumed = 0;
+        if (sscanf(line, "%2hhx%2hhx%2hhx%2hhx%2hhx%2hhx%2hhx%2hhx\t%hx\t%lu\t%hx\t%n",
+                   &device.ieee_addr[7], &device.ieee_addr[6], &device.ieee_addr[5], &device.ieee_addr[4],
+                   &device.ieee_addr[3], &device.ieee_addr[2], &device.ieee_addr[1], &device.ieee_addr[0],
+                   &device.short_addr, &dev_gen, &device.manufacturer_code, &consumed) == 11 &&
+            consumed > 0 && line + consumed <= eol) {
+            const char *p = index_get_name(line + consumed, eol, device.device_name, sizeof(device.device_name));
+            p = index_get_name(p, eol, device.manufacturer_name, sizeof(device.manufacturer_name));
+            // Rejoins before the record is loaded skip discovery too
+            device.interview_complete = p < eol && *p == '1';
+            device.storage_gen = dev_gen;
+            device.detail_pending = true;
+
+            if (device_manager_get(device.short_addr) == NULL && device_manager_restore(&device) == ESP_OK) {
+                restored++;
+            }
+        } else {
+            ESP_LOGW(LOG_TAG, "Skipping malformed index line");
+        }
+        line = eol + 1;
+    }
+
+    ESP_LOGI(LOG_TAG, "Index: %u devices (gen %lu)", (unsigned)restored, (unsigned long)gen);
+    (void)record;
+    return restored;
+}
+
+esp_err_t device_storage_ensure_detail(uint16_t short_addr) {
+    zigbee_device_t *device = device_manager_get(short_addr);
+    if (!device) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!device->detail_pending) {
+        return ESP_OK;
+    }
+    return device_storage_load((esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr), short_addr);
+}
@@ -6,6 +6,31 @@
 #include "esp_err.h"
 #include "mod_zig_types.h"
 
+// Default volatile state flush interval, seconds (0 = on demand only)
+#define DEVICE_STORAGE_VOLATILE_INTERVAL_S 600
+
+// Base wait for the startup load and allowance per stored record
+#define DEVICE_STORAGE_LOAD_BASE_MS        2000
+#define DEVICE_STORAGE_LOAD_MS_PER_RECORD  150
+
+// Statistics of the last startup load
+typedef struct {
+    uint32_t load_records;   // Records reported by "list"
+    uint32_t load_ok;        // Records parsed and added to device manager
+    uint32_t load_failed;    // Records that could not be read, failed CRC or parse
+    uint32_t load_stale;     // Valid records superseded by a newer generation
+    uint32_t load_ms;        // Wall time from schedule to completion
+    uint32_t index_records;  // Devices registered from the index before their records
+    uint32_t index_ms;       // Wall time until the device list was usable
+    bool load_done;          // Loading finished (successfully or not)
+    uint32_t volatile_flushes;  // Volatile state records written
+    uint32_t volatile_failed;   // Volatile state writes rejected by the callback
+    uint32_t save_count;        // Device records written
+    uint32_t save_us_total;     // Time spent writing records, us
+    uint32_t save_us_max;       // Slowest single record write, us
+    bool nvs;                   // NVS backend selected (storage="nvs")
+} device_storage_stats_t;
+
 /**
  * @brief Save device to separate JSON file
  * 
@@ -34,8 +59,8 @@ esp_err_t device_storage_load(esp32_zig_obj_t *self, uint16_t short_addr);
  * @brief Load all devices from JSON files
  * 
  * Gets list of all .json files through storage callback
- * and sequentially loads each device with pauses,
- * to avoid overloading MicroPython scheduler.
+ * and reads them in one "load_many" call. Callbacks without
+ * "load_many" are served one "load" per scheduler round.
  * 
  * @param self Pointer to Zigbee object
  * @return esp_err_t if loading started successfully
@@ -54,6 +79,24 @@ esp_err_t device_storage_load_all(esp32_zig_obj_t *self);
  */
 esp_err_t device_storage_remove(esp32_zig_obj_t *self, uint16_t short_addr);
 
+/**
+ * @brief Save device record immediately (Python context only)
+ *
+ * Bypasses the save queue and the scheduler, for bulk restores.
+ *
+ * @param short_addr Short address of device
+ * @return esp_err_t ESP_ERR_NOT_FOUND if the device is unknown
+ */
+esp_err_t device_storage_save_now(uint16_t short_addr);
+
+/**
+ * @brief Delete device record immediately (Python context only)
+ *
+ * @param short_addr Short address of device
+ * @return esp_err_t ESP_OK
+ */
+esp_err_t device_storage_remove_now(uint16_t short_addr);
+
 /**
  * @brief Initialize device storage system
  * 
@@ -75,7 +118,10 @@ void device_storage_deinit(void);
 /**
  * @brief Set storage callback and register it in GC
  * 
- * @param cb Python callback object
+ * The string "nvs" selects the built-in NVS backend instead of a
+ * Python callback. Raises if the NVS namespace cannot be opened.
+ * 
+ * @param cb Python callback object or "nvs"
  */
 void device_storage_set_callback(mp_obj_t cb);
 
@@ -84,8 +130,86 @@ void device_storage_set_callback(mp_obj_t cb);
  */
 void device_storage_clear_callback(void);
 
-// Function prototypes
-esp_err_t device_storage_load_all(esp32_zig_obj_t *self);
+/**
+ * @brief Wait until device_storage_load_all() has finished
+ *
+ * @param timeout Base wait; extended by DEVICE_STORAGE_LOAD_MS_PER_RECORD
+ *                for every record once the file list is known
+ * @return ESP_OK when loading finished, ESP_ERR_TIMEOUT otherwise
+ */
 esp_err_t device_storage_wait_load_complete(TickType_t timeout);
 
+/**
+ * @brief Load time budget for the current record count
+ *
+ * @param base Base wait in ticks
+ * @return base plus per-record allowance
+ */
+TickType_t device_storage_load_budget(TickType_t base);
+
+/**
+ * @brief Load endpoints, clusters and reports of an index-only device (Python context only)
+ *
+ * Devices registered from the index at boot carry detail_pending until
+ * their record is read in the background. Callers that need the full
+ * record (get_device, save, snapshot export) load it here first.
+ *
+ * @param short_addr Short address of device
+ * @return esp_err_t ESP_OK if the device is complete, ESP_ERR_NOT_FOUND otherwise
+ */
+esp_err_t device_storage_ensure_detail(uint16_t short_addr);
+
+/**
+ * @brief Mark volatile fields of a device as changed
+ *
+ * Battery, power source, firmware and link quality do not trigger a
+ * record save; they are written with the next volatile state flush.
+ *
+ * @param short_addr Short address of device
+ */
+void device_storage_mark_volatile(uint16_t short_addr);
+
+/**
+ * @brief Set periodic flush interval of the volatile state record
+ *
+ * @param seconds Interval, 0 disables the timer (flush on demand only)
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t device_storage_set_volatile_interval(uint32_t seconds);
+
+/**
+ * @brief Write the volatile state record now (Python context only)
+ *
+ * @return esp_err_t ESP_OK if the storage callback accepted the record
+ */
+esp_err_t device_storage_flush_volatile(void);
+
+/**
+ * @brief Upper bound of the volatile state body for the current device list
+ */
+size_t device_storage_volatile_size(void);
+
+/**
+ * @brief Write volatile state body ("V1" + one line per device) into buf
+ *
+ * @param buf Output buffer
+ * @param size Size of buf, device_storage_volatile_size() + 1 is enough
+ * @return size_t Body length without NUL
+ */
+size_t device_storage_volatile_write(char *buf, size_t size);
+
+/**
+ * @brief Apply volatile state body to devices with matching IEEE address
+ *
+ * @param body Body text as produced by device_storage_volatile_write()
+ * @param len Length of body
+ * @return size_t Number of devices updated
+ */
+size_t device_storage_volatile_apply(const char *body, size_t len);
+
+/**
+ * @brief Statistics of the last startup load
+ */
+const device_storage_stats_t *device_storage_get_stats(void);
+
 #endif
@@ -0,0 +1,456 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// NVS storage backend: compact binary device records keyed by IEEE address
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "nvs.h"
+
+#include "device_storage_nvs.h"
+#include "device_manager.h"
+#include "mod_zig_core.h" // For zigbee_format_ieee_addr_to_str
+
+#define LOG_TAG "DEVICE_STORAGE_NVS"
+
+#define NVS_RECORD_VERSION  2       // 1: without the interview state, still read
+#define NVS_KEY_PREFIX      'd'
+#define NVS_KEY_LEN         15      // 'd' + 13 base32 chars of the IEEE address + NUL
+
+// Upper bound of an encoded record: header, three names, all endpoints and report slots
+#define NVS_RECORD_MAX (1 + 2 + 8 + 2 + 2 * (1 + MAX_DEVICE_NAME_LEN) + \
+                        1 + MAX_ENDPOINTS * (1 + 2 + 2 + 1 + MAX_CLUSTERS * 2) + \
+                        1 + MAX_REPORT_CFGS * (1 + 1 + 2 + 2 + 1 + 2 + 2 + 4) + \
+                        1 + 4 + 4)
+
+static nvs_handle_t nvs_dev = 0;
+static bool nvs_dev_open = false;
+
+/* ---------- Record codec ---------- */
+
+// Layout (little endian):
+//   u8 version, u16 short_addr, u8[8] ieee, u16 manufacturer_code,
+//   u8 len + device_name, u8 len + manufacturer_name,
+//   u8 endpoint_count, per endpoint: u8 ep, u16 profile, u16 device, u8 n, u16[n] clusters
+//   u8 report_count, per report: u8 direction, u8 ep, u16 cluster, u16 attr,
+//     SEND: u8 type, u16 min, u16 max, u32 change; RECV: u16 timeout
+//   v2: u8 interview_complete, u32 desc_hash, u32 bind_hash
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t pos;
+    bool ok;
+} rec_cursor_t;
+
+static void put_u8(rec_cursor_t *c, uint8_t v) {
+    if (c->pos + 1 > c->len) {
+        c->ok = false;
+        return;
+    }
+    c->buf[c->pos++] = v;
+}
+
+static void put_u16(rec_cursor_t *c, uint16_t v) {
+    put_u8(c, v & 0xff);
+    put_u8(c, v >> 8);
+}
+
+static void put_u32(rec_cursor_t *c, uint32_t v) {
+    put_u16(c, v & 0xffff);
+    put_u16(c, v >> 16);
+}
+
+static void put_str(rec_cursor_t *c, const char *s, size_t max) {
+    size_t n = strnlen(s, max - 1);
+    put_u8(c, n);
+    for (size_t i = 0; i < n; i++) {
+        put_u8(c, s[i]);
+    }
+}
+
+static uint8_t get_u8(rec_cursor_t *c) {
+    if (c->pos + 1 > c->len) {
+        c->ok = false;
+        return 0;
+    }
+    return c->buf[c->pos++];
+}
+
+static uint16_t get_u16(rec_cursor_t *c) {
+    uint16_t v = get_u8(c);
+    return v | (get_u8(c) << 8);
+}
+
+static uint32_t get_u32(rec_cursor_t *c) {
+    uint32_t v = get_u16(c);
+    return v | ((uint32_t)get_u16(c) << 16);
+}
+
+static void get_str(rec_cursor_t *c, char *s, size_t max) {
+    size_t n = get_u8(c);
+    if (n >= max) {
+        c->ok = false;
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        s[i] = get_u8(c);
+    }
+    s[n] = '\0';
+}
+
+static size_t record_encode(const zigbee_device_t *d, uint8_t *buf, size_t len) {
+    rec_cursor_t c = { .buf = buf, .len = len, .ok = true };
+
+    put_u8(&c, NVS_RECORD_VERSION);
+    put_u16(&c, d->short_addr);
+    for (int i = 0; i < 8; i++) {
+        put_u8(&c, d->ieee_addr[i]);
+    }
+    put_u16(&c, d->manufacturer_code);
+    put_str(&c, d->device_name, sizeof(d->device_name));
+    put_str(&c, d->manufacturer_name, sizeof(d->manufacturer_name));
+
+    uint8_t ep_count = d->endpoint_count < MAX_ENDPOINTS ? d->endpoint_count : MAX_ENDPOINTS;
+    put_u8(&c, ep_count);
+    for (int i = 0; i < ep_count; i++) {
+        const zigbee_endpoint_t *ep = &d->endpoints[i];
+        uint8_t cl_count = ep->cluster_count < MAX_CLUSTERS ? ep->cluster_count : MAX_CLUSTERS;
+        put_u8(&c, ep->endpoint);
+        put_u16(&c, ep->profile_id);
+        put_u16(&c, ep->device_id);
+        put_u8(&c, cl_count);
+        for (int j = 0; j < cl_count; j++) {
+            put_u16(&c, ep->cluster_list[j]);
+        }
+    }
+
+    uint8_t rc_count = 0;
+    for (int i = 0; i < MAX_REPORT_CFGS; i++) {
+        rc_count += d->report_cfgs[i].in_use;
+    }
+    put_u8(&c, rc_count);
+    for (int i = 0; i < MAX_REPORT_CFGS; i++) {
+        const report_cfg_t *cfg = &d->report_cfgs[i];
+        if (!cfg->in_use) continue;
+        put_u8(&c, cfg->direction);
+        put_u8(&c, cfg->ep);
+        put_u16(&c, cfg->cluster_id);
+        put_u16(&c, cfg->attr_id);
+        if (cfg->direction == REPORT_CFG_DIRECTION_SEND) {
+            put_u8(&c, cfg->send_cfg.attr_type);
+            put_u16(&c, cfg->send_cfg.min_int);
+            put_u16(&c, cfg->send_cfg.max_int);
+            put_u32(&c, cfg->send_cfg.reportable_change_val);
+        } else {
+            put_u16(&c, cfg->recv_cfg.timeout_period);
+        }
+    }
+
+    put_u8(&c, d->interview_complete);
+    put_u32(&c, d->desc_hash);
+    put_u32(&c, d->bind_hash);
+
+    return c.ok ? c.pos : 0;
+}
+
+static esp_err_t record_decode(const uint8_t *buf, size_t len, zigbee_device_t *d) {
+    rec_cursor_t c = { .buf = (uint8_t *)buf, .len = len, .ok = true };
+
+    memset(d, 0, sizeof(*d));
+    uint8_t version = get_u8(&c);
+    if (version < 1 || version > NVS_RECORD_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    d->short_addr = get_u16(&c);
+    for (int i = 0; i < 8; i++) {
+        d->ieee_addr[i] = get_u8(&c);
+    }
+    d->manufacturer_code = get_u16(&c);
+    get_str(&c, d->device_name, sizeof(d->device_name));
+    get_str(&c, d->manufacturer_name, sizeof(d->manufacturer_name));
+
+    d->endpoint_count = get_u8(&c);
+    if (d->endpoint_count > MAX_ENDPOINTS) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (int i = 0; i < d->endpoint_count && c.ok; i++) {
+        zigbee_endpoint_t *ep = &d->endpoints[i];
+        ep->endpoint = get_u8(&c);
+        ep->profile_id = get_u16(&c);
+        ep->device_id = get_u16(&c);
+        ep->cluster_count = get_u8(&c);
+        if (ep->cluster_count > MAX_CLUSTERS) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        for (int j = 0; j < ep->cluster_count; j++) {
+            ep->cluster_list[j] = get_u16(&c);
+        }
+    }
+
+    uint8_t rc_count = get_u8(&c);
+    if (rc_count > MAX_REPORT_CFGS) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (int i = 0; i < rc_count && c.ok; i++) {
+        report_cfg_t *cfg = &d->report_cfgs[i];
+        cfg->in_use = true;
+        cfg->direction = get_u8(&c);
+        cfg->ep = get_u8(&c);
+        cfg->cluster_id = get_u16(&c);
+        cfg->attr_id = get_u16(&c);
+        if (cfg->direction == REPORT_CFG_DIRECTION_SEND) {
+            cfg->send_cfg.attr_type = get_u8(&c);
+            cfg->send_cfg.min_int = get_u16(&c);
+            cfg->send_cfg.max_int = get_u16(&c);
+            cfg->send_cfg.reportable_change_val = get_u32(&c);
+        } else {
+            cfg->recv_cfg.timeout_period = get_u16(&c);
+        }
+    }
+
+    // Records written before the interview state interview again on rejoin
+    if (version >= 2) {
+        d->interview_complete = get_u8(&c) != 0;
+        d->desc_hash = get_u32(&c);
+        d->bind_hash = get_u32(&c);
+    }
+
+    if (!c.ok) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    zigbee_format_ieee_addr_to_str(d->ieee_addr, d->ieee_addr_str, sizeof(d->ieee_addr_str));
+    return ESP_OK;
+}
+
+// NVS keys are limited to 15 characters: IEEE address as 13 base32 digits
+static void record_key(const uint8_t ieee[8], char key[NVS_KEY_LEN]) {
+    static const char alphabet[] = "0123456789abcdefghijklmnopqrstuv";
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | ieee[i];
+    }
+    key[0] = NVS_KEY_PREFIX;
+    for (int i = 13; i >= 1; i--) {
+        key[i] = alphabet[v & 0x1f];
+        v >>= 5;
+    }
+    key[14] = '\0';
+}
+
+/* ---------- Backend ---------- */
+
+esp_err_t device_storage_nvs_open(void) {
+    if (nvs_dev_open) {
+        return ESP_OK;
+    }
+    esp_err_t err = nvs_open(DEVICE_STORAGE_NVS_NAMESPACE, NVS_READWRITE, &nvs_dev);
+    if (err != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Failed to open namespace %s: %s", DEVICE_STORAGE_NVS_NAMESPACE, esp_err_to_name(err));
+        return err;
+    }
+    nvs_dev_open = true;
+    ESP_LOGI(LOG_TAG, "Device records in NVS namespace %s", DEVICE_STORAGE_NVS_NAMESPACE);
+    return ESP_OK;
+}
+
+void device_storage_nvs_close(void) {
+    if (nvs_dev_open) {
+        nvs_close(nvs_dev);
+        nvs_dev_open = false;
+    }
+}
+
+esp_err_t device_storage_nvs_save(const zigbee_device_t *device) {
+    if (!nvs_dev_open) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t *buf = malloc(NVS_RECORD_MAX);
+    if (!buf) {
+        return ESP_ERR_NO_MEM;
+    }
+    size_t len = record_encode(device, buf, NVS_RECORD_MAX);
+    if (len == 0) {
+        free(buf);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    char key[NVS_KEY_LEN];
+    record_key(device->ieee_addr, key);
+    esp_err_t err = nvs_set_blob(nvs_dev, key, buf, len);
+    free(buf);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_dev);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Failed to write 0x%04x (%s): %s", device->short_addr, key, esp_err_to_name(err));
+        return err;
+    }
+    ESP_LOGD(LOG_TAG, "Device 0x%04x saved as %s, %u bytes", device->short_addr, key, (unsigned)len);
+    return ESP_OK;
+}
+
+// Walk all device records; stops when fn returns true. Returns true if stopped.
+typedef bool (*record_visit_fn)(const char *key, const zigbee_device_t *device, esp_err_t err, void *arg);
+
+static bool record_foreach(record_visit_fn fn, void *arg) {
+    uint8_t *buf = malloc(NVS_RECORD_MAX);
+    zigbee_device_t *device = malloc(sizeof(zigbee_device_t));
+    if (!buf || !device) {
+        free(buf);
+        free(device);
+        return false;
+    }
+
+    bool stopped = false;
+    nvs_iterator_t it = NULL;
+    esp_err_t res = nvs_entry_find(DEVICE_STORAGE_NVS_PARTITION, DEVICE_STORAGE_NVS_NAMESPACE, NVS_TYPE_BLOB, &it);
+    while (res == ESP_OK && !stopped) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+        if (info.key[0] == NVS_KEY_PREFIX) {
+            size_t len = NVS_RECORD_MAX;
+            esp_err_t err = nvs_get_blob(nvs_dev, info.key, buf, &len);
+            if (err == ESP_OK) {
+                err = record_decode(buf, len, device);
+            }
+            stopped = fn(info.key, device, err, arg);
+        }
+        res = nvs_entry_next(&it);
+    }
+    nvs_release_iterator(it);
+
+    free(buf);
+    free(device);
+    return stopped;
+}
+
+typedef struct {
+    uint16_t short_addr;
+    zigbee_device_t *out;
+    char key[NVS_KEY_LEN];
+} find_ctx_t;
+
+static bool find_by_short(const char *key, const zigbee_device_t *device, esp_err_t err, void *arg) {
+    find_ctx_t *ctx = arg;
+    if (err != ESP_OK || device->short_addr != ctx->short_addr) {
+        return false;
+    }
+    strncpy(ctx->key, key, NVS_KEY_LEN - 1);
+    ctx->key[NVS_KEY_LEN - 1] = '\0';
+    if (ctx->out) {
+        memcpy(ctx->out, device, sizeof(zigbee_device_t));
+    }
+    return true;
+}
+
+esp_err_t device_storage_nvs_remove(uint16_t short_addr) {
+    if (!nvs_dev_open) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // The live entry at this address may be a device that rejoined there after the record was written
+    find_ctx_t ctx = { .short_addr = short_addr };
+    zigbee_device_t *known = device_manager_get(short_addr);
+    if (known && known->stored_addr == short_addr) {
+        record_key(known->ieee_addr, ctx.key);
+    } else if (!record_foreach(find_by_short, &ctx)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t err = nvs_erase_key(nvs_dev, ctx.key);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_dev);
+    }
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    ESP_LOGD(LOG_TAG, "Device 0x%04x removed (%s): %s", short_addr, ctx.key, esp_err_to_name(err));
+    return err;
+}
+
+esp_err_t device_storage_nvs_load(uint16_t short_addr, zigbee_device_t *device) {
+    if (!nvs_dev_open) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Known device: its key is the IEEE address, whatever address the record holds
+    zigbee_device_t *known = device_manager_get(short_addr);
+    if (known) {
+        char key[NVS_KEY_LEN];
+        record_key(known->ieee_addr, key);
+        uint8_t *buf = malloc(NVS_RECORD_MAX);
+        if (!buf) {
+            return ESP_ERR_NO_MEM;
+        }
+        size_t len = NVS_RECORD_MAX;
+        esp_err_t err = nvs_get_blob(nvs_dev, key, buf, &len);
+        if (err == ESP_OK) {
+            err = record_decode(buf, len, device);
+        }
+        free(buf);
+        return err == ESP_ERR_NVS_NOT_FOUND ? ESP_ERR_NOT_FOUND : err;
+    }
+    find_ctx_t ctx = { .short_addr = short_addr, .out = device };
+    return record_foreach(find_by_short, &ctx) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+typedef struct {
+    uint32_t records;
+    uint32_t failed;
+    size_t ok;
+} load_all_stats_t;
+
+static bool restore_one(const char *key, const zigbee_device_t *device, esp_err_t err, void *arg) {
+    load_all_stats_t *stats = arg;
+    stats->records++;
+    if (err == ESP_OK) {
+        err = device_manager_restore(device);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(LOG_TAG, "Record %s not restored: %s", key, esp_err_to_name(err));
+        stats->failed++;
+        return false;
+    }
+    stats->ok++;
+    return false;
+}
+
+size_t device_storage_nvs_load_all(uint32_t *records, uint32_t *failed) {
+    load_all_stats_t stats = {0};
+    if (nvs_dev_open) {
+        record_foreach(restore_one, &stats);
+    }
+    if (records) *records = stats.records;
+    if (failed) *failed = stats.failed;
+    return stats.ok;
+}
+
+esp_err_t device_storage_nvs_save_volatile(const char *body, size_t len) {
+    if (!nvs_dev_open) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = nvs_set_blob(nvs_dev, DEVICE_STORAGE_NVS_VOLATILE, body, len);
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs_dev);
+    }
+    return err;
+}
+
+char *device_storage_nvs_load_volatile(size_t *len) {
+    if (!nvs_dev_open) {
+        return NULL;
+    }
+    size_t size = 0;
+    if (nvs_get_blob(nvs_dev, DEVICE_STORAGE_NVS_VOLATILE, NULL, &size) != ESP_OK || size == 0) {
+        return NULL;
+    }
+    char *body = malloc(size);
+    if (!body) {
+        return NULL;
+    }
+    if (nvs_get_blob(nvs_dev, DEVICE_STORAGE_NVS_VOLATILE, body, &size) != ESP_OK) {
+        free(body);
+        return NULL;
+    }
+    *len = size;
+    return body;
+}
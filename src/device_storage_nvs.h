@@ -0,0 +1,82 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// NVS storage backend: compact binary device records keyed by IEEE address
+#ifndef DEVICE_STORAGE_NVS_H
+#define DEVICE_STORAGE_NVS_H
+
+#include "esp_err.h"
+#include "mod_zig_types.h"
+
+#define DEVICE_STORAGE_NVS_NAMESPACE   "zig_dev"
+#define DEVICE_STORAGE_NVS_PARTITION   "nvs"
+#define DEVICE_STORAGE_NVS_VOLATILE    "volatile"
+
+/**
+ * @brief Open the device namespace in the default NVS partition
+ *
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t device_storage_nvs_open(void);
+
+/**
+ * @brief Close the device namespace
+ */
+void device_storage_nvs_close(void);
+
+/**
+ * @brief Write device record (structural fields only)
+ *
+ * @param device Pointer to device structure
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t device_storage_nvs_save(const zigbee_device_t *device);
+
+/**
+ * @brief Delete record of a device
+ *
+ * Looked up by IEEE address when the device is still known,
+ * otherwise by the short address stored in the records.
+ *
+ * @param short_addr Short address of device
+ * @return esp_err_t ESP_ERR_NOT_FOUND if there is no record
+ */
+esp_err_t device_storage_nvs_remove(uint16_t short_addr);
+
+/**
+ * @brief Read record of a device by short address
+ *
+ * A known device is looked up by its IEEE address, so a record written
+ * before a rejoin at another address is still found.
+ *
+ * @param short_addr Short address of device
+ * @param device Pointer to structure for filling
+ * @return esp_err_t ESP_ERR_NOT_FOUND if there is no record
+ */
+esp_err_t device_storage_nvs_load(uint16_t short_addr, zigbee_device_t *device);
+
+/**
+ * @brief Restore all records into device manager
+ *
+ * @param records Number of records found
+ * @param failed Number of records that could not be decoded or restored
+ * @return size_t Number of devices restored
+ */
+size_t device_storage_nvs_load_all(uint32_t *records, uint32_t *failed);
+
+/**
+ * @brief Write volatile state body
+ *
+ * @param body Body text, see device_storage_volatile_write()
+ * @param len Length of body
+ * @return esp_err_t ESP_OK on success
+ */
+esp_err_t device_storage_nvs_save_volatile(const char *body, size_t len);
+
+/**
+ * @brief Read volatile state body into a newly allocated buffer
+ *
+ * @param len Length of the returned body
+ * @return char* Body (free() after use) or NULL if there is none
+ */
+char *device_storage_nvs_load_volatile(size_t *len);
+
+#endif
@@ -53,7 +53,20 @@
 #include "mod_zig_devices.h"    // device functions
 #include "mod_zig_handlers.h"   // event handlers
 #include "mod_zig_cmd.h"        // device commands
+#include "mod_zig_request.h"    // tracked requests (tsn, timeout, retry, await)
+#include "mod_zig_lock.h"       // stack lock, batch and lock statistics
+#include "mod_zig_mailbox.h"    // held commands for sleepy end devices
+#include "mod_zig_groups.h"     // groups cluster and membership mirror
+#include "mod_zig_ctrl.h"       // typed on/off, level, color and cover commands
+#include "mod_zig_report.h"     // stored report configs and verification
+#include "mod_zig_retry.h"      // interview step and bind retries
+#include "mod_zig_interview.h"  // throttled interview state machine
+#include "mod_zig_fingerprint.h" // interview templates of known models
+#include "mod_zig_binding.h"    // binding table reads and mirror
+#include "mod_zig_topology.h"   // mesh crawler
+#include "mod_zig_route.h"      // concentrator mode and route failures
 #include "device_storage.h"     // device storage
+#include "mod_zig_snapshot.h"   // network snapshot export / import
 #include "mod_zig_custom.h"     // custom cluster functions - tuya, zigbee-thermostat, etc.
 
 //generate from esp-zigbee
@@ -78,7 +91,7 @@ mp_obj_t esp32_zig_init_helper(esp32_zig_obj_t *self, size_t n_args, const mp_ob
     // Update global pointer 
     global_esp32_zig_obj_ptr = MP_OBJ_FROM_PTR(self);
 
-    enum { ARG_name, ARG_bitrate, ARG_rcp_reset_pin, ARG_rcp_boot_pin, ARG_uart_port, ARG_uart_rx_pin, ARG_uart_tx_pin, ARG_start, ARG_storage };
+    enum { ARG_name, ARG_bitrate, ARG_rcp_reset_pin, ARG_rcp_boot_pin, ARG_uart_port, ARG_uart_rx_pin, ARG_uart_tx_pin, ARG_start, ARG_storage, ARG_volatile_interval, ARG_channel_mask, ARG_energy_scan, ARG_concentrator, ARG_discovery_interval };
 
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_name,             MP_ARG_KW_ONLY | MP_ARG_OBJ,    {.u_obj =   mp_const_none   } },
@@ -89,7 +102,12 @@ mp_obj_t esp32_zig_init_helper(esp32_zig_obj_t *self, size_t n_args, const mp_ob
         { MP_QSTR_uart_rx_pin,      MP_ARG_KW_ONLY | MP_ARG_INT,    {.u_int =   4               } },   // Default RX pin
         { MP_QSTR_uart_tx_pin,      MP_ARG_KW_ONLY | MP_ARG_INT,    {.u_int =   5               } },   // Default TX pin
         { MP_QSTR_start,            MP_ARG_KW_ONLY | MP_ARG_BOOL,   {.u_bool =  true            } },   // Default start flag
-        { MP_QSTR_storage,          MP_ARG_KW_ONLY | MP_ARG_OBJ,    {.u_obj =   mp_const_none   } }    // Storage callback
+        { MP_QSTR_storage,          MP_ARG_KW_ONLY | MP_ARG_OBJ,    {.u_obj =   mp_const_none   } },   // Storage callback or "nvs"
+        { MP_QSTR_volatile_interval, MP_ARG_KW_ONLY | MP_ARG_INT,   {.u_int =   DEVICE_STORAGE_VOLATILE_INTERVAL_S } },  // Volatile state flush, seconds (0 = on demand)
+        { MP_QSTR_channel_mask,     MP_ARG_KW_ONLY | MP_ARG_INT,    {.u_int =   ESP_ZB_PRIMARY_CHANNEL_MASK } },   // Channels for formation
+        { MP_QSTR_energy_scan,      MP_ARG_KW_ONLY | MP_ARG_BOOL,   {.u_bool =  false           } },   // Quietest channel of the mask at formation
+        { MP_QSTR_concentrator,     MP_ARG_KW_ONLY | MP_ARG_BOOL,   {.u_bool =  false           } },   // Many-to-one routing
+        { MP_QSTR_discovery_interval, MP_ARG_KW_ONLY | MP_ARG_INT,  {.u_int =   ZIG_CONCENTRATOR_INTERVAL_S } }    // Many-to-one route request, seconds
     };
 
     // parse args
@@ -112,6 +130,9 @@ mp_obj_t esp32_zig_init_helper(esp32_zig_obj_t *self, size_t n_args, const mp_ob
     // Set storage callback
     self->storage_cb = args[ARG_storage].u_obj;
     device_storage_set_callback(self->storage_cb);
+    if (self->storage_cb != mp_const_none) {
+        device_storage_set_volatile_interval(args[ARG_volatile_interval].u_int);
+    }
 
     // Set uart parameters
     self->config->bitrate       =   args[ARG_bitrate].u_int;
@@ -120,6 +141,20 @@ mp_obj_t esp32_zig_init_helper(esp32_zig_obj_t *self, size_t n_args, const mp_ob
     self->config->uart_port     =   args[ARG_uart_port].u_int;
     self->config->uart_rx_pin   =   args[ARG_uart_rx_pin].u_int;
     self->config->uart_tx_pin   =   args[ARG_uart_tx_pin].u_int;
+
+    // Set channel selection
+    self->config->channel_mask  =   (uint32_t)args[ARG_channel_mask].u_int & ZIG_CHANNEL_MASK_ALL;
+    self->config->energy_scan   =   args[ARG_energy_scan].u_bool;
+    if (self->config->channel_mask == 0) {
+        mp_raise_ValueError("channel_mask has no channel 11-26");
+    }
+
+    // Set concentrator mode
+    if (args[ARG_discovery_interval].u_int < 10 || args[ARG_discovery_interval].u_int > 86400) {
+        mp_raise_ValueError("discovery_interval must be 10-86400 s");
+    }
+    self->config->concentrator       = args[ARG_concentrator].u_bool;
+    self->config->discovery_interval = args[ARG_discovery_interval].u_int;
     
     // Check if start flag
     bool start_flag = args[ARG_start].u_bool;
@@ -280,6 +315,17 @@ static const mp_rom_map_elem_t esp32_zig_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_get_network_info), MP_ROM_PTR(&esp32_zig_get_network_info_obj) },
     { MP_ROM_QSTR(MP_QSTR_update_network_status), MP_ROM_PTR(&esp32_zig_update_network_status_obj) },
     { MP_ROM_QSTR(MP_QSTR_scan_networks), MP_ROM_PTR(&esp32_zig_scan_networks_obj) },
+    { MP_ROM_QSTR(MP_QSTR_scan_results), MP_ROM_PTR(&esp32_zig_scan_results_obj) },
+    { MP_ROM_QSTR(MP_QSTR_CHANNEL_MASK_ALL), MP_ROM_INT(ZIG_CHANNEL_MASK_ALL) },
+    { MP_ROM_QSTR(MP_QSTR_change_channel), MP_ROM_PTR(&esp32_zig_change_channel_obj) },
+    { MP_ROM_QSTR(MP_QSTR_route_stats), MP_ROM_PTR(&esp32_zig_route_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_crawl_topology), MP_ROM_PTR(&esp32_zig_crawl_topology_obj) },
+    { MP_ROM_QSTR(MP_QSTR_topology), MP_ROM_PTR(&esp32_zig_topology_obj) },
+    { MP_ROM_QSTR(MP_QSTR_TOPOLOGY_PARENT), MP_ROM_INT(ZIG_TOPOLOGY_PARENT) },
+    { MP_ROM_QSTR(MP_QSTR_TOPOLOGY_CHILD), MP_ROM_INT(ZIG_TOPOLOGY_CHILD) },
+    { MP_ROM_QSTR(MP_QSTR_TOPOLOGY_SIBLING), MP_ROM_INT(ZIG_TOPOLOGY_SIBLING) },
+    { MP_ROM_QSTR(MP_QSTR_TOPOLOGY_NONE), MP_ROM_INT(ZIG_TOPOLOGY_NONE) },
+    { MP_ROM_QSTR(MP_QSTR_TOPOLOGY_PREV_CHILD), MP_ROM_INT(ZIG_TOPOLOGY_PREV_CHILD) },
     { MP_ROM_QSTR(MP_QSTR_start_network), MP_ROM_PTR(&esp32_zig_start_network_obj) },
     
     //Device Management API
@@ -289,21 +335,75 @@ static const mp_rom_map_elem_t esp32_zig_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_save_device),                 MP_ROM_PTR(&esp32_zig_save_device_obj)              }, // save device to storage
     { MP_ROM_QSTR(MP_QSTR_load_device),                 MP_ROM_PTR(&esp32_zig_load_device_obj)              }, // load device from storage
     { MP_ROM_QSTR(MP_QSTR_remove_device),               MP_ROM_PTR(&esp32_zig_remove_device_obj)            }, // remove device from storage
+    { MP_ROM_QSTR(MP_QSTR_storage_stats),               MP_ROM_PTR(&esp32_zig_storage_stats_obj)            }, // startup load statistics
+    { MP_ROM_QSTR(MP_QSTR_flush_storage),               MP_ROM_PTR(&esp32_zig_flush_storage_obj)            }, // write volatile state now
+    { MP_ROM_QSTR(MP_QSTR_export_snapshot),             MP_ROM_PTR(&esp32_zig_export_snapshot_obj)          }, // whole-network snapshot to bytes / stream
+    { MP_ROM_QSTR(MP_QSTR_import_snapshot),             MP_ROM_PTR(&esp32_zig_import_snapshot_obj)          }, // restore whole-network snapshot
 
     // Micropython CMD API    
     { MP_ROM_QSTR(MP_QSTR_send_command), MP_ROM_PTR(&esp32_zig_send_command_obj) },
     { MP_ROM_QSTR(MP_QSTR_set_recv_callback), MP_ROM_PTR(&esp32_zig_set_recv_callback_obj) },
     { MP_ROM_QSTR(MP_QSTR_recv), MP_ROM_PTR(&esp32_zig_recv_obj) },
+    { MP_ROM_QSTR(MP_QSTR_request), MP_ROM_PTR(&esp32_zig_request_obj) },
+    { MP_ROM_QSTR(MP_QSTR_batch), MP_ROM_PTR(&esp32_zig_batch_obj) },
+    { MP_ROM_QSTR(MP_QSTR_lock_stats), MP_ROM_PTR(&esp32_zig_lock_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_post), MP_ROM_PTR(&esp32_zig_post_obj) },
+    { MP_ROM_QSTR(MP_QSTR_mailbox), MP_ROM_PTR(&esp32_zig_mailbox_obj) },
     //use for asyncio
     { MP_ROM_QSTR(MP_QSTR_any), MP_ROM_PTR(&esp32_zig_any_obj) },
 
     { MP_ROM_QSTR(MP_QSTR_bind_cluster), MP_ROM_PTR(&esp32_zig_bind_cluster_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unbind_cluster), MP_ROM_PTR(&esp32_zig_unbind_cluster_obj) },
     { MP_ROM_QSTR(MP_QSTR_configure_report), MP_ROM_PTR(&esp32_zig_configure_report_obj) },
     { MP_ROM_QSTR(MP_QSTR_set_report_config), MP_ROM_PTR(&esp32_zig_set_report_config_obj) },
+    { MP_ROM_QSTR(MP_QSTR_remove_report_config), MP_ROM_PTR(&esp32_zig_remove_report_config_obj) },
+    { MP_ROM_QSTR(MP_QSTR_report_configs), MP_ROM_PTR(&esp32_zig_report_configs_obj) },
+    { MP_ROM_QSTR(MP_QSTR_verify_reporting), MP_ROM_PTR(&esp32_zig_verify_reporting_obj) },
     { MP_ROM_QSTR(MP_QSTR_read_attr), MP_ROM_PTR(&esp32_zig_read_attr_obj) },
     { MP_ROM_QSTR(MP_QSTR_write_attr), MP_ROM_PTR(&esp32_zig_write_attr_obj) },
 
     { MP_ROM_QSTR(MP_QSTR_get_binding_table), MP_ROM_PTR(&esp32_zig_get_binding_table_obj) },
+    { MP_ROM_QSTR(MP_QSTR_bindings), MP_ROM_PTR(&esp32_zig_bindings_obj) },
+    { MP_ROM_QSTR(MP_QSTR_retries), MP_ROM_PTR(&esp32_zig_retries_obj) },
+    { MP_ROM_QSTR(MP_QSTR_RETRY_ACTIVE_EP), MP_ROM_INT(ZIG_RETRY_ACTIVE_EP) },
+    { MP_ROM_QSTR(MP_QSTR_RETRY_SIMPLE_DESC), MP_ROM_INT(ZIG_RETRY_SIMPLE_DESC) },
+    { MP_ROM_QSTR(MP_QSTR_RETRY_BIND), MP_ROM_INT(ZIG_RETRY_BIND) },
+    { MP_ROM_QSTR(MP_QSTR_interview), MP_ROM_PTR(&esp32_zig_interview_obj) },
+    { MP_ROM_QSTR(MP_QSTR_interviews), MP_ROM_PTR(&esp32_zig_interviews_obj) },
+    { MP_ROM_QSTR(MP_QSTR_fingerprints), MP_ROM_PTR(&esp32_zig_fingerprints_obj) },
+    { MP_ROM_QSTR(MP_QSTR_INTERVIEW_ACTIVE_EP), MP_ROM_INT(ZIG_INTERVIEW_ACTIVE_EP) },
+    { MP_ROM_QSTR(MP_QSTR_INTERVIEW_IDENTIFY), MP_ROM_INT(ZIG_INTERVIEW_IDENTIFY) },
+    { MP_ROM_QSTR(MP_QSTR_INTERVIEW_VERIFY), MP_ROM_INT(ZIG_INTERVIEW_VERIFY) },
+    { MP_ROM_QSTR(MP_QSTR_INTERVIEW_SIMPLE_DESC), MP_ROM_INT(ZIG_INTERVIEW_SIMPLE_DESC) },
+    { MP_ROM_QSTR(MP_QSTR_INTERVIEW_BASIC_READ), MP_ROM_INT(ZIG_INTERVIEW_BASIC_READ) },
+    { MP_ROM_QSTR(MP_QSTR_INTERVIEW_BIND), MP_ROM_INT(ZIG_INTERVIEW_BIND) },
+    { MP_ROM_QSTR(MP_QSTR_INTERVIEW_REPORT), MP_ROM_INT(ZIG_INTERVIEW_REPORT) },
+    { MP_ROM_QSTR(MP_QSTR_INTERVIEW_DONE), MP_ROM_INT(ZIG_INTERVIEW_DONE) },
+    { MP_ROM_QSTR(MP_QSTR_INTERVIEW_FAILED), MP_ROM_INT(ZIG_INTERVIEW_FAILED) },
+
+    // Control API
+    { MP_ROM_QSTR(MP_QSTR_on_off), MP_ROM_PTR(&esp32_zig_on_off_obj) },
+    { MP_ROM_QSTR(MP_QSTR_level), MP_ROM_PTR(&esp32_zig_level_obj) },
+    { MP_ROM_QSTR(MP_QSTR_color_xy), MP_ROM_PTR(&esp32_zig_color_xy_obj) },
+    { MP_ROM_QSTR(MP_QSTR_color_temp), MP_ROM_PTR(&esp32_zig_color_temp_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cover), MP_ROM_PTR(&esp32_zig_cover_obj) },
+    { MP_ROM_QSTR(MP_QSTR_COVER_OPEN), MP_ROM_INT(ZIG_COVER_OPEN) },
+    { MP_ROM_QSTR(MP_QSTR_COVER_CLOSE), MP_ROM_INT(ZIG_COVER_CLOSE) },
+    { MP_ROM_QSTR(MP_QSTR_COVER_STOP), MP_ROM_INT(ZIG_COVER_STOP) },
+
+    // Groups API
+    { MP_ROM_QSTR(MP_QSTR_add_group), MP_ROM_PTR(&esp32_zig_add_group_obj) },
+    { MP_ROM_QSTR(MP_QSTR_remove_group), MP_ROM_PTR(&esp32_zig_remove_group_obj) },
+    { MP_ROM_QSTR(MP_QSTR_view_group), MP_ROM_PTR(&esp32_zig_view_group_obj) },
+    { MP_ROM_QSTR(MP_QSTR_groups), MP_ROM_PTR(&esp32_zig_groups_obj) },
+
+    // send_command(mode=...) and broadcast addresses
+    { MP_ROM_QSTR(MP_QSTR_UNICAST), MP_ROM_INT(ZIG_ADDR_UNICAST) },
+    { MP_ROM_QSTR(MP_QSTR_GROUP), MP_ROM_INT(ZIG_ADDR_GROUP) },
+    { MP_ROM_QSTR(MP_QSTR_BROADCAST), MP_ROM_INT(ZIG_ADDR_BROADCAST) },
+    { MP_ROM_QSTR(MP_QSTR_BROADCAST_ALL), MP_ROM_INT(ZIG_BROADCAST_ALL) },
+    { MP_ROM_QSTR(MP_QSTR_BROADCAST_RX_ON), MP_ROM_INT(ZIG_BROADCAST_RX_ON) },
+    { MP_ROM_QSTR(MP_QSTR_BROADCAST_ROUTERS), MP_ROM_INT(ZIG_BROADCAST_ROUTERS) },
 
     // Message type constants
     { MP_ROM_QSTR(MP_QSTR_MSG), MP_ROM_PTR(&zig_msg_module) },
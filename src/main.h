@@ -18,6 +18,7 @@
 
 // Core types and definitions
 #include "mod_zig_types.h"
+#include "mod_zig_lock.h"
 
 #define ZIGBEE_TAG "ZIG_SCRIVO_GATEWAY" 
 
@@ -46,8 +47,9 @@
 // From custom FreeRTOS task (xTaskCreate)  ✅ Yes
 // esp_zb_scheduler_alarm()                 ❌ No
 // esp_zb_zcl_on_off_cmd_req()              ✅ Yes, if outside Zigbee task
-#define ZB_LOCK()   esp_zb_lock_acquire(portMAX_DELAY)
-#define ZB_UNLOCK() esp_zb_lock_release()
+// Nested ZB_LOCK() in the same task (zig.batch()) only counts depth.
+#define ZB_LOCK()   zig_lock_acquire()
+#define ZB_UNLOCK() zig_lock_release()
 
 // Forward declaration of global Zigbee object
 //extern esp32_zig_obj_t esp32_zig_obj;
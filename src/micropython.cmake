@@ -19,12 +19,26 @@ target_sources(usermod_esp32zig INTERFACE
     ${CMAKE_CURRENT_LIST_DIR}/mod_zig_network.c
     ${CMAKE_CURRENT_LIST_DIR}/mod_zig_core.c
     ${CMAKE_CURRENT_LIST_DIR}/mod_zig_cmd.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_request.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_lock.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_mailbox.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_groups.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_ctrl.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_report.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_retry.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_interview.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_fingerprint.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_binding.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_topology.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_route.c
     ${CMAKE_CURRENT_LIST_DIR}/mod_zig_devices.c
     
     # device management - new implementation
     ${CMAKE_CURRENT_LIST_DIR}/device_manager.c
     ${CMAKE_CURRENT_LIST_DIR}/device_storage.c
+    ${CMAKE_CURRENT_LIST_DIR}/device_storage_nvs.c
     ${CMAKE_CURRENT_LIST_DIR}/device_json.c
+    ${CMAKE_CURRENT_LIST_DIR}/mod_zig_snapshot.c
 
     ${CMAKE_CURRENT_LIST_DIR}/mod_zig_custom.c
     
@@ -0,0 +1,492 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Binding table reads with pagination and local mirror of device bindings
+//
+// Mgmt_Bind_rsp carries a few records per frame. Further pages are requested
+// from the callback until the device's total is reached, then one
+// ZIG_MSG_BINDING_TABLE event tells Python the mirror is up to date. Entries
+// are keyed by IEEE address so a rejoin at a new short address keeps them.
+#include <string.h>
+
+// FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ESP-IDF headers
+#include "esp_log.h"
+
+// Zigbee headers
+#include "esp_zigbee_core.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+
+//Project headers
+#include "main.h"
+#include "device_manager.h"
+#include "mod_zig_core.h"
+#include "mod_zig_handlers.h"
+#include "mod_zig_msg.h"
+#include "mod_zig_binding.h"
+
+#define LOG_TAG "ZIG_BINDING"
+
+// Mirror entry, written by the Zigbee task and read from MicroPython
+typedef struct {
+    uint8_t src_ieee[8];
+    uint16_t cluster_id;
+    uint8_t endpoint;
+    uint8_t dst_addr_mode;      /* ESP_ZB_ZDO_BIND_DST_ADDR_MODE_* */
+    union {
+        uint8_t ieee[8];
+        uint16_t group_id;
+    } dst;
+    uint8_t dst_endpoint;       /* Unused for group destinations */
+    bool in_use;
+} binding_entry_t;
+
+// Table read state of one device
+typedef struct {
+    uint8_t ieee[8];
+    uint8_t total;              /* Entries the device reported */
+    bool reading;               /* Pages from index 0 are coming in */
+    bool read;                  /* Every entry is in the mirror */
+    bool in_use;
+} binding_table_t;
+
+static binding_entry_t binding_entries[ZIG_BINDINGS_MAX];
+static binding_table_t binding_tables[ZIG_BINDING_TABLES];
+static portMUX_TYPE binding_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void binding_table_cb(const esp_zb_zdo_binding_table_info_t *table_info, void *user_ctx);
+
+
+// Caller holds binding_lock
+static binding_entry_t *binding_find(const uint8_t src_ieee[8], uint8_t endpoint, uint16_t cluster_id,
+                                     uint8_t dst_addr_mode, const uint8_t dst_ieee[8], uint16_t group_id,
+                                     uint8_t dst_endpoint) {
+    for (int i = 0; i < ZIG_BINDINGS_MAX; i++) {
+        binding_entry_t *e = &binding_entries[i];
+        if (!e->in_use || e->endpoint != endpoint || e->cluster_id != cluster_id ||
+            e->dst_addr_mode != dst_addr_mode || memcmp(e->src_ieee, src_ieee, 8) != 0) {
+            continue;
+        }
+        if (dst_addr_mode == ESP_ZB_ZDO_BIND_DST_ADDR_MODE_16_BIT_GROUP) {
+            if (e->dst.group_id == group_id) {
+                return e;
+            }
+        } else if (e->dst_endpoint == dst_endpoint && memcmp(e->dst.ieee, dst_ieee, 8) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+// Caller holds binding_lock
+static bool binding_insert(const uint8_t src_ieee[8], uint8_t endpoint, uint16_t cluster_id,
+                           uint8_t dst_addr_mode, const uint8_t dst_ieee[8], uint16_t group_id,
+                           uint8_t dst_endpoint) {
+    if (binding_find(src_ieee, endpoint, cluster_id, dst_addr_mode, dst_ieee, group_id, dst_endpoint)) {
+        return true;
+    }
+    for (int i = 0; i < ZIG_BINDINGS_MAX; i++) {
+        binding_entry_t *e = &binding_entries[i];
+        if (!e->in_use) {
+            memset(e, 0, sizeof(*e));
+            memcpy(e->src_ieee, src_ieee, 8);
+            e->endpoint = endpoint;
+            e->cluster_id = cluster_id;
+            e->dst_addr_mode = dst_addr_mode;
+            if (dst_addr_mode == ESP_ZB_ZDO_BIND_DST_ADDR_MODE_16_BIT_GROUP) {
+                e->dst.group_id = group_id;
+            } else {
+                memcpy(e->dst.ieee, dst_ieee, 8);
+                e->dst_endpoint = dst_endpoint;
+            }
+            e->in_use = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Caller holds binding_lock. Existing state of the device, or a new one (oldest reused when full)
+static binding_table_t *binding_table(const uint8_t ieee[8], bool create) {
+    binding_table_t *free_table = NULL;
+    for (int i = 0; i < ZIG_BINDING_TABLES; i++) {
+        binding_table_t *t = &binding_tables[i];
+        if (t->in_use && memcmp(t->ieee, ieee, 8) == 0) {
+            return t;
+        }
+        if (!t->in_use && !free_table) {
+            free_table = t;
+        }
+    }
+    if (!create) {
+        return NULL;
+    }
+    if (!free_table) {
+        // Losing a read state only means the next unbind is sent without checking
+        memmove(&binding_tables[0], &binding_tables[1], sizeof(binding_table_t) * (ZIG_BINDING_TABLES - 1));
+        free_table = &binding_tables[ZIG_BINDING_TABLES - 1];
+    }
+    memset(free_table, 0, sizeof(*free_table));
+    memcpy(free_table->ieee, ieee, 8);
+    free_table->in_use = true;
+    return free_table;
+}
+
+bool zig_binding_known(const uint8_t src_ieee[8], uint8_t endpoint, uint16_t cluster_id,
+                       const uint8_t dst_ieee[8], uint8_t dst_endpoint) {
+    taskENTER_CRITICAL(&binding_lock);
+    bool known = binding_find(src_ieee, endpoint, cluster_id, ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED,
+                              dst_ieee, 0, dst_endpoint) != NULL;
+    taskEXIT_CRITICAL(&binding_lock);
+    return known;
+}
+
+bool zig_binding_table_read(const uint8_t src_ieee[8]) {
+    taskENTER_CRITICAL(&binding_lock);
+    binding_table_t *t = binding_table(src_ieee, false);
+    bool read = t && t->read;
+    taskEXIT_CRITICAL(&binding_lock);
+    return read;
+}
+
+void zig_binding_update(const uint8_t src_ieee[8], uint8_t endpoint, uint16_t cluster_id,
+                        const uint8_t dst_ieee[8], uint8_t dst_endpoint, bool bound) {
+    bool stored = true;
+
+    taskENTER_CRITICAL(&binding_lock);
+    if (bound) {
+        stored = binding_insert(src_ieee, endpoint, cluster_id, ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED,
+                                dst_ieee, 0, dst_endpoint);
+        if (!stored) {
+            // The mirror no longer lists every binding of the device
+            binding_table_t *t = binding_table(src_ieee, false);
+            if (t) {
+                t->read = false;
+            }
+        }
+    } else {
+        binding_entry_t *e = binding_find(src_ieee, endpoint, cluster_id, ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED,
+                                          dst_ieee, 0, dst_endpoint);
+        if (e) {
+            e->in_use = false;
+        }
+    }
+    taskEXIT_CRITICAL(&binding_lock);
+
+    if (!stored) {
+        ESP_LOGW(LOG_TAG, "Mirror full, binding ep=%u cl=0x%04x not recorded", endpoint, cluster_id);
+    }
+}
+
+void zig_binding_forget(const uint8_t src_ieee[8]) {
+    taskENTER_CRITICAL(&binding_lock);
+    for (int i = 0; i < ZIG_BINDINGS_MAX; i++) {
+        if (binding_entries[i].in_use && memcmp(binding_entries[i].src_ieee, src_ieee, 8) == 0) {
+            binding_entries[i].in_use = false;
+        }
+    }
+    binding_table_t *t = binding_table(src_ieee, false);
+    if (t) {
+        t->in_use = false;
+    }
+    taskEXIT_CRITICAL(&binding_lock);
+}
+
+
+// Table complete or read failed: status(signal_type) + total(1) + stored(1)
+static void binding_event(uint16_t short_addr, uint8_t status, uint8_t total, uint8_t stored) {
+    uint8_t data[2] = { total, stored };
+    send_msg_to_micropython_queue(ZIG_MSG_BINDING_TABLE, status, short_addr, 0, 0, data, sizeof(data));
+}
+
+static void binding_table_req(uint16_t short_addr, uint8_t start_index) {
+    esp_zb_zdo_mgmt_bind_param_t req = {
+        .start_index = start_index,
+        .dst_addr    = short_addr,
+    };
+    esp_zb_zdo_binding_table_req(&req, binding_table_cb, (void *)(uintptr_t)short_addr);
+}
+
+// Zigbee task: one page of the device's binding table
+static void binding_table_cb(const esp_zb_zdo_binding_table_info_t *table_info, void *user_ctx) {
+    uint16_t short_addr = (uint16_t)(uintptr_t)user_ctx;
+    zigbee_device_t *device = device_manager_get(short_addr);
+
+    if (table_info->status != ESP_ZB_ZDP_STATUS_SUCCESS || !device) {
+        ESP_LOGW(LOG_TAG, "Binding table of 0x%04x not read, status=%d", short_addr, table_info->status);
+        if (device) {
+            taskENTER_CRITICAL(&binding_lock);
+            binding_table_t *t = binding_table(device->ieee_addr, false);
+            if (t) {
+                t->reading = false;
+            }
+            taskEXIT_CRITICAL(&binding_lock);
+        }
+        binding_event(short_addr, table_info->status ? table_info->status : ESP_ZB_ZDP_STATUS_DEVICE_NOT_FOUND, 0, 0);
+        return;
+    }
+
+    ESP_LOGI(LOG_TAG, "Binding table of 0x%04x: index=%u count=%u total=%u",
+             short_addr, table_info->index, table_info->count, table_info->total);
+
+    uint8_t dropped = 0;
+    uint8_t stored = 0;
+    uint16_t next = table_info->index + table_info->count;
+    bool more = table_info->count > 0 && next < table_info->total;
+    bool complete = next >= table_info->total;
+
+    taskENTER_CRITICAL(&binding_lock);
+    binding_table_t *t = binding_table(device->ieee_addr, true);
+    if (table_info->index == 0) {
+        // First page: the device's table replaces what was known
+        for (int i = 0; i < ZIG_BINDINGS_MAX; i++) {
+            if (binding_entries[i].in_use && memcmp(binding_entries[i].src_ieee, device->ieee_addr, 8) == 0) {
+                binding_entries[i].in_use = false;
+            }
+        }
+        t->reading = true;
+        t->read = false;
+    }
+    t->total = table_info->total;
+    for (esp_zb_zdo_binding_table_record_t *rec = table_info->record; rec; rec = rec->next) {
+        bool group = rec->dst_addr_mode == ESP_ZB_ZDO_BIND_DST_ADDR_MODE_16_BIT_GROUP;
+        if (!binding_insert(rec->src_address, rec->src_endp, rec->cluster_id, rec->dst_addr_mode,
+                            group ? NULL : rec->dst_address.addr_long,
+                            group ? rec->dst_address.addr_short : 0, rec->dst_endp)) {
+            dropped++;
+        }
+    }
+    if (dropped) {
+        t->reading = false;
+    }
+    if (!more) {
+        // An empty page short of the total ends the read, but the mirror is not complete
+        t->read = t->reading && complete;
+        t->reading = false;
+    }
+    for (int i = 0; i < ZIG_BINDINGS_MAX; i++) {
+        stored += binding_entries[i].in_use && memcmp(binding_entries[i].src_ieee, device->ieee_addr, 8) == 0;
+    }
+    taskEXIT_CRITICAL(&binding_lock);
+
+    if (dropped) {
+        ESP_LOGW(LOG_TAG, "Mirror full, %u bindings of 0x%04x not recorded", dropped, short_addr);
+    }
+    if (more) {
+        binding_table_req(short_addr, next);
+        return;
+    }
+    binding_event(short_addr, ESP_ZB_ZDP_STATUS_SUCCESS, table_info->total, stored);
+}
+
+// Zigbee task: Unbind confirmed
+static void unbind_cb(esp_zb_zdp_status_t status, void *user_ctx) {
+    bind_ctx_t *ctx = (bind_ctx_t *)user_ctx;
+    if (status == ESP_ZB_ZDP_STATUS_SUCCESS || status == ESP_ZB_ZDP_STATUS_NO_ENTRY) {
+        ESP_LOGI(LOG_TAG, "Unbind OK device=0x%04x ep=%u cluster=0x%04x", ctx->short_addr, ctx->endpoint, ctx->cluster_id);
+        zig_binding_update(ctx->src_ieee, ctx->endpoint, ctx->cluster_id, ctx->dst_ieee, ctx->dst_endpoint, false);
+    } else {
+        ESP_LOGW(LOG_TAG, "Unbind FAIL device=0x%04x ep=%u cluster=0x%04x status=%d",
+                 ctx->short_addr, ctx->endpoint, ctx->cluster_id, status);
+    }
+    free(ctx);
+}
+
+
+// get_binding_table(addr, start_index=0)
+// Read the binding table page by page into the mirror, ZIG_MSG_BINDING_TABLE follows
+static mp_obj_t esp32_zig_get_binding_table(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr, ARG_start_index };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr,         MP_ARG_REQUIRED  | MP_ARG_INT },
+        { MP_QSTR_start_index,  MP_ARG_INT,      {.u_int = 0} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args,
+                     MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    ZB_LOCK();
+    binding_table_req((uint16_t)args[ARG_addr].u_int, (uint8_t)args[ARG_start_index].u_int);
+    ZB_UNLOCK();
+
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_get_binding_table_obj, 1, esp32_zig_get_binding_table);
+
+
+// unbind_cluster(addr, ep, cl, dst_addr=0, dst_ep=1, force=False)
+// Unbind; False without sending when the read table shows no such binding
+static mp_obj_t esp32_zig_unbind_cluster(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr, ARG_ep, ARG_cl, ARG_dst_addr, ARG_dst_ep, ARG_force };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr,     MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,       MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_cl,       MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_dst_addr, MP_ARG_INT,                  {.u_int = 0} },
+        { MP_QSTR_dst_ep,   MP_ARG_INT,                  {.u_int = ESP_ZB_GATEWAY_ENDPOINT} },
+        { MP_QSTR_force,    MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    if (!self->config->network_formed) {
+        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
+    }
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uint16_t addr = args[ARG_addr].u_int;
+    uint16_t dst_short = args[ARG_dst_addr].u_int;
+    if (args[ARG_ep].u_int < 1 || args[ARG_ep].u_int > 254) {
+        mp_raise_ValueError("Endpoint must be between 1 and 254");
+    }
+
+    bind_ctx_t *bctx = malloc(sizeof(bind_ctx_t));
+    if (bctx == NULL) {
+        mp_raise_msg(&mp_type_MemoryError, "Failed to allocate bind context");
+    }
+    memset(bctx, 0, sizeof(*bctx));
+    bctx->short_addr = addr;
+    bctx->endpoint = args[ARG_ep].u_int;
+    bctx->cluster_id = args[ARG_cl].u_int;
+    bctx->dst_endpoint = args[ARG_dst_ep].u_int;
+
+    ZB_LOCK();
+    zigbee_device_t *device = device_manager_get(addr);
+    zigbee_device_t *dst_dev = dst_short ? device_manager_get(dst_short) : NULL;
+    bool found = device && (dst_short == 0 || dst_dev);
+    bool send = found;
+    if (found) {
+        memcpy(bctx->src_ieee, device->ieee_addr, 8);
+        if (dst_dev) {
+            memcpy(bctx->dst_ieee, dst_dev->ieee_addr, 8);
+        } else {
+            esp_zb_get_long_address(bctx->dst_ieee);
+        }
+        send = args[ARG_force].u_bool || !zig_binding_table_read(bctx->src_ieee) ||
+               zig_binding_known(bctx->src_ieee, bctx->endpoint, bctx->cluster_id, bctx->dst_ieee, bctx->dst_endpoint);
+    }
+    if (send) {
+        esp_zb_zdo_bind_req_param_t req = {0};
+        memcpy(req.src_address, bctx->src_ieee, sizeof(req.src_address));
+        req.src_endp = bctx->endpoint;
+        req.cluster_id = bctx->cluster_id;
+        req.dst_addr_mode = ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED;
+        memcpy(req.dst_address_u.addr_long, bctx->dst_ieee, sizeof(req.dst_address_u.addr_long));
+        req.dst_endp = bctx->dst_endpoint;
+        req.req_dst_addr = addr;
+        esp_zb_zdo_device_unbind_req(&req, unbind_cb, bctx);
+    }
+    ZB_UNLOCK();
+
+    if (!send) {
+        free(bctx);
+    }
+    if (!found) {
+        mp_raise_msg_varg(&mp_type_ValueError, MP_ERROR_TEXT("Device 0x%04x not found"), device ? dst_short : addr);
+    }
+    if (send) {
+        ESP_LOGI(LOG_TAG, "Unbind req sent to dev=0x%04x ep=%u cluster=0x%04x",
+                 addr, (unsigned)args[ARG_ep].u_int, (unsigned)args[ARG_cl].u_int);
+    }
+    return mp_obj_new_bool(send);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_unbind_cluster_obj, 1, esp32_zig_unbind_cluster);
+
+
+// Short address of a known device, 0 for the gateway, -1 if unknown. Caller holds ZB_LOCK.
+static int32_t binding_short(const uint8_t ieee[8], const uint8_t coord_ieee[8]) {
+    if (memcmp(ieee, coord_ieee, 8) == 0) {
+        return 0x0000;
+    }
+    size_t count = 0;
+    const zigbee_device_t *devices = device_manager_get_list(&count);
+    for (size_t i = 0; devices && i < count; i++) {
+        if (memcmp(devices[i].ieee_addr, ieee, 8) == 0) {
+            return devices[i].short_addr;
+        }
+    }
+    return -1;
+}
+
+// Address of a known device, else the IEEE string
+static mp_obj_t binding_addr(int32_t short_addr, const uint8_t ieee[8]) {
+    if (short_addr >= 0) {
+        return MP_OBJ_NEW_SMALL_INT(short_addr);
+    }
+    char ieee_str[24];
+    zigbee_format_ieee_addr_to_str(ieee, ieee_str, sizeof(ieee_str));
+    return mp_obj_new_str(ieee_str, strlen(ieee_str));
+}
+
+// bindings(addr=None)
+// Mirror as {addr: [(ep, cluster, dst, dst_ep), ...]}, or the list of one device
+static mp_obj_t esp32_zig_bindings(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    bool one = args[ARG_addr].u_obj != mp_const_none;
+    int32_t only = one ? mp_obj_get_int(args[ARG_addr].u_obj) : 0;
+
+    // Copy under the lock, resolve addresses under the stack lock, build objects without either
+    binding_entry_t *snapshot = m_new(binding_entry_t, ZIG_BINDINGS_MAX);
+    int32_t src_addr[ZIG_BINDINGS_MAX];
+    int32_t dst_addr[ZIG_BINDINGS_MAX];
+    taskENTER_CRITICAL(&binding_lock);
+    memcpy(snapshot, binding_entries, sizeof(binding_entry_t) * ZIG_BINDINGS_MAX);
+    taskEXIT_CRITICAL(&binding_lock);
+
+    ZB_LOCK();
+    uint8_t coord_ieee[8];
+    esp_zb_get_long_address(coord_ieee);
+    for (int i = 0; i < ZIG_BINDINGS_MAX; i++) {
+        binding_entry_t *e = &snapshot[i];
+        if (e->in_use) {
+            src_addr[i] = binding_short(e->src_ieee, coord_ieee);
+            dst_addr[i] = e->dst_addr_mode == ESP_ZB_ZDO_BIND_DST_ADDR_MODE_16_BIT_GROUP ?
+                          e->dst.group_id : binding_short(e->dst.ieee, coord_ieee);
+        }
+    }
+    ZB_UNLOCK();
+
+    mp_obj_t result = one ? mp_obj_new_list(0, NULL) : mp_obj_new_dict(0);
+    for (int i = 0; i < ZIG_BINDINGS_MAX; i++) {
+        binding_entry_t *e = &snapshot[i];
+        if (!e->in_use || (one && src_addr[i] != only)) {
+            continue;
+        }
+        // Group destinations have no endpoint
+        bool group = e->dst_addr_mode == ESP_ZB_ZDO_BIND_DST_ADDR_MODE_16_BIT_GROUP;
+        mp_obj_t item[4] = {
+            MP_OBJ_NEW_SMALL_INT(e->endpoint),
+            MP_OBJ_NEW_SMALL_INT(e->cluster_id),
+            binding_addr(dst_addr[i], e->dst.ieee),
+            group ? mp_const_none : MP_OBJ_NEW_SMALL_INT(e->dst_endpoint),
+        };
+        mp_obj_t list = result;
+        if (!one) {
+            mp_obj_t key = binding_addr(src_addr[i], e->src_ieee);
+            mp_map_elem_t *elem = mp_map_lookup(mp_obj_dict_get_map(result), key, MP_MAP_LOOKUP);
+            if (elem) {
+                list = elem->value;
+            } else {
+                list = mp_obj_new_list(0, NULL);
+                mp_obj_dict_store(result, key, list);
+            }
+        }
+        mp_obj_list_append(list, mp_obj_new_tuple(4, item));
+    }
+
+    m_del(binding_entry_t, snapshot, ZIG_BINDINGS_MAX);
+    return result;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_bindings_obj, 1, esp32_zig_bindings);
@@ -0,0 +1,56 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Binding table reads with pagination and local mirror of device bindings
+#ifndef MOD_ZIG_BINDING_H
+#define MOD_ZIG_BINDING_H
+
+#include "py/obj.h"
+#include "mod_zig_types.h"
+
+#define ZIG_BINDINGS_MAX        64      /* Binding entries in the mirror, all devices */
+#define ZIG_BINDING_TABLES      16      /* Devices whose whole table was read */
+
+/**
+ * @brief Device has this binding to an IEEE destination
+ *
+ * Called from the Zigbee task, or from MicroPython with ZB_LOCK held.
+ *
+ * @param src_ieee Source device
+ * @param endpoint Source endpoint
+ * @param cluster_id Bound cluster
+ * @param dst_ieee Destination device, the gateway for reporting
+ * @param dst_endpoint Destination endpoint
+ * @return true if the mirror holds it
+ */
+bool zig_binding_known(const uint8_t src_ieee[8], uint8_t endpoint, uint16_t cluster_id,
+                       const uint8_t dst_ieee[8], uint8_t dst_endpoint);
+
+/**
+ * @brief Whole binding table of the device was read
+ *
+ * Only then a binding missing from the mirror is missing on the device.
+ */
+bool zig_binding_table_read(const uint8_t src_ieee[8]);
+
+/**
+ * @brief Bind or Unbind confirmed, update the mirror
+ *
+ * Called from the Zigbee task.
+ *
+ * @param bound true after Bind, false after Unbind
+ */
+void zig_binding_update(const uint8_t src_ieee[8], uint8_t endpoint, uint16_t cluster_id,
+                        const uint8_t dst_ieee[8], uint8_t dst_endpoint, bool bound);
+
+/**
+ * @brief Forget everything known about the device's bindings
+ *
+ * Used when the device was reset or removed.
+ */
+void zig_binding_forget(const uint8_t src_ieee[8]);
+
+// Python API function objects
+extern const mp_obj_fun_builtin_var_t esp32_zig_get_binding_table_obj;   // Read the whole binding table of a device
+extern const mp_obj_fun_builtin_var_t esp32_zig_unbind_cluster_obj;      // Unbind cluster, skipped if not bound
+extern const mp_obj_fun_builtin_var_t esp32_zig_bindings_obj;            // Local binding mirror
+
+#endif // MOD_ZIG_BINDING_H
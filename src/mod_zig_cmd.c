@@ -16,20 +16,24 @@
 #include "mod_zig_cmd.h"
 #include "mod_zig_handlers.h"
 #include "device_manager.h"
+#include "mod_zig_report.h"
+#include "mod_zig_binding.h"
 
 
 #define ZIG_CMD_NAMESPACE "zig_cmd"
 
 
-// recv(timeout=0, list=None)
+// recv(timeout=0, list=None, tsn=False)
 // Non-blocking mode: if timeout==0, function will return None immediately if queue is empty.
 // If timeout>0 — waits for specified time and raises OSError if timeout occurs.
+// tsn=True appends the ZCL transaction sequence number (-1 if none) as 7th element.
 static mp_obj_t esp32_zig_recv(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
-    enum { ARG_timeout, ARG_list };
+    enum { ARG_timeout, ARG_list, ARG_tsn };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_timeout, MP_ARG_INT, {.u_int = 0} },
         { MP_QSTR_list,    MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_tsn,     MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
     };
 
     // parse args
@@ -51,42 +55,48 @@ static mp_obj_t esp32_zig_recv(size_t n_args, const mp_obj_t *pos_args, mp_map_t
         }
     }
 
+    bool with_tsn = args[ARG_tsn].u_bool;
+    size_t n_items = with_tsn ? 7 : 6;
+
     // Create the tuple, or get the list, that will hold the return values
     mp_obj_t ret_obj = args[ARG_list].u_obj;
     mp_obj_t *items;
     if (ret_obj == mp_const_none) {
-        // new tuple of 5 elements
-        ret_obj = mp_obj_new_tuple(6, NULL);
+        // new tuple of 6 (7 with tsn) elements
+        ret_obj = mp_obj_new_tuple(n_items, NULL);
         items = ((mp_obj_tuple_t *)MP_OBJ_TO_PTR(ret_obj))->items;
-        // data goes into index 4
+        // data goes into index 5
         items[5] = mp_obj_new_bytes(msg.data, msg.data_len);
     } else {
-        // User should provide a list of length at least 5 to hold the values
+        // User should provide a list of length at least 6 (7 with tsn) to hold the values
         if (!mp_obj_is_type(ret_obj, &mp_type_list)) {
             mp_raise_TypeError(NULL);
         }
         mp_obj_list_t *list = MP_OBJ_TO_PTR(ret_obj);
-        if (list->len < 6) {
+        if (list->len < n_items) {
             mp_raise_ValueError(NULL);
         }
         items = list->items;
-        // Fifth element must be memoryview
+        // Sixth element must be memoryview
         if (!mp_obj_is_type(items[5], &mp_type_memoryview)) {
             mp_raise_TypeError(NULL);
         }
-        mp_obj_array_t *mv = MP_OBJ_TO_PTR(items[4]);
+        mp_obj_array_t *mv = MP_OBJ_TO_PTR(items[5]);
         if (!(mv->typecode == (MP_OBJ_ARRAY_TYPECODE_FLAG_RW | BYTEARRAY_TYPECODE) || (mv->typecode | 0x20) == (MP_OBJ_ARRAY_TYPECODE_FLAG_RW | 'b'))) {
             mp_raise_ValueError(NULL);
         }
         mv->len = msg.data_len;
         memcpy(mv->items, msg.data, msg.data_len);
     }
-    // Fill tuple/list: [msg_py, signal_type, src_addr, endpoint, cluster_id, data]
+    // Fill tuple/list: [msg_py, signal_type, src_addr, endpoint, cluster_id, data(, tsn)]
     items[0] = MP_OBJ_NEW_SMALL_INT(msg.msg_py);
     items[1] = MP_OBJ_NEW_SMALL_INT(msg.signal_type);
     items[2] = MP_OBJ_NEW_SMALL_INT(msg.src_addr);
     items[3] = MP_OBJ_NEW_SMALL_INT(msg.endpoint);
     items[4] = MP_OBJ_NEW_SMALL_INT(msg.cluster_id);
+    if (with_tsn) {
+        items[6] = MP_OBJ_NEW_SMALL_INT(msg.tsn);
+    }
 
     
     // Return the result
@@ -116,42 +126,15 @@ MP_DEFINE_CONST_FUN_OBJ_2(esp32_zig_set_recv_callback_obj, esp32_zig_set_recv_ca
 
 
 
-static mp_obj_t esp32_zig_send_command(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    // Simplified argument check
-    mp_arg_check_num(n_args, kw_args->used, 1, MP_OBJ_FUN_ARGS_MAX, true);
-    
-    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
-
-    // Check if network is formed
-    if (!self->config->network_formed) {
-        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
-        return mp_const_none;
+uint8_t zig_cmd_send(uint16_t addr, uint8_t endpoint, int mode, uint16_t cluster_id, uint8_t command_id,
+                     uint16_t manuf_code, bool default_resp, uint8_t data_type, const void *data, uint16_t data_len) {
+    if (mode == ZIG_ADDR_BROADCAST && addr != ZIG_BROADCAST_ALL && addr != ZIG_BROADCAST_RX_ON
+        && addr != ZIG_BROADCAST_ROUTERS) {
+        mp_raise_ValueError("broadcast address must be 0xFFFC, 0xFFFD or 0xFFFF");
+    } else if (mode != ZIG_ADDR_UNICAST && mode != ZIG_ADDR_GROUP && mode != ZIG_ADDR_BROADCAST) {
+        mp_raise_ValueError("mode must be UNICAST, GROUP or BROADCAST");
     }
 
-    enum { ARG_addr, ARG_ep, ARG_cl, ARG_cmd, ARG_data, ARG_manuf_code, ARG_default_resp, ARG_data_type };
-    static const mp_arg_t allowed_args[] = {
-        { MP_QSTR_addr,         MP_ARG_REQUIRED | MP_ARG_INT },
-        { MP_QSTR_ep,           MP_ARG_REQUIRED | MP_ARG_INT },  
-        { MP_QSTR_cl,           MP_ARG_REQUIRED | MP_ARG_INT },
-        { MP_QSTR_cmd,          MP_ARG_REQUIRED | MP_ARG_INT },
-        { MP_QSTR_data,         MP_ARG_OBJ, {.u_obj = mp_const_none} },
-        { MP_QSTR_manuf_code,   MP_ARG_INT, {.u_int = 0} },
-        { MP_QSTR_default_resp, MP_ARG_BOOL, {.u_bool = false} },
-        { MP_QSTR_data_type,    MP_ARG_INT, {.u_int = ESP_ZB_ZCL_ATTR_TYPE_SET} } // Default: 0x50U,  use for raw data send.
-    };
-    
-    // Parse args
-    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
-    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
-
-    // Get command parameters
-    uint16_t addr = args[ARG_addr].u_int;
-    uint8_t endpoint = args[ARG_ep].u_int;
-    uint16_t cluster_id = args[ARG_cl].u_int;
-    uint8_t command_id = args[ARG_cmd].u_int;
-    uint16_t manuf_code = args[ARG_manuf_code].u_int;
-    uint8_t data_type = args[ARG_data_type].u_int;
-
     // Create command structure
     esp_zb_zcl_custom_cluster_cmd_t cmd_req;
     memset(&cmd_req, 0, sizeof(cmd_req));  // Clear entire structure
@@ -162,67 +145,96 @@ static mp_obj_t esp32_zig_send_command(size_t n_args, const mp_obj_t *pos_args,
     cmd_req.zcl_basic_cmd.src_endpoint = ESP_ZB_GATEWAY_ENDPOINT;
 
     // Initialize command fields
-    cmd_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+    // Group frames go to every endpoint that joined the group. Broadcasts take
+    // an endpoint as usual, 0xFF for all. Nobody answers either with a Default Response.
+    cmd_req.address_mode = mode == ZIG_ADDR_GROUP ? ESP_ZB_APS_ADDR_MODE_16_GROUP_ENDP_NOT_PRESENT
+                                                  : ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
     cmd_req.profile_id = ESP_ZB_AF_HA_PROFILE_ID;
     cmd_req.cluster_id = cluster_id;
     cmd_req.custom_cmd_id = command_id;
     cmd_req.direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV;
-    cmd_req.dis_defalut_resp = args[ARG_default_resp].u_bool;
+    cmd_req.dis_defalut_resp = mode == ZIG_ADDR_UNICAST ? default_resp : 1;
     cmd_req.manuf_specific = manuf_code > 0 ? 1 : 0;
     cmd_req.manuf_code = manuf_code;
 
-    // Initialize data fields
-    if (args[ARG_data].u_obj != mp_const_none) {
-        mp_buffer_info_t data_info;
-        mp_get_buffer_raise(args[ARG_data].u_obj, &data_info, MP_BUFFER_READ);
-        
+    // Initialize data fields. The stack copies the payload into its own buffer
+    // before the request returns, so the caller's buffer is used as is.
+    if (data != NULL) {
         cmd_req.data.type = data_type;  // Use specified data type
-        cmd_req.data.size = data_info.len;
-        cmd_req.data.value = malloc(data_info.len);
-        if (cmd_req.data.value == NULL) {
-            mp_raise_msg(&mp_type_MemoryError, "Failed to allocate memory for command data");
-            return mp_const_none;
-        }
-        memcpy(cmd_req.data.value, data_info.buf, data_info.len);
-
-        // ESP_LOGI(ZIG_CMD_NAMESPACE, "Command data: size=%d bytes, type=0x%02x", 
-        //          data_info.len, data_type);
-        // for (int i = 0; i < data_info.len; i++) {
-        //     ESP_LOGI(ZIG_CMD_NAMESPACE, "  [%d]: 0x%02x", i, ((uint8_t*)cmd_req.data.value)[i]);
-        // }
-        
+        cmd_req.data.size = data_len;
+        cmd_req.data.value = (void *)data;
     } else {
         cmd_req.data.type = ESP_ZB_ZCL_ATTR_TYPE_NULL;
         cmd_req.data.value = NULL;
         cmd_req.data.size = 0;
     }
 
-    ESP_LOGI(ZIG_CMD_NAMESPACE, "Sending command: addr=0x%04x, ep=%d, cl=0x%04x, cmd=0x%02x, data_len=%d", 
-        addr, endpoint, cluster_id, command_id, cmd_req.data.size);
+    ESP_LOGI(ZIG_CMD_NAMESPACE, "Sending command: addr=0x%04x, mode=%d, ep=%d, cl=0x%04x, cmd=0x%02x, data_len=%d", 
+        addr, mode, endpoint, cluster_id, command_id, cmd_req.data.size);
 
     // Send command
     ZB_LOCK();
     uint8_t tsn = esp_zb_zcl_custom_cluster_cmd_req(&cmd_req);
     ZB_UNLOCK();
 
-    // Free allocated memory
-    if (cmd_req.data.value != NULL) {
-        free(cmd_req.data.value);
+    return tsn;
+}
+
+
+static mp_obj_t esp32_zig_send_command(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    // Simplified argument check
+    mp_arg_check_num(n_args, kw_args->used, 1, MP_OBJ_FUN_ARGS_MAX, true);
+    
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+
+    // Check if network is formed
+    if (!self->config->network_formed) {
+        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
+        return mp_const_none;
+    }
+
+    enum { ARG_addr, ARG_ep, ARG_cl, ARG_cmd, ARG_data, ARG_manuf_code, ARG_default_resp, ARG_data_type, ARG_mode };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr,         MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,           MP_ARG_REQUIRED | MP_ARG_INT },  
+        { MP_QSTR_cl,           MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_cmd,          MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_data,         MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_manuf_code,   MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_default_resp, MP_ARG_BOOL, {.u_bool = false} },
+        { MP_QSTR_data_type,    MP_ARG_INT, {.u_int = ESP_ZB_ZCL_ATTR_TYPE_SET} }, // Default: 0x50U,  use for raw data send.
+        { MP_QSTR_mode,         MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = ZIG_ADDR_UNICAST} }, // addr is a device, group id or broadcast address
+    };
+    
+    // Parse args
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_buffer_info_t data_info = { .buf = NULL, .len = 0 };
+    if (args[ARG_data].u_obj != mp_const_none) {
+        mp_get_buffer_raise(args[ARG_data].u_obj, &data_info, MP_BUFFER_READ);
     }
 
+    uint8_t tsn = zig_cmd_send(args[ARG_addr].u_int, args[ARG_ep].u_int, args[ARG_mode].u_int,
+                               args[ARG_cl].u_int, args[ARG_cmd].u_int, args[ARG_manuf_code].u_int,
+                               args[ARG_default_resp].u_bool, args[ARG_data_type].u_int,
+                               data_info.buf, data_info.len);
     return mp_obj_new_int(tsn);
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_send_command_obj, 1, esp32_zig_send_command);
 
 
+// bind_cluster(addr, ep, cl, dst_addr=0, dst_ep=1, force=False)
+// Bind; False without sending when the binding mirror already has it
 static mp_obj_t esp32_zig_bind_cluster(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    enum { ARG_addr, ARG_ep, ARG_cl, ARG_dst_addr, ARG_dst_ep };
+    enum { ARG_addr, ARG_ep, ARG_cl, ARG_dst_addr, ARG_dst_ep, ARG_force };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_addr,     MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
         { MP_QSTR_ep,       MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
         { MP_QSTR_cl,       MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
         { MP_QSTR_dst_addr, MP_ARG_INT,                  {.u_int = 0} },
         { MP_QSTR_dst_ep,   MP_ARG_INT,                  {.u_int = ESP_ZB_GATEWAY_ENDPOINT} },
+        { MP_QSTR_force,    MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
     };
 
     // Parse arguments
@@ -290,43 +302,177 @@ static mp_obj_t esp32_zig_bind_cluster(size_t n_args, const mp_obj_t *pos_args,
     *bctx = (bind_ctx_t){ 
         .short_addr = addr,
         .endpoint = ep,
-        .cluster_id = cluster 
+        .cluster_id = cluster,
+        .dst_endpoint = dst_ep
     };
+    memcpy(bctx->src_ieee, bind_req.src_address, sizeof(bctx->src_ieee));
+    memcpy(bctx->dst_ieee, bind_req.dst_address_u.addr_long, sizeof(bctx->dst_ieee));
 
-    ESP_LOGI(ZIG_CMD_NAMESPACE, "Binding cluster: src=0x%04x ep=%d cluster=0x%04x -> dst=0x%04x ep=%d", 
-             addr, ep, cluster, dst_short ? dst_short : 0x0000, dst_ep);
-                          
-    // Send bind request
+    // Send bind request, unless the device is known to have it
     ZB_LOCK();
-    esp_zb_zdo_device_bind_req(&bind_req, bind_cb, bctx);
+    bool send = args[ARG_force].u_bool ||
+                !zig_binding_known(bctx->src_ieee, ep, cluster, bctx->dst_ieee, dst_ep);
+    if (send) {
+        esp_zb_zdo_device_bind_req(&bind_req, bind_cb, bctx);
+    } else if (dst_short == 0) {
+        // Bound to the gateway already: stored report configs are checked as after a bind
+        zig_report_sync(device, ep, cluster, NULL);
+    }
     ZB_UNLOCK();
 
-    return mp_const_none;
+    if (!send) {
+        free(bctx);
+        ESP_LOGI(ZIG_CMD_NAMESPACE, "Already bound: src=0x%04x ep=%d cluster=0x%04x", addr, ep, cluster);
+        return mp_const_false;
+    }
+    ESP_LOGI(ZIG_CMD_NAMESPACE, "Binding cluster: src=0x%04x ep=%d cluster=0x%04x -> dst=0x%04x ep=%d", 
+             addr, ep, cluster, dst_short ? dst_short : 0x0000, dst_ep);
+    return mp_const_true;
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_bind_cluster_obj, 1, esp32_zig_bind_cluster);
 
 
+size_t zig_report_change_size(uint8_t attr_type) {
+    if (attr_type >= ESP_ZB_ZCL_ATTR_TYPE_U8 && attr_type <= ESP_ZB_ZCL_ATTR_TYPE_U64) {
+        return attr_type - ESP_ZB_ZCL_ATTR_TYPE_U8 + 1;
+    }
+    if (attr_type >= ESP_ZB_ZCL_ATTR_TYPE_S8 && attr_type <= ESP_ZB_ZCL_ATTR_TYPE_S64) {
+        return attr_type - ESP_ZB_ZCL_ATTR_TYPE_S8 + 1;
+    }
+    switch (attr_type) {
+        case ESP_ZB_ZCL_ATTR_TYPE_SEMI:
+            return 2;
+        case ESP_ZB_ZCL_ATTR_TYPE_SINGLE:
+        case ESP_ZB_ZCL_ATTR_TYPE_TIME_OF_DAY:
+        case ESP_ZB_ZCL_ATTR_TYPE_DATE:
+        case ESP_ZB_ZCL_ATTR_TYPE_UTC_TIME:
+            return 4;
+        case ESP_ZB_ZCL_ATTR_TYPE_DOUBLE:
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+// Bytes a record takes in the Configure Reporting payload
+static size_t report_cfg_record_size(const report_cfg_t *cfg) {
+    if (cfg->direction == REPORT_CFG_DIRECTION_RECV) {
+        return 5;   // direction(1) + attr_id(2) + timeout(2)
+    }
+    // direction(1) + attr_id(2) + attr_type(1) + min(2) + max(2) + reportable change
+    return 8 + zig_report_change_size(cfg->send_cfg.attr_type);
+}
+
+size_t zig_report_cfg_send(uint16_t addr, uint8_t endpoint, uint16_t cluster_id,
+                           const report_cfg_t *cfgs, size_t count, uint8_t *tsns) {
+    esp_zb_zcl_config_report_record_t records[ZIG_REPORT_CFG_PER_FRAME];
+    uint64_t changes[ZIG_REPORT_CFG_PER_FRAME];   // Read by the stack up to the attribute size
+    size_t frames = 0;
+    size_t i = 0;
+
+    while (i < count) {
+        uint8_t n = 0;
+        size_t payload = 0;
+        memset(records, 0, sizeof(records));
+
+        while (i < count && n < ZIG_REPORT_CFG_PER_FRAME) {
+            const report_cfg_t *cfg = &cfgs[i];
+            size_t rec_len = report_cfg_record_size(cfg);
+            if (n > 0 && payload + rec_len > ZIG_ZCL_PAYLOAD_MAX) {
+                break;
+            }
+
+            esp_zb_zcl_config_report_record_t *rec = &records[n];
+            rec->attributeID = cfg->attr_id;
+            if (cfg->direction == REPORT_CFG_DIRECTION_RECV) {
+                rec->direction = ESP_ZB_ZCL_REPORT_DIRECTION_RECV;
+                rec->timeout = cfg->recv_cfg.timeout_period;
+            } else {
+                rec->direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND;
+                rec->attrType = cfg->send_cfg.attr_type;
+                rec->min_interval = cfg->send_cfg.min_int;
+                rec->max_interval = cfg->send_cfg.max_int;
+                // Unset change stays all ones: report on max interval only
+                changes[n] = cfg->send_cfg.reportable_change_val == 0xFFFFFFFF ? UINT64_MAX
+                                                                                : cfg->send_cfg.reportable_change_val;
+                rec->reportable_change = zig_report_change_size(rec->attrType) ? &changes[n] : NULL;
+            }
+            payload += rec_len;
+            n++;
+            i++;
+        }
+
+        esp_zb_zcl_config_report_cmd_t report_cmd;
+        memset(&report_cmd, 0, sizeof(report_cmd));
+        report_cmd.zcl_basic_cmd.dst_addr_u.addr_short = addr;
+        report_cmd.zcl_basic_cmd.dst_endpoint = endpoint;
+        report_cmd.zcl_basic_cmd.src_endpoint = ESP_ZB_GATEWAY_ENDPOINT;
+        report_cmd.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+        report_cmd.clusterID = cluster_id;
+        report_cmd.record_number = n;
+        report_cmd.record_field = records;
+
+        uint8_t tsn = esp_zb_zcl_config_report_cmd_req(&report_cmd);
+        ESP_LOGI(ZIG_CMD_NAMESPACE, "Configure reporting: addr=0x%04x, ep=%d, cl=0x%04x, records=%d, tsn=%d",
+                 addr, endpoint, cluster_id, n, tsn);
+        if (tsns) {
+            tsns[frames] = tsn;
+        }
+        frames++;
+    }
+    return frames;
+}
+
+// One record of configure_report(records=...):
+// (attr, attr_type, min_int, max_int[, reportable_change]) to send reports, (attr, timeout) to receive them
+static void report_cfg_from_obj(report_cfg_t *cfg, mp_obj_t item) {
+    size_t len;
+    mp_obj_t *rec;
+    mp_obj_get_array(item, &len, &rec);
+
+    memset(cfg, 0, sizeof(*cfg));
+    if (len == 2) {
+        cfg->direction = REPORT_CFG_DIRECTION_RECV;
+        cfg->attr_id = mp_obj_get_int(rec[0]);
+        cfg->recv_cfg.timeout_period = mp_obj_get_int(rec[1]);
+    } else if (len == 4 || len == 5) {
+        cfg->direction = REPORT_CFG_DIRECTION_SEND;
+        cfg->attr_id = mp_obj_get_int(rec[0]);
+        cfg->send_cfg.attr_type = mp_obj_get_int(rec[1]);
+        cfg->send_cfg.min_int = mp_obj_get_int(rec[2]);
+        cfg->send_cfg.max_int = mp_obj_get_int(rec[3]);
+        cfg->send_cfg.reportable_change_val = (len == 5 && rec[4] != mp_const_none)
+            ? (uint32_t)mp_obj_get_int_truncated(rec[4]) : 0xFFFFFFFF;
+    } else {
+        mp_raise_ValueError(MP_ERROR_TEXT("records items must be (attr, attr_type, min_int, max_int[, change]) or (attr, timeout)"));
+    }
+}
+
 // Python API: configure reporting for a bound cluster
+// Single attribute with attr=..., or records=[...] packed into as few frames as fit.
+// Returns the TSN, or a tuple of TSNs for records.
 static mp_obj_t esp32_zig_configure_report(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
 
     enum {
         ARG_addr, ARG_ep, ARG_cl, ARG_attr, ARG_direction, // Common args
         ARG_attr_type, ARG_min_int, ARG_max_int, ARG_reportable_change, // For SEND direction
-        ARG_timeout // For RECV direction
+        ARG_timeout, // For RECV direction
+        ARG_records // Several attributes of the cluster
     };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_addr,     MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
         { MP_QSTR_ep,       MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
         { MP_QSTR_cl,       MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} }, // cluster_id
-        { MP_QSTR_attr,     MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} }, // attr_id
+        { MP_QSTR_attr,     MP_ARG_OBJ, {.u_obj = mp_const_none} }, // attr_id, or records
         { MP_QSTR_direction, MP_ARG_INT, {.u_int = REPORT_CFG_DIRECTION_SEND} }, // Default to SEND
         // Args for SEND direction (conditionally required/optional)
-        { MP_QSTR_attr_type, MP_ARG_INT, {.u_int = 0} }, // Will be checked if direction is SEND
+        { MP_QSTR_attr_type, MP_ARG_INT, {.u_int = -1} }, // Will be checked if direction is SEND
         { MP_QSTR_min_int, MP_ARG_INT, {.u_int = 300} },
         { MP_QSTR_max_int, MP_ARG_INT, {.u_int = 3600} },
         { MP_QSTR_reportable_change, MP_ARG_INT, {.u_int = -1} }, // -1 signifies not set by user for SEND
         // Arg for RECV direction (conditionally required)
         { MP_QSTR_timeout,  MP_ARG_INT, {.u_int = 0xFFFF} }, // Marker for not set for RECV
+        { MP_QSTR_records,  MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
     };
 
     mp_arg_val_t vals[MP_ARRAY_SIZE(allowed_args)];
@@ -335,166 +481,98 @@ static mp_obj_t esp32_zig_configure_report(size_t n_args, const mp_obj_t *pos_ar
     uint16_t addr_val = vals[ARG_addr].u_int;
     uint8_t ep_val = vals[ARG_ep].u_int;
     uint16_t cluster_id_val = vals[ARG_cl].u_int;
-    uint16_t attribute_id_val = vals[ARG_attr].u_int;
-    uint8_t direction_val = (uint8_t)vals[ARG_direction].u_int;
-
-    esp_zb_zcl_config_report_cmd_t report_cmd;
-    esp_zb_zcl_config_report_record_t record;
-    memset(&report_cmd, 0, sizeof(report_cmd));
-    memset(&record, 0, sizeof(record));
-
-    report_cmd.zcl_basic_cmd.dst_addr_u.addr_short = addr_val;
-    report_cmd.zcl_basic_cmd.dst_endpoint = ep_val;
-    report_cmd.zcl_basic_cmd.src_endpoint = ESP_ZB_GATEWAY_ENDPOINT; // Assuming this is the gateway's endpoint
-    report_cmd.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
-    report_cmd.clusterID = cluster_id_val;
-    report_cmd.record_number = 1;
-    report_cmd.record_field = &record; 
-    // report_cmd.direction is for the command itself, usually TO_SRV, this is implicitly set or default
-
-    record.attributeID = attribute_id_val;
-    record.direction = direction_val; // This is esp_zb_zcl_report_direction_t
-
-    uint32_t *allocated_reportable_change_val = NULL;
-
-    if (direction_val == REPORT_CFG_DIRECTION_SEND) {
-        // Check if attr_type was actually passed using mp_map_lookup
-        mp_map_elem_t *elem_attr_type = mp_map_lookup(kw_args, MP_OBJ_NEW_QSTR(MP_QSTR_attr_type), MP_MAP_LOOKUP);
-        if (elem_attr_type == NULL) { // attr_type was not provided
-             mp_raise_ValueError("attr_type is required for SEND direction");
+
+    if (vals[ARG_records].u_obj != mp_const_none) {
+        size_t total;
+        mp_obj_t *items;
+        mp_obj_get_array(vals[ARG_records].u_obj, &total, &items);
+        if (total == 0) {
+            mp_raise_ValueError(MP_ERROR_TEXT("records is empty"));
+        }
+
+        // Validate all records before sending anything
+        report_cfg_t *cfgs = m_new(report_cfg_t, total);
+        for (size_t i = 0; i < total; i++) {
+            report_cfg_from_obj(&cfgs[i], items[i]);
         }
-        // Access fields of esp_zb_zcl_config_report_record_t directly for SEND case
-        record.attrType = (uint8_t)vals[ARG_attr_type].u_int;
-        record.min_interval = (uint16_t)vals[ARG_min_int].u_int;
-        record.max_interval = (uint16_t)vals[ARG_max_int].u_int;
 
-        int reportable_change_input = vals[ARG_reportable_change].u_int;
+        uint8_t *tsns = m_new(uint8_t, total);
+        ZB_LOCK();
+        size_t frames = zig_report_cfg_send(addr_val, ep_val, cluster_id_val, cfgs, total, tsns);
+        ZB_UNLOCK();
 
-        // Always allocate memory for SEND direction / always allocate memory for SEND direction
-        allocated_reportable_change_val = malloc(sizeof(uint32_t));
-        if (allocated_reportable_change_val == NULL) {
-            mp_raise_msg(&mp_type_MemoryError, "Failed to allocate for reportable_change");
+        mp_obj_tuple_t *ret = MP_OBJ_TO_PTR(mp_obj_new_tuple(frames, NULL));
+        for (size_t i = 0; i < frames; i++) {
+            ret->items[i] = MP_OBJ_NEW_SMALL_INT(tsns[i]);
         }
-        
-        if (reportable_change_input != -1) {
-            // User specified value
-            *allocated_reportable_change_val = (uint32_t)reportable_change_input;
-        } else {
-            // User did not specify - use 0 (any change) or 0xFFFFFFFF (only by time)
-                *allocated_reportable_change_val = 0xFFFFFFFF; // Only by time
-            }
-        record.reportable_change = allocated_reportable_change_val;
+        m_del(report_cfg_t, cfgs, total);
+        m_del(uint8_t, tsns, total);
+        return MP_OBJ_FROM_PTR(ret);
+    }
+
+    if (vals[ARG_attr].u_obj == mp_const_none) {
+        mp_raise_TypeError(MP_ERROR_TEXT("attr or records required"));
+    }
 
+    report_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.attr_id = mp_obj_get_int(vals[ARG_attr].u_obj);
+    cfg.direction = (uint8_t)vals[ARG_direction].u_int;
 
-    } else if (direction_val == REPORT_CFG_DIRECTION_RECV) {
+    if (cfg.direction == REPORT_CFG_DIRECTION_SEND) {
+        if (vals[ARG_attr_type].u_int == -1) { // attr_type was not provided
+             mp_raise_ValueError("attr_type is required for SEND direction");
+        }
+        cfg.send_cfg.attr_type = (uint8_t)vals[ARG_attr_type].u_int;
+        cfg.send_cfg.min_int = (uint16_t)vals[ARG_min_int].u_int;
+        cfg.send_cfg.max_int = (uint16_t)vals[ARG_max_int].u_int;
+        // User did not specify - 0xFFFFFFFF (only by time)
+        cfg.send_cfg.reportable_change_val = vals[ARG_reportable_change].u_int != -1
+            ? (uint32_t)vals[ARG_reportable_change].u_int : 0xFFFFFFFF;
+    } else if (cfg.direction == REPORT_CFG_DIRECTION_RECV) {
         // Check if timeout was actually passed or is still marker
         if (vals[ARG_timeout].u_int == 0xFFFF) { 
              mp_raise_ValueError("timeout is required for RECV direction");
         }
-        // Access field of esp_zb_zcl_config_report_record_t directly for RECV case
-        record.timeout = (uint16_t)vals[ARG_timeout].u_int;
+        cfg.recv_cfg.timeout_period = (uint16_t)vals[ARG_timeout].u_int;
     } else {
         mp_raise_ValueError("Invalid direction value");
     }
 
     uint8_t tsn;
     ZB_LOCK();
-    tsn = esp_zb_zcl_config_report_cmd_req(&report_cmd);
+    zig_report_cfg_send(addr_val, ep_val, cluster_id_val, &cfg, 1, &tsn);
     ZB_UNLOCK();
 
-    if (allocated_reportable_change_val != NULL) {
-        free(allocated_reportable_change_val);
-    }
-
     return mp_obj_new_int(tsn);
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_configure_report_obj, 1, esp32_zig_configure_report);
 
 
 
-// Python API: set preconfigured report parameters for a device
-static mp_obj_t esp32_zig_set_report_config(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-
-    enum {
-        ARG_addr, ARG_ep, ARG_cl, ARG_attr, ARG_direction, // Common args
-        ARG_attr_type, ARG_min_int, ARG_max_int, ARG_reportable_change, // For SEND direction
-        ARG_timeout // For RECV direction
-    };
-    static const mp_arg_t allowed_args[] = {
-        { MP_QSTR_addr,                 MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
-        { MP_QSTR_ep,                   MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
-        { MP_QSTR_cl,                   MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
-        { MP_QSTR_attr,                 MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
-
-        { MP_QSTR_direction,            MP_ARG_INT, {.u_int = REPORT_CFG_DIRECTION_SEND} }, // Default to SEND
-        // Args for SEND direction (conditionally required)
-        { MP_QSTR_attr_type,            MP_ARG_INT, {.u_int = 0} },          // Made optional here, will check dependency later
-        { MP_QSTR_min_int,              MP_ARG_INT, {.u_int = 0} },
-        { MP_QSTR_max_int,              MP_ARG_INT, {.u_int = 30} },
-        { MP_QSTR_reportable_change,    MP_ARG_INT, {.u_int = 0xFFFFFFFF} }, // Marker for not set
-        // Arg for RECV direction (conditionally required)
-        { MP_QSTR_timeout,              MP_ARG_INT, {.u_int = 0xFFFF} },    // Marker for not set / default for RECV
+// Send one Read Attributes frame
+static uint8_t read_attr_frame(uint16_t addr, uint8_t endpoint, uint16_t cluster_id, uint16_t manuf_code,
+                               uint16_t *attr_ids, uint8_t count) {
+    esp_zb_zcl_read_attr_cmd_t read_req = {
+        .zcl_basic_cmd = { .dst_addr_u = { .addr_short = addr }, .dst_endpoint = endpoint, .src_endpoint = ESP_ZB_GATEWAY_ENDPOINT },
+        .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+        .clusterID = cluster_id,
+        .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV,
+        .manuf_specific = manuf_code > 0 ? 1 : 0,
+        .manuf_code = manuf_code,
+        .attr_number = count,
+        .attr_field = attr_ids
     };
-
-    mp_arg_val_t vals[MP_ARRAY_SIZE(allowed_args)];
-    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, vals);
-
-    uint16_t addr_val      = vals[ARG_addr].u_int;
-    uint8_t  ep_val        = vals[ARG_ep].u_int;
-    uint16_t cl_val        = vals[ARG_cl].u_int;
-    uint16_t attr_id_val   = vals[ARG_attr].u_int;
-    uint8_t  direction_val = (uint8_t)vals[ARG_direction].u_int;
-
-    zigbee_device_t *dev = device_manager_get(addr_val);
-    if (!dev) {
-        mp_raise_msg_varg(&mp_type_ValueError, "Device 0x%04x not found", addr_val);
-    }
-    
-    report_cfg_t *r_cfg = NULL;
-    for (int j = 0; j < MAX_REPORT_CFGS; j++) {
-        if (!dev->report_cfgs[j].in_use) {
-            r_cfg = &dev->report_cfgs[j];
-            break;
-        }
-    }
-
-    if (!r_cfg) {
-        mp_raise_msg(&mp_type_RuntimeError, "No free report slots");
-        return mp_const_none; // Should not reach here due to raise
-    }
-
-    r_cfg->in_use      = true;
-    r_cfg->direction   = direction_val;
-    r_cfg->ep          = ep_val;
-    r_cfg->cluster_id  = cl_val;
-    r_cfg->attr_id     = attr_id_val;
-
-    if (direction_val == REPORT_CFG_DIRECTION_SEND) {
-        // attr_type is required for SEND direction
-        mp_map_elem_t *elem_attr_type = mp_map_lookup(kw_args, MP_OBJ_NEW_QSTR(MP_QSTR_attr_type), MP_MAP_LOOKUP);
-        if (elem_attr_type == NULL) { // Check if attr_type was actually passed
-             mp_raise_ValueError("attr_type is required for SEND direction");
-        }
-        r_cfg->send_cfg.attr_type = (uint8_t)vals[ARG_attr_type].u_int;
-        r_cfg->send_cfg.min_int = (uint16_t)vals[ARG_min_int].u_int;
-        r_cfg->send_cfg.max_int = (uint16_t)vals[ARG_max_int].u_int;
-        r_cfg->send_cfg.reportable_change_val = (uint32_t)vals[ARG_reportable_change].u_int;
-    } else if (direction_val == REPORT_CFG_DIRECTION_RECV) {
-        // timeout is required for RECV direction
-        if (vals[ARG_timeout].u_int == 0xFFFF) { // Check if timeout was actually passed or is still marker
-             mp_raise_ValueError("timeout is required for RECV direction");
-        }
-        r_cfg->recv_cfg.timeout_period = (uint16_t)vals[ARG_timeout].u_int;
-    } else {
-        mp_raise_ValueError("Invalid direction value");
-    }
-
-    return mp_const_true;
+    uint8_t tsn;
+    ZB_LOCK();
+    tsn = esp_zb_zcl_read_attr_cmd_req(&read_req);
+    ZB_UNLOCK();
+    return tsn;
 }
-MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_set_report_config_obj, 1, esp32_zig_set_report_config);
 
-
-// Modify attribute reading function
+// read_attr(addr, ep, cluster, attr_id=None, attrs=None, manuf_code=0)
+// Single attr_id returns the TSN. attrs=[...] packs the ids into as few frames as
+// possible (ZIG_READ_ATTR_PER_FRAME each) and returns a tuple of TSNs, one per frame.
 static mp_obj_t esp32_zig_read_attr(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     // Simplified argument check
     mp_arg_check_num(n_args, kw_args->used, 1, MP_OBJ_FUN_ARGS_MAX, true);
@@ -507,12 +585,14 @@ static mp_obj_t esp32_zig_read_attr(size_t n_args, const mp_obj_t *pos_args, mp_
         return mp_const_none;
     }
 
-    enum { ARG_addr, ARG_ep, ARG_cluster, ARG_attr_id };
+    enum { ARG_addr, ARG_ep, ARG_cluster, ARG_attr_id, ARG_attrs, ARG_manuf_code };
     static const mp_arg_t allowed_args[] = {
-        { MP_QSTR_addr,    MP_ARG_REQUIRED | MP_ARG_INT },
-        { MP_QSTR_ep,      MP_ARG_REQUIRED | MP_ARG_INT },
-        { MP_QSTR_cluster, MP_ARG_REQUIRED | MP_ARG_INT },
-        { MP_QSTR_attr_id, MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_addr,       MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,         MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_cluster,    MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_attr_id,    MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_attrs,      MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_manuf_code, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
     };
 
     // Parse args
@@ -522,28 +602,93 @@ static mp_obj_t esp32_zig_read_attr(size_t n_args, const mp_obj_t *pos_args, mp_
     uint16_t addr = args[ARG_addr].u_int;
     uint8_t endpoint = args[ARG_ep].u_int;
     uint16_t cluster_id = args[ARG_cluster].u_int;
-    uint16_t attr_id = args[ARG_attr_id].u_int;
-    uint16_t *attr_field = malloc(sizeof(uint16_t));
-    *attr_field = attr_id;
+    uint16_t manuf_code = args[ARG_manuf_code].u_int;
 
-    esp_zb_zcl_read_attr_cmd_t read_req = {
-        .zcl_basic_cmd = { .dst_addr_u = { .addr_short = addr }, .dst_endpoint = endpoint, .src_endpoint = ESP_ZB_GATEWAY_ENDPOINT },
+    // Attribute ids live on the stack, the stack copies them into the frame
+    uint16_t attr_ids[ZIG_READ_ATTR_PER_FRAME];
+
+    if (args[ARG_attrs].u_obj == mp_const_none) {
+        if (args[ARG_attr_id].u_obj == mp_const_none) {
+            mp_raise_TypeError(MP_ERROR_TEXT("attr_id or attrs required"));
+        }
+        attr_ids[0] = mp_obj_get_int(args[ARG_attr_id].u_obj);
+        return mp_obj_new_int(read_attr_frame(addr, endpoint, cluster_id, manuf_code, attr_ids, 1));
+    }
+
+    size_t total;
+    mp_obj_t *items;
+    mp_obj_get_array(args[ARG_attrs].u_obj, &total, &items);
+    if (total == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("attrs is empty"));
+    }
+
+    // Convert all ids before sending anything
+    uint16_t *ids = m_new(uint16_t, total);
+    for (size_t i = 0; i < total; i++) {
+        mp_int_t id = mp_obj_get_int(items[i]);
+        if (id < 0 || id > 0xFFFF) {
+            mp_raise_ValueError(MP_ERROR_TEXT("attr_id out of range"));
+        }
+        ids[i] = id;
+    }
+
+    size_t frames = (total + ZIG_READ_ATTR_PER_FRAME - 1) / ZIG_READ_ATTR_PER_FRAME;
+    mp_obj_tuple_t *tsns = MP_OBJ_TO_PTR(mp_obj_new_tuple(frames, NULL));
+    for (size_t f = 0; f < frames; f++) {
+        size_t first = f * ZIG_READ_ATTR_PER_FRAME;
+        size_t left = total - first;
+        uint8_t count = left > ZIG_READ_ATTR_PER_FRAME ? ZIG_READ_ATTR_PER_FRAME : left;
+        tsns->items[f] = mp_obj_new_int(read_attr_frame(addr, endpoint, cluster_id, manuf_code, &ids[first], count));
+    }
+    m_del(uint16_t, ids, total);
+
+    return MP_OBJ_FROM_PTR(tsns);
+}
+
+// Send one Write Attributes frame
+static uint8_t write_attr_frame(uint16_t addr, uint8_t endpoint, uint16_t cluster_id, uint16_t manuf_code,
+                                esp_zb_zcl_attribute_t *attrs, uint8_t count) {
+    esp_zb_zcl_write_attr_cmd_t cmd = {
+        .zcl_basic_cmd = {
+            .dst_addr_u.addr_short = addr,
+            .dst_endpoint = endpoint,
+            .src_endpoint = ESP_ZB_GATEWAY_ENDPOINT,
+        },
         .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
         .clusterID = cluster_id,
         .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV,
-        .attr_number = 1,
-        .attr_field = attr_field
+        .dis_defalut_resp = 0,
+        .manuf_specific = manuf_code > 0 ? 1 : 0,
+        .manuf_code = manuf_code,
+        .attr_number = count,
+        .attr_field = attrs
     };
     uint8_t tsn;
     ZB_LOCK();
-    tsn = esp_zb_zcl_read_attr_cmd_req(&read_req);
+    tsn = esp_zb_zcl_write_attr_cmd_req(&cmd);
     ZB_UNLOCK();
-    free(attr_field);
+    return tsn;
+}
 
-    return mp_obj_new_int(tsn);
+// Fill attribute record from (attr_id, attr_type, value), value is any buffer
+static size_t write_attr_record(esp_zb_zcl_attribute_t *attr, mp_obj_t id_obj, mp_obj_t type_obj, mp_obj_t value_obj) {
+    mp_buffer_info_t buf_info;
+    mp_get_buffer_raise(value_obj, &buf_info, MP_BUFFER_READ);
+    if (buf_info.len + 3 > ZIG_ZCL_PAYLOAD_MAX) {
+        mp_raise_ValueError(MP_ERROR_TEXT("attribute value too long"));
+    }
+    attr->id = mp_obj_get_int(id_obj);
+    attr->data.type = mp_obj_get_int(type_obj);
+    attr->data.size = buf_info.len;
+    attr->data.value = buf_info.buf;
+    // Record on air: id(2) + type(1) + value
+    return 3 + buf_info.len;
 }
 
-// Modify attribute writing function
+// write_attr(addr, ep, cluster, attr_id, attr_type, value, *, attrs=None, manuf_code=0)
+// attrs=[(attr_id, attr_type, value), ...] packs the records into as few Write Attributes
+// frames as fit and returns a tuple of TSNs, one per frame. Per-attribute status arrives
+// as ESP_ZB_CORE_CMD_WRITE_ATTR_RESP_CB_ID message.
 static mp_obj_t esp32_zig_write_attr(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     // Simplified argument check
     mp_arg_check_num(n_args, kw_args->used, 1, MP_OBJ_FUN_ARGS_MAX, true);
@@ -556,14 +701,16 @@ static mp_obj_t esp32_zig_write_attr(size_t n_args, const mp_obj_t *pos_args, mp
         return mp_const_none;
     }
 
-    enum { ARG_addr, ARG_ep, ARG_cluster, ARG_attr_id, ARG_attr_type, ARG_value };
+    enum { ARG_addr, ARG_ep, ARG_cluster, ARG_attr_id, ARG_attr_type, ARG_value, ARG_attrs, ARG_manuf_code };
     static const mp_arg_t allowed_args[] = {
-        { MP_QSTR_addr,      MP_ARG_REQUIRED | MP_ARG_INT },
-        { MP_QSTR_ep,        MP_ARG_REQUIRED | MP_ARG_INT },
-        { MP_QSTR_cluster,   MP_ARG_REQUIRED | MP_ARG_INT },
-        { MP_QSTR_attr_id,   MP_ARG_REQUIRED | MP_ARG_INT },
-        { MP_QSTR_attr_type, MP_ARG_REQUIRED | MP_ARG_INT },
-        { MP_QSTR_value,     MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_addr,       MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,         MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_cluster,    MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_attr_id,    MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_attr_type,  MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_value,      MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_attrs,      MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_manuf_code, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = 0} },
     };
 
     // Parse args
@@ -573,45 +720,61 @@ static mp_obj_t esp32_zig_write_attr(size_t n_args, const mp_obj_t *pos_args, mp
     uint16_t addr = args[ARG_addr].u_int;
     uint8_t endpoint = args[ARG_ep].u_int;
     uint16_t cluster = args[ARG_cluster].u_int;
-    uint16_t attr_id = args[ARG_attr_id].u_int;
-    uint8_t attr_type = args[ARG_attr_type].u_int;
-    mp_obj_t value = args[ARG_value].u_obj;
+    uint16_t manuf_code = args[ARG_manuf_code].u_int;
 
-    // Get data buffer
-    mp_buffer_info_t buf_info;
-    mp_get_buffer_raise(value, &buf_info, MP_BUFFER_READ);
-    
-    // Prepare attribute structure
-    esp_zb_zcl_attribute_t attr = {
-        .id = attr_id,
-        .data = {
-            .type = attr_type,
-            .size = buf_info.len,
-            .value = buf_info.buf
+    // Records point into the Python buffers, the stack copies them into the frame
+    esp_zb_zcl_attribute_t attrs[ZIG_WRITE_ATTR_PER_FRAME];
+
+    if (args[ARG_attrs].u_obj == mp_const_none) {
+        if (args[ARG_attr_id].u_obj == mp_const_none || args[ARG_attr_type].u_obj == mp_const_none ||
+            args[ARG_value].u_obj == mp_const_none) {
+            mp_raise_TypeError(MP_ERROR_TEXT("attr_id, attr_type and value or attrs required"));
         }
-    };
+        write_attr_record(&attrs[0], args[ARG_attr_id].u_obj, args[ARG_attr_type].u_obj, args[ARG_value].u_obj);
+        return mp_obj_new_int(write_attr_frame(addr, endpoint, cluster, manuf_code, attrs, 1));
+    }
 
-    // Prepare command structure
-    esp_zb_zcl_write_attr_cmd_t cmd = {
-        .zcl_basic_cmd = {
-            .dst_addr_u.addr_short = addr,
-            .dst_endpoint = endpoint,
-            .src_endpoint = ESP_ZB_GATEWAY_ENDPOINT,
-        },
-        .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
-        .clusterID = cluster,
-        .dis_defalut_resp = 0,
-        .manuf_code = 0,
-        .attr_number = 1,
-        .attr_field = &attr
-    };
+    size_t total;
+    mp_obj_t *items;
+    mp_obj_get_array(args[ARG_attrs].u_obj, &total, &items);
+    if (total == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("attrs is empty"));
+    }
 
-    // Send command
-    ZB_LOCK();
-    uint8_t tsn_write = esp_zb_zcl_write_attr_cmd_req(&cmd);
-    ZB_UNLOCK();
+    // Validate all records before sending anything
+    for (size_t i = 0; i < total; i++) {
+        size_t len;
+        mp_obj_t *rec;
+        mp_obj_get_array(items[i], &len, &rec);
+        if (len != 3) {
+            mp_raise_ValueError(MP_ERROR_TEXT("attrs items must be (attr_id, attr_type, value)"));
+        }
+        write_attr_record(&attrs[0], rec[0], rec[1], rec[2]);
+    }
 
-    return mp_obj_new_int(tsn_write);
+    mp_obj_t tsns = mp_obj_new_list(0, NULL);
+    size_t i = 0;
+    while (i < total) {
+        uint8_t count = 0;
+        size_t payload = 0;
+        while (i < total && count < ZIG_WRITE_ATTR_PER_FRAME) {
+            mp_obj_t *rec;
+            mp_obj_get_array_fixed_n(items[i], 3, &rec);
+            size_t rec_len = write_attr_record(&attrs[count], rec[0], rec[1], rec[2]);
+            if (count > 0 && payload + rec_len > ZIG_ZCL_PAYLOAD_MAX) {
+                break;
+            }
+            payload += rec_len;
+            count++;
+            i++;
+        }
+        mp_obj_list_append(tsns, mp_obj_new_int(write_attr_frame(addr, endpoint, cluster, manuf_code, attrs, count)));
+    }
+
+    size_t frames;
+    mp_obj_t *tsn_items;
+    mp_obj_get_array(tsns, &frames, &tsn_items);
+    return mp_obj_new_tuple(frames, tsn_items);
 }
 
 MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_read_attr_obj, 1, esp32_zig_read_attr);
@@ -619,33 +782,4 @@ MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_write_attr_obj, 1, esp32_zig_write_attr);
 
 
 
-// Python API: request binding table from a device
-static mp_obj_t esp32_zig_get_binding_table(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    enum { ARG_addr, ARG_start_index };
-    static const mp_arg_t allowed_args[] = {
-        { MP_QSTR_addr,         MP_ARG_REQUIRED  | MP_ARG_INT },
-        { MP_QSTR_start_index,  MP_ARG_INT,      {.u_int = 0} },
-    };
-    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
-    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args,
-                     MP_ARRAY_SIZE(allowed_args), allowed_args, args);
-
-    uint16_t addr        = (uint16_t)args[ARG_addr].u_int;
-    uint8_t  start_index = (uint8_t) args[ARG_start_index].u_int;
-
-    esp_zb_zdo_mgmt_bind_param_t req = {
-        .start_index = start_index,
-        .dst_addr    = addr,
-    };
-
-    ZB_LOCK();
-    esp_zb_zdo_binding_table_req(&req, binding_table_cb, (void*)(uintptr_t)addr);
-    ZB_UNLOCK();
-
-    return mp_const_none;
-}
-MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_get_binding_table_obj, 1, esp32_zig_get_binding_table);
-
-
-
 
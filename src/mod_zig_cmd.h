@@ -14,6 +14,75 @@
 
 
 
+// ZCL payload of one frame: unfragmented APS payload (82 bytes)
+// minus a manufacturer-specific ZCL header (5 bytes)
+#define ZIG_ZCL_PAYLOAD_MAX (82 - 5)
+
+// Attribute ids per Read Attributes frame, 2 bytes per id
+#define ZIG_READ_ATTR_PER_FRAME (ZIG_ZCL_PAYLOAD_MAX / 2)
+
+// Write Attributes records per frame (id, type and at least one byte of value)
+#define ZIG_WRITE_ATTR_PER_FRAME 16
+
+// Configure Reporting records per frame (5 bytes each for the shortest, receive records)
+#define ZIG_REPORT_CFG_PER_FRAME (ZIG_ZCL_PAYLOAD_MAX / 5)
+
+// send_command(mode=...): what addr is
+#define ZIG_ADDR_UNICAST    0       /* Short address of a device */
+#define ZIG_ADDR_GROUP      1       /* Group id */
+#define ZIG_ADDR_BROADCAST  2       /* One of the broadcast addresses below */
+
+// Broadcast addresses
+#define ZIG_BROADCAST_ALL       0xFFFF  /* All devices, sleepy end devices included */
+#define ZIG_BROADCAST_RX_ON     0xFFFD  /* Devices with receiver on when idle */
+#define ZIG_BROADCAST_ROUTERS   0xFFFC  /* Coordinator and routers */
+
+/**
+ * @brief Send a cluster command from the gateway endpoint
+ *
+ * Shared by send_command() and the typed control helpers. Raises ValueError
+ * for a bad mode or broadcast address.
+ *
+ * @param addr Device short address, group id or broadcast address
+ * @param endpoint Destination endpoint, ignored for groups
+ * @param mode ZIG_ADDR_UNICAST, ZIG_ADDR_GROUP or ZIG_ADDR_BROADCAST
+ * @param cluster_id Cluster id
+ * @param command_id Cluster command id
+ * @param manuf_code Manufacturer code, 0 for a standard command
+ * @param default_resp Value of the disable default response bit for unicasts
+ * @param data_type Payload type, ESP_ZB_ZCL_ATTR_TYPE_SET for raw bytes
+ * @param data Payload, NULL for none. Only read during the call
+ * @param data_len Length of payload
+ * @return uint8_t TSN of the frame
+ */
+uint8_t zig_cmd_send(uint16_t addr, uint8_t endpoint, int mode, uint16_t cluster_id, uint8_t command_id,
+                     uint16_t manuf_code, bool default_resp, uint8_t data_type, const void *data, uint16_t data_len);
+
+/**
+ * @brief Size of the Reportable Change field for an attribute type
+ *
+ * @param attr_type ZCL attribute type
+ * @return size_t Bytes of the field, 0 for discrete types that carry none
+ */
+size_t zig_report_change_size(uint8_t attr_type);
+
+/**
+ * @brief Send Configure Reporting for several attributes of one cluster
+ *
+ * Records are packed into as few frames as the ZCL payload allows. Called
+ * from the Zigbee task, or from MicroPython with ZB_LOCK held.
+ *
+ * @param addr Device short address
+ * @param endpoint Device endpoint
+ * @param cluster_id Cluster of all records
+ * @param cfgs Records, in_use / ep / cluster_id fields are ignored
+ * @param count Number of records
+ * @param tsns TSN of every frame sent, room for count entries, or NULL
+ * @return size_t Number of frames sent
+ */
+size_t zig_report_cfg_send(uint16_t addr, uint8_t endpoint, uint16_t cluster_id,
+                           const report_cfg_t *cfgs, size_t count, uint8_t *tsns);
+
 //Send Command
 extern const mp_obj_fun_builtin_var_t   esp32_zig_send_command_obj;               // Send command to device
 
@@ -23,11 +92,8 @@ extern const mp_obj_fun_builtin_fixed_t esp32_zig_any_obj;
 
 extern const mp_obj_fun_builtin_var_t esp32_zig_bind_cluster_obj;                 // Bind cluster to device
 extern const mp_obj_fun_builtin_var_t esp32_zig_configure_report_obj;             // Configure report for device
-extern const mp_obj_fun_builtin_var_t esp32_zig_set_report_config_obj;           // Set report configuration for device
 extern const mp_obj_fun_builtin_var_t esp32_zig_read_attr_obj;                   // Read attribute from device
 extern const mp_obj_fun_builtin_var_t esp32_zig_write_attr_obj;                  // Write attribute to device
-
-extern const mp_obj_fun_builtin_var_t esp32_zig_get_binding_table_obj;            // Get binding table from device
     
 
 
@@ -42,6 +42,7 @@
 // mod_zig_core.c
 #include "mod_zig_core.h"
 #include "mod_zig_handlers.h"
+#include "mod_zig_route.h"
 #include "mod_zig_custom.h"  // Adding header file inclusion
 #include "main.h"  // Adding for access to constants
 #include "device_storage.h"  // Adding for device storage functions
@@ -248,11 +249,14 @@ esp_err_t init_zigbee_gateway(esp32_zig_obj_t *self) {
     ESP_LOGI(TAG, "GATEWAY:INIT: Initializing Zigbee stack");
     esp_zb_init(&zb_nwk_cfg);
 
+    // Concentrator mode starts once the network is formed or restored
+    zig_route_configure(self->config->concentrator, self->config->discovery_interval);
+
     ESP_ERROR_CHECK(check_rcp_version());
 
 
-    ESP_LOGI(TAG, "GATEWAY:INIT: Setting primary channel");
-    esp_zb_set_primary_network_channel_set(ESP_ZB_PRIMARY_CHANNEL_MASK);
+    ESP_LOGI(TAG, "GATEWAY:INIT: Setting primary channel mask 0x%08lx", (unsigned long)self->config->channel_mask);
+    esp_zb_set_primary_network_channel_set(self->config->channel_mask);
 
     // Create endpoint list and cluster list
     ESP_LOGI(TAG, "ZIGBEE: Creating endpoint list and cluster list");
@@ -306,6 +310,11 @@ esp_err_t init_zigbee_gateway(esp32_zig_obj_t *self) {
         esp_zb_attribute_list_t *onoff_client = esp_zb_on_off_cluster_create(&onoff_cfg);
         esp_zb_cluster_list_add_on_off_cluster(cluster_list, onoff_client, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE);
     }
+    // Add Groups cluster as client so Add/Remove/View Group responses reach the gateway
+    {
+        esp_zb_attribute_list_t *groups_client = esp_zb_groups_cluster_create(NULL);
+        esp_zb_cluster_list_add_groups_cluster(cluster_list, groups_client, ESP_ZB_ZCL_CLUSTER_CLIENT_ROLE);
+    }
     // Add IAS Zone cluster as client for alarm/sensor reports
     {
         esp_zb_ias_zone_cluster_cfg_t ias_cfg = {0};
@@ -371,14 +380,22 @@ static void zigbee_commissioning_task(void *pvParameters) {
 
     // Load all devices from storage first
     ESP_LOGI(TAG, "GATEWAY:TASK: Loading devices from storage...");
-    device_storage_load_all(self);
-
-    // Wait for device loading to complete
-    esp_err_t wait_result = device_storage_wait_load_complete(pdMS_TO_TICKS(5000));
-    if (wait_result != ESP_OK) {
-        ESP_LOGW(TAG, "Timeout waiting for device loading, continuing with empty device list");
+    if (device_storage_load_all(self) == ESP_OK) {
+        // Wait for device loading to complete, budget grows with the number of records
+        esp_err_t wait_result = device_storage_wait_load_complete(pdMS_TO_TICKS(DEVICE_STORAGE_LOAD_BASE_MS));
+        const device_storage_stats_t *stats = device_storage_get_stats();
+        if (wait_result != ESP_OK) {
+            ESP_LOGW(TAG, "Timeout waiting for device loading (%u/%u loaded), continuing with partial device list",
+                     (unsigned)stats->load_ok, (unsigned)stats->load_records);
+        } else if (stats->index_records > 0) {
+            ESP_LOGI(TAG, "Device index loaded: %u devices in %u ms, records follow in background",
+                     (unsigned)stats->index_records, (unsigned)stats->index_ms);
+        } else {
+            ESP_LOGI(TAG, "Device loading completed: %u devices in %u ms",
+                     (unsigned)stats->load_ok, (unsigned)stats->load_ms);
+        }
     } else {
-        ESP_LOGI(TAG, "Device loading completed successfully");
+        ESP_LOGW(TAG, "Device loading not started, continuing with empty device list");
     }
 
     // Initialize Zigbee gateway
@@ -434,10 +451,15 @@ esp_err_t esp32_zig_start_gateway(esp32_zig_obj_t *self) {
         return ESP_FAIL;
     }
 
-    // Wait for commissioning task to complete
-    if (xSemaphoreTake(commissioning_done_semaphore, pdMS_TO_TICKS(10000)) != pdTRUE) {
-        ESP_LOGE(TAG, "Timeout waiting for commissioning task");
-        return ESP_FAIL;
+    // Wait for commissioning task to complete.
+    // Device loading runs as scheduled Python callbacks, so keep servicing them while waiting.
+    TickType_t wait_start = xTaskGetTickCount();
+    while (xSemaphoreTake(commissioning_done_semaphore, pdMS_TO_TICKS(10)) != pdTRUE) {
+        mp_event_handle_nowait();
+        if ((xTaskGetTickCount() - wait_start) >= device_storage_load_budget(pdMS_TO_TICKS(10000))) {
+            ESP_LOGE(TAG, "Timeout waiting for commissioning task");
+            return ESP_FAIL;
+        }
     }
 
     // Create main task only after successful initialization
@@ -0,0 +1,221 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Typed control commands: payloads built on the stack with the ZCL byte layout
+#include <string.h>
+
+// Zigbee headers
+#include "esp_zigbee_core.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+
+//Project headers
+#include "main.h"
+#include "mod_zig_cmd.h"
+#include "mod_zig_ctrl.h"
+
+// Cluster command ids
+#define CMD_ON_OFF_OFF                  0x00
+#define CMD_ON_OFF_ON                   0x01
+#define CMD_ON_OFF_TOGGLE               0x02
+#define CMD_LEVEL_MOVE_TO_LEVEL         0x00
+#define CMD_LEVEL_MOVE_TO_LEVEL_ON_OFF  0x04
+#define CMD_COLOR_MOVE_TO_COLOR         0x07
+#define CMD_COLOR_MOVE_TO_TEMPERATURE   0x0A
+#define CMD_COVER_GO_TO_LIFT_PERCENT    0x05
+#define CMD_COVER_GO_TO_TILT_PERCENT    0x08
+
+#define COLOR_XY_MAX 0xFEFF     // CurrentX / CurrentY range
+
+
+static void ctrl_check_network(mp_obj_t self_in) {
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!self->config->network_formed) {
+        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
+    }
+}
+
+static mp_int_t ctrl_range(mp_int_t value, mp_int_t max, const char *msg) {
+    if (value < 0 || value > max) {
+        mp_raise_ValueError(msg);
+    }
+    return value;
+}
+
+// Little-endian uint16 into a payload
+static size_t ctrl_put_u16(uint8_t *buf, size_t pos, uint16_t value) {
+    buf[pos] = value & 0xFF;
+    buf[pos + 1] = (value >> 8) & 0xFF;
+    return pos + 2;
+}
+
+// Chromaticity as float 0.0-1.0 or raw 0-0xFEFF
+static uint16_t ctrl_color_coord(mp_obj_t value) {
+    if (mp_obj_is_float(value)) {
+        mp_float_t f = mp_obj_get_float(value);
+        if (!(f >= 0 && f <= 1)) {
+            mp_raise_ValueError("x and y must be 0.0-1.0");
+        }
+        mp_int_t raw = (mp_int_t)(f * 65536 + 0.5);
+        return raw > COLOR_XY_MAX ? COLOR_XY_MAX : raw;
+    }
+    return ctrl_range(mp_obj_get_int(value), COLOR_XY_MAX, "x and y must be 0-0xFEFF");
+}
+
+static mp_obj_t ctrl_send(mp_int_t addr, mp_int_t ep, mp_int_t mode, uint16_t cluster_id, uint8_t command_id,
+                          const uint8_t *payload, size_t len) {
+    uint8_t tsn = zig_cmd_send(addr, ep, mode, cluster_id, command_id, 0, false,
+                               ESP_ZB_ZCL_ATTR_TYPE_SET, len ? payload : NULL, len);
+    return MP_OBJ_NEW_SMALL_INT(tsn);
+}
+
+
+// on_off(addr, ep, on=None, *, mode=UNICAST)
+// True / False for On / Off, None for Toggle
+static mp_obj_t esp32_zig_on_off(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr, ARG_ep, ARG_on, ARG_mode };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr, MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,   MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_on,   MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_mode, MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = ZIG_ADDR_UNICAST} },
+    };
+
+    ctrl_check_network(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uint8_t cmd = CMD_ON_OFF_TOGGLE;
+    if (args[ARG_on].u_obj != mp_const_none) {
+        cmd = mp_obj_is_true(args[ARG_on].u_obj) ? CMD_ON_OFF_ON : CMD_ON_OFF_OFF;
+    }
+    return ctrl_send(args[ARG_addr].u_int, args[ARG_ep].u_int, args[ARG_mode].u_int,
+                     ESP_ZB_ZCL_CLUSTER_ID_ON_OFF, cmd, NULL, 0);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_on_off_obj, 1, esp32_zig_on_off);
+
+
+// level(addr, ep, level, transition=0, *, on_off=True, mode=UNICAST)
+// Move to Level: level(1) + transition time(2, 1/10 s). on_off=True also
+// switches the light on, or off at level 0.
+static mp_obj_t esp32_zig_level(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr, ARG_ep, ARG_level, ARG_transition, ARG_on_off, ARG_mode };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr,       MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,         MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_level,      MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_transition, MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_on_off,     MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = true} },
+        { MP_QSTR_mode,       MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = ZIG_ADDR_UNICAST} },
+    };
+
+    ctrl_check_network(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uint8_t payload[3];
+    payload[0] = ctrl_range(args[ARG_level].u_int, 254, "level must be 0-254");
+    size_t len = ctrl_put_u16(payload, 1, ctrl_range(args[ARG_transition].u_int, 0xFFFF, "transition must be 0-0xFFFF"));
+
+    return ctrl_send(args[ARG_addr].u_int, args[ARG_ep].u_int, args[ARG_mode].u_int,
+                     ESP_ZB_ZCL_CLUSTER_ID_LEVEL_CONTROL,
+                     args[ARG_on_off].u_bool ? CMD_LEVEL_MOVE_TO_LEVEL_ON_OFF : CMD_LEVEL_MOVE_TO_LEVEL,
+                     payload, len);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_level_obj, 1, esp32_zig_level);
+
+
+// color_xy(addr, ep, x, y, transition=0, *, mode=UNICAST)
+// Move to Color: x(2) + y(2) + transition time(2)
+static mp_obj_t esp32_zig_color_xy(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr, ARG_ep, ARG_x, ARG_y, ARG_transition, ARG_mode };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr,       MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,         MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_x,          MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_y,          MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_transition, MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_mode,       MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = ZIG_ADDR_UNICAST} },
+    };
+
+    ctrl_check_network(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uint8_t payload[6];
+    size_t len = ctrl_put_u16(payload, 0, ctrl_color_coord(args[ARG_x].u_obj));
+    len = ctrl_put_u16(payload, len, ctrl_color_coord(args[ARG_y].u_obj));
+    len = ctrl_put_u16(payload, len, ctrl_range(args[ARG_transition].u_int, 0xFFFF, "transition must be 0-0xFFFF"));
+
+    return ctrl_send(args[ARG_addr].u_int, args[ARG_ep].u_int, args[ARG_mode].u_int,
+                     ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, CMD_COLOR_MOVE_TO_COLOR, payload, len);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_color_xy_obj, 1, esp32_zig_color_xy);
+
+
+// color_temp(addr, ep, mireds, transition=0, *, mode=UNICAST)
+// Move to Color Temperature: mireds(2) + transition time(2)
+static mp_obj_t esp32_zig_color_temp(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr, ARG_ep, ARG_mireds, ARG_transition, ARG_mode };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr,       MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,         MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_mireds,     MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_transition, MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_mode,       MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = ZIG_ADDR_UNICAST} },
+    };
+
+    ctrl_check_network(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uint8_t payload[4];
+    size_t len = ctrl_put_u16(payload, 0, ctrl_range(args[ARG_mireds].u_int, 0xFEFF, "mireds must be 0-0xFEFF"));
+    len = ctrl_put_u16(payload, len, ctrl_range(args[ARG_transition].u_int, 0xFFFF, "transition must be 0-0xFFFF"));
+
+    return ctrl_send(args[ARG_addr].u_int, args[ARG_ep].u_int, args[ARG_mode].u_int,
+                     ESP_ZB_ZCL_CLUSTER_ID_COLOR_CONTROL, CMD_COLOR_MOVE_TO_TEMPERATURE, payload, len);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_color_temp_obj, 1, esp32_zig_color_temp);
+
+
+// cover(addr, ep, action=None, *, lift=None, tilt=None, mode=UNICAST)
+// One of: action COVER_OPEN / COVER_CLOSE / COVER_STOP, lift or tilt percentage
+static mp_obj_t esp32_zig_cover(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr, ARG_ep, ARG_action, ARG_lift, ARG_tilt, ARG_mode };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr,   MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,     MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_action, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_lift,   MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_tilt,   MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_obj = mp_const_none} },
+        { MP_QSTR_mode,   MP_ARG_KW_ONLY | MP_ARG_INT, {.u_int = ZIG_ADDR_UNICAST} },
+    };
+
+    ctrl_check_network(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    int given = (args[ARG_action].u_obj != mp_const_none) + (args[ARG_lift].u_obj != mp_const_none)
+              + (args[ARG_tilt].u_obj != mp_const_none);
+    if (given != 1) {
+        mp_raise_TypeError("give one of action, lift or tilt");
+    }
+
+    uint8_t payload[1];
+    size_t len = 0;
+    uint8_t cmd;
+    if (args[ARG_action].u_obj != mp_const_none) {
+        cmd = ctrl_range(mp_obj_get_int(args[ARG_action].u_obj), ZIG_COVER_STOP, "action must be COVER_OPEN, COVER_CLOSE or COVER_STOP");
+    } else if (args[ARG_lift].u_obj != mp_const_none) {
+        cmd = CMD_COVER_GO_TO_LIFT_PERCENT;
+        payload[len++] = ctrl_range(mp_obj_get_int(args[ARG_lift].u_obj), 100, "lift must be 0-100");
+    } else {
+        cmd = CMD_COVER_GO_TO_TILT_PERCENT;
+        payload[len++] = ctrl_range(mp_obj_get_int(args[ARG_tilt].u_obj), 100, "tilt must be 0-100");
+    }
+
+    return ctrl_send(args[ARG_addr].u_int, args[ARG_ep].u_int, args[ARG_mode].u_int,
+                     ESP_ZB_ZCL_CLUSTER_ID_WINDOW_COVERING, cmd, payload, len);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_cover_obj, 1, esp32_zig_cover);
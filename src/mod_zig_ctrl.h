@@ -0,0 +1,20 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Typed control commands: On/Off, Level Control, Color Control, Window Covering
+#ifndef MOD_ZIG_CTRL_H
+#define MOD_ZIG_CTRL_H
+
+#include "py/obj.h"
+
+// Window Covering commands accepted by cover(action)
+#define ZIG_COVER_OPEN      0x00    /* Up / Open */
+#define ZIG_COVER_CLOSE     0x01    /* Down / Close */
+#define ZIG_COVER_STOP      0x02    /* Stop */
+
+// Python API function objects
+extern const mp_obj_fun_builtin_var_t esp32_zig_on_off_obj;          // On, Off or Toggle
+extern const mp_obj_fun_builtin_var_t esp32_zig_level_obj;           // Move to Level (with On/Off)
+extern const mp_obj_fun_builtin_var_t esp32_zig_color_xy_obj;        // Move to Color
+extern const mp_obj_fun_builtin_var_t esp32_zig_color_temp_obj;      // Move to Color Temperature
+extern const mp_obj_fun_builtin_var_t esp32_zig_cover_obj;           // Open / close / stop or go to lift / tilt
+
+#endif // MOD_ZIG_CTRL_H
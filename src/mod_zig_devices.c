@@ -11,6 +11,8 @@
 #include "device_manager.h"
 #include "device_storage.h"
 #include "device_json.h"
+#include "mod_zig_binding.h"
+#include "cJSON.h"
 
 // ESP-Zigbee headers for structure definitions
 #include "esp_zigbee_core.h"
@@ -49,6 +51,10 @@ mp_obj_t esp32_zig_remove_device(size_t n_args, const mp_obj_t *args) {
     }
     
     uint16_t short_addr = mp_obj_get_int(args[1]);
+    zigbee_device_t *device = device_manager_get(short_addr);
+    if (device) {
+        zig_binding_forget(device->ieee_addr);
+    }
     esp_err_t err = device_manager_remove(short_addr);
     if (err != ESP_OK) {
         mp_raise_msg_varg(&mp_type_RuntimeError, 
@@ -94,27 +100,20 @@ mp_obj_t esp32_zig_get_device(size_t n_args, const mp_obj_t *args) {
     if (!device) {
         return mp_const_none;
     }
-    
-    // Create JSON object with device info
-    cJSON *json = device_to_json(device);
-    if (!json) {
-        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Failed to create device JSON"));
-        return mp_const_none;
+
+    // Index-only after boot: read endpoints and reports now instead of waiting for the background load
+    if (device->detail_pending) {
+        device_storage_ensure_detail(short_addr);
+        device = device_manager_get(short_addr);
     }
     
-    // Convert to string
-    char *json_str = cJSON_PrintUnformatted(json);
-    cJSON_Delete(json);
-    
-    if (!json_str) {
-        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Failed to convert JSON to string"));
+    // Serialize device info straight into a Python string
+    mp_obj_t ret = device_to_json_str(device);
+    if (ret == mp_const_none) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Failed to create device JSON"));
         return mp_const_none;
     }
-    
-    // Create Python string
-    mp_obj_t ret = mp_obj_new_str(json_str, strlen(json_str));
-    free(json_str);
-    
+
     return ret;
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(esp32_zig_get_device_obj, 2, 2, esp32_zig_get_device);
@@ -154,6 +153,7 @@ mp_obj_t esp32_zig_get_device_summary(size_t n_args, const mp_obj_t *args) {
     cJSON_AddStringToObject(json, "model", device->model);
     cJSON_AddStringToObject(json, "name", device->device_name);
     cJSON_AddBoolToObject(json, "active", device->active);
+    cJSON_AddBoolToObject(json, "interviewed", device->interview_complete);
     cJSON_AddNumberToObject(json, "frm_ver", device->firmware_version);
     cJSON_AddNumberToObject(json, "power", device->power_source);
     cJSON_AddNumberToObject(json, "bat_volt", device->battery_voltage);
@@ -171,6 +171,39 @@ mp_obj_t esp32_zig_get_device_summary(size_t n_args, const mp_obj_t *args) {
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(esp32_zig_get_device_summary_obj, 2, 2, esp32_zig_get_device_summary);
 
+// Storage statistics: startup load counters, save latency and timing
+mp_obj_t esp32_zig_storage_stats(size_t n_args, const mp_obj_t *args) {
+    const device_storage_stats_t *stats = device_storage_get_stats();
+    mp_obj_t dict = mp_obj_new_dict(14);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_load_records), mp_obj_new_int_from_uint(stats->load_records));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_load_ok), mp_obj_new_int_from_uint(stats->load_ok));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_load_failed), mp_obj_new_int_from_uint(stats->load_failed));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_load_stale), mp_obj_new_int_from_uint(stats->load_stale));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_load_ms), mp_obj_new_int_from_uint(stats->load_ms));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_index_records), mp_obj_new_int_from_uint(stats->index_records));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_index_ms), mp_obj_new_int_from_uint(stats->index_ms));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_load_done), mp_obj_new_bool(stats->load_done));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_volatile_flushes), mp_obj_new_int_from_uint(stats->volatile_flushes));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_volatile_failed), mp_obj_new_int_from_uint(stats->volatile_failed));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_save_count), mp_obj_new_int_from_uint(stats->save_count));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_save_us_avg),
+                      mp_obj_new_int_from_uint(stats->save_count ? stats->save_us_total / stats->save_count : 0));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_save_us_max), mp_obj_new_int_from_uint(stats->save_us_max));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_backend), MP_OBJ_NEW_QSTR(stats->nvs ? MP_QSTR_nvs : MP_QSTR_callback));
+    return dict;
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(esp32_zig_storage_stats_obj, 1, 1, esp32_zig_storage_stats);
+
+// Write volatile state (battery, power, link quality) now, e.g. before a planned reset
+mp_obj_t esp32_zig_flush_storage(size_t n_args, const mp_obj_t *args) {
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    if (!self->storage_cb || self->storage_cb == mp_const_none) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Storage callback not set"));
+    }
+    return mp_obj_new_bool(device_storage_flush_volatile() == ESP_OK);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(esp32_zig_flush_storage_obj, 1, 1, esp32_zig_flush_storage);
+
 // Helper function for getting text description of link quality
 static const char* get_quality_description(uint8_t lqi) {
     if (lqi >= 200) return "Very Good";
@@ -18,6 +18,8 @@ extern const mp_obj_fun_builtin_var_t esp32_zig_get_device_obj;
 extern const mp_obj_fun_builtin_var_t esp32_zig_get_device_list_obj;
 extern const mp_obj_fun_builtin_var_t esp32_zig_get_device_summary_obj;
 extern const mp_obj_fun_builtin_var_t esp32_zig_remove_device_obj;
+extern const mp_obj_fun_builtin_var_t esp32_zig_storage_stats_obj;
+extern const mp_obj_fun_builtin_var_t esp32_zig_flush_storage_obj;
 
 //extern const mp_obj_fun_builtin_var_t esp32_zig_get_binding_table_obj;            // Get binding table from device
 
@@ -28,6 +30,8 @@ mp_obj_t esp32_zig_load_device(size_t n_args, const mp_obj_t *args);
 mp_obj_t esp32_zig_get_device(size_t n_args, const mp_obj_t *args);
 mp_obj_t esp32_zig_get_device_list(size_t n_args, const mp_obj_t *args);
 mp_obj_t esp32_zig_get_device_summary(size_t n_args, const mp_obj_t *args);
+mp_obj_t esp32_zig_storage_stats(size_t n_args, const mp_obj_t *args);
+mp_obj_t esp32_zig_flush_storage(size_t n_args, const mp_obj_t *args);
 
 
 
@@ -0,0 +1,228 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Interview templates of known models: endpoints, clusters and default reporting
+//
+// A template is a fully interviewed device already in the device table, so
+// the cache only keeps the model identity and who to copy from. Everything
+// here runs in the Zigbee task, or in MicroPython under ZB_LOCK.
+#include <string.h>
+
+// ESP-IDF headers
+#include "esp_log.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+
+//Project headers
+#include "main.h"
+#include "device_manager.h"
+#include "mod_zig_fingerprint.h"
+
+#define LOG_TAG "ZIG_FINGERPRINT"
+
+// Model identity and the device that serves as its template
+typedef struct {
+    uint16_t manufacturer_code;
+    char manufacturer_name[MAX_MANUFACTURER_NAME_LEN];
+    char model[MAX_DEVICE_NAME_LEN];
+    uint8_t app_version;
+    uint8_t ieee_addr[8];
+    uint32_t hits;
+    bool in_use;
+} fingerprint_t;
+
+static fingerprint_t fingerprints[ZIG_FINGERPRINT_MAX];
+static uint8_t fingerprint_next;    // Slot replaced when the table is full
+
+
+// Model identifier is kept in device_name
+static bool fingerprint_same_model(const zigbee_device_t *a, const zigbee_device_t *b) {
+    return a->manufacturer_code == b->manufacturer_code && a->firmware_version == b->firmware_version &&
+           strcmp(a->manufacturer_name, b->manufacturer_name) == 0 && strcmp(a->device_name, b->device_name) == 0;
+}
+
+static bool fingerprint_matches(const fingerprint_t *f, const zigbee_device_t *dev) {
+    return f->in_use && f->manufacturer_code == dev->manufacturer_code && f->app_version == dev->firmware_version &&
+           strcmp(f->manufacturer_name, dev->manufacturer_name) == 0 && strcmp(f->model, dev->device_name) == 0;
+}
+
+static zigbee_device_t *fingerprint_device(const uint8_t ieee_addr[8]) {
+    size_t count = 0;
+    zigbee_device_t *devices = device_manager_get_list(&count);
+    for (size_t i = 0; devices && i < count; i++) {
+        if (memcmp(devices[i].ieee_addr, ieee_addr, 8) == 0) {
+            return &devices[i];
+        }
+    }
+    return NULL;
+}
+
+bool zig_fingerprint_record_complete(const zigbee_device_t *dev) {
+    if (dev->detail_pending || dev->endpoint_count == 0 ||
+        dev->manufacturer_name[0] == '\0' || dev->device_name[0] == '\0') {
+        return false;
+    }
+    for (int i = 0; i < dev->endpoint_count; i++) {
+        if (dev->endpoints[i].cluster_count == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A degraded interview never sets interview_complete, so it can't make a template
+bool zig_fingerprint_complete(const zigbee_device_t *dev) {
+    return dev->interview_complete && zig_fingerprint_record_complete(dev);
+}
+
+void zig_fingerprint_learn(const zigbee_device_t *dev) {
+    if (!zig_fingerprint_complete(dev)) {
+        return;
+    }
+    fingerprint_t *slot = NULL;
+    for (int i = 0; i < ZIG_FINGERPRINT_MAX; i++) {
+        if (fingerprint_matches(&fingerprints[i], dev)) {
+            // Keep a template that still exists, it may carry hits already
+            if (fingerprint_device(fingerprints[i].ieee_addr)) {
+                return;
+            }
+            slot = &fingerprints[i];
+            break;
+        }
+        if (!slot && !fingerprints[i].in_use) {
+            slot = &fingerprints[i];
+        }
+    }
+    if (!slot) {
+        slot = &fingerprints[fingerprint_next];
+        fingerprint_next = (fingerprint_next + 1) % ZIG_FINGERPRINT_MAX;
+    }
+
+    memset(slot, 0, sizeof(*slot));
+    slot->manufacturer_code = dev->manufacturer_code;
+    strncpy(slot->manufacturer_name, dev->manufacturer_name, sizeof(slot->manufacturer_name) - 1);
+    strncpy(slot->model, dev->device_name, sizeof(slot->model) - 1);
+    slot->app_version = dev->firmware_version;
+    memcpy(slot->ieee_addr, dev->ieee_addr, 8);
+    slot->in_use = true;
+    ESP_LOGI(LOG_TAG, "Template of %s / %s v%u: %s", slot->manufacturer_name, slot->model, slot->app_version,
+             dev->ieee_addr_str);
+}
+
+const zigbee_device_t *zig_fingerprint_lookup(const zigbee_device_t *dev) {
+    if (dev->manufacturer_name[0] == '\0' || dev->device_name[0] == '\0') {
+        return NULL;
+    }
+
+    for (int i = 0; i < ZIG_FINGERPRINT_MAX; i++) {
+        fingerprint_t *f = &fingerprints[i];
+        if (!fingerprint_matches(f, dev)) {
+            continue;
+        }
+        const zigbee_device_t *tpl = fingerprint_device(f->ieee_addr);
+        if (tpl && fingerprint_same_model(tpl, dev) && zig_fingerprint_complete(tpl)) {
+            if (tpl != dev) {
+                return tpl;
+            }
+        } else {
+            // Template left or changed: forget it and look again below
+            f->in_use = false;
+        }
+        break;
+    }
+
+    // Devices loaded from storage are templates too
+    size_t count = 0;
+    zigbee_device_t *devices = device_manager_get_list(&count);
+    for (size_t i = 0; devices && i < count; i++) {
+        const zigbee_device_t *tpl = &devices[i];
+        if (tpl != dev && fingerprint_same_model(tpl, dev) && zig_fingerprint_complete(tpl)) {
+            zig_fingerprint_learn(tpl);
+            return tpl;
+        }
+    }
+    return NULL;
+}
+
+bool zig_fingerprint_apply_endpoints(zigbee_device_t *dev, const zigbee_device_t *tpl) {
+    if (dev->endpoint_count != tpl->endpoint_count) {
+        return false;
+    }
+    for (int i = 0; i < dev->endpoint_count; i++) {
+        if (dev->endpoints[i].endpoint != tpl->endpoints[i].endpoint) {
+            return false;
+        }
+    }
+    memcpy(dev->endpoints, tpl->endpoints, sizeof(zigbee_endpoint_t) * tpl->endpoint_count);
+    return true;
+}
+
+int zig_fingerprint_apply_reports(zigbee_device_t *dev, const zigbee_device_t *tpl) {
+    for (int i = 0; i < MAX_REPORT_CFGS; i++) {
+        if (dev->report_cfgs[i].in_use) {
+            return 0;
+        }
+    }
+    int copied = 0;
+    for (int i = 0; i < MAX_REPORT_CFGS; i++) {
+        if (tpl->report_cfgs[i].in_use) {
+            dev->report_cfgs[copied++] = tpl->report_cfgs[i];
+        }
+    }
+    return copied;
+}
+
+void zig_fingerprint_hit(const zigbee_device_t *tpl) {
+    for (int i = 0; i < ZIG_FINGERPRINT_MAX; i++) {
+        if (fingerprints[i].in_use && memcmp(fingerprints[i].ieee_addr, tpl->ieee_addr, 8) == 0) {
+            fingerprints[i].hits++;
+            return;
+        }
+    }
+}
+
+
+// fingerprints(clear=False)
+// Known models as dicts with the template device and the joins it shortened
+static mp_obj_t esp32_zig_fingerprints(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_clear };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_clear, MP_ARG_BOOL, {.u_bool = false} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    // Copy under the lock, build objects without it
+    fingerprint_t snapshot[ZIG_FINGERPRINT_MAX];
+    uint16_t template_addr[ZIG_FINGERPRINT_MAX];
+    ZB_LOCK();
+    memcpy(snapshot, fingerprints, sizeof(snapshot));
+    for (int i = 0; i < ZIG_FINGERPRINT_MAX; i++) {
+        const zigbee_device_t *tpl = snapshot[i].in_use ? fingerprint_device(snapshot[i].ieee_addr) : NULL;
+        template_addr[i] = tpl ? tpl->short_addr : 0xFFFF;
+    }
+    if (args[ARG_clear].u_bool) {
+        memset(fingerprints, 0, sizeof(fingerprints));
+        fingerprint_next = 0;
+    }
+    ZB_UNLOCK();
+
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (int i = 0; i < ZIG_FINGERPRINT_MAX; i++) {
+        fingerprint_t *f = &snapshot[i];
+        if (!f->in_use) {
+            continue;
+        }
+        mp_obj_t dict = mp_obj_new_dict(6);
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_manufacturer_code), MP_OBJ_NEW_SMALL_INT(f->manufacturer_code));
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_manufacturer_name), mp_obj_new_str(f->manufacturer_name, strlen(f->manufacturer_name)));
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_model), mp_obj_new_str(f->model, strlen(f->model)));
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_app_version), MP_OBJ_NEW_SMALL_INT(f->app_version));
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_template), template_addr[i] == 0xFFFF ? mp_const_none : MP_OBJ_NEW_SMALL_INT(template_addr[i]));
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_hits), mp_obj_new_int_from_uint(f->hits));
+        mp_obj_list_append(list, dict);
+    }
+    return list;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_fingerprints_obj, 1, esp32_zig_fingerprints);
@@ -0,0 +1,65 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Interview templates of known models: endpoints, clusters and default reporting
+#ifndef MOD_ZIG_FINGERPRINT_H
+#define MOD_ZIG_FINGERPRINT_H
+
+#include "py/obj.h"
+#include "mod_zig_types.h"
+
+#define ZIG_FINGERPRINT_MAX     16      /* Models remembered */
+
+/**
+ * @brief Device record holds everything an interview would collect
+ *
+ * Identity (manufacturer, model) and a Simple Descriptor for every endpoint.
+ */
+bool zig_fingerprint_record_complete(const zigbee_device_t *dev);
+
+/**
+ * @brief Device can serve as a template: complete record from a finished, non-degraded interview
+ */
+bool zig_fingerprint_complete(const zigbee_device_t *dev);
+
+/**
+ * @brief Fully interviewed device of the same model
+ *
+ * Matches manufacturer code, manufacturer name, model identifier and
+ * application version. Called from the Zigbee task.
+ *
+ * @param dev Device whose Basic attributes were read
+ * @return Template device, NULL if no other device of this model is known
+ */
+const zigbee_device_t *zig_fingerprint_lookup(const zigbee_device_t *dev);
+
+/**
+ * @brief Copy endpoint descriptors of the template
+ *
+ * Only when the device reported the same active endpoints as the template.
+ *
+ * @return true if the descriptors were copied
+ */
+bool zig_fingerprint_apply_endpoints(zigbee_device_t *dev, const zigbee_device_t *tpl);
+
+/**
+ * @brief Copy the template's report configs to a device that has none
+ *
+ * @return Number of configs copied
+ */
+int zig_fingerprint_apply_reports(zigbee_device_t *dev, const zigbee_device_t *tpl);
+
+/**
+ * @brief Remember a fully interviewed device as the template of its model
+ *
+ * Called from the Zigbee task when an interview finishes.
+ */
+void zig_fingerprint_learn(const zigbee_device_t *dev);
+
+/**
+ * @brief Count a join that skipped the full interview thanks to the template
+ */
+void zig_fingerprint_hit(const zigbee_device_t *tpl);
+
+// Python API function objects
+extern const mp_obj_fun_builtin_var_t esp32_zig_fingerprints_obj;    // Known models and template hits
+
+#endif // MOD_ZIG_FINGERPRINT_H
@@ -0,0 +1,273 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Groups cluster management and local mirror of group membership
+#include <string.h>
+
+// FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ESP-IDF headers
+#include "esp_log.h"
+
+// Zigbee headers
+#include "esp_zigbee_core.h"
+#include "zcl/esp_zigbee_zcl_command.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+
+//Project headers
+#include "main.h"
+#include "mod_zig_groups.h"
+
+#define LOG_TAG "ZIG_GROUPS"
+
+#define GROUP_ALL -1
+
+// Mirror entry, written by the Zigbee task and read from MicroPython
+typedef struct {
+    uint16_t group_id;
+    uint16_t short_addr;
+    uint8_t endpoint;
+    bool in_use;
+} group_member_t;
+
+static group_member_t group_members[ZIG_GROUP_MEMBERS_MAX];
+static portMUX_TYPE groups_lock = portMUX_INITIALIZER_UNLOCKED;
+
+
+// Caller holds groups_lock
+static group_member_t *groups_find(uint16_t short_addr, uint8_t endpoint, uint16_t group_id) {
+    for (int i = 0; i < ZIG_GROUP_MEMBERS_MAX; i++) {
+        group_member_t *m = &group_members[i];
+        if (m->in_use && m->short_addr == short_addr && m->endpoint == endpoint && m->group_id == group_id) {
+            return m;
+        }
+    }
+    return NULL;
+}
+
+// Caller holds groups_lock
+static bool groups_insert(uint16_t short_addr, uint8_t endpoint, uint16_t group_id) {
+    if (groups_find(short_addr, endpoint, group_id)) {
+        return true;
+    }
+    for (int i = 0; i < ZIG_GROUP_MEMBERS_MAX; i++) {
+        group_member_t *m = &group_members[i];
+        if (!m->in_use) {
+            m->short_addr = short_addr;
+            m->endpoint = endpoint;
+            m->group_id = group_id;
+            m->in_use = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void zig_groups_update(uint16_t short_addr, uint8_t endpoint, uint16_t group_id, bool member) {
+    bool stored = true;
+
+    taskENTER_CRITICAL(&groups_lock);
+    if (member) {
+        stored = groups_insert(short_addr, endpoint, group_id);
+    } else {
+        group_member_t *m = groups_find(short_addr, endpoint, group_id);
+        if (m) {
+            m->in_use = false;
+        }
+    }
+    taskEXIT_CRITICAL(&groups_lock);
+
+    if (!stored) {
+        ESP_LOGW(LOG_TAG, "Mirror full, group 0x%04x of 0x%04x/%u not recorded", group_id, short_addr, endpoint);
+    }
+}
+
+void zig_groups_replace(uint16_t short_addr, uint8_t endpoint, const uint16_t *group_ids, uint8_t count) {
+    uint8_t stored = 0;
+
+    taskENTER_CRITICAL(&groups_lock);
+    for (int i = 0; i < ZIG_GROUP_MEMBERS_MAX; i++) {
+        group_member_t *m = &group_members[i];
+        if (m->in_use && m->short_addr == short_addr && m->endpoint == endpoint) {
+            m->in_use = false;
+        }
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        stored += groups_insert(short_addr, endpoint, group_ids[i]);
+    }
+    taskEXIT_CRITICAL(&groups_lock);
+
+    if (stored < count) {
+        ESP_LOGW(LOG_TAG, "Mirror full, %u of %u groups of 0x%04x/%u recorded", stored, count, short_addr, endpoint);
+    }
+}
+
+
+// Shared arguments of the Groups cluster commands
+enum { ARG_addr, ARG_ep, ARG_group_id };
+
+static void groups_parse(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args, bool group_required,
+                         mp_arg_val_t *args) {
+    const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr,     MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,       MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_group_id, (group_required ? MP_ARG_REQUIRED : 0) | MP_ARG_INT, {.u_int = GROUP_ALL} },
+    };
+
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    if (!self->config->network_formed) {
+        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
+    }
+
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    if (args[ARG_group_id].u_int != GROUP_ALL && (args[ARG_group_id].u_int < 0 || args[ARG_group_id].u_int > 0xFFF7)) {
+        mp_raise_ValueError("group_id must be 0x0000-0xFFF7");
+    }
+}
+
+static void groups_basic_cmd(esp_zb_zcl_basic_cmd_t *basic, const mp_arg_val_t *args) {
+    basic->dst_addr_u.addr_short = args[ARG_addr].u_int;
+    basic->dst_endpoint = args[ARG_ep].u_int;
+    basic->src_endpoint = ESP_ZB_GATEWAY_ENDPOINT;
+}
+
+
+// add_group(addr, ep, group_id)
+// Add Group; the response updates the mirror
+static mp_obj_t esp32_zig_add_group(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    mp_arg_val_t args[3];
+    groups_parse(n_args, pos_args, kw_args, true, args);
+
+    esp_zb_zcl_groups_add_group_cmd_t cmd_req = {0};
+    groups_basic_cmd(&cmd_req.zcl_basic_cmd, args);
+    cmd_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+    cmd_req.group_id = args[ARG_group_id].u_int;
+
+    ZB_LOCK();
+    uint8_t tsn = esp_zb_zcl_groups_add_group_cmd_req(&cmd_req);
+    ZB_UNLOCK();
+
+    ESP_LOGI(LOG_TAG, "Add group 0x%04x to 0x%04x/%u, tsn=%u",
+             cmd_req.group_id, cmd_req.zcl_basic_cmd.dst_addr_u.addr_short, cmd_req.zcl_basic_cmd.dst_endpoint, tsn);
+    return mp_obj_new_int(tsn);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_add_group_obj, 1, esp32_zig_add_group);
+
+
+// remove_group(addr, ep, group_id=-1)
+// Remove Group, or Remove All Groups without group_id
+static mp_obj_t esp32_zig_remove_group(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    mp_arg_val_t args[3];
+    groups_parse(n_args, pos_args, kw_args, false, args);
+
+    uint8_t tsn;
+    if (args[ARG_group_id].u_int == GROUP_ALL) {
+        // No response of its own, the Default Response clears the mirror
+        esp_zb_zcl_groups_cmd_t cmd_req = {0};
+        groups_basic_cmd(&cmd_req.zcl_basic_cmd, args);
+        cmd_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+
+        ZB_LOCK();
+        tsn = esp_zb_zcl_groups_remove_all_groups_cmd_req(&cmd_req);
+        ZB_UNLOCK();
+    } else {
+        esp_zb_zcl_groups_add_group_cmd_t cmd_req = {0};
+        groups_basic_cmd(&cmd_req.zcl_basic_cmd, args);
+        cmd_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+        cmd_req.group_id = args[ARG_group_id].u_int;
+
+        ZB_LOCK();
+        tsn = esp_zb_zcl_groups_remove_group_cmd_req(&cmd_req);
+        ZB_UNLOCK();
+    }
+
+    ESP_LOGI(LOG_TAG, "Remove group %d from 0x%04x/%u, tsn=%u",
+             (int)args[ARG_group_id].u_int, (unsigned)args[ARG_addr].u_int, (unsigned)args[ARG_ep].u_int, tsn);
+    return mp_obj_new_int(tsn);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_remove_group_obj, 1, esp32_zig_remove_group);
+
+
+// view_group(addr, ep, group_id=-1)
+// View Group, or Get Group Membership of all groups without group_id
+static mp_obj_t esp32_zig_view_group(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    mp_arg_val_t args[3];
+    groups_parse(n_args, pos_args, kw_args, false, args);
+
+    uint8_t tsn;
+    if (args[ARG_group_id].u_int == GROUP_ALL) {
+        // Empty group list: the device answers with every group it is in
+        esp_zb_zcl_groups_get_group_membership_cmd_t cmd_req = {0};
+        groups_basic_cmd(&cmd_req.zcl_basic_cmd, args);
+        cmd_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+        cmd_req.group_number = 0;
+        cmd_req.group_list = NULL;
+
+        ZB_LOCK();
+        tsn = esp_zb_zcl_groups_get_group_membership_cmd_req(&cmd_req);
+        ZB_UNLOCK();
+    } else {
+        esp_zb_zcl_groups_add_group_cmd_t cmd_req = {0};
+        groups_basic_cmd(&cmd_req.zcl_basic_cmd, args);
+        cmd_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+        cmd_req.group_id = args[ARG_group_id].u_int;
+
+        ZB_LOCK();
+        tsn = esp_zb_zcl_groups_view_group_cmd_req(&cmd_req);
+        ZB_UNLOCK();
+    }
+
+    return mp_obj_new_int(tsn);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_view_group_obj, 1, esp32_zig_view_group);
+
+
+// groups(group_id=None)
+// Mirror as {group_id: [(addr, ep), ...]}, or the member list of one group
+static mp_obj_t esp32_zig_groups(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_group_id };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_group_id, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    bool one = args[ARG_group_id].u_obj != mp_const_none;
+    uint16_t only = one ? mp_obj_get_int(args[ARG_group_id].u_obj) : 0;
+
+    // Copy under the lock, build objects without it
+    group_member_t snapshot[ZIG_GROUP_MEMBERS_MAX];
+    taskENTER_CRITICAL(&groups_lock);
+    memcpy(snapshot, group_members, sizeof(snapshot));
+    taskEXIT_CRITICAL(&groups_lock);
+
+    mp_obj_t result = one ? mp_obj_new_list(0, NULL) : mp_obj_new_dict(0);
+    for (int i = 0; i < ZIG_GROUP_MEMBERS_MAX; i++) {
+        group_member_t *m = &snapshot[i];
+        if (!m->in_use || (one && m->group_id != only)) {
+            continue;
+        }
+        mp_obj_t member[2] = {
+            MP_OBJ_NEW_SMALL_INT(m->short_addr),
+            MP_OBJ_NEW_SMALL_INT(m->endpoint),
+        };
+        mp_obj_t list = result;
+        if (!one) {
+            mp_obj_t key = MP_OBJ_NEW_SMALL_INT(m->group_id);
+            mp_map_elem_t *elem = mp_map_lookup(mp_obj_dict_get_map(result), key, MP_MAP_LOOKUP);
+            if (elem) {
+                list = elem->value;
+            } else {
+                list = mp_obj_new_list(0, NULL);
+                mp_obj_dict_store(result, key, list);
+            }
+        }
+        mp_obj_list_append(list, mp_obj_new_tuple(2, member));
+    }
+    return result;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_groups_obj, 1, esp32_zig_groups);
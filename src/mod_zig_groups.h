@@ -0,0 +1,46 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Groups cluster management and local mirror of group membership
+#ifndef MOD_ZIG_GROUPS_H
+#define MOD_ZIG_GROUPS_H
+
+#include "py/obj.h"
+#include "mod_zig_types.h"
+
+#define ZIG_GROUP_MEMBERS_MAX   64      /* (group, device, endpoint) entries in the mirror */
+
+// Groups cluster server to client command ids
+#define ZIG_GROUPS_CMD_ADD_RESP     0x00
+#define ZIG_GROUPS_CMD_VIEW_RESP    0x01
+#define ZIG_GROUPS_CMD_REMOVE_RESP  0x03
+
+/**
+ * @brief Set or clear one membership in the mirror
+ *
+ * Called from the Zigbee task for Add / Remove / View Group responses.
+ *
+ * @param short_addr Device address
+ * @param endpoint Device endpoint
+ * @param group_id Group id
+ * @param member true if the endpoint is in the group
+ */
+void zig_groups_update(uint16_t short_addr, uint8_t endpoint, uint16_t group_id, bool member);
+
+/**
+ * @brief Replace all memberships of an endpoint in the mirror
+ *
+ * Called from the Zigbee task for Get Group Membership responses.
+ *
+ * @param short_addr Device address
+ * @param endpoint Device endpoint
+ * @param group_ids Groups the endpoint is in
+ * @param count Number of group ids
+ */
+void zig_groups_replace(uint16_t short_addr, uint8_t endpoint, const uint16_t *group_ids, uint8_t count);
+
+// Python API function objects
+extern const mp_obj_fun_builtin_var_t esp32_zig_add_group_obj;       // Add device endpoint to a group
+extern const mp_obj_fun_builtin_var_t esp32_zig_remove_group_obj;    // Remove from one group or all groups
+extern const mp_obj_fun_builtin_var_t esp32_zig_view_group_obj;      // Ask for one group or all memberships
+extern const mp_obj_fun_builtin_var_t esp32_zig_groups_obj;          // Local membership mirror
+
+#endif // MOD_ZIG_GROUPS_H
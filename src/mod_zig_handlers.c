@@ -23,12 +23,24 @@
 #include "mod_zig_core.h"
 #include "mod_zig_msg.h"
 #include "mod_zig_devices.h"
+#include "mod_zig_cmd.h"
+#include "mod_zig_request.h"
+#include "mod_zig_mailbox.h"
+#include "mod_zig_groups.h"
+#include "mod_zig_report.h"
+#include "mod_zig_retry.h"
+#include "mod_zig_interview.h"
+#include "mod_zig_binding.h"
+#include "mod_zig_topology.h"
+#include "mod_zig_network.h"
+#include "mod_zig_route.h"
 #include "main.h"
 
 #define HANDLERS_TAG "ZIGBEE_HANDLERS"
 
 // Function prototypes
 static void simple_desc_req_cb(esp_zb_zdp_status_t status, esp_zb_af_simple_desc_1_1_t *simple_desc, void *user_ctx);
+static void active_ep_cb(esp_zb_zdp_status_t status, uint8_t ep_count, uint8_t *ep_id_list, void *user_ctx);
 
 void bdb_start_top_level_commissioning_cb(uint8_t mode_mask)
 {
@@ -57,13 +69,13 @@ void rcp_error_handler(void) {
 
 
 // Function for sending message to queue with message type
-void send_msg_to_micropython_queue(uint8_t msg_py, uint16_t signal_type, uint16_t src_addr, uint8_t endpoint, uint16_t cluster_id, uint8_t *data, uint8_t data_len) {
+static void queue_msg(uint8_t msg_py, uint16_t signal_type, uint16_t src_addr, uint8_t endpoint, uint16_t cluster_id, int16_t tsn, uint8_t *data, uint8_t data_len) {
     esp32_zig_obj_t *self = (esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr);
     if (self) {
 
         // Log event to ESP-IDF console
-        ESP_LOGI(HANDLERS_TAG, "Event->Py addr=0x%04x ep=%u cid=0x%04x len=%u sig=0x%04x", 
-                 src_addr, endpoint, cluster_id, data_len, signal_type);
+        ESP_LOGI(HANDLERS_TAG, "Event->Py addr=0x%04x ep=%u cid=0x%04x len=%u sig=0x%04x tsn=%d", 
+                 src_addr, endpoint, cluster_id, data_len, signal_type, tsn);
 
         zigbee_message_t msg;
         msg.msg_py = msg_py;
@@ -71,6 +83,7 @@ void send_msg_to_micropython_queue(uint8_t msg_py, uint16_t signal_type, uint16_
         msg.src_addr = src_addr;
         msg.endpoint = endpoint;
         msg.cluster_id = cluster_id;
+        msg.tsn = tsn;
         
         // Safely copy data without overflow
         // Since data_len is uint8_t, it can't be > 255, but msg.data might be larger
@@ -97,6 +110,17 @@ void send_msg_to_micropython_queue(uint8_t msg_py, uint16_t signal_type, uint16_
     }
 }
 
+void send_msg_to_micropython_queue(uint8_t msg_py, uint16_t signal_type, uint16_t src_addr, uint8_t endpoint, uint16_t cluster_id, uint8_t *data, uint8_t data_len) {
+    queue_msg(msg_py, signal_type, src_addr, endpoint, cluster_id, -1, data, data_len);
+}
+
+void send_zcl_msg_to_micropython_queue(uint8_t msg_py, uint16_t signal_type, const esp_zb_zcl_cmd_info_t *info,
+                                       uint8_t status, uint8_t *data, uint8_t data_len) {
+    zig_request_resolve(info->src_address.u.short_addr, info->header.tsn, signal_type, status, data, data_len);
+    queue_msg(msg_py, signal_type, info->src_address.u.short_addr, info->src_endpoint, info->cluster,
+              info->header.tsn, data, data_len);
+}
+
 
 
 // Callback for handling ZDO-Bind response
@@ -104,78 +128,96 @@ void bind_cb(esp_zb_zdp_status_t status, void *user_ctx) {
     bind_ctx_t *ctx = (bind_ctx_t*)user_ctx;
     if (status == ESP_ZB_ZDP_STATUS_SUCCESS) {
         ESP_LOGI(HANDLERS_TAG, "Bind OK device=0x%04x ep=%u cluster=0x%04x", ctx->short_addr, ctx->endpoint, ctx->cluster_id);
-        
-        // Configure reporting for the bound cluster
-        // Configure reporting is now moved to Python via zig.configure_report()
-        // Apply stored report configurations
-        zigbee_device_t *dev = device_manager_get(ctx->short_addr);
-        if (dev) {
-            for (int j = 0; j < MAX_REPORT_CFGS; j++) {
-                report_cfg_t *r = &dev->report_cfgs[j];
-                if (r->in_use && r->ep == ctx->endpoint && r->cluster_id == ctx->cluster_id) {
-                    esp_zb_zcl_config_report_cmd_t report_cmd = {0};
-                    esp_zb_zcl_config_report_record_t rec = {0};
-                    uint32_t *allocated_rc_val = NULL; // To manage allocated memory for reportable_change
-
-                    report_cmd.zcl_basic_cmd.dst_addr_u.addr_short = ctx->short_addr;
-                    report_cmd.zcl_basic_cmd.dst_endpoint = r->ep; // Use endpoint from report_cfg_t
-                    report_cmd.zcl_basic_cmd.src_endpoint = ESP_ZB_GATEWAY_ENDPOINT;
-                    report_cmd.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
-                    report_cmd.clusterID = r->cluster_id; // Use cluster_id from report_cfg_t
-                    report_cmd.record_number = 1;
-                    report_cmd.record_field = &rec;
-                    // The report_cmd.direction (for the command frame) is typically ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV
-                    // This is often a default or set implicitly by the SDK function if not a direct field here.
-                    // Let's assume the SDK handles the command direction or it's part of zcl_basic_cmd implicitly.
-
-                    rec.attributeID = r->attr_id; // Use attr_id from report_cfg_t
-
-                    if (r->direction == REPORT_CFG_DIRECTION_SEND) {
-                        rec.direction = ESP_ZB_ZCL_REPORT_DIRECTION_SEND; // Correct direction for the record
-                        rec.attrType = r->send_cfg.attr_type;
-                        rec.min_interval = r->send_cfg.min_int;
-                        rec.max_interval = r->send_cfg.max_int;
-                        
-                        if (r->send_cfg.reportable_change_val != 0xFFFFFFFF) {
-                            allocated_rc_val = malloc(sizeof(uint32_t));
-                            if (allocated_rc_val) {
-                                *allocated_rc_val = r->send_cfg.reportable_change_val;
-                                rec.reportable_change = allocated_rc_val;
-                            } else {
-                                ESP_LOGE(HANDLERS_TAG, "Failed to allocate for reportable_change in bind_cb");
-                                rec.reportable_change = NULL; // Or handle error more gracefully
-                            }
-                        } else {
-                            rec.reportable_change = NULL; // No reportable change configured or discrete attribute
-                        }
-                    } else if (r->direction == REPORT_CFG_DIRECTION_RECV) {
-                        rec.direction = ESP_ZB_ZCL_REPORT_DIRECTION_RECV; // Correct direction for the record
-                        rec.timeout = r->recv_cfg.timeout_period;
-                        // For RECV, other fields like attrType, min/max_interval, reportable_change are not used in the record.
-                    } else {
-                        ESP_LOGW(HANDLERS_TAG, "Unknown report_cfg direction: %d", r->direction);
-                        if (allocated_rc_val) free(allocated_rc_val); // Should not happen here, but good practice
-                        continue; // Skip this configuration
-                    }
-                    
-                    ESP_LOGI(HANDLERS_TAG, "Auto-configuring reporting after bind: addr=0x%04x, ep=%d, cl=0x%04x, attr=0x%04x, dir=%d", 
-                        ctx->short_addr, r->ep, r->cluster_id, r->attr_id, r->direction);
-
-                    esp_zb_zcl_config_report_cmd_req(&report_cmd);
-
-                    if (allocated_rc_val) {
-                        free(allocated_rc_val);
-                    }
-                }
+        zig_retry_done(ZIG_RETRY_BIND, ctx->short_addr, ctx->endpoint, ctx->cluster_id);
+        zig_binding_update(ctx->src_ieee, ctx->endpoint, ctx->cluster_id, ctx->dst_ieee, ctx->dst_endpoint, true);
+
+        // Inside an interview the Report step configures it; otherwise check the
+        // stored configs of the cluster now and send the ones the device lacks
+        if (!zig_interview_advance(ctx->short_addr, ZIG_INTERVIEW_BIND, ctx->endpoint, ctx->cluster_id)) {
+            zigbee_device_t *dev = device_manager_get(ctx->short_addr);
+            if (dev) {
+                zig_report_sync(dev, ctx->endpoint, ctx->cluster_id, NULL);
             }
         }
     } else {
         ESP_LOGW(HANDLERS_TAG, "Bind FAIL device=0x%04x ep=%u cluster=0x%04x status=%d", ctx->short_addr, ctx->endpoint, ctx->cluster_id, status);
+        zig_retry_failed(ZIG_RETRY_BIND, ctx->short_addr, ctx->endpoint, ctx->cluster_id, status);
     }
     free(ctx);
 }
 
 
+// Interview requests, also sent again by the retry engine
+
+void zig_request_active_ep(uint16_t short_addr) {
+    esp_zb_zdo_active_ep_req_param_t active_ep_req = {
+        .addr_of_interest = short_addr
+    };
+    esp_zb_zdo_active_ep_req(&active_ep_req, active_ep_cb, (void*)(uintptr_t)short_addr);
+    ESP_LOGI(HANDLERS_TAG, "ZIGBEE: Device request Active EP for device: 0x%04x", short_addr);
+}
+
+bool zig_request_simple_desc(uint16_t short_addr, uint8_t endpoint) {
+    zigbee_device_t *device = device_manager_get(short_addr);
+    if (!device) {
+        return false;
+    }
+    int ep_index = -1;
+    for (int j = 0; j < device->endpoint_count; j++) {
+        if (device->endpoints[j].endpoint == endpoint) {
+            ep_index = j;
+            break;
+        }
+    }
+    if (ep_index < 0) {
+        return false;
+    }
+
+    esp_zb_zdo_simple_desc_req_param_t req = {
+        .addr_of_interest = short_addr,
+        .endpoint = endpoint
+    };
+// Pass short_addr and ep_index to user_ctx
+    uintptr_t cb_ctx = ((uintptr_t)short_addr << 8) | (ep_index & 0xFF);
+    esp_zb_zdo_simple_desc_req(&req, simple_desc_req_cb, (void*)cb_ctx);
+    return true;
+}
+
+void zig_request_bind(const zigbee_device_t *device, uint8_t endpoint, uint16_t cluster_id) {
+    esp_zb_zdo_bind_req_param_t bind_req;
+// Initialize structure
+    memset(&bind_req, 0, sizeof(bind_req));
+// Source address (IEEE) for binding
+    memcpy(bind_req.src_address, device->ieee_addr, sizeof(esp_zb_ieee_addr_t));
+    bind_req.cluster_id    = cluster_id;
+    bind_req.src_endp      = endpoint;
+    bind_req.dst_addr_mode = ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED;
+// Destination IEEE address (coordinator)
+    {
+        esp_zb_ieee_addr_t coord_ieee;
+        esp_zb_get_long_address(coord_ieee);
+        memcpy(bind_req.dst_address_u.addr_long, coord_ieee, sizeof(esp_zb_ieee_addr_t));
+    }
+    bind_req.dst_endp      = ESP_ZB_GATEWAY_ENDPOINT;
+    // Address where to send the ZDO request
+    bind_req.req_dst_addr  = device->short_addr;
+// Context for callback
+    bind_ctx_t *bctx = malloc(sizeof(bind_ctx_t));
+    if (!bctx) {
+        ESP_LOGE(HANDLERS_TAG, "Failed to allocate bind context");
+        return;
+    }
+    bctx->short_addr = device->short_addr;
+    bctx->endpoint   = endpoint;
+    bctx->cluster_id = cluster_id;
+    memcpy(bctx->src_ieee, bind_req.src_address, sizeof(bctx->src_ieee));
+    memcpy(bctx->dst_ieee, bind_req.dst_address_u.addr_long, sizeof(bctx->dst_ieee));
+    bctx->dst_endpoint = bind_req.dst_endp;
+    esp_zb_zdo_device_bind_req(&bind_req, bind_cb, bctx);
+    ESP_LOGI(HANDLERS_TAG, "Bind req sent to dev=0x%04x ep=%u cluster=0x%04x", device->short_addr, endpoint, cluster_id);
+}
+
+
 
 
 
@@ -186,8 +228,10 @@ static void active_ep_cb(esp_zb_zdp_status_t status, uint8_t ep_count, uint8_t *
     
     if (status != ESP_ZB_ZDP_STATUS_SUCCESS) {
         ESP_LOGW(HANDLERS_TAG, "Active EP request failed for device 0x%04x, status: %d", short_addr, status);
+        zig_retry_failed(ZIG_RETRY_ACTIVE_EP, short_addr, 0, 0, status);
         return;
     }
+    zig_retry_done(ZIG_RETRY_ACTIVE_EP, short_addr, 0, 0);
 
     zigbee_device_t *device = device_manager_get(short_addr);
     if (!device) {
@@ -214,29 +258,20 @@ static void active_ep_cb(esp_zb_zdp_status_t status, uint8_t ep_count, uint8_t *
             device->endpoint_count++;
         }
         
-// Request Simple Descriptor in any case
-        esp_zb_zdo_simple_desc_req_param_t req = {
-            .addr_of_interest = short_addr,
-            .endpoint = ep
-        };
-// Pass short_addr and ep_index to user_ctx
-        uintptr_t cb_ctx = ((uintptr_t)short_addr << 8) | (ep_index & 0xFF);
-        esp_zb_zdo_simple_desc_req(&req, simple_desc_req_cb, (void*)cb_ctx);
-        
         if (ep_index >= device->endpoint_count - 1) {
             ESP_LOGI(HANDLERS_TAG, "Device 0x%04x: added endpoint %d", short_addr, ep);
         } else {
             ESP_LOGI(HANDLERS_TAG, "Device 0x%04x: updating endpoint %d", short_addr, ep);
         }
     }
+
+// Simple Descriptors follow one endpoint at a time
+    zig_interview_advance(short_addr, ZIG_INTERVIEW_ACTIVE_EP, 0, 0);
 }
 
 
 // Callback for Simple Descriptor response
 static void simple_desc_req_cb(esp_zb_zdp_status_t status, esp_zb_af_simple_desc_1_1_t *simple_desc, void *user_ctx) {
-    if (status != ESP_ZB_ZDP_STATUS_SUCCESS || simple_desc == NULL) {
-        return;
-    }
     uintptr_t ctx = (uintptr_t)user_ctx;
     uint16_t short_addr = (uint16_t)(ctx >> 8);
     int ep_index = (int)(ctx & 0xFF);
@@ -248,6 +283,23 @@ static void simple_desc_req_cb(esp_zb_zdp_status_t status, esp_zb_af_simple_desc
     }
     zigbee_endpoint_t *ep_rec = &device->endpoints[ep_index];
 
+    if (status != ESP_ZB_ZDP_STATUS_SUCCESS || simple_desc == NULL) {
+        ESP_LOGW(HANDLERS_TAG, "Simple Descriptor request failed for device 0x%04x ep %u, status: %d", short_addr, ep_rec->endpoint, status);
+        zig_retry_failed(ZIG_RETRY_SIMPLE_DESC, short_addr, ep_rec->endpoint, 0, status);
+        return;
+    }
+    zig_retry_done(ZIG_RETRY_SIMPLE_DESC, short_addr, ep_rec->endpoint, 0);
+
+// Compare with the stored descriptor, interview Verify relies on it
+    uint8_t cluster_count = simple_desc->app_input_cluster_count + simple_desc->app_output_cluster_count;
+    if (cluster_count > MAX_CLUSTERS) {
+        cluster_count = MAX_CLUSTERS;
+    }
+    bool changed = ep_rec->profile_id != simple_desc->app_profile_id ||
+                   ep_rec->device_id != simple_desc->app_device_id ||
+                   ep_rec->cluster_count != cluster_count ||
+                   memcmp(ep_rec->cluster_list, simple_desc->app_cluster_list, cluster_count * sizeof(uint16_t)) != 0;
+
     ep_rec->profile_id     = simple_desc->app_profile_id;
     ep_rec->device_id      = simple_desc->app_device_id;
     ep_rec->cluster_count  = simple_desc->app_input_cluster_count + simple_desc->app_output_cluster_count;
@@ -262,144 +314,36 @@ static void simple_desc_req_cb(esp_zb_zdp_status_t status, esp_zb_af_simple_desc
         ep_rec->cluster_list[i] = simple_desc->app_cluster_list[i];
     }
 
-// Check if Basic and Power Config clusters are in the device
-    bool has_basic = false;
-    bool has_power_config = false;
-    for (int i = 0; i < ep_rec->cluster_count; i++) {
-        if (ep_rec->cluster_list[i] == ESP_ZB_ZCL_CLUSTER_ID_BASIC) {
-            has_basic = true;
-        } else if (ep_rec->cluster_list[i] == ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG) {
-            has_power_config = true;
-        }
-    }
-
-    if (has_basic || has_power_config) {
-        ESP_LOGI(HANDLERS_TAG, "Found Basic/Power clusters on device 0x%04x, endpoint %d", 
-                 device->short_addr, simple_desc->endpoint);
-            
-// Allocate memory for attributes array
-        uint16_t *attr_field = malloc(6 * sizeof(uint16_t));
-        uint8_t tsn = 0;
-        
-        if (attr_field == NULL) {
-            ESP_LOGE(HANDLERS_TAG, "Failed to allocate memory for attr_field");
-            return;
-        }
-
-// Form request for all attributes
-        uint8_t attr_count = 0;
-        if (has_basic) {
-            attr_field[attr_count++] = ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID;     // 0x0004
-            attr_field[attr_count++] = ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID;      // 0x0005
-            attr_field[attr_count++] = ESP_ZB_ZCL_ATTR_BASIC_APPLICATION_VERSION_ID;   // 0x0001
-            attr_field[attr_count++] = ESP_ZB_ZCL_ATTR_BASIC_POWER_SOURCE_ID;         // 0x0007
-
-            esp_zb_zcl_read_attr_cmd_t read_basic_cmd = {
-                .zcl_basic_cmd = {
-                    .dst_addr_u.addr_short = device->short_addr,
-                    .dst_endpoint = simple_desc->endpoint,
-                    .src_endpoint = ESP_ZB_GATEWAY_ENDPOINT,
-                },
-                .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
-                .clusterID = ESP_ZB_ZCL_CLUSTER_ID_BASIC,
-                .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV,
-                .attr_number = attr_count,
-                .attr_field = attr_field
-            };
-
-            tsn = esp_zb_zcl_read_attr_cmd_req(&read_basic_cmd);
-            ESP_LOGI(HANDLERS_TAG, "Basic cluster info request sent, tsn=%d", tsn);
+    ESP_LOGI(HANDLERS_TAG, "cluster_count: %d", ep_rec->cluster_count);
+    // Send simple descriptor info to MicroPython: ep, count, profile, device, clusters list
+
+    // uint8_t buf[70];
+    // size_t pos = 0;
+    // buf[pos++] = ep_rec->endpoint;
+    // buf[pos++] = (uint8_t)ep_rec->cluster_count;
+    // buf[pos++] = ep_rec->profile_id & 0xFF;
+    // buf[pos++] = (ep_rec->profile_id >> 8) & 0xFF;
+    // buf[pos++] = ep_rec->device_id & 0xFF;
+    // buf[pos++] = (ep_rec->device_id >> 8) & 0xFF;
+    // for (int i = 0; i < ep_rec->cluster_count; i++) {
+    //     buf[pos++] = ep_rec->cluster_list[i] & 0xFF;
+    //     buf[pos++] = (ep_rec->cluster_list[i] >> 8) & 0xFF;
+    // }
+
+    //Not need now, because we store all info in device_manager and json file
+    //send_msg_to_micropython_queue(ZIG_MSG_SIMPLE_DESC_REQ_CB, , device->short_addr, 0xFD, 0xFFFD, buf, pos);
+
+// Interviews save once at the end, a changed descriptor outside one is saved now
+    ESP_LOGI(HANDLERS_TAG, "Device 0x%04x: endpoints and clusters initialized", device->short_addr);
+    if (changed) {
+        device->interview_complete = false;
+        if (!zig_interview_pending(short_addr)) {
+            device_storage_save((esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr), device->short_addr);
         }
-
-        if (has_power_config) {
-            attr_count = 0;
-            attr_field[attr_count++] = ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_VOLTAGE_ID;           // 0x0020
-            attr_field[attr_count++] = ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_PERCENTAGE_REMAINING_ID; // 0x0021
-
-            esp_zb_zcl_read_attr_cmd_t read_power_cmd = {
-                .zcl_basic_cmd = {
-                    .dst_addr_u.addr_short = device->short_addr,
-                    .dst_endpoint = simple_desc->endpoint,
-                    .src_endpoint = ESP_ZB_GATEWAY_ENDPOINT,
-                },
-                .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
-                .clusterID = ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG,
-                .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV,
-                .attr_number = attr_count,
-                .attr_field = attr_field
-            };
-
-            tsn = esp_zb_zcl_read_attr_cmd_req(&read_power_cmd);
-            ESP_LOGI(HANDLERS_TAG, "Power Config cluster info request sent, tsn=%d", tsn);
-        }
-        
-        free(attr_field);
     }
 
-// Iterate through all input clusters (server) of device
-    for (int i = 0; i < (int)simple_desc->app_input_cluster_count; i++) {
-        uint16_t cluster_id = simple_desc->app_cluster_list[i];
-        // Send bind only if cluster is configured through Python report_cfg
-        bool should_bind = false;
-        for (int j = 0; j < MAX_REPORT_CFGS; j++) {
-            report_cfg_t *r = &device->report_cfgs[j];
-            if (r->in_use && r->ep == simple_desc->endpoint && r->cluster_id == cluster_id) {
-                should_bind = true;
-                break;
-            }
-        }
-        if (!should_bind) {
-            continue;
-        }       
-         esp_zb_zdo_bind_req_param_t bind_req;
-// Initialize structure
-        memset(&bind_req, 0, sizeof(bind_req));
-// Source address (IEEE) for binding
-        memcpy(bind_req.src_address, device->ieee_addr, sizeof(esp_zb_ieee_addr_t));
-        bind_req.cluster_id    = cluster_id;
-        bind_req.src_endp      = simple_desc->endpoint;
-        bind_req.dst_addr_mode = ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED;
-// Destination IEEE address (coordinator)
-        {
-            esp_zb_ieee_addr_t coord_ieee;
-            esp_zb_get_long_address(coord_ieee);
-            memcpy(bind_req.dst_address_u.addr_long, coord_ieee, sizeof(esp_zb_ieee_addr_t));
-        }
-        bind_req.dst_endp      = ESP_ZB_GATEWAY_ENDPOINT;
-        // Address where to send the ZDO request
-        bind_req.req_dst_addr  = device->short_addr;
-// Context for callback
-        bind_ctx_t *bctx = malloc(sizeof(bind_ctx_t));
-        bctx->short_addr = device->short_addr;
-        bctx->endpoint   = simple_desc->endpoint;
-        bctx->cluster_id = cluster_id;
-        esp_zb_zdo_device_bind_req(&bind_req, bind_cb, bctx);
-        ESP_LOGI(HANDLERS_TAG, "Bind req sent to dev=0x%04x ep=%u cluster=0x%04x", device->short_addr, simple_desc->endpoint, cluster_id);
-        }
-
-        ESP_LOGI(HANDLERS_TAG, "cluster_count: %d", ep_rec->cluster_count);
-        // Send simple descriptor info to MicroPython: ep, count, profile, device, clusters list
-
-        // uint8_t buf[70];
-        // size_t pos = 0;
-        // buf[pos++] = ep_rec->endpoint;
-        // buf[pos++] = (uint8_t)ep_rec->cluster_count;
-        // buf[pos++] = ep_rec->profile_id & 0xFF;
-        // buf[pos++] = (ep_rec->profile_id >> 8) & 0xFF;
-        // buf[pos++] = ep_rec->device_id & 0xFF;
-        // buf[pos++] = (ep_rec->device_id >> 8) & 0xFF;
-        // for (int i = 0; i < ep_rec->cluster_count; i++) {
-        //     buf[pos++] = ep_rec->cluster_list[i] & 0xFF;
-        //     buf[pos++] = (ep_rec->cluster_list[i] >> 8) & 0xFF;
-        // }
-
-        //Not need now, because we store all info in device_manager and json file
-        //send_msg_to_micropython_queue(ZIG_MSG_SIMPLE_DESC_REQ_CB, , device->short_addr, 0xFD, 0xFFFD, buf, pos);
-
-// Save device after initialization of all endpoints and clusters
-        ESP_LOGI(HANDLERS_TAG, "Device 0x%04x: endpoints and clusters initialized", device->short_addr);
-        device_storage_save((esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr), device->short_addr);
-    
+// Next endpoint, then Basic reads and binds
+    zig_interview_descriptor(short_addr, ep_rec->endpoint, changed);
 }
 
 
@@ -455,8 +399,9 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct) {
                 }
 
                 if (esp_zb_bdb_is_factory_new()) {
-                    esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_FORMATION);
+                    zig_network_form();
                 } else {
+                    zig_route_start();
                     ESP_LOGI(HANDLERS_TAG, "Device restarted in existing network mode. Network steering will be initiated by ESP_ZB_BDB_SIGNAL_FORMATION if applicable.");
                 }
             } else {
@@ -476,6 +421,9 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct) {
                     extended_pan_id[7], extended_pan_id[6], extended_pan_id[5], extended_pan_id[4],
                     extended_pan_id[3], extended_pan_id[2], extended_pan_id[1], extended_pan_id[0]);
 
+                // New network, the map of the old one is meaningless
+                zig_topology_reset();
+                zig_route_start();
                 esp_zb_scheduler_alarm((esp_zb_callback_t)bdb_start_top_level_commissioning_cb,
                                      ESP_ZB_BDB_MODE_NETWORK_STEERING, 100);
             } else {
@@ -522,14 +470,16 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct) {
                 ESP_LOGE(HANDLERS_TAG, "ZIGBEE: Device 0x%04x not found in manager after add/update attempt. Cannot proceed with EP discovery.", dev_annce_params->device_short_addr);
                 break;
             }
+
+            // Receiver off when idle: commands wait in the mailbox until the device is heard from
+            device->rx_off_when_idle = !(dev_annce_params->capability & ZIG_MAC_CAP_RX_ON_WHEN_IDLE);
+            zig_mailbox_heard(dev_annce_params->device_short_addr);
             
-            // Request active endpoints for update 
-            esp_zb_zdo_active_ep_req_param_t active_ep_req = {
-                .addr_of_interest = dev_annce_params->device_short_addr
-            };
-            esp_zb_zdo_active_ep_req(&active_ep_req, active_ep_cb, (void*)(uintptr_t)dev_annce_params->device_short_addr);
-            
-            ESP_LOGI(HANDLERS_TAG, "ZIGBEE: Device request Active EP for device: 0x%04x", dev_annce_params->device_short_addr);
+            // Fresh interview: earlier retries are stale and the attempt budget starts over
+            zig_retry_reset(dev_annce_params->device_short_addr);
+
+            // Interview runs once a slot is free, a fully known device skips it
+            zig_interview_rejoin(dev_annce_params->device_short_addr);
             ESP_LOGI(HANDLERS_TAG, "ZIGBEE: Device added/updated: 0x%04x", device->short_addr);
             break;
         }
@@ -584,7 +534,10 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct) {
         }
 
         case ESP_ZB_NLME_STATUS_INDICATION: {
-            uint8_t status = *(uint8_t *)esp_zb_app_signal_get_params(p_sg_p);
+            esp_zb_zdo_signal_nwk_status_indication_params_t *nwk_status =
+                (esp_zb_zdo_signal_nwk_status_indication_params_t *)esp_zb_app_signal_get_params(p_sg_p);
+            uint8_t status = nwk_status->status;
+            zig_route_status(status, nwk_status->network_addr);
             switch (status) {
                 case ZB_NWK_COMMAND_STATUS_BAD_KEY_SEQUENCE_NUMBER:
                     ESP_LOGW(HANDLERS_TAG, "Bad key sequence number");
@@ -681,14 +634,16 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct) {
                 if (add_err == ESP_OK || add_err == ESP_ERR_INVALID_STATE) { // ESP_ERR_INVALID_STATE might mean it was already added by a concurrent event or handled conflict
                     ESP_LOGI(HANDLERS_TAG, "Successfully added device 0x%04x (IEEE: %s) from Device Update signal. Will interview.", 
                              update_params->short_addr, ieee_from_signal_str);
-                    
-                    // Request active endpoints for update 
-                    esp_zb_zdo_active_ep_req_param_t active_ep_req = {
-                        .addr_of_interest = update_params->short_addr
-                    };
-                    esp_zb_zdo_active_ep_req(&active_ep_req, active_ep_cb, (void*)(uintptr_t)update_params->short_addr);
-                    
-                    ESP_LOGI(HANDLERS_TAG, "ZIGBEE: Device request Active EP for device: 0x%04x", update_params->short_addr);
+
+                    // Unsecured join of a known IEEE: the device was reset, its bindings are gone
+                    device = device_manager_get(update_params->short_addr);
+                    if (device && update_params->status == 0x01) {
+                        device->interview_complete = false;
+                        zig_binding_forget(device->ieee_addr);
+                    }
+
+                    // Interview runs once a slot is free, a rejoin at a new address may skip it
+                    zig_interview_rejoin(update_params->short_addr);
                 } else {
                     ESP_LOGE(HANDLERS_TAG, "Failed to add device 0x%04x (IEEE: %s) from Device Update signal. Error: %s. Cannot interview.", 
                              update_params->short_addr, ieee_from_signal_str, esp_err_to_name(add_err));
@@ -706,12 +661,15 @@ void esp_zb_app_signal_handler(esp_zb_app_signal_t *signal_struct) {
                     // For now, just log.
                 }
 
-                // Update device metrics
+                // Unsecured join: the device was reset, the announcement that follows interviews it again
+                if (update_params->status == 0x01) {
+                    device->interview_complete = false;
+                    zig_binding_forget(device->ieee_addr);
+                }
+
+                // Update device metrics (runtime state only, the stored record is unchanged)
                 device->active = true;
                 device_manager_update_timestamp(update_params->short_addr);
-                
-                // Save device after update
-                device_storage_save((esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr), device->short_addr);
             }
             break;
         }
@@ -780,13 +738,18 @@ esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const
         }
 
 
+        // Remove All Groups is only answered by a Default Response
+        if (resp->info.cluster == ESP_ZB_ZCL_CLUSTER_ID_GROUPS && resp->resp_to_cmd == ESP_ZB_ZCL_CMD_GROUPS_REMOVE_ALL_GROUPS
+            && resp->status_code == ESP_ZB_ZCL_STATUS_SUCCESS) {
+            zig_groups_replace(resp->info.src_address.u.short_addr, resp->info.src_endpoint, NULL, 0);
+        }
+
         // Send command execution result to MicroPython
-        send_msg_to_micropython_queue(
+        send_zcl_msg_to_micropython_queue(
             ZIG_MSG_ZB_ACTION_HANDLER,
             ESP_ZB_CORE_CMD_DEFAULT_RESP_CB_ID,
-            resp->info.src_address.u.short_addr,
-            resp->info.src_endpoint,
-            resp->info.cluster,
+            &resp->info,
+            resp->status_code,
             data,
             sizeof(data)
         );
@@ -797,6 +760,7 @@ esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const
 
     case ESP_ZB_CORE_REPORT_ATTR_CB_ID: {                       //         = 0x2000,   /*!< Attribute Report, refer to esp_zb_zcl_report_attr_message_t */
         const esp_zb_zcl_report_attr_message_t *report_msg = (esp_zb_zcl_report_attr_message_t *)message;
+        zig_mailbox_heard(report_msg->src_address.u.short_addr);
 
         // Send full attribute data: ID (2 bytes), type (1 byte), payload
         uint16_t attr_id = report_msg->attribute.id;
@@ -844,6 +808,14 @@ esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const
                     // Update device timestamp instead of LQI/RSSI
                     device_manager_update_timestamp(short_addr);
 
+                    // Snapshot to tell record changes (names) from volatile ones (power/battery)
+                    char prev_manufacturer[sizeof(device->manufacturer_name)];
+                    char prev_name[sizeof(device->device_name)];
+                    memcpy(prev_manufacturer, device->manufacturer_name, sizeof(prev_manufacturer));
+                    memcpy(prev_name, device->device_name, sizeof(prev_name));
+                    uint8_t prev_volatile[4] = { device->power_source, device->firmware_version,
+                                                 device->battery_voltage, device->battery_percentage };
+
                     esp_zb_zcl_read_attr_resp_variable_t *current = variable;
                     
                     while (current) {
@@ -902,11 +874,21 @@ esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const
                         current = current->next;
                     }
 
-// Save device after receiving all attributes
-                    if (device->manufacturer_name[0] != '\0' && device->device_name[0] != '\0') {
+// Save device record only when identity attributes changed
+                    bool names_changed = strcmp(prev_manufacturer, device->manufacturer_name) != 0 ||
+                                         strcmp(prev_name, device->device_name) != 0;
+                    if (names_changed && device->manufacturer_name[0] != '\0' && device->device_name[0] != '\0' &&
+                        !zig_interview_pending(device->short_addr)) {
                         ESP_LOGI(HANDLERS_TAG, "Device 0x%04x: got all required attributes", device->short_addr);
                         device_storage_save((esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr), device->short_addr);
                     }
+
+                    // Power/battery values go to the volatile state record
+                    uint8_t cur_volatile[4] = { device->power_source, device->firmware_version,
+                                                device->battery_voltage, device->battery_percentage };
+                    if (memcmp(prev_volatile, cur_volatile, sizeof(cur_volatile)) != 0) {
+                        device_storage_mark_volatile(device->short_addr);
+                    }
                 }
             }
             
@@ -928,12 +910,11 @@ esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const
                         memcpy(buf + 3, value_ptr, payload_len);
                     }
 
-                    send_msg_to_micropython_queue(
+                    send_zcl_msg_to_micropython_queue(
                         ZIG_MSG_ZB_APP_SIGNAL_HANDLER,
                         ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID,
-                        read_msg->info.src_address.u.short_addr,
-                        read_msg->info.src_endpoint,
-                        read_msg->info.cluster,
+                        &read_msg->info,
+                        read_msg->info.status,
                         buf,
                         buf_len
                     );
@@ -942,11 +923,47 @@ esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const
                 }
                 variable = variable->next;
             }
+        } else {
+            // Nothing to deliver, but the request waiting for it is answered
+            zig_request_resolve(read_msg->info.src_address.u.short_addr, read_msg->info.header.tsn,
+                                ESP_ZB_CORE_CMD_READ_ATTR_RESP_CB_ID, read_msg->info.status, NULL, 0);
+        }
+        // After the Basic attributes are stored: Identify looks the model up
+        zig_interview_zcl_resp(read_msg->info.src_address.u.short_addr, read_msg->info.header.tsn);
+        break;
+    }
+    case ESP_ZB_CORE_CMD_WRITE_ATTR_RESP_CB_ID: {
+        const esp_zb_zcl_cmd_write_attr_resp_message_t *write_msg = (esp_zb_zcl_cmd_write_attr_resp_message_t *)message;
+
+        // Per-attribute status: status(1) + attr_id(2) per record. All written
+        // successfully comes back as a single SUCCESS record without attribute id.
+        uint8_t data[3 * ZIG_WRITE_ATTR_PER_FRAME];
+        size_t data_len = 0;
+        for (esp_zb_zcl_write_attr_resp_variable_t *variable = write_msg->variables;
+             variable && data_len + 3 <= sizeof(data); variable = variable->next) {
+            data[data_len++] = variable->status;
+            data[data_len++] = variable->attribute_id & 0xFF;
+            data[data_len++] = (variable->attribute_id >> 8) & 0xFF;
         }
+        if (data_len == 0) {
+            data[data_len++] = write_msg->info.status;
+            data[data_len++] = 0;
+            data[data_len++] = 0;
+        }
+
+        send_zcl_msg_to_micropython_queue(
+            ZIG_MSG_ZB_APP_SIGNAL_HANDLER,
+            ESP_ZB_CORE_CMD_WRITE_ATTR_RESP_CB_ID,
+            &write_msg->info,
+            write_msg->info.status,
+            data,
+            data_len
+        );
         break;
     }
     case ESP_ZB_CORE_CMD_REPORT_CONFIG_RESP_CB_ID: {
         const esp_zb_zcl_cmd_config_report_resp_message_t *config_msg = (esp_zb_zcl_cmd_config_report_resp_message_t *)message;
+        zig_interview_zcl_resp(config_msg->info.src_address.u.short_addr, config_msg->info.header.tsn);
         
         if (config_msg->info.status == ESP_ZB_ZCL_STATUS_SUCCESS) {
             // Send report configuration information
@@ -955,18 +972,126 @@ esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const
                 config_msg->variables ? config_msg->variables->attribute_id & 0xFF : 0
             };
 
-            send_msg_to_micropython_queue(
+            send_zcl_msg_to_micropython_queue(
                 ZIG_MSG_ZB_APP_SIGNAL_HANDLER,
                 ESP_ZB_CORE_CMD_REPORT_CONFIG_RESP_CB_ID,
-                config_msg->info.src_address.u.short_addr,
-                config_msg->info.src_endpoint,
-                config_msg->info.cluster,
+                &config_msg->info,
+                config_msg->info.status,
                 data,
                 sizeof(data)
             );
+        } else {
+            zig_request_resolve(config_msg->info.src_address.u.short_addr, config_msg->info.header.tsn,
+                                ESP_ZB_CORE_CMD_REPORT_CONFIG_RESP_CB_ID, config_msg->info.status, NULL, 0);
+        }
+        break;
+    }
+    case ESP_ZB_CORE_CMD_READ_REPORT_CFG_RESP_CB_ID: {
+        // Diff against the stored configs, forwarded to MicroPython from there
+        zig_report_verify_resp(message);
+        const esp_zb_zcl_cmd_read_report_config_resp_message_t *cfg_msg =
+            (esp_zb_zcl_cmd_read_report_config_resp_message_t *)message;
+        zig_interview_zcl_resp(cfg_msg->info.src_address.u.short_addr, cfg_msg->info.header.tsn);
+        break;
+    }
+
+    case ESP_ZB_CORE_CMD_OPERATE_GROUP_RESP_CB_ID: {
+        const esp_zb_zcl_groups_operate_group_resp_message_t *group_msg =
+            (esp_zb_zcl_groups_operate_group_resp_message_t *)message;
+        uint8_t cmd_id = group_msg->info.command.id;
+        uint8_t status = group_msg->info.status;
+
+        // Already a member / not a member answers the question as well as SUCCESS
+        if (cmd_id == ZIG_GROUPS_CMD_ADD_RESP
+            && (status == ESP_ZB_ZCL_STATUS_SUCCESS || status == ESP_ZB_ZCL_STATUS_DUPE_EXISTS)) {
+            zig_groups_update(group_msg->info.src_address.u.short_addr, group_msg->info.src_endpoint,
+                              group_msg->group_id, true);
+        } else if (cmd_id == ZIG_GROUPS_CMD_REMOVE_RESP
+            && (status == ESP_ZB_ZCL_STATUS_SUCCESS || status == ESP_ZB_ZCL_STATUS_NOT_FOUND)) {
+            zig_groups_update(group_msg->info.src_address.u.short_addr, group_msg->info.src_endpoint,
+                              group_msg->group_id, false);
         }
+
+        // Format: status(1) + command_id(1) + group_id(2)
+        uint8_t data[4] = { status, cmd_id, group_msg->group_id & 0xFF, (group_msg->group_id >> 8) & 0xFF };
+        send_zcl_msg_to_micropython_queue(
+            ZIG_MSG_ZB_APP_SIGNAL_HANDLER,
+            ESP_ZB_CORE_CMD_OPERATE_GROUP_RESP_CB_ID,
+            &group_msg->info,
+            status,
+            data,
+            sizeof(data)
+        );
+        break;
+    }
+
+    case ESP_ZB_CORE_CMD_VIEW_GROUP_RESP_CB_ID: {
+        const esp_zb_zcl_groups_view_group_resp_message_t *view_msg =
+            (esp_zb_zcl_groups_view_group_resp_message_t *)message;
+        uint8_t status = view_msg->info.status;
+
+        if (status == ESP_ZB_ZCL_STATUS_SUCCESS || status == ESP_ZB_ZCL_STATUS_NOT_FOUND) {
+            zig_groups_update(view_msg->info.src_address.u.short_addr, view_msg->info.src_endpoint,
+                              view_msg->group_id, status == ESP_ZB_ZCL_STATUS_SUCCESS);
+        }
+
+        // Format: status(1) + group_id(2) + group name as ZCL string (len(1) + chars), empty if not supported
+        uint8_t data[4 + 16];
+        size_t data_len = 0;
+        data[data_len++] = status;
+        data[data_len++] = view_msg->group_id & 0xFF;
+        data[data_len++] = (view_msg->group_id >> 8) & 0xFF;
+        uint8_t name_len = view_msg->group_name ? view_msg->group_name[0] : 0;
+        name_len = name_len > 16 ? 16 : name_len;
+        data[data_len++] = name_len;
+        if (name_len) {
+            memcpy(&data[data_len], &view_msg->group_name[1], name_len);
+            data_len += name_len;
+        }
+
+        send_zcl_msg_to_micropython_queue(
+            ZIG_MSG_ZB_APP_SIGNAL_HANDLER,
+            ESP_ZB_CORE_CMD_VIEW_GROUP_RESP_CB_ID,
+            &view_msg->info,
+            status,
+            data,
+            data_len
+        );
+        break;
+    }
+
+    case ESP_ZB_CORE_CMD_GET_GROUP_MEMBERSHIP_RESP_CB_ID: {
+        const esp_zb_zcl_groups_get_group_membership_resp_message_t *member_msg =
+            (esp_zb_zcl_groups_get_group_membership_resp_message_t *)message;
+        uint8_t count = member_msg->group_id ? member_msg->group_count : 0;
+
+        if (member_msg->info.status == ESP_ZB_ZCL_STATUS_SUCCESS) {
+            zig_groups_replace(member_msg->info.src_address.u.short_addr, member_msg->info.src_endpoint,
+                               member_msg->group_id, count);
+        }
+
+        // Format: capacity(1) + count(1) + group_id(2) per group
+        uint8_t data[2 + 2 * 32];
+        size_t data_len = 0;
+        data[data_len++] = member_msg->capacity;
+        data[data_len++] = count;
+        for (uint8_t i = 0; i < count && data_len + 2 <= sizeof(data); i++) {
+            data[data_len++] = member_msg->group_id[i] & 0xFF;
+            data[data_len++] = (member_msg->group_id[i] >> 8) & 0xFF;
+        }
+        data[1] = (data_len - 2) / 2;
+
+        send_zcl_msg_to_micropython_queue(
+            ZIG_MSG_ZB_APP_SIGNAL_HANDLER,
+            ESP_ZB_CORE_CMD_GET_GROUP_MEMBERSHIP_RESP_CB_ID,
+            &member_msg->info,
+            member_msg->info.status,
+            data,
+            data_len
+        );
         break;
     }
+
     case ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_REQ_CB_ID: {
         const esp_zb_zcl_custom_cluster_command_message_t *custom_msg = 
             (esp_zb_zcl_custom_cluster_command_message_t *)message;
@@ -998,12 +1123,11 @@ esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const
         }
 
         // Forward all custom cluster responses to Python for processing
-        send_msg_to_micropython_queue(
+        send_zcl_msg_to_micropython_queue(
             ZIG_MSG_ZB_APP_SIGNAL_HANDLER,
             ESP_ZB_CORE_CMD_CUSTOM_CLUSTER_RESP_CB_ID,
-            resp_msg->info.src_address.u.short_addr,
-            resp_msg->info.src_endpoint,
-            resp_msg->info.cluster,
+            &resp_msg->info,
+            resp_msg->info.status,
             (uint8_t *)resp_msg->data.value,
             resp_msg->data.size
         );
@@ -1036,6 +1160,10 @@ bool zb_raw_cmd_handler(uint8_t bufid)
     ESP_LOGI(HANDLERS_TAG, "RAW command handler, bufid: %d", bufid);
     zb_zcl_parsed_hdr_t *cmd_info = ZB_BUF_GET_PARAM(bufid, zb_zcl_parsed_hdr_t);
 
+    // Every ZCL frame a device sends passes here: it is awake right now, send what waits for it.
+    // Events generated locally (interview, retry, binding) carry the address too but prove nothing.
+    zig_mailbox_heard(cmd_info->addr_data.common_data.source.u.short_addr);
+
     // Get raw payload
     uint8_t payload_len = zb_buf_len(bufid);
     uint8_t *payload = zb_buf_begin(bufid);
@@ -1096,32 +1224,3 @@ bool zb_raw_cmd_handler(uint8_t bufid)
     return true;
 }
 
-
-
-// Callback for ZDO binding table response
-void binding_table_cb(const esp_zb_zdo_binding_table_info_t *table_info, void *user_ctx) {
-    uint16_t short_addr = (uint16_t)(uintptr_t)user_ctx;
-    ESP_LOGI(HANDLERS_TAG, "Binding table response for 0x%04x: total=%d, count=%d",
-             short_addr, table_info->total, table_info->count);
-    // Iterate through all records
-    esp_zb_zdo_binding_table_record_t *rec = table_info->record;
-    while (rec) {
-        // Format source and destination addresses
-        char src_str[24];
-        char dst_str[32];
-        zigbee_format_ieee_addr_to_str(rec->src_address, src_str, sizeof(src_str));
-        if (rec->dst_addr_mode == ESP_ZB_ZDO_BIND_DST_ADDR_MODE_64_BIT_EXTENDED) {
-            zigbee_format_ieee_addr_to_str(rec->dst_address.addr_long, dst_str, sizeof(dst_str));
-        } else {
-            snprintf(dst_str, sizeof(dst_str), "short=0x%04x", rec->dst_address.addr_short);
-        }
-        // Build record string
-        char record_str[128];
-        snprintf(record_str, sizeof(record_str),
-            "%s ep=%u cluster=0x%04x -> %s ep=%u",
-            src_str, rec->src_endp, rec->cluster_id, dst_str, rec->dst_endp);
-        ESP_LOGI(HANDLERS_TAG, "Binding record: %s", record_str);
-        rec = rec->next;
-    }
-}
-
@@ -22,10 +22,16 @@ esp_err_t zb_action_handler(esp_zb_core_action_callback_id_t callback_id, const
 // Callback for bind operations
 void bind_cb(esp_zb_zdp_status_t status, void *user_ctx);
 
+// Interview requests, called from the Zigbee task
+void zig_request_active_ep(uint16_t short_addr);
+bool zig_request_simple_desc(uint16_t short_addr, uint8_t endpoint);    // false if the endpoint is unknown
+void zig_request_bind(const zigbee_device_t *device, uint8_t endpoint, uint16_t cluster_id);
+
 void send_msg_to_micropython_queue(uint8_t msg_py, uint16_t signal_type, uint16_t src_addr, uint8_t endpoint, 
                                  uint16_t cluster_id, uint8_t *data, uint8_t data_len);
 
-// Callback for ZDO binding table response, used by Python wrapper
-void binding_table_cb(const esp_zb_zdo_binding_table_info_t *table_info, void *user_ctx);
+// ZCL response: carries the TSN and resolves the request waiting for it
+void send_zcl_msg_to_micropython_queue(uint8_t msg_py, uint16_t signal_type, const esp_zb_zcl_cmd_info_t *info,
+                                       uint8_t status, uint8_t *data, uint8_t data_len);
 
 #endif /* MOD_ZIG_HANDLERS_H */
\ No newline at end of file
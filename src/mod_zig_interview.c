@@ -0,0 +1,735 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Device interview state machine with a global concurrency limit
+//
+// ActiveEP -> Identify -> SimpleDesc[i] -> BasicRead[i] -> Bind[j] -> Report[j],
+// one request in flight per device and at most `limit` devices at once. Devices
+// announcing together wait in a FIFO instead of flooding the coordinator.
+// A device whose record is complete, or whose model has a template, only
+// confirms one Simple Descriptor (Verify) before Bind. A rejoin of a device
+// whose last interview finished with the same descriptors and bindings
+// sends nothing at all, the record is saved once when an interview ends.
+// Everything here runs in the Zigbee task, or in MicroPython under ZB_LOCK.
+#include <string.h>
+
+// ESP-IDF headers
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Zigbee headers
+#include "esp_zigbee_core.h"
+#include "zcl/esp_zigbee_zcl_command.h"
+#include "zcl/esp_zigbee_zcl_basic.h"
+#include "zcl/esp_zigbee_zcl_power_config.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+
+//Project headers
+#include "main.h"
+#include "device_manager.h"
+#include "device_storage.h"
+#include "mod_zig_handlers.h"
+#include "mod_zig_msg.h"
+#include "mod_zig_report.h"
+#include "mod_zig_interview.h"
+#include "mod_zig_binding.h"
+
+#define LOG_TAG "ZIG_INTERVIEW"
+
+// Running interview
+typedef struct {
+    uint16_t short_addr;
+    uint8_t state;                  /* zig_interview_state_t */
+    uint8_t result;                 /* Result of the current step */
+    int item;                       /* Endpoint index or report_cfgs index of the current step, -1 before the first */
+    uint8_t tsns[MAX_REPORT_CFGS];  /* ZCL frames of the current item */
+    uint8_t tsn_count;
+    uint16_t answered;              /* Bit per tsns entry */
+    int64_t started_ms;
+    int64_t step_started_ms;
+    bool verified;                  /* Verify: descriptor matched */
+    bool from_template;             /* Endpoints were copied from another device of the model */
+    bool degraded;                  /* A step timed out or gave items up: the record is not complete */
+    bool in_use;
+} interview_t;
+
+// Waiting device and the step its interview starts from, QUEUED for the usual start
+typedef struct {
+    uint16_t short_addr;
+    uint8_t from;
+} interview_queued_t;
+
+static interview_t interviews[ZIG_INTERVIEW_SLOTS];
+static interview_queued_t interview_queue[ZIG_INTERVIEW_QUEUE];
+static uint8_t queue_head;
+static uint8_t queue_len;
+static uint8_t interview_limit = ZIG_INTERVIEW_CONCURRENT;
+
+static struct {
+    uint32_t done;
+    uint32_t failed;
+    uint32_t dropped;   /* Queue full */
+    uint32_t verified;  /* Full discovery skipped */
+    uint32_t skipped;   /* Rejoins of complete devices: nothing sent, or Bind / Report only */
+} interview_stats;
+
+static void interview_run(int slot);
+static void interview_timeout_cb(uint8_t slot);
+
+
+static int64_t interview_now_ms(void) {
+    return esp_timer_get_time() / 1000;
+}
+
+// FNV-1a, field by field so struct padding stays out of it
+static uint32_t interview_hash(uint32_t h, uint32_t value, uint8_t size) {
+    for (uint8_t i = 0; i < size; i++) {
+        h ^= (value >> (8 * i)) & 0xFF;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t interview_desc_hash(const zigbee_device_t *dev) {
+    uint32_t h = interview_hash(2166136261u, dev->endpoint_count, 1);
+    for (int i = 0; i < dev->endpoint_count; i++) {
+        const zigbee_endpoint_t *ep = &dev->endpoints[i];
+        h = interview_hash(h, ep->endpoint, 1);
+        h = interview_hash(h, ep->profile_id, 2);
+        h = interview_hash(h, ep->device_id, 2);
+        h = interview_hash(h, ep->cluster_count, 1);
+        for (int c = 0; c < ep->cluster_count; c++) {
+            h = interview_hash(h, ep->cluster_list[c], 2);
+        }
+    }
+    return h;
+}
+
+static int interview_next_pair(const zigbee_device_t *dev, int after);
+
+// Pairs Bind would send, with the reporting of each
+static uint32_t interview_bind_hash(const zigbee_device_t *dev) {
+    uint32_t h = 2166136261u;
+    for (int j = interview_next_pair(dev, -1); j >= 0; j = interview_next_pair(dev, j)) {
+        h = interview_hash(h, dev->report_cfgs[j].ep, 1);
+        h = interview_hash(h, dev->report_cfgs[j].cluster_id, 2);
+    }
+    for (int j = 0; j < MAX_REPORT_CFGS; j++) {
+        const report_cfg_t *r = &dev->report_cfgs[j];
+        if (r->in_use && r->direction == REPORT_CFG_DIRECTION_SEND) {
+            h = interview_hash(h, r->attr_id, 2);
+            h = interview_hash(h, r->send_cfg.min_int, 2);
+            h = interview_hash(h, r->send_cfg.max_int, 2);
+            h = interview_hash(h, r->send_cfg.reportable_change_val, 4);
+        }
+    }
+    return h;
+}
+
+static interview_t *interview_find(uint16_t short_addr) {
+    for (int i = 0; i < ZIG_INTERVIEW_SLOTS; i++) {
+        if (interviews[i].in_use && interviews[i].short_addr == short_addr) {
+            return &interviews[i];
+        }
+    }
+    return NULL;
+}
+
+static int interview_active(void) {
+    int active = 0;
+    for (int i = 0; i < ZIG_INTERVIEW_SLOTS; i++) {
+        active += interviews[i].in_use;
+    }
+    return active;
+}
+
+// Step finished: status(1) + step_ms(4) + total_ms(4), little endian
+static void interview_event(const interview_t *iv, uint8_t state, uint8_t result) {
+    int64_t now = interview_now_ms();
+    uint32_t step_ms = (uint32_t)(now - iv->step_started_ms);
+    uint32_t total_ms = (uint32_t)(now - iv->started_ms);
+    uint8_t data[9] = {
+        result,
+        step_ms & 0xFF, (step_ms >> 8) & 0xFF, (step_ms >> 16) & 0xFF, (step_ms >> 24) & 0xFF,
+        total_ms & 0xFF, (total_ms >> 8) & 0xFF, (total_ms >> 16) & 0xFF, (total_ms >> 24) & 0xFF,
+    };
+    ESP_LOGI(LOG_TAG, "0x%04x step %u result %u in %lu ms (total %lu ms)",
+             iv->short_addr, state, result, (unsigned long)step_ms, (unsigned long)total_ms);
+    send_msg_to_micropython_queue(ZIG_MSG_INTERVIEW, state, iv->short_addr, 0, 0, data, sizeof(data));
+}
+
+static void interview_enter(interview_t *iv, zig_interview_state_t state) {
+    iv->state = state;
+    iv->result = ZIG_INTERVIEW_OK;
+    iv->item = -1;
+    iv->step_started_ms = interview_now_ms();
+}
+
+// Complete records only need Verify, everything else starts from Active EP
+static void interview_begin(interview_t *iv, zig_interview_state_t from) {
+    zigbee_device_t *dev = device_manager_get(iv->short_addr);
+    iv->started_ms = interview_now_ms();
+    iv->verified = false;
+    iv->from_template = false;
+    iv->degraded = false;
+    if (from == ZIG_INTERVIEW_QUEUED) {
+        from = dev && zig_fingerprint_record_complete(dev) ? ZIG_INTERVIEW_VERIFY : ZIG_INTERVIEW_ACTIVE_EP;
+    }
+    interview_enter(iv, from);
+}
+
+// Start queued interviews while below the limit
+static void interview_dispatch(void) {
+    while (queue_len > 0 && interview_active() < interview_limit) {
+        interview_queued_t next = interview_queue[queue_head];
+        queue_head = (queue_head + 1) % ZIG_INTERVIEW_QUEUE;
+        queue_len--;
+
+        for (int i = 0; i < ZIG_INTERVIEW_SLOTS; i++) {
+            interview_t *iv = &interviews[i];
+            if (!iv->in_use) {
+                memset(iv, 0, sizeof(*iv));
+                iv->short_addr = next.short_addr;
+                iv->in_use = true;
+                interview_begin(iv, next.from);
+                interview_run(i);
+                break;
+            }
+        }
+    }
+}
+
+static void interview_finish(interview_t *iv, zig_interview_state_t state) {
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)interview_timeout_cb, iv - interviews);
+    iv->step_started_ms = interview_now_ms();
+    bool complete = state == ZIG_INTERVIEW_DONE && !iv->degraded;
+    interview_event(iv, state, complete ? ZIG_INTERVIEW_OK : ZIG_INTERVIEW_PARTIAL);
+    zigbee_device_t *dev = device_manager_get(iv->short_addr);
+    if (state == ZIG_INTERVIEW_DONE) {
+        interview_stats.done++;
+    } else {
+        interview_stats.failed++;
+    }
+    iv->in_use = false;
+    if (dev) {
+        // Steps do not save, everything collected goes out in one write.
+        // A degraded run is kept but not marked complete: the next rejoin interviews again.
+        dev->interview_complete = complete;
+        if (complete) {
+            dev->desc_hash = interview_desc_hash(dev);
+            dev->bind_hash = interview_bind_hash(dev);
+            zig_fingerprint_learn(dev);
+        }
+        device_storage_save((esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr), iv->short_addr);
+    }
+    interview_dispatch();
+}
+
+// Next stored report config that opens a new (ep, cluster) pair of an endpoint the device has
+static int interview_next_pair(const zigbee_device_t *dev, int after) {
+    for (int j = after + 1; j < MAX_REPORT_CFGS; j++) {
+        const report_cfg_t *r = &dev->report_cfgs[j];
+        if (!r->in_use) {
+            continue;
+        }
+        bool seen = false;
+        for (int k = 0; k < j && !seen; k++) {
+            const report_cfg_t *p = &dev->report_cfgs[k];
+            seen = p->in_use && p->ep == r->ep && p->cluster_id == r->cluster_id;
+        }
+        if (seen) {
+            continue;
+        }
+        for (int e = 0; e < dev->endpoint_count; e++) {
+            const zigbee_endpoint_t *ep_rec = &dev->endpoints[e];
+            if (ep_rec->endpoint != r->ep) {
+                continue;
+            }
+            for (int c = 0; c < ep_rec->cluster_count; c++) {
+                if (ep_rec->cluster_list[c] == r->cluster_id) {
+                    return j;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+static uint8_t interview_read(const zigbee_device_t *dev, uint8_t endpoint, uint16_t cluster_id,
+                              uint16_t *attr_field, uint8_t attr_count) {
+    esp_zb_zcl_read_attr_cmd_t read_cmd = {
+        .zcl_basic_cmd = {
+            .dst_addr_u.addr_short = dev->short_addr,
+            .dst_endpoint = endpoint,
+            .src_endpoint = ESP_ZB_GATEWAY_ENDPOINT,
+        },
+        .address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT,
+        .clusterID = cluster_id,
+        .direction = ESP_ZB_ZCL_CMD_DIRECTION_TO_SRV,
+        .attr_number = attr_count,
+        .attr_field = attr_field
+    };
+    return esp_zb_zcl_read_attr_cmd_req(&read_cmd);
+}
+
+// Basic and Power Config reads of one endpoint, false if it has neither cluster
+static bool interview_basic_read(interview_t *iv, const zigbee_device_t *dev, const zigbee_endpoint_t *ep_rec) {
+    bool has_basic = false;
+    bool has_power_config = false;
+    for (int i = 0; i < ep_rec->cluster_count; i++) {
+        if (ep_rec->cluster_list[i] == ESP_ZB_ZCL_CLUSTER_ID_BASIC) {
+            has_basic = true;
+        } else if (ep_rec->cluster_list[i] == ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG) {
+            has_power_config = true;
+        }
+    }
+
+    if (has_basic) {
+        uint16_t attrs[] = {
+            ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID,     // 0x0004
+            ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID,      // 0x0005
+            ESP_ZB_ZCL_ATTR_BASIC_APPLICATION_VERSION_ID,   // 0x0001
+            ESP_ZB_ZCL_ATTR_BASIC_POWER_SOURCE_ID,          // 0x0007
+        };
+        iv->tsns[iv->tsn_count++] = interview_read(dev, ep_rec->endpoint, ESP_ZB_ZCL_CLUSTER_ID_BASIC, attrs, 4);
+    }
+    if (has_power_config) {
+        uint16_t attrs[] = {
+            ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_VOLTAGE_ID,                // 0x0020
+            ESP_ZB_ZCL_ATTR_POWER_CONFIG_BATTERY_PERCENTAGE_REMAINING_ID,   // 0x0021
+        };
+        iv->tsns[iv->tsn_count++] = interview_read(dev, ep_rec->endpoint, ESP_ZB_ZCL_CLUSTER_ID_POWER_CONFIG, attrs, 2);
+    }
+    return iv->tsn_count > 0;
+}
+
+// Send the next item of the current step, false when the step has none left
+static bool interview_issue(interview_t *iv, const zigbee_device_t *dev) {
+    iv->tsn_count = 0;
+    iv->answered = 0;
+
+    switch (iv->state) {
+        case ZIG_INTERVIEW_ACTIVE_EP:
+            if (iv->item >= 0) {
+                return false;
+            }
+            iv->item = 0;
+            zig_request_active_ep(iv->short_addr);
+            return true;
+
+        case ZIG_INTERVIEW_IDENTIFY:
+            if (iv->item >= 0 || dev->endpoint_count == 0) {
+                return false;
+            }
+            iv->item = 0;
+            {
+                uint16_t attrs[] = {
+                    ESP_ZB_ZCL_ATTR_BASIC_MANUFACTURER_NAME_ID,     // 0x0004
+                    ESP_ZB_ZCL_ATTR_BASIC_MODEL_IDENTIFIER_ID,      // 0x0005
+                    ESP_ZB_ZCL_ATTR_BASIC_APPLICATION_VERSION_ID,   // 0x0001
+                    ESP_ZB_ZCL_ATTR_BASIC_POWER_SOURCE_ID,          // 0x0007
+                };
+                iv->tsns[iv->tsn_count++] = interview_read(dev, dev->endpoints[0].endpoint,
+                                                           ESP_ZB_ZCL_CLUSTER_ID_BASIC, attrs, 4);
+            }
+            break;
+
+        case ZIG_INTERVIEW_VERIFY:
+            if (iv->item >= 0 || dev->endpoint_count == 0) {
+                return false;
+            }
+            iv->item = 0;
+            return zig_request_simple_desc(iv->short_addr, dev->endpoints[0].endpoint);
+
+        case ZIG_INTERVIEW_SIMPLE_DESC:
+            while (++iv->item < dev->endpoint_count) {
+                if (zig_request_simple_desc(iv->short_addr, dev->endpoints[iv->item].endpoint)) {
+                    return true;
+                }
+            }
+            return false;
+
+        case ZIG_INTERVIEW_BASIC_READ:
+            while (++iv->item < dev->endpoint_count) {
+                if (interview_basic_read(iv, dev, &dev->endpoints[iv->item])) {
+                    break;
+                }
+            }
+            break;
+
+        case ZIG_INTERVIEW_BIND: {
+            // Pairs the binding mirror shows bound to the gateway are not bound again
+            esp_zb_ieee_addr_t coord_ieee;
+            esp_zb_get_long_address(coord_ieee);
+            while ((iv->item = interview_next_pair(dev, iv->item)) >= 0) {
+                const report_cfg_t *r = &dev->report_cfgs[iv->item];
+                if (!zig_binding_known(dev->ieee_addr, r->ep, r->cluster_id, coord_ieee, ESP_ZB_GATEWAY_ENDPOINT)) {
+                    zig_request_bind(dev, r->ep, r->cluster_id);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        case ZIG_INTERVIEW_REPORT:
+            while ((iv->item = interview_next_pair(dev, iv->item)) >= 0) {
+                const report_cfg_t *r = &dev->report_cfgs[iv->item];
+                iv->tsn_count = zig_report_sync(dev, r->ep, r->cluster_id, iv->tsns);
+                if (iv->tsn_count > 0) {
+                    break;
+                }
+            }
+            break;
+
+        default:
+            return false;
+    }
+
+    // ZCL items: responses are not guaranteed, move on after a while
+    if (iv->tsn_count == 0) {
+        return false;
+    }
+    esp_zb_scheduler_alarm((esp_zb_callback_t)interview_timeout_cb, iv - interviews, ZIG_INTERVIEW_ZCL_TIMEOUT_MS);
+    return true;
+}
+
+static void interview_run(int slot) {
+    interview_t *iv = &interviews[slot];
+    while (iv->in_use) {
+        zigbee_device_t *dev = device_manager_get(iv->short_addr);
+        if (!dev) {
+            ESP_LOGW(LOG_TAG, "Device 0x%04x left during interview", iv->short_addr);
+            interview_finish(iv, ZIG_INTERVIEW_FAILED);
+            return;
+        }
+        if (interview_issue(iv, dev)) {
+            return;
+        }
+
+        // CHANGED only reports a Verify mismatch, discovery then runs in full
+        if (iv->result == ZIG_INTERVIEW_TIMEOUT || iv->result == ZIG_INTERVIEW_PARTIAL) {
+            iv->degraded = true;
+        }
+        interview_event(iv, iv->state, iv->result);
+        switch (iv->state) {
+            case ZIG_INTERVIEW_ACTIVE_EP:
+                interview_enter(iv, ZIG_INTERVIEW_IDENTIFY);
+                break;
+
+            case ZIG_INTERVIEW_IDENTIFY: {
+                // Known model with the same endpoints: borrow its descriptors, then confirm one
+                const zigbee_device_t *tpl = zig_fingerprint_lookup(dev);
+                iv->from_template = tpl && zig_fingerprint_apply_endpoints(dev, tpl);
+                interview_enter(iv, iv->from_template ? ZIG_INTERVIEW_VERIFY : ZIG_INTERVIEW_SIMPLE_DESC);
+                break;
+            }
+
+            case ZIG_INTERVIEW_VERIFY:
+                if (iv->verified) {
+                    interview_stats.verified++;
+                    if (iv->from_template) {
+                        const zigbee_device_t *tpl = zig_fingerprint_lookup(dev);
+                        if (tpl) {
+                            int reports = zig_fingerprint_apply_reports(dev, tpl);
+                            zig_fingerprint_hit(tpl);
+                            ESP_LOGI(LOG_TAG, "0x%04x set up from template %s, %d report configs",
+                                     iv->short_addr, tpl->ieee_addr_str, reports);
+                        }
+                    }
+                    interview_enter(iv, ZIG_INTERVIEW_BIND);
+                } else {
+                    // First endpoint was just refreshed, discovery goes on from the second
+                    interview_enter(iv, ZIG_INTERVIEW_SIMPLE_DESC);
+                    iv->item = 0;
+                }
+                break;
+
+            case ZIG_INTERVIEW_REPORT:
+                interview_finish(iv, ZIG_INTERVIEW_DONE);
+                return;
+
+            default:
+                interview_enter(iv, iv->state + 1);
+                break;
+        }
+    }
+}
+
+// Zigbee task: ZCL item not fully answered in time
+static void interview_timeout_cb(uint8_t slot) {
+    if (slot >= ZIG_INTERVIEW_SLOTS || !interviews[slot].in_use || interviews[slot].tsn_count == 0) {
+        return;
+    }
+    ESP_LOGW(LOG_TAG, "0x%04x step %u: responses timed out", interviews[slot].short_addr, interviews[slot].state);
+    interviews[slot].result = ZIG_INTERVIEW_TIMEOUT;
+    interview_run(slot);
+}
+
+static interview_queued_t *interview_queued(uint16_t short_addr) {
+    for (uint8_t i = 0; i < queue_len; i++) {
+        interview_queued_t *q = &interview_queue[(queue_head + i) % ZIG_INTERVIEW_QUEUE];
+        if (q->short_addr == short_addr) {
+            return q;
+        }
+    }
+    return NULL;
+}
+
+static void interview_queue_add(uint16_t short_addr, zig_interview_state_t from) {
+    interview_t *iv = interview_find(short_addr);
+    if (iv) {
+        // Announced again mid-interview: start over
+        esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)interview_timeout_cb, iv - interviews);
+        interview_begin(iv, from);
+        interview_run(iv - interviews);
+        return;
+    }
+
+    interview_queued_t *q = interview_queued(short_addr);
+    if (q) {
+        // A full interview covers a Bind-only one
+        if (from == ZIG_INTERVIEW_QUEUED) {
+            q->from = from;
+        }
+        return;
+    }
+    if (queue_len >= ZIG_INTERVIEW_QUEUE) {
+        ESP_LOGW(LOG_TAG, "Queue full, interview of 0x%04x dropped", short_addr);
+        interview_stats.dropped++;
+        return;
+    }
+    interview_queue[(queue_head + queue_len) % ZIG_INTERVIEW_QUEUE] = (interview_queued_t){ short_addr, from };
+    queue_len++;
+    ESP_LOGI(LOG_TAG, "Interview of 0x%04x queued, %u waiting", short_addr, queue_len);
+    interview_dispatch();
+}
+
+void zig_interview_start(uint16_t short_addr) {
+    interview_queue_add(short_addr, ZIG_INTERVIEW_QUEUED);
+}
+
+// Python context: read the record of an index-only device, then judge its rejoin
+static mp_obj_t interview_rejoin_detail(mp_obj_t short_addr_obj) {
+    uint16_t short_addr = mp_obj_get_int(short_addr_obj);
+    device_storage_ensure_detail(short_addr);
+    ZB_LOCK();
+    zigbee_device_t *dev = device_manager_get(short_addr);
+    if (dev && dev->detail_pending) {
+        ESP_LOGW(LOG_TAG, "0x%04x rejoined, stored record not readable", short_addr);
+        zig_interview_start(short_addr);
+    } else if (dev) {
+        zig_interview_rejoin(short_addr);
+    }
+    ZB_UNLOCK();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(interview_rejoin_detail_obj, interview_rejoin_detail);
+
+void zig_interview_rejoin(uint16_t short_addr) {
+    zigbee_device_t *dev = device_manager_get(short_addr);
+    if (!dev || !dev->interview_complete || interview_find(short_addr) || interview_queued(short_addr)) {
+        zig_interview_start(short_addr);
+        return;
+    }
+
+    // Index-only record: the hashes to compare are in the detail, read it first
+    if (dev->detail_pending) {
+        if (!mp_sched_schedule(MP_OBJ_FROM_PTR(&interview_rejoin_detail_obj), MP_OBJ_NEW_SMALL_INT(short_addr))) {
+            zig_interview_start(short_addr);
+        }
+        return;
+    }
+
+    if (interview_desc_hash(dev) != dev->desc_hash) {
+        ESP_LOGI(LOG_TAG, "0x%04x rejoined, descriptors changed since the last interview", short_addr);
+        zig_interview_start(short_addr);
+        return;
+    }
+
+    interview_stats.skipped++;
+    if (interview_bind_hash(dev) != dev->bind_hash) {
+        ESP_LOGI(LOG_TAG, "0x%04x rejoined, bindings changed since the last interview", short_addr);
+        interview_queue_add(short_addr, ZIG_INTERVIEW_BIND);
+        return;
+    }
+
+    // Nothing to send: report the interview as done right away
+    interview_t done = { .short_addr = short_addr };
+    done.started_ms = done.step_started_ms = interview_now_ms();
+    ESP_LOGI(LOG_TAG, "0x%04x rejoined, interview skipped", short_addr);
+    interview_event(&done, ZIG_INTERVIEW_DONE, ZIG_INTERVIEW_OK);
+}
+
+bool zig_interview_pending(uint16_t short_addr) {
+    return interview_find(short_addr) || interview_queued(short_addr);
+}
+
+bool zig_interview_advance(uint16_t short_addr, zig_interview_state_t step, uint8_t endpoint, uint16_t cluster_id) {
+    interview_t *iv = interview_find(short_addr);
+    if (!iv || iv->state != step) {
+        return false;
+    }
+    zigbee_device_t *dev = device_manager_get(short_addr);
+    if (dev && iv->item >= 0) {
+        if (step == ZIG_INTERVIEW_SIMPLE_DESC &&
+            (iv->item >= dev->endpoint_count || dev->endpoints[iv->item].endpoint != endpoint)) {
+            return false;
+        }
+        if (step == ZIG_INTERVIEW_BIND &&
+            (dev->report_cfgs[iv->item].ep != endpoint || dev->report_cfgs[iv->item].cluster_id != cluster_id)) {
+            return false;
+        }
+    }
+    interview_run(iv - interviews);
+    return true;
+}
+
+void zig_interview_descriptor(uint16_t short_addr, uint8_t endpoint, bool changed) {
+    interview_t *iv = interview_find(short_addr);
+    if (!iv) {
+        return;
+    }
+    if (iv->state == ZIG_INTERVIEW_VERIFY) {
+        zigbee_device_t *dev = device_manager_get(short_addr);
+        if (!dev || dev->endpoint_count == 0 || dev->endpoints[0].endpoint != endpoint) {
+            return;
+        }
+        iv->verified = !changed;
+        iv->result = changed ? ZIG_INTERVIEW_CHANGED : ZIG_INTERVIEW_OK;
+        interview_run(iv - interviews);
+        return;
+    }
+    zig_interview_advance(short_addr, ZIG_INTERVIEW_SIMPLE_DESC, endpoint, 0);
+}
+
+void zig_interview_zcl_resp(uint16_t short_addr, uint8_t tsn) {
+    interview_t *iv = interview_find(short_addr);
+    if (!iv || iv->tsn_count == 0) {
+        return;
+    }
+    uint16_t all = (1u << iv->tsn_count) - 1;
+    for (uint8_t i = 0; i < iv->tsn_count; i++) {
+        if (iv->tsns[i] == tsn) {
+            iv->answered |= 1u << i;
+        }
+    }
+    if ((iv->answered & all) == all) {
+        esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)interview_timeout_cb, iv - interviews);
+        interview_run(iv - interviews);
+    }
+}
+
+void zig_interview_step_failed(zig_retry_step_t step, uint16_t short_addr, uint8_t endpoint, uint16_t cluster_id) {
+    interview_t *iv = interview_find(short_addr);
+    if (!iv) {
+        return;
+    }
+    if ((step == ZIG_RETRY_ACTIVE_EP && iv->state == ZIG_INTERVIEW_ACTIVE_EP) ||
+        (step == ZIG_RETRY_SIMPLE_DESC && iv->state == ZIG_INTERVIEW_VERIFY)) {
+        interview_finish(iv, ZIG_INTERVIEW_FAILED);
+        return;
+    }
+    zig_interview_state_t state = step == ZIG_RETRY_SIMPLE_DESC ? ZIG_INTERVIEW_SIMPLE_DESC : ZIG_INTERVIEW_BIND;
+    if (iv->state == state) {
+        iv->result = ZIG_INTERVIEW_PARTIAL;
+        zig_interview_advance(short_addr, state, endpoint, cluster_id);
+    }
+}
+
+
+// interview(addr)
+// Queue an interview of a known device
+static mp_obj_t esp32_zig_interview(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr, MP_ARG_REQUIRED | MP_ARG_INT },
+    };
+
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    if (!self->config->network_formed) {
+        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
+    }
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uint16_t short_addr = args[ARG_addr].u_int;
+    ZB_LOCK();
+    bool known = device_manager_get(short_addr) != NULL;
+    if (known) {
+        zig_interview_start(short_addr);
+    }
+    ZB_UNLOCK();
+
+    if (!known) {
+        mp_raise_ValueError("Unknown device");
+    }
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_interview_obj, 1, esp32_zig_interview);
+
+
+// interviews(limit=None)
+// Running (addr, step, elapsed_ms), queued addresses and counters; limit sets the concurrency
+static mp_obj_t esp32_zig_interviews(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_limit };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_limit, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_limit].u_obj != mp_const_none) {
+        mp_int_t limit = mp_obj_get_int(args[ARG_limit].u_obj);
+        if (limit < 1 || limit > ZIG_INTERVIEW_SLOTS) {
+            mp_raise_msg_varg(&mp_type_ValueError, MP_ERROR_TEXT("limit must be 1-%d"), ZIG_INTERVIEW_SLOTS);
+        }
+        ZB_LOCK();
+        interview_limit = limit;
+        interview_dispatch();
+        ZB_UNLOCK();
+    }
+
+    // Copy under the lock, build objects without it
+    interview_t running[ZIG_INTERVIEW_SLOTS];
+    uint16_t queued[ZIG_INTERVIEW_QUEUE];
+    ZB_LOCK();
+    memcpy(running, interviews, sizeof(running));
+    uint8_t count = queue_len;
+    for (uint8_t i = 0; i < count; i++) {
+        queued[i] = interview_queue[(queue_head + i) % ZIG_INTERVIEW_QUEUE].short_addr;
+    }
+    ZB_UNLOCK();
+
+    int64_t now = interview_now_ms();
+    mp_obj_t active = mp_obj_new_list(0, NULL);
+    for (int i = 0; i < ZIG_INTERVIEW_SLOTS; i++) {
+        if (!running[i].in_use) {
+            continue;
+        }
+        mp_obj_t item[3] = {
+            MP_OBJ_NEW_SMALL_INT(running[i].short_addr),
+            MP_OBJ_NEW_SMALL_INT(running[i].state),
+            mp_obj_new_int_from_uint((uint32_t)(now - running[i].started_ms)),
+        };
+        mp_obj_list_append(active, mp_obj_new_tuple(3, item));
+    }
+    mp_obj_t waiting = mp_obj_new_list(0, NULL);
+    for (uint8_t i = 0; i < count; i++) {
+        mp_obj_list_append(waiting, MP_OBJ_NEW_SMALL_INT(queued[i]));
+    }
+
+    mp_obj_t dict = mp_obj_new_dict(8);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_active), active);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_queued), waiting);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_limit), MP_OBJ_NEW_SMALL_INT(interview_limit));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_done), mp_obj_new_int_from_uint(interview_stats.done));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_failed), mp_obj_new_int_from_uint(interview_stats.failed));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_dropped), mp_obj_new_int_from_uint(interview_stats.dropped));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_verified), mp_obj_new_int_from_uint(interview_stats.verified));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_skipped), mp_obj_new_int_from_uint(interview_stats.skipped));
+    return dict;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_interviews_obj, 1, esp32_zig_interviews);
@@ -0,0 +1,108 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Device interview state machine with a global concurrency limit
+#ifndef MOD_ZIG_INTERVIEW_H
+#define MOD_ZIG_INTERVIEW_H
+
+#include "py/obj.h"
+#include "mod_zig_types.h"
+#include "mod_zig_retry.h"
+#include "mod_zig_fingerprint.h"
+
+#define ZIG_INTERVIEW_SLOTS         8       /* Highest concurrency limit */
+#define ZIG_INTERVIEW_CONCURRENT    2       /* Interviews running at once by default */
+#define ZIG_INTERVIEW_QUEUE         32      /* Devices waiting for an interview slot */
+#define ZIG_INTERVIEW_ZCL_TIMEOUT_MS 5000   /* Wait for the responses of one ZCL step item */
+
+// Interview steps, also the signal_type of ZIG_MSG_INTERVIEW
+typedef enum {
+    ZIG_INTERVIEW_QUEUED      = 0,  /* Waiting for a slot */
+    ZIG_INTERVIEW_ACTIVE_EP   = 1,  /* Active_EP_req */
+    ZIG_INTERVIEW_IDENTIFY    = 2,  /* Basic manufacturer / model / version read on the first endpoint */
+    ZIG_INTERVIEW_VERIFY      = 3,  /* One Simple_Desc_req checked against the stored or template record */
+    ZIG_INTERVIEW_SIMPLE_DESC = 4,  /* Simple_Desc_req, one endpoint at a time */
+    ZIG_INTERVIEW_BASIC_READ  = 5,  /* Basic / Power Config reads, one endpoint at a time */
+    ZIG_INTERVIEW_BIND        = 6,  /* Bind_req of every cluster with stored report configs */
+    ZIG_INTERVIEW_REPORT      = 7,  /* Configure Reporting of the bound clusters */
+    ZIG_INTERVIEW_DONE        = 8,  /* Finished */
+    ZIG_INTERVIEW_FAILED      = 9,  /* Abandoned, Active EP or Verify never answered or device left */
+} zig_interview_state_t;
+
+// Step result in ZIG_MSG_INTERVIEW
+#define ZIG_INTERVIEW_OK        0   /* Every item answered */
+#define ZIG_INTERVIEW_TIMEOUT   1   /* Some ZCL responses never came, step moved on */
+#define ZIG_INTERVIEW_PARTIAL   2   /* Some items were given up after retries */
+#define ZIG_INTERVIEW_CHANGED   3   /* Verify: descriptor differs, full discovery follows */
+
+/**
+ * @brief Queue an interview, or restart the running one of this device
+ *
+ * Called from the Zigbee task, or from MicroPython with ZB_LOCK held.
+ *
+ * @param short_addr Device address
+ */
+void zig_interview_start(uint16_t short_addr);
+
+/**
+ * @brief Device announced or rejoined: interview only what changed
+ *
+ * A device whose last interview finished with the descriptors it still has
+ * sends nothing; if its report configs changed since, only Bind and Report
+ * run. Anything else gets a full interview. An index-only device has its
+ * record read in Python context first. Called from the Zigbee task.
+ *
+ * @param short_addr Device address, already updated by device_manager_add
+ */
+void zig_interview_rejoin(uint16_t short_addr);
+
+/**
+ * @brief Interview of the device is running or waiting for a slot
+ *
+ * Steps leave saving to the end of the interview.
+ */
+bool zig_interview_pending(uint16_t short_addr);
+
+/**
+ * @brief ZDO step item answered, continue the interview
+ *
+ * Called from the Zigbee task.
+ *
+ * @param short_addr Device address
+ * @param step Step the answer belongs to
+ * @param endpoint Endpoint of a Simple Descriptor or Bind answer
+ * @param cluster_id Cluster of a Bind answer
+ * @return true if an interview was waiting for it
+ */
+bool zig_interview_advance(uint16_t short_addr, zig_interview_state_t step, uint8_t endpoint, uint16_t cluster_id);
+
+/**
+ * @brief Simple Descriptor answered, continue the interview
+ *
+ * Called from the Zigbee task once the descriptor is stored. Verify goes
+ * straight to Bind when nothing changed.
+ *
+ * @param short_addr Device address
+ * @param endpoint Endpoint of the descriptor
+ * @param changed Descriptor differs from the stored one
+ */
+void zig_interview_descriptor(uint16_t short_addr, uint8_t endpoint, bool changed);
+
+/**
+ * @brief ZCL response arrived, continue the interview once its step item is answered
+ *
+ * Called from the Zigbee task for Read Attributes and Configure Reporting responses.
+ */
+void zig_interview_zcl_resp(uint16_t short_addr, uint8_t tsn);
+
+/**
+ * @brief Retry engine gave up on a step
+ *
+ * Active EP fails the interview; a Simple Descriptor or Bind item is skipped.
+ * Called from the Zigbee task.
+ */
+void zig_interview_step_failed(zig_retry_step_t step, uint16_t short_addr, uint8_t endpoint, uint16_t cluster_id);
+
+// Python API function objects
+extern const mp_obj_fun_builtin_var_t esp32_zig_interview_obj;       // Queue an interview of a known device
+extern const mp_obj_fun_builtin_var_t esp32_zig_interviews_obj;      // Running / queued interviews, concurrency limit
+
+#endif // MOD_ZIG_INTERVIEW_H
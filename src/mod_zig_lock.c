@@ -0,0 +1,235 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Zigbee stack lock wrapper: nesting, batching and contention statistics
+#include <string.h>
+
+// FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ESP-IDF headers
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+
+// Zigbee headers
+#include "esp_zigbee_core.h"
+
+//Project headers
+#include "main.h"
+#include "mod_zig_lock.h"
+
+#define LOG_TAG "ZIG_LOCK"
+
+// Owner and depth are only written by the task holding esp_zb_lock,
+// another task can never see its own handle there.
+static TaskHandle_t lock_owner = NULL;
+static uint32_t lock_depth = 0;
+static int64_t lock_taken_us = 0;
+static zig_lock_stats_t lock_stats = {0};
+static portMUX_TYPE lock_stats_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void zig_lock_acquire(void) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    if (lock_owner == task) {
+        lock_depth++;
+        taskENTER_CRITICAL(&lock_stats_mux);
+        lock_stats.nested++;
+        taskEXIT_CRITICAL(&lock_stats_mux);
+        return;
+    }
+
+    // Try first so a wait on the Zigbee task shows up as contention
+    int64_t start_us = esp_timer_get_time();
+    bool contended = !esp_zb_lock_acquire(0);
+    if (contended) {
+        esp_zb_lock_acquire(portMAX_DELAY);
+    }
+
+    lock_owner = task;
+    lock_depth = 1;
+    lock_taken_us = esp_timer_get_time();
+    uint32_t wait_us = (uint32_t)(lock_taken_us - start_us);
+    taskENTER_CRITICAL(&lock_stats_mux);
+    lock_stats.acquired++;
+    if (contended) {
+        lock_stats.contended++;
+        lock_stats.wait_us_total += wait_us;
+        if (wait_us > lock_stats.wait_us_max) {
+            lock_stats.wait_us_max = wait_us;
+        }
+    }
+    taskEXIT_CRITICAL(&lock_stats_mux);
+}
+
+void zig_lock_release(void) {
+    if (lock_depth == 0) {
+        ESP_LOGE(LOG_TAG, "Release without acquire");
+        return;
+    }
+    if (--lock_depth > 0) {
+        return;
+    }
+
+    uint32_t hold_us = (uint32_t)(esp_timer_get_time() - lock_taken_us);
+    taskENTER_CRITICAL(&lock_stats_mux);
+    lock_stats.hold_us_total += hold_us;
+    if (hold_us > lock_stats.hold_us_max) {
+        lock_stats.hold_us_max = hold_us;
+    }
+    taskEXIT_CRITICAL(&lock_stats_mux);
+    lock_owner = NULL;
+    esp_zb_lock_release();
+}
+
+
+// Commands batch() runs: native frame senders only. No Python code runs under the
+// lock, so the Zigbee task waits for frame building, not for the application.
+static const uint16_t batch_commands[] = {
+    MP_QSTR_send_command, MP_QSTR_read_attr, MP_QSTR_write_attr, MP_QSTR_configure_report,
+    MP_QSTR_bind_cluster, MP_QSTR_unbind_cluster,
+    MP_QSTR_on_off, MP_QSTR_level, MP_QSTR_color_xy, MP_QSTR_color_temp, MP_QSTR_cover,
+    MP_QSTR_add_group, MP_QSTR_remove_group, MP_QSTR_view_group,
+};
+
+static bool batch_command(mp_obj_t name) {
+    if (!mp_obj_is_str(name)) {
+        return false;
+    }
+    qstr q = mp_obj_str_get_qstr(name);
+    for (size_t i = 0; i < MP_ARRAY_SIZE(batch_commands); i++) {
+        if (batch_commands[i] == q) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// batch(calls) - run [("command", args), ("command", args, kwargs), ...] under one lock acquisition
+// Commands are named, see batch_commands. Returns list of the call results (TSNs).
+// All entries are checked before the first one runs, an exception stops the batch.
+static mp_obj_t esp32_zig_batch(mp_obj_t self_in, mp_obj_t calls_in) {
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    // Check if network is formed
+    if (!self->config->network_formed) {
+        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
+        return mp_const_none;
+    }
+
+    size_t n_calls;
+    mp_obj_t *calls;
+    mp_obj_get_array(calls_in, &n_calls, &calls);
+
+    for (size_t i = 0; i < n_calls; i++) {
+        size_t len;
+        mp_obj_t *call;
+        mp_obj_get_array(calls[i], &len, &call);
+        if (len != 2 && len != 3) {
+            mp_raise_ValueError(MP_ERROR_TEXT("batch items must be (command, args[, kwargs])"));
+        }
+        if (!batch_command(call[0])) {
+            mp_raise_ValueError(MP_ERROR_TEXT("batch command must name a ZIG send method"));
+        }
+        size_t n_args;
+        mp_obj_t *args;
+        mp_obj_get_array(call[1], &n_args, &args);
+        size_t n_kw = 0;
+        if (len == 3 && call[2] != mp_const_none) {
+            if (!mp_obj_is_type(call[2], &mp_type_dict)) {
+                mp_raise_TypeError(MP_ERROR_TEXT("kwargs must be a dict"));
+            }
+            n_kw = mp_obj_dict_len(call[2]);
+        }
+        if (n_args + 2 * n_kw > ZIG_BATCH_ARGS_MAX) {
+            mp_raise_ValueError(MP_ERROR_TEXT("too many arguments in batch item"));
+        }
+    }
+
+    mp_obj_list_t *results = MP_OBJ_TO_PTR(mp_obj_new_list(n_calls, NULL));
+    // Method and self, then the arguments
+    mp_obj_t call_args[2 + ZIG_BATCH_ARGS_MAX];
+
+    nlr_buf_t nlr;
+    ZB_LOCK();
+    // A command that raises between its own ZB_LOCK and ZB_UNLOCK leaves depth behind
+    uint32_t depth = lock_depth;
+    if (nlr_push(&nlr) == 0) {
+        for (size_t i = 0; i < n_calls; i++) {
+            size_t len;
+            mp_obj_t *call;
+            mp_obj_get_array(calls[i], &len, &call);
+
+            size_t n_args;
+            mp_obj_t *args;
+            mp_obj_get_array(call[1], &n_args, &args);
+            mp_load_method(self_in, mp_obj_str_get_qstr(call[0]), call_args);
+            memcpy(call_args + 2, args, n_args * sizeof(mp_obj_t));
+
+            size_t n_kw = 0;
+            if (len == 3 && call[2] != mp_const_none) {
+                mp_map_t *kw = mp_obj_dict_get_map(call[2]);
+                for (size_t j = 0; j < kw->alloc; j++) {
+                    if (mp_map_slot_is_filled(kw, j)) {
+                        call_args[2 + n_args + 2 * n_kw] = MP_OBJ_NEW_QSTR(mp_obj_str_get_qstr(kw->table[j].key));
+                        call_args[2 + n_args + 2 * n_kw + 1] = kw->table[j].value;
+                        n_kw++;
+                    }
+                }
+            }
+
+            results->items[i] = mp_call_method_n_kw(n_args, n_kw, call_args);
+        }
+        nlr_pop();
+        taskENTER_CRITICAL(&lock_stats_mux);
+        lock_stats.batches++;
+        lock_stats.batch_calls += n_calls;
+        taskEXIT_CRITICAL(&lock_stats_mux);
+        ZB_UNLOCK();
+    } else {
+        while (lock_depth > depth) {
+            ZB_UNLOCK();
+        }
+        ZB_UNLOCK();
+        nlr_jump(nlr.ret_val);
+    }
+
+    return MP_OBJ_FROM_PTR(results);
+}
+MP_DEFINE_CONST_FUN_OBJ_2(esp32_zig_batch_obj, esp32_zig_batch);
+
+
+// lock_stats(reset=False) - stack lock use from MicroPython side
+static mp_obj_t esp32_zig_lock_stats(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_reset };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_reset, MP_ARG_BOOL, {.u_bool = false} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    taskENTER_CRITICAL(&lock_stats_mux);
+    zig_lock_stats_t stats = lock_stats;
+    if (args[ARG_reset].u_bool) {
+        memset(&lock_stats, 0, sizeof(lock_stats));
+    }
+    taskEXIT_CRITICAL(&lock_stats_mux);
+
+    mp_obj_t dict = mp_obj_new_dict(9);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_acquired), mp_obj_new_int_from_uint(stats.acquired));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_nested), mp_obj_new_int_from_uint(stats.nested));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_contended), mp_obj_new_int_from_uint(stats.contended));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_wait_us_avg),
+                      mp_obj_new_int_from_uint(stats.contended ? (uint32_t)(stats.wait_us_total / stats.contended) : 0));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_wait_us_max), mp_obj_new_int_from_uint(stats.wait_us_max));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_hold_us_avg),
+                      mp_obj_new_int_from_uint(stats.acquired ? (uint32_t)(stats.hold_us_total / stats.acquired) : 0));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_hold_us_max), mp_obj_new_int_from_uint(stats.hold_us_max));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_batches), mp_obj_new_int_from_uint(stats.batches));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_batch_calls), mp_obj_new_int_from_uint(stats.batch_calls));
+    return dict;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_lock_stats_obj, 1, esp32_zig_lock_stats);
@@ -0,0 +1,41 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Zigbee stack lock wrapper: nesting, batching and contention statistics
+#ifndef MOD_ZIG_LOCK_H
+#define MOD_ZIG_LOCK_H
+
+#include <stdint.h>
+#include "py/obj.h"
+
+#define ZIG_BATCH_ARGS_MAX  16      /* Positional args + 2 x keyword args per batched call */
+
+/**
+ * @brief Take the Zigbee stack lock
+ *
+ * Only the outermost call of a task takes esp_zb_lock, nested calls
+ * (a send inside zig.batch()) just count depth.
+ */
+void zig_lock_acquire(void);
+
+/**
+ * @brief Release the Zigbee stack lock taken by zig_lock_acquire()
+ */
+void zig_lock_release(void);
+
+// Lock statistics, MicroPython side only
+typedef struct {
+    uint32_t acquired;          // Outermost acquisitions
+    uint32_t nested;            // Nested acquisitions served without touching esp_zb_lock
+    uint32_t contended;         // Acquisitions that had to wait for the Zigbee task
+    uint64_t wait_us_total;     // Time spent waiting on contended acquisitions
+    uint32_t wait_us_max;
+    uint64_t hold_us_total;     // Time the lock was held
+    uint32_t hold_us_max;
+    uint32_t batches;           // zig.batch() calls
+    uint32_t batch_calls;       // Commands sent through zig.batch()
+} zig_lock_stats_t;
+
+// Python API function objects
+extern const mp_obj_fun_builtin_fixed_t esp32_zig_batch_obj;              // Run several commands under one lock
+extern const mp_obj_fun_builtin_var_t   esp32_zig_lock_stats_obj;         // Lock hold / contention statistics
+
+#endif // MOD_ZIG_LOCK_H
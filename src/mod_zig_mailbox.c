@@ -0,0 +1,313 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Outbound mailbox for sleepy end devices: commands wait until the device is heard from
+#include <string.h>
+
+// FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ESP-IDF headers
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "py/mpstate.h"
+
+//Project headers
+#include "main.h"
+#include "device_manager.h"
+#include "mod_zig_mailbox.h"
+#include "mod_zig_request.h"
+
+#define LOG_TAG "ZIG_MAILBOX"
+
+#define POWER_SOURCE_BATTERY 0x03
+
+// Held commands: dict short_addr -> list of entries, highest priority first
+MP_REGISTER_ROOT_POINTER(mp_obj_t zig_mailbox);
+
+// Entry tuple layout
+enum { ENTRY_PRIORITY, ENTRY_EXPIRES, ENTRY_SEND, ENTRY_ARGS, ENTRY_N_ARGS, ENTRY_LEN };
+
+// Addresses with held commands, checked by the Zigbee task
+typedef struct {
+    uint16_t short_addr;
+    bool in_use;
+    bool flush_scheduled;
+} mailbox_addr_t;
+
+static mailbox_addr_t mailbox_addrs[ZIG_MAILBOX_DEVICES];
+static portMUX_TYPE mailbox_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static struct {
+    uint32_t direct;    // Sent at once, device awake
+    uint32_t held;      // Put in a mailbox
+    uint32_t flushed;   // Sent after the device was heard from
+    uint32_t expired;   // Dropped after their TTL
+    uint32_t failed;    // Raised when sent from the mailbox
+} mailbox_stats;
+
+
+static uint32_t mailbox_now_s(void) {
+    return esp_timer_get_time() / 1000000;
+}
+
+static bool mailbox_addr_add(uint16_t short_addr) {
+    bool added = false;
+    taskENTER_CRITICAL(&mailbox_lock);
+    for (int i = 0; i < ZIG_MAILBOX_DEVICES; i++) {
+        if (!mailbox_addrs[i].in_use) {
+            mailbox_addrs[i].short_addr = short_addr;
+            mailbox_addrs[i].flush_scheduled = false;
+            mailbox_addrs[i].in_use = true;
+            added = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&mailbox_lock);
+    return added;
+}
+
+static void mailbox_addr_release(uint16_t short_addr) {
+    taskENTER_CRITICAL(&mailbox_lock);
+    for (int i = 0; i < ZIG_MAILBOX_DEVICES; i++) {
+        if (mailbox_addrs[i].in_use && mailbox_addrs[i].short_addr == short_addr) {
+            mailbox_addrs[i].in_use = false;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&mailbox_lock);
+}
+
+static mp_obj_t mailbox_get(void) {
+    if (MP_STATE_PORT(zig_mailbox) == MP_OBJ_NULL) {
+        MP_STATE_PORT(zig_mailbox) = mp_obj_new_dict(0);
+    }
+    return MP_STATE_PORT(zig_mailbox);
+}
+
+// Drop expired entries, returns number dropped
+static size_t mailbox_prune(mp_obj_t entries, uint32_t now_s) {
+    mp_obj_list_t *list = MP_OBJ_TO_PTR(entries);
+    size_t kept = 0;
+    for (size_t i = 0; i < list->len; i++) {
+        mp_obj_tuple_t *entry = MP_OBJ_TO_PTR(list->items[i]);
+        if ((uint32_t)MP_OBJ_SMALL_INT_VALUE(entry->items[ENTRY_EXPIRES]) >= now_s) {
+            list->items[kept++] = list->items[i];
+        }
+    }
+    size_t dropped = list->len - kept;
+    for (size_t i = kept; i < list->len; i++) {
+        list->items[i] = MP_OBJ_NULL;
+    }
+    list->len = kept;
+    mailbox_stats.expired += dropped;
+    return dropped;
+}
+
+// Scheduled from zig_mailbox_heard(): send held commands. Each send takes the stack lock
+// itself, the application callables run without it.
+static mp_obj_t mailbox_flush(mp_obj_t addr_in) {
+    uint16_t short_addr = mp_obj_get_int(addr_in);
+    mailbox_addr_release(short_addr);
+
+    mp_obj_t mailbox = mailbox_get();
+    mp_map_elem_t *elem = mp_map_lookup(mp_obj_dict_get_map(mailbox), addr_in, MP_MAP_LOOKUP);
+    if (!elem) {
+        return mp_const_none;
+    }
+    mp_obj_t entries = elem->value;
+    mp_obj_dict_delete(mailbox, addr_in);
+
+    mailbox_prune(entries, mailbox_now_s());
+    size_t n_entries;
+    mp_obj_t *items;
+    mp_obj_get_array(entries, &n_entries, &items);
+    if (n_entries == 0) {
+        return mp_const_none;
+    }
+
+    ESP_LOGI(LOG_TAG, "Device 0x%04x heard, sending %u held command(s)", short_addr, (unsigned)n_entries);
+    for (size_t i = 0; i < n_entries; i++) {
+        mp_obj_tuple_t *entry = MP_OBJ_TO_PTR(items[i]);
+        mp_obj_tuple_t *call_args = MP_OBJ_TO_PTR(entry->items[ENTRY_ARGS]);
+        size_t n_args = MP_OBJ_SMALL_INT_VALUE(entry->items[ENTRY_N_ARGS]);
+        size_t n_kw = (call_args->len - n_args) / 2;
+
+        // One failing command must not hold back the rest
+        nlr_buf_t nlr;
+        if (nlr_push(&nlr) == 0) {
+            mp_call_function_n_kw(entry->items[ENTRY_SEND], n_args, n_kw, call_args->items);
+            nlr_pop();
+            mailbox_stats.flushed++;
+        } else {
+            mailbox_stats.failed++;
+            ESP_LOGW(LOG_TAG, "Held command to 0x%04x failed", short_addr);
+            mp_obj_print_exception(&mp_plat_print, MP_OBJ_FROM_PTR(nlr.ret_val));
+        }
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(mailbox_flush_obj, mailbox_flush);
+
+void zig_mailbox_heard(uint16_t short_addr) {
+    mailbox_addr_t *slot = NULL;
+
+    taskENTER_CRITICAL(&mailbox_lock);
+    for (int i = 0; i < ZIG_MAILBOX_DEVICES; i++) {
+        if (mailbox_addrs[i].in_use && mailbox_addrs[i].short_addr == short_addr &&
+            !mailbox_addrs[i].flush_scheduled) {
+            mailbox_addrs[i].flush_scheduled = true;
+            slot = &mailbox_addrs[i];
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&mailbox_lock);
+
+    if (slot && !mp_sched_schedule(MP_OBJ_FROM_PTR(&mailbox_flush_obj), MP_OBJ_NEW_SMALL_INT(short_addr))) {
+        // Scheduler queue full, the next message from the device tries again
+        taskENTER_CRITICAL(&mailbox_lock);
+        slot->flush_scheduled = false;
+        taskEXIT_CRITICAL(&mailbox_lock);
+    }
+}
+
+bool zig_mailbox_is_sleepy(const zigbee_device_t *device) {
+    if (!device) {
+        return false;
+    }
+    if (device->rx_off_when_idle) {
+        return true;
+    }
+    // Basic cluster power source, bit 7 flags a secondary source
+    return (device->power_source & 0x7F) == POWER_SOURCE_BATTERY;
+}
+
+
+// post(send, *args, ttl=600, priority=0, **kwargs)
+// Awake devices: calls send(*args, **kwargs) now and returns its result.
+// Sleepy devices: holds the call until the device is heard from and returns None.
+static mp_obj_t esp32_zig_post(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    mp_arg_check_num(n_args, kw_args->used, 2, MP_OBJ_FUN_ARGS_MAX, true);
+
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+
+    // Check if network is formed
+    if (!self->config->network_formed) {
+        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
+        return mp_const_none;
+    }
+
+    static const qstr own[] = { MP_QSTR_ttl, MP_QSTR_priority };
+    mp_obj_t own_values[MP_ARRAY_SIZE(own)] = { MP_OBJ_NULL, MP_OBJ_NULL };
+    size_t send_n_args = n_args - 2;
+    size_t send_n_kw;
+    uint16_t short_addr;
+    mp_obj_t call_args = zig_call_pack(send_n_args, pos_args + 2, kw_args, own, MP_ARRAY_SIZE(own),
+                                       own_values, &send_n_kw, &short_addr);
+
+    if (!zig_mailbox_is_sleepy(device_manager_get(short_addr))) {
+        mailbox_stats.direct++;
+        mp_obj_tuple_t *args = MP_OBJ_TO_PTR(call_args);
+        return mp_call_function_n_kw(pos_args[1], send_n_args, send_n_kw, args->items);
+    }
+
+    mp_int_t ttl_s = own_values[0] != MP_OBJ_NULL ? mp_obj_get_int(own_values[0]) : ZIG_MAILBOX_TTL_S;
+    mp_int_t priority = own_values[1] != MP_OBJ_NULL ? mp_obj_get_int(own_values[1]) : 0;
+    if (ttl_s <= 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("ttl must be positive"));
+    }
+
+    mp_obj_t mailbox = mailbox_get();
+    mp_obj_t key = MP_OBJ_NEW_SMALL_INT(short_addr);
+    mp_map_elem_t *elem = mp_map_lookup(mp_obj_dict_get_map(mailbox), key, MP_MAP_LOOKUP);
+    mp_obj_t entries;
+    if (elem) {
+        entries = elem->value;
+    } else {
+        if (!mailbox_addr_add(short_addr)) {
+            mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Too many devices with held commands"));
+        }
+        entries = mp_obj_new_list(0, NULL);
+        mp_obj_dict_store(mailbox, key, entries);
+    }
+
+    uint32_t now_s = mailbox_now_s();
+    mailbox_prune(entries, now_s);
+    mp_obj_list_t *list = MP_OBJ_TO_PTR(entries);
+    if (list->len >= ZIG_MAILBOX_DEPTH) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Mailbox full"));
+    }
+
+    mp_obj_t entry_items[ENTRY_LEN] = {
+        [ENTRY_PRIORITY] = MP_OBJ_NEW_SMALL_INT(priority),
+        [ENTRY_EXPIRES]  = MP_OBJ_NEW_SMALL_INT(now_s + ttl_s),
+        [ENTRY_SEND]     = pos_args[1],
+        [ENTRY_ARGS]     = call_args,
+        [ENTRY_N_ARGS]   = MP_OBJ_NEW_SMALL_INT(send_n_args),
+    };
+    mp_obj_t entry = mp_obj_new_tuple(ENTRY_LEN, entry_items);
+
+    // Keep highest priority first, same priority in posting order
+    size_t pos = list->len;
+    while (pos > 0) {
+        mp_obj_tuple_t *prev = MP_OBJ_TO_PTR(list->items[pos - 1]);
+        if (MP_OBJ_SMALL_INT_VALUE(prev->items[ENTRY_PRIORITY]) >= priority) {
+            break;
+        }
+        pos--;
+    }
+    mp_obj_list_append(entries, entry);
+    memmove(&list->items[pos + 1], &list->items[pos], (list->len - 1 - pos) * sizeof(mp_obj_t));
+    list->items[pos] = entry;
+
+    mailbox_stats.held++;
+    ESP_LOGI(LOG_TAG, "Holding command for sleepy device 0x%04x (%u held)", short_addr, (unsigned)list->len);
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_post_obj, 1, esp32_zig_post);
+
+
+// mailbox(clear=None) - held commands per device and counters
+// clear=addr drops the commands held for that device.
+static mp_obj_t esp32_zig_mailbox(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_clear };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_clear, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_obj_t mailbox = mailbox_get();
+    if (args[ARG_clear].u_obj != mp_const_none) {
+        mp_obj_t key = MP_OBJ_NEW_SMALL_INT(mp_obj_get_int(args[ARG_clear].u_obj));
+        if (mp_map_lookup(mp_obj_dict_get_map(mailbox), key, MP_MAP_LOOKUP)) {
+            mp_obj_dict_delete(mailbox, key);
+        }
+        mailbox_addr_release(MP_OBJ_SMALL_INT_VALUE(key));
+    }
+
+    uint32_t now_s = mailbox_now_s();
+    mp_obj_t held = mp_obj_new_dict(0);
+    mp_map_t *map = mp_obj_dict_get_map(mailbox);
+    for (size_t i = 0; i < map->alloc; i++) {
+        if (mp_map_slot_is_filled(map, i)) {
+            mailbox_prune(map->table[i].value, now_s);
+            mp_obj_list_t *list = MP_OBJ_TO_PTR(map->table[i].value);
+            mp_obj_dict_store(held, map->table[i].key, MP_OBJ_NEW_SMALL_INT(list->len));
+        }
+    }
+
+    mp_obj_t dict = mp_obj_new_dict(6);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_held), held);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_direct), mp_obj_new_int_from_uint(mailbox_stats.direct));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_queued), mp_obj_new_int_from_uint(mailbox_stats.held));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_flushed), mp_obj_new_int_from_uint(mailbox_stats.flushed));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_expired), mp_obj_new_int_from_uint(mailbox_stats.expired));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_failed), mp_obj_new_int_from_uint(mailbox_stats.failed));
+    return dict;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_mailbox_obj, 1, esp32_zig_mailbox);
@@ -0,0 +1,38 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Outbound mailbox for sleepy end devices: commands wait until the device is heard from
+#ifndef MOD_ZIG_MAILBOX_H
+#define MOD_ZIG_MAILBOX_H
+
+#include "py/obj.h"
+#include "mod_zig_types.h"
+
+#define ZIG_MAILBOX_DEVICES     16      /* Devices with held commands */
+#define ZIG_MAILBOX_DEPTH       8       /* Held commands per device */
+#define ZIG_MAILBOX_TTL_S       600     /* Default time to live of a held command */
+
+#define ZIG_MAC_CAP_RX_ON_WHEN_IDLE  0x08   /* MAC capability flags: receiver on when idle */
+
+/**
+ * @brief Device was heard from, flush its mailbox
+ *
+ * Called from the Zigbee task on real receive paths only: incoming ZCL
+ * frames, attribute reports and device announcements. Only schedules the
+ * flush, commands are sent from the MicroPython thread.
+ *
+ * @param short_addr Source address of the frame
+ */
+void zig_mailbox_heard(uint16_t short_addr);
+
+/**
+ * @brief Whether commands to this device should wait in the mailbox
+ *
+ * @param device Device, NULL is treated as awake
+ * @return true for end devices with receiver off when idle or on battery
+ */
+bool zig_mailbox_is_sleepy(const zigbee_device_t *device);
+
+// Python API function objects
+extern const mp_obj_fun_builtin_var_t esp32_zig_post_obj;            // Send now or hold for a sleepy device
+extern const mp_obj_fun_builtin_var_t esp32_zig_mailbox_obj;         // Held commands and counters
+
+#endif // MOD_ZIG_MAILBOX_H
@@ -13,11 +13,17 @@
     X(REPORT_ATTR_CB,       2, "Attribute report"               ) \
     X(READ_ATTR_RESP,       3, "Read attribute response"        ) \
     X(REPORT_CONFIG_RESP,   4, "Report configuration response"  ) \
-    /* 5-6: reserved */ \
+    X(RETRY,                5, "Interview step retry scheduled" ) \
+    X(RETRY_GIVE_UP,        6, "Interview step abandoned"       ) \
     X(SIGNAL_DEVICE_REBOOT, 7, "Device reboot signal"           ) \
     X(SIGNAL_FORMATION,     8, "Network formation signal"       ) \
     X(SIGNAL_DEVICE_ANNCE,  9, "Device announcement"            ) \
-    /* 10-99: reserved */ \
+    X(INTERVIEW,           10, "Interview step finished"        ) \
+    X(BINDING_TABLE,       11, "Binding table read"             ) \
+    X(SCAN,                12, "Network scan finished"          ) \
+    X(TOPOLOGY,            13, "Topology crawl finished"        ) \
+    X(CHANNEL,             14, "Channel selected"               ) \
+    /* 15-49: reserved, 40-45 taken by the custom cluster types below */ \
     X(ZB_APP_SIGNAL_HANDLER,   50, "ZB app signal handler -> esp_zigbee_zdo_common.h"      ) \
     X(ACTION_DEFAULT,      100, "Default action"                ) \
     X(ZB_ACTION_HANDLER,   200, "zb_action_handler"             ) \
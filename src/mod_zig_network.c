@@ -1,4 +1,6 @@
 // Copyright (c) 2025 Viktor Vorobjov
+#include <string.h>
+
 #include "py/runtime.h"
 #include "py/obj.h"
 
@@ -6,8 +8,24 @@
 
 #include "main.h"
 #include "mod_zig_network.h"
+#include "mod_zig_handlers.h"
+#include "mod_zig_msg.h"
 #include "zdo/esp_zigbee_zdo_command.h"
 
+// Energy detect channel selection, touched in the Zigbee task or under ZB_LOCK
+typedef enum {
+    ED_IDLE,
+    ED_FORM,                        /* Formation waits for the result */
+    ED_CHANGE,                      /* change_channel() of the running network */
+} ed_purpose_t;
+
+static ed_purpose_t ed_purpose;
+static uint32_t ed_mask;            // Channels still to measure
+static uint32_t ed_scored;          // Channels measured by the last scan
+static int8_t ed_energy[27];        // Energy in dBm, by channel number
+static uint8_t ed_selected;         // Quietest channel of the last scan, 0 if none
+static bool scan_running;           // Active scan of scan_networks() in progress
+
 // open_network(duration=180) - Open Zigbee network for new devices to join
 static mp_obj_t esp32_zig_open_network(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     static const mp_arg_t allowed_args[] = {
@@ -115,6 +133,29 @@ mp_obj_t esp32_zig_get_network_info(mp_obj_t self_in) {
         mp_obj_dict_store(net_dict, MP_OBJ_NEW_QSTR(MP_QSTR_extended_pan_id), 
                          mp_obj_new_str(ext_pan_id_str, len));
     }
+
+    // Channel selection: allowed mask, last energy detect scores and its pick
+    int8_t energy[27];
+    ZB_LOCK();
+    uint32_t scored = ed_scored;
+    uint8_t selected = ed_selected;
+    memcpy(energy, ed_energy, sizeof(energy));
+    ZB_UNLOCK();
+
+    mp_obj_dict_store(net_dict, MP_OBJ_NEW_QSTR(MP_QSTR_channel_mask),
+                     mp_obj_new_int_from_uint(self->config->channel_mask));
+    mp_obj_dict_store(net_dict, MP_OBJ_NEW_QSTR(MP_QSTR_selected_channel),
+                     selected ? MP_OBJ_NEW_SMALL_INT(selected) : mp_const_none);
+    mp_obj_t scores = mp_const_none;
+    if (scored) {
+        scores = mp_obj_new_dict(0);
+        for (int ch = 11; ch <= 26; ch++) {
+            if (scored & (1UL << ch)) {
+                mp_obj_dict_store(scores, MP_OBJ_NEW_SMALL_INT(ch), MP_OBJ_NEW_SMALL_INT(energy[ch]));
+            }
+        }
+    }
+    mp_obj_dict_store(net_dict, MP_OBJ_NEW_QSTR(MP_QSTR_energy), scores);
     
     return net_dict;
 }
@@ -163,57 +204,163 @@ MP_DEFINE_CONST_FUN_OBJ_1(esp32_zig_update_network_status_obj, esp32_zig_update_
 
 
 
-// get_network_info() - Get information about the Zigbee network
+// Network scan: one channel at a time with a pause in between, so the
+// coordinator is back on its own channel for normal traffic after each one.
+// Scan state and results are touched in the Zigbee task, or under ZB_LOCK.
+typedef struct {
+    uint16_t pan_id;
+    uint8_t extended_pan_id[8];
+    uint8_t channel;
+    bool permit_join;
+    bool router_capacity;
+    bool end_device_capacity;
+} scan_network_t;
+
+static scan_network_t scan_networks[ZIG_SCAN_MAX];
+static uint8_t scan_count;
+static uint32_t scan_mask;          // Channels still to scan
+static uint8_t scan_duration;
+static uint8_t scan_status;         // First error of the scan, ESP_ZB_ZDP_STATUS_SUCCESS if none
+
+static void scan_result_handler(esp_zb_zdp_status_t zdo_status, uint8_t count, esp_zb_network_descriptor_t *nwk_descriptor);
+
+// Zigbee task: scan the next channel of the mask, or report the result
+static void scan_next(uint8_t param) {
+    (void)param;
+    if (scan_mask == 0) {
+        scan_running = false;
+        ESP_LOGI("SCAN", "Scanning completed. Found networks: %d", scan_count);
+        uint8_t data[1] = { scan_count };
+        send_msg_to_micropython_queue(ZIG_MSG_SCAN, scan_status, 0, 0, 0, data, sizeof(data));
+        return;
+    }
+    uint32_t channel = scan_mask & -scan_mask;      // Lowest channel left
+    scan_mask &= ~channel;
+    esp_zb_zdo_active_scan_request(channel, scan_duration, scan_result_handler);
+}
+
 static void scan_result_handler(esp_zb_zdp_status_t zdo_status, uint8_t count, esp_zb_network_descriptor_t *nwk_descriptor) {
     if (zdo_status != ESP_ZB_ZDP_STATUS_SUCCESS) {
-        ESP_LOGW("SCAN", "Scanning completed with error: %d", zdo_status);
-        return;
+        ESP_LOGW("SCAN", "Channel scan completed with error: %d", zdo_status);
+        if (scan_status == ESP_ZB_ZDP_STATUS_SUCCESS) {
+            scan_status = zdo_status;
+        }
+        count = 0;
     }
-    ESP_LOGI("SCAN", "Scanning completed. Found networks: %d", count);
     for (int i = 0; i < count; ++i) {
-        ESP_LOGI("SCAN", "Network %d: PAN ID: 0x%04x, Channel: %d, Permit Join: %d",
-                 i + 1,
-                 nwk_descriptor[i].short_pan_id,
-                 nwk_descriptor[i].logic_channel,
-                 nwk_descriptor[i].permit_joining);
+        const esp_zb_network_descriptor_t *d = &nwk_descriptor[i];
+        ESP_LOGI("SCAN", "Network: PAN ID: 0x%04x, Channel: %d, Permit Join: %d",
+                 d->short_pan_id, d->logic_channel, d->permit_joining);
+
+        // Beacons of several routers of one network collapse into one entry
+        scan_network_t *n = NULL;
+        for (int j = 0; j < scan_count; j++) {
+            if (scan_networks[j].channel == d->logic_channel &&
+                memcmp(scan_networks[j].extended_pan_id, d->extended_pan_id, 8) == 0) {
+                n = &scan_networks[j];
+                break;
+            }
+        }
+        if (!n) {
+            if (scan_count >= ZIG_SCAN_MAX) {
+                continue;
+            }
+            n = &scan_networks[scan_count++];
+            memset(n, 0, sizeof(*n));
+            n->pan_id = d->short_pan_id;
+            memcpy(n->extended_pan_id, d->extended_pan_id, 8);
+            n->channel = d->logic_channel;
+        }
+        n->permit_join |= d->permit_joining;
+        n->router_capacity |= d->router_capacity;
+        n->end_device_capacity |= d->end_device_capacity;
     }
+    esp_zb_scheduler_alarm((esp_zb_callback_t)scan_next, 0, ZIG_SCAN_GAP_MS);
 }
 
 
+// scan_networks(channel_mask=ZIG_CHANNEL_MASK_ALL, duration=3)
+// Start a scan, False if a scan is running; MSG.SCAN follows, results from scan_results()
+static mp_obj_t esp32_zig_scan_networks(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_channel_mask, ARG_duration };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_channel_mask, MP_ARG_INT, {.u_int = ZIG_CHANNEL_MASK_ALL} },
+        { MP_QSTR_duration,     MP_ARG_INT, {.u_int = 3} },
+    };
 
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
-
-// scan_networks() - Scan for nearby Zigbee networks
-static mp_obj_t esp32_zig_scan_networks(mp_obj_t self_in) {
-    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(self_in);
-    
     // Check if device is initialized and is a gateway
     if (!self->config->network_formed) {
         mp_raise_msg(&mp_type_RuntimeError, "Device is not initialized");
         return mp_const_none;
     }
-    
-    
+
     // Check if Zigbee stack is started
     if (!esp_zb_is_started()) {
         mp_raise_msg(&mp_type_RuntimeError, "Zigbee stack is not started");
         return mp_const_none;
     }
-    
-    // Start a network scan
+
+    uint32_t channel_mask = (uint32_t)args[ARG_channel_mask].u_int & ZIG_CHANNEL_MASK_ALL;
+    if (channel_mask == 0) {
+        mp_raise_ValueError("channel_mask has no channel 11-26");
+    }
+    if (args[ARG_duration].u_int < 0 || args[ARG_duration].u_int > 14) {
+        mp_raise_ValueError("duration must be 0-14");
+    }
+
+    // Start a network scan, results of the previous one are dropped
     ZB_LOCK();
-    // Scan all channels (11-26) with default duration
-    uint32_t channel_mask = 0x07FFF800;  // All Zigbee channels (11-26)
-    uint8_t scan_duration = 5;           // Reasonable duration for scanning
-    esp_zb_zdo_active_scan_request(channel_mask, scan_duration, scan_result_handler);
+    bool start = !scan_running && ed_purpose == ED_IDLE;
+    if (start) {
+        scan_running = true;
+        scan_count = 0;
+        scan_mask = channel_mask;
+        scan_duration = args[ARG_duration].u_int;
+        scan_status = ESP_ZB_ZDP_STATUS_SUCCESS;
+        scan_next(0);
+    }
     ZB_UNLOCK();
-    
-    // Note: This is an asynchronous operation, results will be delivered through the signal handler
-    // For now, we'll just return a message that scan has started
-    return mp_obj_new_str("Network scan started", 20);
+
+    return mp_obj_new_bool(start);
 }
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_scan_networks_obj, 1, esp32_zig_scan_networks);
 
-MP_DEFINE_CONST_FUN_OBJ_1(esp32_zig_scan_networks_obj, esp32_zig_scan_networks);
+
+// scan_results()
+// Networks found by the last scan as dicts
+static mp_obj_t esp32_zig_scan_results(mp_obj_t self_in) {
+    (void)self_in;
+
+    // Copy under the lock, build objects without it
+    scan_network_t found[ZIG_SCAN_MAX];
+    ZB_LOCK();
+    uint8_t count = scan_count;
+    memcpy(found, scan_networks, sizeof(scan_network_t) * count);
+    ZB_UNLOCK();
+
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (int i = 0; i < count; i++) {
+        scan_network_t *n = &found[i];
+        char ext_pan_id_str[24];
+        int len = snprintf(ext_pan_id_str, sizeof(ext_pan_id_str), "%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x",
+                           n->extended_pan_id[7], n->extended_pan_id[6], n->extended_pan_id[5], n->extended_pan_id[4],
+                           n->extended_pan_id[3], n->extended_pan_id[2], n->extended_pan_id[1], n->extended_pan_id[0]);
+        mp_obj_t dict = mp_obj_new_dict(6);
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_pan_id), MP_OBJ_NEW_SMALL_INT(n->pan_id));
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_extended_pan_id), mp_obj_new_str(ext_pan_id_str, len));
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_channel), MP_OBJ_NEW_SMALL_INT(n->channel));
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_permit_join), mp_obj_new_bool(n->permit_join));
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_router_capacity), mp_obj_new_bool(n->router_capacity));
+        mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_end_device_capacity), mp_obj_new_bool(n->end_device_capacity));
+        mp_obj_list_append(list, dict);
+    }
+    return list;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(esp32_zig_scan_results_obj, esp32_zig_scan_results);
 
 
 // Python API: deferred start of Zigbee gateway
@@ -234,3 +381,148 @@ static mp_obj_t esp32_zig_start_network(mp_obj_t self_in) {
     return mp_const_none;
 }
 MP_DEFINE_CONST_FUN_OBJ_1(esp32_zig_start_network_obj, esp32_zig_start_network);
+
+
+static void ed_result_handler(esp_zb_zdp_status_t status, uint16_t count, esp_zb_energy_detect_channel_info_t *channel_info);
+
+// Mgmt_NWK_Update_req to every router and rx-on device, they switch after the broadcast delivery time
+static void network_change_channel(uint8_t channel) {
+    esp_zb_zdo_mgmt_nwk_update_req_param_t req = {
+        .scan_channels = 1UL << channel,
+        .scan_duration = ZIG_NWK_UPDATE_CHANGE,
+        .dst_addr      = 0xFFFD,
+    };
+    esp_zb_zdo_mgmt_nwk_update_req(&req, NULL, NULL);
+    // A later formation starts on the new channel too
+    esp_zb_set_primary_network_channel_set(1UL << channel);
+    ESP_LOGI("CHANNEL", "Moving network to channel %u", channel);
+}
+
+// Quietest measured channel, 0 if none
+static uint8_t ed_quietest(void) {
+    uint8_t best = 0;
+    for (uint8_t ch = 11; ch <= 26; ch++) {
+        if ((ed_scored & (1UL << ch)) && (!best || ed_energy[ch] < ed_energy[best])) {
+            best = ch;
+        }
+    }
+    return best;
+}
+
+// Scan done: form, or move the running network: channel(1) + energy(1, int8 dBm)
+static void ed_finish(void) {
+    ed_purpose_t purpose = ed_purpose;
+    ed_purpose = ED_IDLE;
+    ed_selected = ed_quietest();
+    esp32_zig_obj_t *self = (esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr);
+    uint8_t channel = ed_selected;
+    uint8_t status = ed_selected ? ESP_ZB_ZDP_STATUS_SUCCESS : ESP_ZB_ZDP_STATUS_TIMEOUT;
+
+    if (purpose == ED_FORM) {
+        // Nothing measured: let the stack pick from the whole mask
+        uint32_t mask = ed_selected ? (1UL << ed_selected) : self->config->channel_mask;
+        ESP_LOGI("CHANNEL", "Forming on channel mask 0x%08lx", (unsigned long)mask);
+        esp_zb_set_primary_network_channel_set(mask);
+        esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_FORMATION);
+    } else if (ed_selected) {
+        // Own traffic raises the current channel's energy, move only for a clear gain
+        uint8_t current = esp_zb_get_current_channel();
+        if (current != ed_selected && (!(ed_scored & (1UL << current)) ||
+            ed_energy[ed_selected] + ZIG_CHANNEL_MARGIN_DB <= ed_energy[current])) {
+            network_change_channel(ed_selected);
+        } else {
+            channel = current;
+        }
+    }
+
+    uint8_t data[2] = { channel, channel ? (uint8_t)ed_energy[channel] : 0 };
+    send_msg_to_micropython_queue(ZIG_MSG_CHANNEL, status, 0, 0, 0, data, sizeof(data));
+}
+
+// Zigbee task: measure the next channel, a running network gets its channel back in between
+static void ed_next(uint8_t param) {
+    (void)param;
+    if (ed_mask == 0) {
+        ed_finish();
+        return;
+    }
+    uint32_t channel = ed_mask & -ed_mask;
+    ed_mask &= ~channel;
+    esp_zb_zdo_energy_detect_request(channel, ZIG_ENERGY_SCAN_DURATION, ed_result_handler);
+}
+
+static void ed_result_handler(esp_zb_zdp_status_t status, uint16_t count, esp_zb_energy_detect_channel_info_t *channel_info) {
+    if (status != ESP_ZB_ZDP_STATUS_SUCCESS) {
+        ESP_LOGW("CHANNEL", "Energy detect completed with error: %d", status);
+        count = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        uint8_t ch = channel_info[i].channel_number;
+        if (ch >= 11 && ch <= 26) {
+            ed_energy[ch] = channel_info[i].energy_detected;
+            ed_scored |= 1UL << ch;
+            ESP_LOGI("CHANNEL", "Channel %u: %d dBm", ch, channel_info[i].energy_detected);
+        }
+    }
+    esp_zb_scheduler_alarm((esp_zb_callback_t)ed_next, 0, ed_purpose == ED_CHANGE ? ZIG_SCAN_GAP_MS : 0);
+}
+
+static void ed_start(ed_purpose_t purpose, uint32_t mask) {
+    ed_purpose = purpose;
+    ed_mask = mask;
+    ed_scored = 0;
+    ed_selected = 0;
+    ed_next(0);
+}
+
+void zig_network_form(void) {
+    esp32_zig_obj_t *self = (esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr);
+    uint32_t mask = self->config->channel_mask;
+    // A single channel has nothing to choose from
+    if (self->config->energy_scan && (mask & (mask - 1))) {
+        ESP_LOGI("CHANNEL", "Energy detect over channel mask 0x%08lx", (unsigned long)mask);
+        ed_start(ED_FORM, mask);
+        return;
+    }
+    esp_zb_bdb_start_top_level_commissioning(ESP_ZB_BDB_MODE_NETWORK_FORMATION);
+}
+
+
+// change_channel(channel=None)
+// Move the running network; None picks the quietest channel of the mask, MSG.CHANNEL follows
+static mp_obj_t esp32_zig_change_channel(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_channel };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_channel, MP_ARG_OBJ, {.u_obj = mp_const_none} },
+    };
+
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (!self->config->network_formed) {
+        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
+    }
+
+    int channel = 0;
+    if (args[ARG_channel].u_obj != mp_const_none) {
+        channel = mp_obj_get_int(args[ARG_channel].u_obj);
+        if (channel < 11 || channel > 26) {
+            mp_raise_ValueError("channel must be 11-26");
+        }
+    }
+
+    ZB_LOCK();
+    bool start = !scan_running && ed_purpose == ED_IDLE;
+    if (start) {
+        if (channel) {
+            network_change_channel(channel);
+        } else {
+            ed_start(ED_CHANGE, self->config->channel_mask);
+        }
+    }
+    ZB_UNLOCK();
+
+    return mp_obj_new_bool(start);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_change_channel_obj, 1, esp32_zig_change_channel);
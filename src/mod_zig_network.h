@@ -10,12 +10,30 @@
 #include "py/obj.h"
 #include "py/runtime.h"
 
+#define ZIG_CHANNEL_MASK_ALL    0x07FFF800  /* Channels 11-26 */
+#define ZIG_SCAN_MAX            16          /* Networks kept from one scan */
+#define ZIG_SCAN_GAP_MS         250         /* Pause between two scanned channels */
+#define ZIG_ENERGY_SCAN_DURATION 5          /* Energy detect time per channel, (2^n + 1) * 15.36 ms */
+#define ZIG_CHANNEL_MARGIN_DB   6           /* change_channel() keeps the channel unless another is this much quieter */
+#define ZIG_NWK_UPDATE_CHANGE   0xFE        /* Mgmt_NWK_Update_req scan duration: switch channel */
+
+/**
+ * @brief Form the network, after an energy detect scan when enabled
+ *
+ * With energy_scan set and more than one channel in the mask, every channel
+ * is scored first and the quietest one is formed on. Called from the Zigbee
+ * task on the first start of a factory new coordinator.
+ */
+void zig_network_form(void);
+
 // Network management function objects
 extern const mp_obj_fun_builtin_var_t esp32_zig_open_network_obj;
 extern const mp_obj_fun_builtin_fixed_t esp32_zig_close_network_obj;
 extern const mp_obj_fun_builtin_fixed_t esp32_zig_get_network_info_obj;
 extern const mp_obj_fun_builtin_fixed_t esp32_zig_update_network_status_obj;
-extern const mp_obj_fun_builtin_fixed_t esp32_zig_scan_networks_obj;
+extern const mp_obj_fun_builtin_var_t esp32_zig_scan_networks_obj;          // Scan channel by channel
+extern const mp_obj_fun_builtin_fixed_t esp32_zig_scan_results_obj;        // Networks of the last scan
+extern const mp_obj_fun_builtin_var_t esp32_zig_change_channel_obj;         // Move the running network
 extern const mp_obj_fun_builtin_fixed_t esp32_zig_start_network_obj;
 
 // Direct access to network functions for internal use
@@ -0,0 +1,492 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Stored report configurations: upsert, delete, list and verification against the device
+#include <string.h>
+
+// FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ESP-IDF headers
+#include "esp_log.h"
+
+// Zigbee headers
+#include "esp_zigbee_core.h"
+#include "zcl/esp_zigbee_zcl_command.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+
+//Project headers
+#include "main.h"
+#include "device_manager.h"
+#include "device_storage.h"
+#include "mod_zig_cmd.h"
+#include "mod_zig_msg.h"
+#include "mod_zig_handlers.h"
+#include "mod_zig_report.h"
+
+#define LOG_TAG "ZIG_REPORT"
+
+#define REPORT_ANY -1       // Filter value matching every ep / cluster / attr / direction
+
+// Read Reporting Configuration sent by verify_reporting()
+typedef struct {
+    uint16_t short_addr;
+    uint8_t tsn;
+    bool fix;               // Configure drifted records again
+    bool in_use;
+} report_verify_t;
+
+static report_verify_t report_verify[ZIG_REPORT_VERIFY_MAX];
+static uint8_t report_verify_next;
+static portMUX_TYPE report_verify_lock = portMUX_INITIALIZER_UNLOCKED;
+
+
+static report_cfg_t *report_cfg_find(zigbee_device_t *dev, uint8_t ep, uint16_t cluster_id, uint16_t attr_id,
+                                     uint8_t direction) {
+    for (int i = 0; i < MAX_REPORT_CFGS; i++) {
+        report_cfg_t *r = &dev->report_cfgs[i];
+        if (r->in_use && r->ep == ep && r->cluster_id == cluster_id && r->attr_id == attr_id &&
+            r->direction == direction) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+size_t zig_report_apply(const zigbee_device_t *dev, uint8_t ep, uint16_t cluster_id, uint8_t *tsns) {
+    report_cfg_t cfgs[MAX_REPORT_CFGS];
+    size_t count = 0;
+    for (int j = 0; j < MAX_REPORT_CFGS; j++) {
+        const report_cfg_t *r = &dev->report_cfgs[j];
+        if (r->in_use && r->ep == ep && r->cluster_id == cluster_id) {
+            if (r->direction != REPORT_CFG_DIRECTION_SEND && r->direction != REPORT_CFG_DIRECTION_RECV) {
+                ESP_LOGW(LOG_TAG, "Unknown report_cfg direction: %d", r->direction);
+                continue; // Skip this configuration
+            }
+            cfgs[count++] = *r;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t frames = zig_report_cfg_send(dev->short_addr, ep, cluster_id, cfgs, count, tsns);
+    ESP_LOGI(LOG_TAG, "Configuring stored reporting: addr=0x%04x, ep=%d, cl=0x%04x, %d records in %d frames",
+             dev->short_addr, ep, cluster_id, (int)count, (int)frames);
+    return frames;
+}
+
+static bool report_cfg_matches_filter(const report_cfg_t *r, mp_int_t ep, mp_int_t cl, mp_int_t attr, mp_int_t direction) {
+    return r->in_use && (ep == REPORT_ANY || r->ep == ep) && (cl == REPORT_ANY || r->cluster_id == cl) &&
+           (attr == REPORT_ANY || r->attr_id == attr) && (direction == REPORT_ANY || r->direction == direction);
+}
+
+static bool report_cfg_equal(const report_cfg_t *a, const report_cfg_t *b) {
+    if (a->direction == REPORT_CFG_DIRECTION_RECV) {
+        return a->recv_cfg.timeout_period == b->recv_cfg.timeout_period;
+    }
+    return a->send_cfg.attr_type == b->send_cfg.attr_type && a->send_cfg.min_int == b->send_cfg.min_int &&
+           a->send_cfg.max_int == b->send_cfg.max_int &&
+           a->send_cfg.reportable_change_val == b->send_cfg.reportable_change_val;
+}
+
+// Device with its full record loaded, raises if unknown
+static zigbee_device_t *report_device(uint16_t short_addr) {
+    device_storage_ensure_detail(short_addr);
+    zigbee_device_t *dev = device_manager_get(short_addr);
+    if (!dev) {
+        mp_raise_msg_varg(&mp_type_ValueError, MP_ERROR_TEXT("Device 0x%04x not found"), short_addr);
+    }
+    return dev;
+}
+
+static void report_verify_add(uint16_t short_addr, uint8_t tsn, bool fix) {
+    taskENTER_CRITICAL(&report_verify_lock);
+    // Oldest entry is overwritten when all are waiting
+    report_verify_t *v = &report_verify[report_verify_next];
+    report_verify_next = (report_verify_next + 1) % ZIG_REPORT_VERIFY_MAX;
+    v->short_addr = short_addr;
+    v->tsn = tsn;
+    v->fix = fix;
+    v->in_use = true;
+    taskEXIT_CRITICAL(&report_verify_lock);
+}
+
+// Whether a response belongs to verify_reporting(fix=True)
+static bool report_verify_take(uint16_t short_addr, uint8_t tsn) {
+    bool fix = false;
+    taskENTER_CRITICAL(&report_verify_lock);
+    for (int i = 0; i < ZIG_REPORT_VERIFY_MAX; i++) {
+        report_verify_t *v = &report_verify[i];
+        if (v->in_use && v->short_addr == short_addr && v->tsn == tsn) {
+            fix = v->fix;
+            v->in_use = false;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&report_verify_lock);
+    return fix;
+}
+
+// Read Reporting Configuration for the given records of one cluster, the response is diffed
+// in zig_report_verify_resp(). Caller holds the stack lock; registered before it is released,
+// so the response can't overtake it.
+static uint8_t report_read_cfg(uint16_t short_addr, uint8_t ep, uint16_t cluster_id,
+                               esp_zb_zcl_attribute_record_t *records, uint8_t n, bool fix) {
+    esp_zb_zcl_read_report_config_cmd_t cmd_req;
+    memset(&cmd_req, 0, sizeof(cmd_req));
+    cmd_req.zcl_basic_cmd.dst_addr_u.addr_short = short_addr;
+    cmd_req.zcl_basic_cmd.dst_endpoint = ep;
+    cmd_req.zcl_basic_cmd.src_endpoint = ESP_ZB_GATEWAY_ENDPOINT;
+    cmd_req.address_mode = ESP_ZB_APS_ADDR_MODE_16_ENDP_PRESENT;
+    cmd_req.clusterID = cluster_id;
+    cmd_req.record_number = n;
+    cmd_req.record_field = records;
+
+    uint8_t tsn = esp_zb_zcl_read_report_config_cmd_req(&cmd_req);
+    report_verify_add(short_addr, tsn, fix);
+    return tsn;
+}
+
+size_t zig_report_sync(const zigbee_device_t *dev, uint8_t ep, uint16_t cluster_id, uint8_t *tsns) {
+    // Never configured: nothing to compare against, send everything
+    if (!dev->interview_complete) {
+        return zig_report_apply(dev, ep, cluster_id, tsns);
+    }
+
+    esp_zb_zcl_attribute_record_t records[MAX_REPORT_CFGS];
+    uint8_t n = 0;
+    for (int i = 0; i < MAX_REPORT_CFGS; i++) {
+        const report_cfg_t *r = &dev->report_cfgs[i];
+        if (r->in_use && r->ep == ep && r->cluster_id == cluster_id) {
+            records[n].report_direction = r->direction;
+            records[n].attributeID = r->attr_id;
+            n++;
+        }
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    uint8_t tsn = report_read_cfg(dev->short_addr, ep, cluster_id, records, n, true);
+    if (tsns) {
+        tsns[0] = tsn;
+    }
+    ESP_LOGI(LOG_TAG, "Checking stored reporting: addr=0x%04x, ep=%d, cl=0x%04x, %d records",
+             dev->short_addr, ep, cluster_id, n);
+    return 1;
+}
+
+// Stored config against one record read back from the device
+static bool report_cfg_in_sync(const report_cfg_t *want, const esp_zb_zcl_read_report_config_resp_variable_t *var) {
+    if (var->status != ESP_ZB_ZCL_STATUS_SUCCESS) {
+        return false;   // Not configured on the device
+    }
+    if (want->direction == REPORT_CFG_DIRECTION_RECV) {
+        return var->server.timeout == want->recv_cfg.timeout_period;
+    }
+    if (var->client.attr_type != want->send_cfg.attr_type || var->client.min_interval != want->send_cfg.min_int ||
+        var->client.max_interval != want->send_cfg.max_int) {
+        return false;
+    }
+
+    // Reportable change, little-endian and as wide as the attribute; unset is all ones
+    size_t size = zig_report_change_size(want->send_cfg.attr_type);
+    uint64_t change = want->send_cfg.reportable_change_val == 0xFFFFFFFF ? UINT64_MAX
+                                                                        : want->send_cfg.reportable_change_val;
+    for (size_t i = 0; i < size; i++) {
+        if (var->client.delta[i] != (uint8_t)(change >> (8 * i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void zig_report_verify_resp(const void *message) {
+    const esp_zb_zcl_cmd_read_report_config_resp_message_t *msg = message;
+    uint16_t short_addr = msg->info.src_address.u.short_addr;
+    uint8_t ep = msg->info.src_endpoint;
+    uint16_t cluster_id = msg->info.cluster;
+
+    bool fix = report_verify_take(short_addr, msg->info.header.tsn);
+    zigbee_device_t *dev = device_manager_get(short_addr);
+
+    report_cfg_t drifted[MAX_REPORT_CFGS];
+    size_t n_drifted = 0;
+    // Format: status(1) + direction(1) + attr_id(2) + in_sync(1) per record
+    uint8_t data[5 * MAX_REPORT_CFGS];
+    size_t data_len = 0;
+
+    for (esp_zb_zcl_read_report_config_resp_variable_t *var = msg->variables;
+         var && data_len + 5 <= sizeof(data); var = var->next) {
+        const report_cfg_t *want = dev ? report_cfg_find(dev, ep, cluster_id, var->attribute_id, var->report_direction) : NULL;
+        uint8_t sync = ZIG_REPORT_UNKNOWN;
+        if (want) {
+            sync = report_cfg_in_sync(want, var) ? ZIG_REPORT_IN_SYNC : ZIG_REPORT_DRIFT;
+            if (sync == ZIG_REPORT_DRIFT && n_drifted < MAX_REPORT_CFGS) {
+                drifted[n_drifted++] = *want;
+            }
+        }
+        data[data_len++] = var->status;
+        data[data_len++] = var->report_direction;
+        data[data_len++] = var->attribute_id & 0xFF;
+        data[data_len++] = (var->attribute_id >> 8) & 0xFF;
+        data[data_len++] = sync;
+    }
+
+    if (n_drifted > 0) {
+        ESP_LOGI(LOG_TAG, "0x%04x ep=%u cl=0x%04x: %d report configs drifted%s",
+                 short_addr, ep, cluster_id, (int)n_drifted, fix ? ", configuring again" : "");
+        if (fix) {
+            zig_report_cfg_send(short_addr, ep, cluster_id, drifted, n_drifted, NULL);
+        }
+    }
+
+    send_zcl_msg_to_micropython_queue(
+        ZIG_MSG_ZB_APP_SIGNAL_HANDLER,
+        ESP_ZB_CORE_CMD_READ_REPORT_CFG_RESP_CB_ID,
+        &msg->info,
+        msg->info.status,
+        data,
+        data_len
+    );
+}
+
+
+// set_report_config(addr, ep, cl, attr, direction=SEND, attr_type, min_int=0, max_int=30,
+//                   reportable_change=None, timeout)
+// Insert or replace the stored config of (ep, cl, attr, direction); applied after every bind.
+// Returns True if the stored state changed (and is being saved), False if it was already there.
+static mp_obj_t esp32_zig_set_report_config(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+
+    enum {
+        ARG_addr, ARG_ep, ARG_cl, ARG_attr, ARG_direction, // Common args
+        ARG_attr_type, ARG_min_int, ARG_max_int, ARG_reportable_change, // For SEND direction
+        ARG_timeout // For RECV direction
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr,                 MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_ep,                   MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_cl,                   MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_attr,                 MP_ARG_REQUIRED | MP_ARG_INT, {.u_int = 0} },
+
+        { MP_QSTR_direction,            MP_ARG_INT, {.u_int = REPORT_CFG_DIRECTION_SEND} }, // Default to SEND
+        // Args for SEND direction (conditionally required)
+        { MP_QSTR_attr_type,            MP_ARG_INT, {.u_int = -1} },         // Marker for not set, required for SEND
+        { MP_QSTR_min_int,              MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_max_int,              MP_ARG_INT, {.u_int = 30} },
+        { MP_QSTR_reportable_change,    MP_ARG_INT, {.u_int = 0xFFFFFFFF} }, // Marker for not set
+        // Arg for RECV direction (conditionally required)
+        { MP_QSTR_timeout,              MP_ARG_INT, {.u_int = 0xFFFF} },    // Marker for not set / default for RECV
+    };
+
+    mp_arg_val_t vals[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, vals);
+
+    // Build and validate before touching the table
+    report_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.in_use     = true;
+    cfg.direction  = (uint8_t)vals[ARG_direction].u_int;
+    cfg.ep         = vals[ARG_ep].u_int;
+    cfg.cluster_id = vals[ARG_cl].u_int;
+    cfg.attr_id    = vals[ARG_attr].u_int;
+
+    if (cfg.direction == REPORT_CFG_DIRECTION_SEND) {
+        if (vals[ARG_attr_type].u_int == -1) {
+             mp_raise_ValueError("attr_type is required for SEND direction");
+        }
+        cfg.send_cfg.attr_type = (uint8_t)vals[ARG_attr_type].u_int;
+        cfg.send_cfg.min_int = (uint16_t)vals[ARG_min_int].u_int;
+        cfg.send_cfg.max_int = (uint16_t)vals[ARG_max_int].u_int;
+        cfg.send_cfg.reportable_change_val = (uint32_t)vals[ARG_reportable_change].u_int;
+    } else if (cfg.direction == REPORT_CFG_DIRECTION_RECV) {
+        if (vals[ARG_timeout].u_int == 0xFFFF) {
+             mp_raise_ValueError("timeout is required for RECV direction");
+        }
+        cfg.recv_cfg.timeout_period = (uint16_t)vals[ARG_timeout].u_int;
+    } else {
+        mp_raise_ValueError("Invalid direction value");
+    }
+
+    uint16_t addr = vals[ARG_addr].u_int;
+    zigbee_device_t *dev = report_device(addr);
+
+    // The Zigbee task reads the table in bind_cb, keep it out while writing
+    bool changed = false;
+    bool full = false;
+    ZB_LOCK();
+    report_cfg_t *slot = report_cfg_find(dev, cfg.ep, cfg.cluster_id, cfg.attr_id, cfg.direction);
+    if (slot) {
+        changed = !report_cfg_equal(slot, &cfg);
+    } else {
+        for (int j = 0; j < MAX_REPORT_CFGS && !slot; j++) {
+            if (!dev->report_cfgs[j].in_use) {
+                slot = &dev->report_cfgs[j];
+            }
+        }
+        full = slot == NULL;
+        changed = !full;
+    }
+    if (changed) {
+        *slot = cfg;
+    }
+    ZB_UNLOCK();
+
+    if (full) {
+        mp_raise_msg(&mp_type_RuntimeError, "No free report slots");
+    }
+    if (changed) {
+        device_storage_save(MP_OBJ_TO_PTR(pos_args[0]), addr);
+    }
+    return mp_obj_new_bool(changed);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_set_report_config_obj, 1, esp32_zig_set_report_config);
+
+
+// remove_report_config(addr, ep=-1, cl=-1, attr=-1, direction=-1)
+// Delete stored configs matching the filter (-1 matches any). Returns the number removed.
+static mp_obj_t esp32_zig_remove_report_config(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr, ARG_ep, ARG_cl, ARG_attr, ARG_direction };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr,      MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,        MP_ARG_INT, {.u_int = REPORT_ANY} },
+        { MP_QSTR_cl,        MP_ARG_INT, {.u_int = REPORT_ANY} },
+        { MP_QSTR_attr,      MP_ARG_INT, {.u_int = REPORT_ANY} },
+        { MP_QSTR_direction, MP_ARG_INT, {.u_int = REPORT_ANY} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uint16_t addr = args[ARG_addr].u_int;
+    zigbee_device_t *dev = report_device(addr);
+
+    int removed = 0;
+    ZB_LOCK();
+    for (int i = 0; i < MAX_REPORT_CFGS; i++) {
+        report_cfg_t *r = &dev->report_cfgs[i];
+        if (report_cfg_matches_filter(r, args[ARG_ep].u_int, args[ARG_cl].u_int, args[ARG_attr].u_int,
+                                      args[ARG_direction].u_int)) {
+            memset(r, 0, sizeof(*r));
+            removed++;
+        }
+    }
+    ZB_UNLOCK();
+
+    if (removed > 0) {
+        device_storage_save(MP_OBJ_TO_PTR(pos_args[0]), addr);
+    }
+    return MP_OBJ_NEW_SMALL_INT(removed);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_remove_report_config_obj, 1, esp32_zig_remove_report_config);
+
+
+// report_configs(addr, ep=-1, cl=-1)
+// Stored configs as dicts with the keys of the device record
+static mp_obj_t esp32_zig_report_configs(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr, ARG_ep, ARG_cl };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr, MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,   MP_ARG_INT, {.u_int = REPORT_ANY} },
+        { MP_QSTR_cl,   MP_ARG_INT, {.u_int = REPORT_ANY} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    zigbee_device_t *dev = report_device(args[ARG_addr].u_int);
+
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (int i = 0; i < MAX_REPORT_CFGS; i++) {
+        const report_cfg_t *r = &dev->report_cfgs[i];
+        if (!report_cfg_matches_filter(r, args[ARG_ep].u_int, args[ARG_cl].u_int, REPORT_ANY, REPORT_ANY)) {
+            continue;
+        }
+        mp_obj_t d = mp_obj_new_dict(8);
+        mp_obj_dict_store(d, MP_OBJ_NEW_QSTR(MP_QSTR_direction), MP_OBJ_NEW_SMALL_INT(r->direction));
+        mp_obj_dict_store(d, MP_OBJ_NEW_QSTR(MP_QSTR_ep), MP_OBJ_NEW_SMALL_INT(r->ep));
+        mp_obj_dict_store(d, MP_OBJ_NEW_QSTR(MP_QSTR_cluster_id), MP_OBJ_NEW_SMALL_INT(r->cluster_id));
+        mp_obj_dict_store(d, MP_OBJ_NEW_QSTR(MP_QSTR_attr_id), MP_OBJ_NEW_SMALL_INT(r->attr_id));
+        if (r->direction == REPORT_CFG_DIRECTION_SEND) {
+            mp_obj_dict_store(d, MP_OBJ_NEW_QSTR(MP_QSTR_attr_type), MP_OBJ_NEW_SMALL_INT(r->send_cfg.attr_type));
+            mp_obj_dict_store(d, MP_OBJ_NEW_QSTR(MP_QSTR_min_int), MP_OBJ_NEW_SMALL_INT(r->send_cfg.min_int));
+            mp_obj_dict_store(d, MP_OBJ_NEW_QSTR(MP_QSTR_max_int), MP_OBJ_NEW_SMALL_INT(r->send_cfg.max_int));
+            if (r->send_cfg.reportable_change_val != 0xFFFFFFFF) {
+                mp_obj_dict_store(d, MP_OBJ_NEW_QSTR(MP_QSTR_reportable_change_val),
+                                  mp_obj_new_int_from_uint(r->send_cfg.reportable_change_val));
+            }
+        } else {
+            mp_obj_dict_store(d, MP_OBJ_NEW_QSTR(MP_QSTR_timeout_period), MP_OBJ_NEW_SMALL_INT(r->recv_cfg.timeout_period));
+        }
+        mp_obj_list_append(list, d);
+    }
+    return list;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_report_configs_obj, 1, esp32_zig_report_configs);
+
+
+// verify_reporting(addr, ep=-1, cl=-1, *, fix=True)
+// Read Reporting Configuration for the stored configs, one frame per (ep, cluster).
+// Drifted records are configured again with fix=True. Returns a tuple of TSNs.
+static mp_obj_t esp32_zig_verify_reporting(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_addr, ARG_ep, ARG_cl, ARG_fix };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_addr, MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_ep,   MP_ARG_INT, {.u_int = REPORT_ANY} },
+        { MP_QSTR_cl,   MP_ARG_INT, {.u_int = REPORT_ANY} },
+        { MP_QSTR_fix,  MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = true} },
+    };
+
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    if (!self->config->network_formed) {
+        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
+    }
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    uint16_t addr = args[ARG_addr].u_int;
+    zigbee_device_t *dev = report_device(addr);
+
+    // Copy the wanted configs, then group them by (ep, cluster)
+    report_cfg_t cfgs[MAX_REPORT_CFGS];
+    size_t count = 0;
+    for (int i = 0; i < MAX_REPORT_CFGS; i++) {
+        if (report_cfg_matches_filter(&dev->report_cfgs[i], args[ARG_ep].u_int, args[ARG_cl].u_int,
+                                      REPORT_ANY, REPORT_ANY)) {
+            cfgs[count++] = dev->report_cfgs[i];
+        }
+    }
+
+    mp_obj_t tsns[MAX_REPORT_CFGS];
+    size_t frames = 0;
+    bool done[MAX_REPORT_CFGS] = { false };
+    esp_zb_zcl_attribute_record_t records[MAX_REPORT_CFGS];
+
+    for (size_t i = 0; i < count; i++) {
+        if (done[i]) {
+            continue;
+        }
+        uint8_t n = 0;
+        for (size_t j = i; j < count; j++) {
+            if (!done[j] && cfgs[j].ep == cfgs[i].ep && cfgs[j].cluster_id == cfgs[i].cluster_id) {
+                records[n].report_direction = cfgs[j].direction;
+                records[n].attributeID = cfgs[j].attr_id;
+                done[j] = true;
+                n++;
+            }
+        }
+
+        ZB_LOCK();
+        uint8_t tsn = report_read_cfg(addr, cfgs[i].ep, cfgs[i].cluster_id, records, n, args[ARG_fix].u_bool);
+        ZB_UNLOCK();
+
+        tsns[frames++] = MP_OBJ_NEW_SMALL_INT(tsn);
+    }
+
+    return mp_obj_new_tuple(frames, tsns);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_verify_reporting_obj, 1, esp32_zig_verify_reporting);
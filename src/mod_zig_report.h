@@ -0,0 +1,63 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Stored report configurations: upsert, delete, list and verification against the device
+#ifndef MOD_ZIG_REPORT_H
+#define MOD_ZIG_REPORT_H
+
+#include "py/obj.h"
+#include "mod_zig_types.h"
+
+#define ZIG_REPORT_VERIFY_MAX   8       /* Read Reporting Configuration frames awaiting a response */
+
+// In-sync flag of a verify_reporting() result record
+#define ZIG_REPORT_DRIFT        0       /* Device differs from the stored config */
+#define ZIG_REPORT_IN_SYNC      1       /* Device matches the stored config */
+#define ZIG_REPORT_UNKNOWN      0xFF    /* No stored config for the attribute */
+
+/**
+ * @brief Compare a Read Reporting Configuration response with the stored configs
+ *
+ * Called from the Zigbee task. Records that drifted are configured again
+ * when the read came from verify_reporting(fix=True). The result goes to
+ * MicroPython as status(1) + direction(1) + attr_id(2) + in_sync(1) per record.
+ *
+ * @param message esp_zb_zcl_cmd_read_report_config_resp_message_t
+ */
+void zig_report_verify_resp(const void *message);
+
+/**
+ * @brief Send all stored configs of one cluster to the device
+ *
+ * Called from the Zigbee task, or from MicroPython with ZB_LOCK held.
+ *
+ * @param dev Device with the stored configs
+ * @param ep Endpoint
+ * @param cluster_id Cluster
+ * @param tsns TSN of every frame sent, room for MAX_REPORT_CFGS entries, or NULL
+ * @return size_t Number of frames sent, 0 if nothing is stored for the cluster
+ */
+size_t zig_report_apply(const zigbee_device_t *dev, uint8_t ep, uint16_t cluster_id, uint8_t *tsns);
+
+/**
+ * @brief Bring the reporting of one cluster in line with the stored configs
+ *
+ * A device that never finished an interview gets every stored config
+ * (zig_report_apply). Otherwise one Read Reporting Configuration frame is
+ * sent and only the records that drifted are configured again from
+ * zig_report_verify_resp(). Called from the Zigbee task, or from MicroPython
+ * with ZB_LOCK held.
+ *
+ * @param dev Device with the stored configs
+ * @param ep Endpoint
+ * @param cluster_id Cluster
+ * @param tsns TSN of every frame sent, room for MAX_REPORT_CFGS entries, or NULL
+ * @return size_t Number of frames sent, 0 if nothing is stored for the cluster
+ */
+size_t zig_report_sync(const zigbee_device_t *dev, uint8_t ep, uint16_t cluster_id, uint8_t *tsns);
+
+// Python API function objects
+extern const mp_obj_fun_builtin_var_t esp32_zig_set_report_config_obj;      // Insert or replace a stored config
+extern const mp_obj_fun_builtin_var_t esp32_zig_remove_report_config_obj;   // Delete matching stored configs
+extern const mp_obj_fun_builtin_var_t esp32_zig_report_configs_obj;         // List stored configs
+extern const mp_obj_fun_builtin_var_t esp32_zig_verify_reporting_obj;       // Read Reporting Configuration and diff
+
+#endif // MOD_ZIG_REPORT_H
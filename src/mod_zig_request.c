@@ -0,0 +1,466 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Pending ZCL requests: TSN correlation, timeouts, retries and asyncio awaiting
+#include <string.h>
+
+// FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ESP-IDF headers
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "py/mperrno.h"
+
+//Project headers
+#include "main.h"
+#include "mod_zig_request.h"
+
+#define LOG_TAG "ZIG_REQUEST"
+
+#define REQUEST_RETRIES_MAX 5
+
+enum {
+    SLOT_FREE = 0,
+    SLOT_RESERVED,      // Frame is being sent, TSN not known yet
+    SLOT_PENDING,       // Waiting for the response
+    SLOT_DONE,          // Response received, not collected yet
+};
+
+// Table entry, shared between the Zigbee task and MicroPython
+typedef struct {
+    uint8_t state;
+    uint8_t tsn;
+    uint16_t short_addr;
+    uint16_t signal_type;
+    uint8_t status;
+    uint8_t data_len;
+    bool early;                             // Response caught while RESERVED, TSN checked on arm
+    uint32_t id;                            // Changes on every reuse of the slot
+    int64_t expires_us;                     // Slot may be reclaimed after this time
+    uint8_t data[ZIG_REQUEST_DATA_MAX];     // Payloads, each as len(1) + bytes
+} request_slot_t;
+
+static request_slot_t request_slots[ZIG_REQUEST_MAX];
+static uint32_t request_next_id = 1;
+static portMUX_TYPE request_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// asyncio.sleep_ms, looked up on the first await
+MP_REGISTER_ROOT_POINTER(mp_obj_t zig_request_sleep_ms);
+
+// Request object, owns one slot while pending
+typedef struct {
+    mp_obj_base_t base;
+    mp_obj_t send;              // Function that sent the frame, called again on retry
+    mp_obj_t call_args;         // Positional args followed by key/value pairs
+    mp_obj_t result;            // MP_OBJ_NULL until resolved
+    size_t n_args;
+    size_t n_kw;
+    int64_t deadline_us;
+    uint32_t timeout_ms;
+    uint32_t id;
+    uint16_t short_addr;
+    uint8_t slot;
+    uint8_t tsn;
+    uint8_t attempt;
+    uint8_t retries;
+    bool expired;
+} zig_request_obj_t;
+
+
+// Reserve a slot, reclaiming ones nobody collected in time
+static int request_slot_reserve(uint16_t short_addr, uint32_t *id) {
+    int64_t now = esp_timer_get_time();
+    int slot = -1;
+
+    taskENTER_CRITICAL(&request_lock);
+    for (int i = 0; i < ZIG_REQUEST_MAX; i++) {
+        request_slot_t *s = &request_slots[i];
+        if (s->state == SLOT_FREE || (s->state != SLOT_RESERVED && now > s->expires_us)) {
+            s->state = SLOT_RESERVED;
+            s->short_addr = short_addr;
+            s->data_len = 0;
+            s->early = false;
+            s->id = request_next_id++;
+            *id = s->id;
+            slot = i;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL(&request_lock);
+    return slot;
+}
+
+// Back to RESERVED before a retry, so a response to the new frame is caught early too
+static void request_slot_rewind(uint8_t slot, uint32_t id) {
+    taskENTER_CRITICAL(&request_lock);
+    request_slot_t *s = &request_slots[slot];
+    if (s->id == id && s->state == SLOT_PENDING) {
+        s->state = SLOT_RESERVED;
+        s->data_len = 0;
+        s->early = false;
+    }
+    taskEXIT_CRITICAL(&request_lock);
+}
+
+// Start waiting for the response with this TSN, or keep the one that came in early
+static void request_slot_arm(uint8_t slot, uint32_t id, uint8_t tsn, int64_t expires_us) {
+    taskENTER_CRITICAL(&request_lock);
+    request_slot_t *s = &request_slots[slot];
+    // A retry may find the previous attempt already answered, keep that
+    if (s->id == id && s->state == SLOT_RESERVED) {
+        if (s->early && s->tsn == tsn) {
+            s->state = SLOT_DONE;
+        } else {
+            s->state = SLOT_PENDING;
+            s->tsn = tsn;
+            s->data_len = 0;
+        }
+        s->early = false;
+        s->expires_us = expires_us;
+    }
+    taskEXIT_CRITICAL(&request_lock);
+}
+
+static void request_slot_release(uint8_t slot, uint32_t id) {
+    taskENTER_CRITICAL(&request_lock);
+    if (request_slots[slot].id == id) {
+        request_slots[slot].state = SLOT_FREE;
+    }
+    taskEXIT_CRITICAL(&request_lock);
+}
+
+// Copy out a resolved slot and free it. SLOT_FREE means the slot was reclaimed.
+static uint8_t request_slot_take(uint8_t slot, uint32_t id, request_slot_t *out) {
+    uint8_t state = SLOT_FREE;
+
+    taskENTER_CRITICAL(&request_lock);
+    request_slot_t *s = &request_slots[slot];
+    if (s->id == id) {
+        state = s->state;
+        if (state == SLOT_DONE) {
+            *out = *s;
+            s->state = SLOT_FREE;
+        }
+    }
+    taskEXIT_CRITICAL(&request_lock);
+    return state;
+}
+
+void zig_request_resolve(uint16_t short_addr, uint8_t tsn, uint16_t signal_type, uint8_t status,
+                         const uint8_t *data, uint8_t data_len) {
+    taskENTER_CRITICAL(&request_lock);
+    for (int i = 0; i < ZIG_REQUEST_MAX; i++) {
+        request_slot_t *s = &request_slots[i];
+        if (s->short_addr != short_addr) {
+            continue;
+        }
+        if (s->state == SLOT_RESERVED) {
+            // send() runs unlocked, so the response may beat its TSN here.
+            // Keep the latest one, arm decides whether it was ours.
+            if (!s->early || s->tsn != tsn || s->signal_type != signal_type) {
+                s->early = true;
+                s->tsn = tsn;
+                s->signal_type = signal_type;
+                s->status = status;
+                s->data_len = 0;
+            }
+        } else if (s->tsn != tsn) {
+            continue;
+        } else if (s->state == SLOT_PENDING) {
+            s->state = SLOT_DONE;
+            s->signal_type = signal_type;
+            s->status = status;
+            s->data_len = 0;
+        } else if (s->state != SLOT_DONE || s->signal_type != signal_type) {
+            continue;
+        }
+        // Further messages of the same response append their payload
+        if (data && s->data_len + 1 + data_len <= ZIG_REQUEST_DATA_MAX) {
+            s->data[s->data_len++] = data_len;
+            memcpy(&s->data[s->data_len], data, data_len);
+            s->data_len += data_len;
+        }
+        break;
+    }
+    taskEXIT_CRITICAL(&request_lock);
+}
+
+
+// Result tuple: (signal_type, status, [payload, ...]) with payloads as delivered by recv()
+static mp_obj_t request_build_result(const request_slot_t *s) {
+    mp_obj_t payloads = mp_obj_new_list(0, NULL);
+    size_t pos = 0;
+    while (pos < s->data_len) {
+        uint8_t len = s->data[pos++];
+        mp_obj_list_append(payloads, mp_obj_new_bytes(&s->data[pos], len));
+        pos += len;
+    }
+    mp_obj_t items[3] = {
+        MP_OBJ_NEW_SMALL_INT(s->signal_type),
+        MP_OBJ_NEW_SMALL_INT(s->status),
+        payloads,
+    };
+    return mp_obj_new_tuple(3, items);
+}
+
+// Send the frame and start waiting for its response.
+// send() takes the stack lock itself and is called without it held. A response that
+// arrives before the TSN is known is kept by the RESERVED slot and matched on arm.
+static void request_transmit(zig_request_obj_t *self) {
+    nlr_buf_t nlr;
+    request_slot_rewind(self->slot, self->id);
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_tuple_t *call_args = MP_OBJ_TO_PTR(self->call_args);
+        mp_obj_t ret = mp_call_function_n_kw(self->send, self->n_args, self->n_kw, call_args->items);
+        if (!mp_obj_is_int(ret)) {
+            mp_raise_ValueError(MP_ERROR_TEXT("send must return a single TSN"));
+        }
+        self->tsn = mp_obj_get_int(ret);
+        self->deadline_us = esp_timer_get_time() + ((int64_t)self->timeout_ms << self->attempt) * 1000;
+        request_slot_arm(self->slot, self->id, self->tsn, self->deadline_us + (int64_t)ZIG_REQUEST_GRACE_MS * 1000);
+        nlr_pop();
+    } else {
+        request_slot_release(self->slot, self->id);
+        self->expired = true;
+        nlr_jump(nlr.ret_val);
+    }
+}
+
+// Collect the response, or expire / retry once the deadline has passed
+static void request_poll(zig_request_obj_t *self) {
+    if (self->result != MP_OBJ_NULL || self->expired) {
+        return;
+    }
+
+    request_slot_t slot;
+    uint8_t state = request_slot_take(self->slot, self->id, &slot);
+    if (state == SLOT_DONE) {
+        self->result = request_build_result(&slot);
+        return;
+    }
+    if (state == SLOT_FREE) {
+        self->expired = true;
+        return;
+    }
+    if (esp_timer_get_time() < self->deadline_us) {
+        return;
+    }
+
+    if (self->attempt < self->retries) {
+        self->attempt++;
+        ESP_LOGI(LOG_TAG, "Retry %u/%u to 0x%04x (tsn %u)", self->attempt, self->retries, self->short_addr, self->tsn);
+        request_transmit(self);
+        return;
+    }
+
+    ESP_LOGW(LOG_TAG, "Request to 0x%04x timed out (tsn %u)", self->short_addr, self->tsn);
+    request_slot_release(self->slot, self->id);
+    self->expired = true;
+}
+
+
+// done() - response received or request expired
+static mp_obj_t zig_request_done(mp_obj_t self_in) {
+    zig_request_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    request_poll(self);
+    return mp_obj_new_bool(self->result != MP_OBJ_NULL || self->expired);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(zig_request_done_obj, zig_request_done);
+
+// result() - response tuple, None while pending, OSError(ETIMEDOUT) when expired
+static mp_obj_t zig_request_result(mp_obj_t self_in) {
+    zig_request_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    request_poll(self);
+    if (self->result != MP_OBJ_NULL) {
+        return self->result;
+    }
+    if (self->expired) {
+        mp_raise_OSError(MP_ETIMEDOUT);
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(zig_request_result_obj, zig_request_result);
+
+// cancel() - stop waiting, a late response is ignored
+static mp_obj_t zig_request_cancel(mp_obj_t self_in) {
+    zig_request_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->result == MP_OBJ_NULL && !self->expired) {
+        request_slot_release(self->slot, self->id);
+        self->expired = true;
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(zig_request_cancel_obj, zig_request_cancel);
+
+// await support: poll, and while pending park the task in asyncio for a poll period
+static mp_obj_t zig_request_iternext(mp_obj_t self_in) {
+    zig_request_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    request_poll(self);
+    if (self->result != MP_OBJ_NULL) {
+        return mp_make_stop_iteration(self->result);
+    }
+    if (self->expired) {
+        mp_raise_OSError(MP_ETIMEDOUT);
+    }
+
+    int64_t left_ms = (self->deadline_us - esp_timer_get_time()) / 1000;
+    mp_int_t poll_ms = left_ms < ZIG_REQUEST_POLL_MS ? (left_ms > 0 ? left_ms : 0) : ZIG_REQUEST_POLL_MS;
+    if (MP_STATE_PORT(zig_request_sleep_ms) == MP_OBJ_NULL) {
+        mp_obj_t asyncio = mp_import_name(MP_QSTR_asyncio, mp_const_none, MP_OBJ_NEW_SMALL_INT(0));
+        MP_STATE_PORT(zig_request_sleep_ms) = mp_load_attr(asyncio, MP_QSTR_sleep_ms);
+    }
+    mp_obj_t sleep = mp_call_function_1(MP_STATE_PORT(zig_request_sleep_ms), MP_OBJ_NEW_SMALL_INT(poll_ms));
+    return mp_iternext(sleep);
+}
+
+static void zig_request_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
+    if (dest[0] != MP_OBJ_NULL) {
+        return;
+    }
+    zig_request_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (attr == MP_QSTR_tsn) {
+        dest[0] = MP_OBJ_NEW_SMALL_INT(self->tsn);
+    } else if (attr == MP_QSTR_addr) {
+        dest[0] = MP_OBJ_NEW_SMALL_INT(self->short_addr);
+    } else if (attr == MP_QSTR_attempt) {
+        dest[0] = MP_OBJ_NEW_SMALL_INT(self->attempt);
+    } else {
+        // Methods from locals dict
+        dest[1] = MP_OBJ_SENTINEL;
+    }
+}
+
+static void zig_request_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    zig_request_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    const char *state = self->result != MP_OBJ_NULL ? "done" : (self->expired ? "expired" : "pending");
+    mp_printf(print, "<Request addr=0x%04x tsn=%u %s>", self->short_addr, self->tsn, state);
+}
+
+static const mp_rom_map_elem_t zig_request_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_done),   MP_ROM_PTR(&zig_request_done_obj)   },
+    { MP_ROM_QSTR(MP_QSTR_result), MP_ROM_PTR(&zig_request_result_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cancel), MP_ROM_PTR(&zig_request_cancel_obj) },
+};
+static MP_DEFINE_CONST_DICT(zig_request_locals_dict, zig_request_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    zig_request_type,
+    MP_QSTR_Request,
+    MP_TYPE_FLAG_ITER_IS_ITERNEXT,
+    iter, zig_request_iternext,
+    attr, zig_request_attr,
+    print, zig_request_print,
+    locals_dict, &zig_request_locals_dict
+);
+
+
+mp_obj_t zig_call_pack(size_t n_args, const mp_obj_t *args, mp_map_t *kw_args,
+                       const qstr *own, size_t n_own, mp_obj_t *own_values, size_t *n_kw, uint16_t *addr) {
+    mp_obj_t addr_obj = n_args > 0 ? args[0] : MP_OBJ_NULL;
+
+    // Own keywords are handed back, the rest is packed for send
+    size_t send_n_kw = 0;
+    for (size_t i = 0; i < kw_args->alloc; i++) {
+        if (!mp_map_slot_is_filled(kw_args, i)) {
+            continue;
+        }
+        bool is_own = false;
+        for (size_t j = 0; j < n_own; j++) {
+            if (kw_args->table[i].key == MP_OBJ_NEW_QSTR(own[j])) {
+                own_values[j] = kw_args->table[i].value;
+                is_own = true;
+            }
+        }
+        if (!is_own) {
+            send_n_kw++;
+        }
+    }
+
+    mp_obj_tuple_t *call_args = MP_OBJ_TO_PTR(mp_obj_new_tuple(n_args + 2 * send_n_kw, NULL));
+    memcpy(call_args->items, args, n_args * sizeof(mp_obj_t));
+    mp_obj_t *kw_items = call_args->items + n_args;
+    for (size_t i = 0; i < kw_args->alloc; i++) {
+        if (!mp_map_slot_is_filled(kw_args, i)) {
+            continue;
+        }
+        mp_obj_t key = kw_args->table[i].key;
+        bool is_own = false;
+        for (size_t j = 0; j < n_own; j++) {
+            is_own |= key == MP_OBJ_NEW_QSTR(own[j]);
+        }
+        if (is_own) {
+            continue;
+        }
+        if (key == MP_OBJ_NEW_QSTR(MP_QSTR_addr)) {
+            addr_obj = kw_args->table[i].value;
+        }
+        *kw_items++ = key;
+        *kw_items++ = kw_args->table[i].value;
+    }
+    if (addr_obj == MP_OBJ_NULL) {
+        mp_raise_TypeError(MP_ERROR_TEXT("addr required"));
+    }
+
+    *n_kw = send_n_kw;
+    *addr = mp_obj_get_int(addr_obj);
+    return MP_OBJ_FROM_PTR(call_args);
+}
+
+// request(send, *args, timeout=3000, retries=0, **kwargs)
+// Calls send(*args, **kwargs), which must return a single TSN (send_command, read_attr,
+// write_attr, configure_report), and returns a Request tracking its response.
+// Destination is the addr keyword or the first positional argument.
+static mp_obj_t esp32_zig_request(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    mp_arg_check_num(n_args, kw_args->used, 2, MP_OBJ_FUN_ARGS_MAX, true);
+
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+
+    // Check if network is formed
+    if (!self->config->network_formed) {
+        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
+        return mp_const_none;
+    }
+
+    static const qstr own[] = { MP_QSTR_timeout, MP_QSTR_retries };
+    mp_obj_t own_values[MP_ARRAY_SIZE(own)] = { MP_OBJ_NULL, MP_OBJ_NULL };
+    size_t send_n_kw;
+    uint16_t short_addr;
+    mp_obj_t call_args = zig_call_pack(n_args - 2, pos_args + 2, kw_args, own, MP_ARRAY_SIZE(own),
+                                       own_values, &send_n_kw, &short_addr);
+
+    mp_int_t timeout_ms = own_values[0] != MP_OBJ_NULL ? mp_obj_get_int(own_values[0]) : ZIG_REQUEST_TIMEOUT_MS;
+    mp_int_t retries = own_values[1] != MP_OBJ_NULL ? mp_obj_get_int(own_values[1]) : 0;
+    if (timeout_ms <= 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("timeout must be positive"));
+    }
+    if (retries < 0 || retries > REQUEST_RETRIES_MAX) {
+        mp_raise_ValueError(MP_ERROR_TEXT("retries out of range"));
+    }
+
+    zig_request_obj_t *req = mp_obj_malloc(zig_request_obj_t, &zig_request_type);
+    req->send = pos_args[1];
+    req->call_args = call_args;
+    req->result = MP_OBJ_NULL;
+    req->n_args = n_args - 2;
+    req->n_kw = send_n_kw;
+    req->timeout_ms = timeout_ms;
+    req->short_addr = short_addr;
+    req->tsn = 0;
+    req->attempt = 0;
+    req->retries = retries;
+    req->expired = false;
+
+    int slot = request_slot_reserve(req->short_addr, &req->id);
+    if (slot < 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Too many pending requests"));
+    }
+    req->slot = slot;
+
+    request_transmit(req);
+    return MP_OBJ_FROM_PTR(req);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_request_obj, 1, esp32_zig_request);
@@ -0,0 +1,57 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Pending ZCL requests tracked by (short address, TSN)
+#ifndef MOD_ZIG_REQUEST_H
+#define MOD_ZIG_REQUEST_H
+
+#include "py/obj.h"
+#include "mod_zig_types.h"
+
+#define ZIG_REQUEST_MAX          16         /* Outstanding tracked requests */
+#define ZIG_REQUEST_DATA_MAX     128        /* Response payload kept per request */
+#define ZIG_REQUEST_TIMEOUT_MS   3000       /* Default response timeout */
+#define ZIG_REQUEST_POLL_MS      20         /* asyncio poll period while pending */
+#define ZIG_REQUEST_GRACE_MS     30000      /* Unclaimed slot lifetime past its deadline */
+
+/**
+ * @brief Resolve the pending request matching a ZCL response
+ *
+ * Called from the Zigbee task. Responses split into several messages
+ * (one per attribute) are appended to the same request.
+ *
+ * @param short_addr Source address of the response
+ * @param tsn Transaction sequence number of the response
+ * @param signal_type Action callback id of the response
+ * @param status ZCL status of the response
+ * @param data Payload as delivered by recv()
+ * @param data_len Length of payload
+ */
+void zig_request_resolve(uint16_t short_addr, uint8_t tsn, uint16_t signal_type, uint8_t status,
+                         const uint8_t *data, uint8_t data_len);
+
+/**
+ * @brief Pack arguments of a deferred send(*args, **kwargs) call
+ *
+ * Keywords listed in own are taken out and returned in own_values
+ * (left untouched when absent). Destination is the addr keyword or
+ * the first positional argument, TypeError if there is none.
+ *
+ * @param n_args Number of positional arguments for send
+ * @param args Positional arguments for send
+ * @param kw_args Keyword arguments, own and for send
+ * @param own Keywords consumed by the caller
+ * @param n_own Number of own keywords
+ * @param own_values Values of own keywords
+ * @param n_kw Number of keyword arguments packed for send
+ * @param addr Destination short address
+ * @return mp_obj_t Tuple of positional args followed by key/value pairs
+ */
+mp_obj_t zig_call_pack(size_t n_args, const mp_obj_t *args, mp_map_t *kw_args,
+                       const qstr *own, size_t n_own, mp_obj_t *own_values, size_t *n_kw, uint16_t *addr);
+
+// Request object returned by zig.request()
+extern const mp_obj_type_t zig_request_type;
+
+// request(send, *args, timeout=3000, retries=0, **kwargs)
+extern const mp_obj_fun_builtin_var_t esp32_zig_request_obj;
+
+#endif // MOD_ZIG_REQUEST_H
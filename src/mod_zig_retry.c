@@ -0,0 +1,324 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Retry with exponential backoff for interview steps and binds
+#include <string.h>
+
+// FreeRTOS headers
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// ESP-IDF headers
+#include "esp_log.h"
+#include "esp_random.h"
+
+// Zigbee headers
+#include "esp_zigbee_core.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+
+//Project headers
+#include "main.h"
+#include "mod_zig_retry.h"
+#include "mod_zig_handlers.h"
+#include "mod_zig_msg.h"
+#include "mod_zig_interview.h"
+#include "device_manager.h"
+
+#define LOG_TAG "ZIG_RETRY"
+
+// Alarm parameter: slot in the low nibble, slot generation in the high one.
+// An alarm armed for an earlier use of a slot finds another generation and is dropped.
+_Static_assert(ZIG_RETRY_SLOTS <= 16, "retry slot index must fit the alarm parameter nibble");
+#define RETRY_ALARM_PARAM(slot, gen)    ((uint8_t)(((gen) & 0x0F) << 4 | (slot)))
+
+// Step that failed at least once, written by the Zigbee task and read from MicroPython
+typedef struct {
+    uint16_t short_addr;
+    uint16_t cluster_id;
+    uint8_t endpoint;
+    uint8_t step;
+    uint8_t attempt;        /* Retries sent so far */
+    uint8_t gen;            /* Bumped on every new use of the slot, see RETRY_ALARM_PARAM */
+    bool in_use;
+} retry_slot_t;
+
+// Attempts spent per device since it last announced
+typedef struct {
+    uint16_t short_addr;
+    uint8_t used;
+    bool in_use;
+    uint32_t stamp;         /* Last take, for eviction */
+} retry_budget_t;
+
+static retry_slot_t retry_slots[ZIG_RETRY_SLOTS];
+static retry_budget_t retry_budgets[ZIG_RETRY_DEVICES];
+static uint32_t retry_budget_clock;
+static portMUX_TYPE retry_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static struct {
+    uint32_t scheduled;     /* Retries armed */
+    uint32_t recovered;     /* Steps that succeeded after a retry */
+    uint32_t gave_up;       /* Steps abandoned */
+} retry_stats;
+
+static void retry_alarm_cb(uint8_t param);
+
+
+// Caller holds retry_lock
+static retry_slot_t *retry_find(zig_retry_step_t step, uint16_t short_addr, uint8_t endpoint, uint16_t cluster_id) {
+    for (int i = 0; i < ZIG_RETRY_SLOTS; i++) {
+        retry_slot_t *s = &retry_slots[i];
+        if (s->in_use && s->step == step && s->short_addr == short_addr &&
+            s->endpoint == endpoint && s->cluster_id == cluster_id) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+// Caller holds retry_lock
+static bool retry_device_waiting(uint16_t short_addr) {
+    for (int i = 0; i < ZIG_RETRY_SLOTS; i++) {
+        if (retry_slots[i].in_use && retry_slots[i].short_addr == short_addr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Caller holds retry_lock. Takes one attempt from the device budget, false only if spent.
+// A full table gives up the least recently used device with nothing waiting: its steps
+// all finished, the budget only limits retries within one run.
+static bool retry_budget_take(uint16_t short_addr) {
+    retry_budget_t *free_budget = NULL;
+    retry_budget_t *idle = NULL;
+    retry_budget_t *oldest = NULL;
+    for (int i = 0; i < ZIG_RETRY_DEVICES; i++) {
+        retry_budget_t *b = &retry_budgets[i];
+        if (!b->in_use) {
+            free_budget = free_budget ? free_budget : b;
+            continue;
+        }
+        if (b->short_addr == short_addr) {
+            if (b->used >= ZIG_RETRY_BUDGET) {
+                return false;
+            }
+            b->used++;
+            b->stamp = ++retry_budget_clock;
+            return true;
+        }
+        if (!oldest || b->stamp < oldest->stamp) {
+            oldest = b;
+        }
+        if ((!idle || b->stamp < idle->stamp) && !retry_device_waiting(b->short_addr)) {
+            idle = b;
+        }
+    }
+
+    // Every tracked device with a step waiting only happens with more devices than slots
+    retry_budget_t *entry = free_budget ? free_budget : idle ? idle : oldest;
+    entry->short_addr = short_addr;
+    entry->used = 1;
+    entry->in_use = true;
+    entry->stamp = ++retry_budget_clock;
+    return true;
+}
+
+// Exponential backoff with equal jitter: half of the delay is fixed, half is random
+static uint32_t retry_delay_ms(uint8_t attempt) {
+    uint32_t delay = ZIG_RETRY_BASE_MS;
+    for (uint8_t i = 1; i < attempt && delay < ZIG_RETRY_CAP_MS; i++) {
+        delay <<= 1;
+    }
+    if (delay > ZIG_RETRY_CAP_MS) {
+        delay = ZIG_RETRY_CAP_MS;
+    }
+    return delay / 2 + esp_random() % (delay / 2 + 1);
+}
+
+static void retry_event(uint8_t msg_py, zig_retry_step_t step, uint16_t short_addr, uint8_t endpoint,
+                        uint16_t cluster_id, uint8_t attempt, uint8_t status, uint32_t delay_ms) {
+    uint8_t data[6] = {
+        attempt,
+        status,
+        delay_ms & 0xFF,
+        (delay_ms >> 8) & 0xFF,
+        (delay_ms >> 16) & 0xFF,
+        (delay_ms >> 24) & 0xFF,
+    };
+    send_msg_to_micropython_queue(msg_py, step, short_addr, endpoint, cluster_id,
+                                  data, msg_py == ZIG_MSG_RETRY ? 6 : 2);
+}
+
+bool zig_retry_failed(zig_retry_step_t step, uint16_t short_addr, uint8_t endpoint, uint16_t cluster_id, uint8_t status) {
+    int index = -1;
+    uint8_t attempt = 0;
+    uint8_t gen = 0;
+    bool budget = false;
+
+    taskENTER_CRITICAL(&retry_lock);
+    retry_slot_t *s = retry_find(step, short_addr, endpoint, cluster_id);
+    if (!s) {
+        for (int i = 0; i < ZIG_RETRY_SLOTS; i++) {
+            if (!retry_slots[i].in_use) {
+                s = &retry_slots[i];
+                s->step = step;
+                s->short_addr = short_addr;
+                s->endpoint = endpoint;
+                s->cluster_id = cluster_id;
+                s->attempt = 0;
+                s->gen++;
+                s->in_use = true;
+                break;
+            }
+        }
+    }
+    if (s) {
+        index = s - retry_slots;
+        attempt = s->attempt;
+        gen = s->gen;
+        budget = s->attempt < ZIG_RETRY_STEP_MAX && retry_budget_take(short_addr);
+        if (budget) {
+            s->attempt++;
+            retry_stats.scheduled++;
+        } else {
+            s->in_use = false;
+            retry_stats.gave_up++;
+        }
+    } else {
+        retry_stats.gave_up++;
+    }
+    taskEXIT_CRITICAL(&retry_lock);
+
+    if (!budget) {
+        ESP_LOGW(LOG_TAG, "Give up step %d of 0x%04x ep=%u cl=0x%04x after %u retries, status=%d%s",
+                 step, short_addr, endpoint, cluster_id, attempt, status, index < 0 ? " (no free slot)" : "");
+        retry_event(ZIG_MSG_RETRY_GIVE_UP, step, short_addr, endpoint, cluster_id, attempt, status, 0);
+        zig_interview_step_failed(step, short_addr, endpoint, cluster_id);
+        return false;
+    }
+
+    uint32_t delay_ms = retry_delay_ms(attempt + 1);
+    esp_zb_scheduler_alarm((esp_zb_callback_t)retry_alarm_cb, RETRY_ALARM_PARAM(index, gen), delay_ms);
+    ESP_LOGI(LOG_TAG, "Retry %u of step %d for 0x%04x ep=%u cl=0x%04x in %lu ms, status=%d",
+             attempt + 1, step, short_addr, endpoint, cluster_id, (unsigned long)delay_ms, status);
+    retry_event(ZIG_MSG_RETRY, step, short_addr, endpoint, cluster_id, attempt + 1, status, delay_ms);
+    return true;
+}
+
+void zig_retry_done(zig_retry_step_t step, uint16_t short_addr, uint8_t endpoint, uint16_t cluster_id) {
+    taskENTER_CRITICAL(&retry_lock);
+    retry_slot_t *s = retry_find(step, short_addr, endpoint, cluster_id);
+    if (s) {
+        s->in_use = false;
+        retry_stats.recovered++;
+    }
+    taskEXIT_CRITICAL(&retry_lock);
+}
+
+void zig_retry_reset(uint16_t short_addr) {
+    taskENTER_CRITICAL(&retry_lock);
+    for (int i = 0; i < ZIG_RETRY_SLOTS; i++) {
+        if (retry_slots[i].in_use && retry_slots[i].short_addr == short_addr) {
+            retry_slots[i].in_use = false;
+            // Alarms of freed slots find nothing to send, or another generation once reused
+        }
+    }
+    for (int i = 0; i < ZIG_RETRY_DEVICES; i++) {
+        if (retry_budgets[i].in_use && retry_budgets[i].short_addr == short_addr) {
+            retry_budgets[i].in_use = false;
+        }
+    }
+    taskEXIT_CRITICAL(&retry_lock);
+}
+
+// Zigbee task: send the step again
+static void retry_alarm_cb(uint8_t param) {
+    uint8_t slot = param & 0x0F;
+    if (slot >= ZIG_RETRY_SLOTS) {
+        return;
+    }
+
+    taskENTER_CRITICAL(&retry_lock);
+    retry_slot_t s = retry_slots[slot];
+    taskEXIT_CRITICAL(&retry_lock);
+
+    if (!s.in_use || RETRY_ALARM_PARAM(slot, s.gen) != param) {
+        return;
+    }
+
+    zigbee_device_t *device = device_manager_get(s.short_addr);
+    if (!device) {
+        ESP_LOGW(LOG_TAG, "Device 0x%04x left, retry dropped", s.short_addr);
+        zig_retry_reset(s.short_addr);
+        zig_interview_step_failed(s.step, s.short_addr, s.endpoint, s.cluster_id);
+        return;
+    }
+
+    switch (s.step) {
+        case ZIG_RETRY_ACTIVE_EP:
+            zig_request_active_ep(s.short_addr);
+            break;
+        case ZIG_RETRY_SIMPLE_DESC:
+            if (!zig_request_simple_desc(s.short_addr, s.endpoint)) {
+                zig_retry_done(s.step, s.short_addr, s.endpoint, s.cluster_id);
+                zig_interview_step_failed(s.step, s.short_addr, s.endpoint, s.cluster_id);
+            }
+            break;
+        case ZIG_RETRY_BIND:
+            zig_request_bind(device, s.endpoint, s.cluster_id);
+            break;
+        default:
+            break;
+    }
+}
+
+
+// retries(reset=False)
+// Pending retries as (step, addr, ep, cluster, attempt) and counters
+static mp_obj_t esp32_zig_retries(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_reset };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_reset, MP_ARG_BOOL, {.u_bool = false} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    // Copy under the lock, build objects without it
+    retry_slot_t snapshot[ZIG_RETRY_SLOTS];
+    taskENTER_CRITICAL(&retry_lock);
+    memcpy(snapshot, retry_slots, sizeof(snapshot));
+    uint32_t scheduled = retry_stats.scheduled;
+    uint32_t recovered = retry_stats.recovered;
+    uint32_t gave_up = retry_stats.gave_up;
+    if (args[ARG_reset].u_bool) {
+        memset(&retry_stats, 0, sizeof(retry_stats));
+    }
+    taskEXIT_CRITICAL(&retry_lock);
+
+    mp_obj_t pending = mp_obj_new_list(0, NULL);
+    for (int i = 0; i < ZIG_RETRY_SLOTS; i++) {
+        retry_slot_t *s = &snapshot[i];
+        if (!s->in_use) {
+            continue;
+        }
+        mp_obj_t item[5] = {
+            MP_OBJ_NEW_SMALL_INT(s->step),
+            MP_OBJ_NEW_SMALL_INT(s->short_addr),
+            MP_OBJ_NEW_SMALL_INT(s->endpoint),
+            MP_OBJ_NEW_SMALL_INT(s->cluster_id),
+            MP_OBJ_NEW_SMALL_INT(s->attempt),
+        };
+        mp_obj_list_append(pending, mp_obj_new_tuple(5, item));
+    }
+
+    mp_obj_t dict = mp_obj_new_dict(4);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_pending), pending);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_scheduled), mp_obj_new_int_from_uint(scheduled));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_recovered), mp_obj_new_int_from_uint(recovered));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_gave_up), mp_obj_new_int_from_uint(gave_up));
+    return dict;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_retries_obj, 1, esp32_zig_retries);
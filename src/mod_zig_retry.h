@@ -0,0 +1,57 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Retry with exponential backoff for interview steps and binds
+#ifndef MOD_ZIG_RETRY_H
+#define MOD_ZIG_RETRY_H
+
+#include "py/obj.h"
+#include "mod_zig_types.h"
+
+#define ZIG_RETRY_SLOTS         16      /* Steps waiting for a retry at once */
+#define ZIG_RETRY_DEVICES       16      /* Devices with a tracked attempt budget */
+#define ZIG_RETRY_STEP_MAX      5       /* Attempts of one step before giving up */
+#define ZIG_RETRY_BUDGET        20      /* Attempts of all steps of one device until it announces again */
+#define ZIG_RETRY_BASE_MS       1000    /* Delay before the first retry */
+#define ZIG_RETRY_CAP_MS        60000   /* Longest delay between retries */
+
+// Retried steps, also the signal_type of ZIG_MSG_RETRY / ZIG_MSG_RETRY_GIVE_UP
+typedef enum {
+    ZIG_RETRY_ACTIVE_EP   = 0,  /* Active_EP_req */
+    ZIG_RETRY_SIMPLE_DESC = 1,  /* Simple_Desc_req of one endpoint */
+    ZIG_RETRY_BIND        = 2,  /* Bind_req of one cluster, reporting is configured again on success */
+} zig_retry_step_t;
+
+/**
+ * @brief Step failed, schedule it again or give up
+ *
+ * Called from the Zigbee task. The delay doubles with every attempt up to
+ * ZIG_RETRY_CAP_MS, half of it is random. MicroPython gets ZIG_MSG_RETRY with
+ * attempt(1) + status(1) + delay_ms(4), or ZIG_MSG_RETRY_GIVE_UP with
+ * attempt(1) + status(1) once the step or device budget is spent.
+ *
+ * @param step Failed step
+ * @param short_addr Device address
+ * @param endpoint Endpoint, 0 for ZIG_RETRY_ACTIVE_EP
+ * @param cluster_id Cluster, 0 unless ZIG_RETRY_BIND
+ * @param status ZDP status of the failure
+ * @return true if a retry was scheduled
+ */
+bool zig_retry_failed(zig_retry_step_t step, uint16_t short_addr, uint8_t endpoint, uint16_t cluster_id, uint8_t status);
+
+/**
+ * @brief Step succeeded, forget its attempts
+ *
+ * Called from the Zigbee task.
+ */
+void zig_retry_done(zig_retry_step_t step, uint16_t short_addr, uint8_t endpoint, uint16_t cluster_id);
+
+/**
+ * @brief Device announced itself: cancel its pending retries and refill its budget
+ *
+ * Called from the Zigbee task.
+ */
+void zig_retry_reset(uint16_t short_addr);
+
+// Python API function objects
+extern const mp_obj_fun_builtin_var_t esp32_zig_retries_obj;         // Pending retries and counters
+
+#endif // MOD_ZIG_RETRY_H
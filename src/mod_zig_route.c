@@ -0,0 +1,205 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Many-to-one routing (concentrator mode) and route failure statistics
+//
+// As a concentrator the gateway broadcasts a many-to-one route request every
+// interval. Routers then keep one route towards it instead of discovering it
+// each on their own, send a route record with their first frame, and the
+// gateway answers along that source route. Route failures from the NLME status
+// indication are counted per kind and per destination; a broken many-to-one
+// or source route gets a new route request without waiting for the interval.
+// Everything here runs in the Zigbee task, or in MicroPython under ZB_LOCK.
+#include <string.h>
+
+// ESP-IDF headers
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Zigbee headers
+#include "esp_zigbee_core.h"
+#include "zboss_api.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+
+//Project headers
+#include "main.h"
+#include "mod_zig_route.h"
+
+#define LOG_TAG "ZIG_ROUTE"
+
+// Failures of one destination
+typedef struct {
+    uint16_t short_addr;
+    uint16_t failures;
+    bool in_use;
+} route_addr_t;
+
+typedef struct {
+    uint32_t requests;              /* Many-to-one route requests started by the gateway */
+    uint32_t repairs;               /* Of those, sent right after a failure */
+    uint32_t no_route;
+    uint32_t link_failures;         /* Tree, non-tree and parent link failures */
+    uint32_t source_route_failures;
+    uint32_t many_to_one_failures;
+    uint32_t address_conflicts;
+    uint32_t other;
+    uint8_t last_status;
+    uint16_t last_addr;
+    uint32_t last_ms;               /* Time of the last status, 0 if none */
+} route_stats_t;
+
+static bool route_enabled;
+static bool route_running;
+static uint32_t route_interval_s = ZIG_CONCENTRATOR_INTERVAL_S;
+static uint32_t route_request_ms;   // Time of the last route request
+static route_stats_t route_stats;
+static route_addr_t route_addrs[ZIG_ROUTE_ADDRS];
+
+
+static uint32_t route_now_ms(void) {
+    return esp_timer_get_time() / 1000;
+}
+
+// Sends a many-to-one route request now and every interval after
+static void route_request(void) {
+    zb_start_concentrator_mode(ZIG_CONCENTRATOR_RADIUS, route_interval_s);
+    route_request_ms = route_now_ms();
+    route_stats.requests++;
+}
+
+void zig_route_configure(bool enabled, uint32_t interval_s) {
+    route_enabled = enabled;
+    route_interval_s = interval_s;
+    ESP_LOGI(LOG_TAG, "Concentrator %s, route request every %lu s", enabled ? "on" : "off", (unsigned long)interval_s);
+}
+
+void zig_route_start(void) {
+    if (!route_enabled || route_running) {
+        return;
+    }
+    route_running = true;
+    route_request();
+    ESP_LOGI(LOG_TAG, "Concentrator started");
+}
+
+// Busiest entries stay, a new destination replaces the one with the fewest failures
+static void route_count_addr(uint16_t short_addr) {
+    route_addr_t *slot = &route_addrs[0];
+    for (int i = 0; i < ZIG_ROUTE_ADDRS; i++) {
+        route_addr_t *a = &route_addrs[i];
+        if (a->in_use && a->short_addr == short_addr) {
+            a->failures++;
+            return;
+        }
+        if (slot->in_use && (!a->in_use || a->failures < slot->failures)) {
+            slot = a;
+        }
+    }
+    slot->short_addr = short_addr;
+    slot->failures = 1;
+    slot->in_use = true;
+}
+
+void zig_route_status(uint8_t status, uint16_t short_addr) {
+    bool route_failure = true;
+    switch (status) {
+        case ZB_NWK_COMMAND_STATUS_NO_ROUTE_AVAILABLE:
+            route_stats.no_route++;
+            break;
+        case ZB_NWK_COMMAND_STATUS_TREE_LINK_FAILURE:
+        case ZB_NWK_COMMAND_STATUS_NONE_TREE_LINK_FAILURE:
+        case ZB_NWK_COMMAND_STATUS_PARENT_LINK_FAILURE:
+            route_stats.link_failures++;
+            break;
+        case ZB_NWK_COMMAND_STATUS_SOURCE_ROUTE_FAILURE:
+            route_stats.source_route_failures++;
+            break;
+        case ZB_NWK_COMMAND_STATUS_MANY_TO_ONE_ROUTE_FAILURE:
+            route_stats.many_to_one_failures++;
+            break;
+        case ZB_NWK_COMMAND_STATUS_ADDRESS_CONFLICT:
+            route_stats.address_conflicts++;
+            route_failure = false;
+            break;
+        default:
+            route_stats.other++;
+            route_failure = false;
+            break;
+    }
+    route_stats.last_status = status;
+    route_stats.last_addr = short_addr;
+    route_stats.last_ms = route_now_ms();
+    if (route_failure) {
+        route_count_addr(short_addr);
+    }
+
+    // Routes towards the gateway broke: rebuild them now instead of at the next interval
+    if (route_running && (status == ZB_NWK_COMMAND_STATUS_SOURCE_ROUTE_FAILURE ||
+                          status == ZB_NWK_COMMAND_STATUS_MANY_TO_ONE_ROUTE_FAILURE) &&
+        route_now_ms() - route_request_ms >= ZIG_ROUTE_REPAIR_MIN_MS) {
+        ESP_LOGI(LOG_TAG, "Route failure towards 0x%04x, new many-to-one route request", short_addr);
+        route_request();
+        route_stats.repairs++;
+    }
+}
+
+
+// route_stats(clear=False)
+// Concentrator state, failure counts by kind and by destination
+static mp_obj_t esp32_zig_route_stats(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_clear };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_clear, MP_ARG_BOOL, {.u_bool = false} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    // Copy under the lock, build objects without it
+    route_stats_t stats;
+    route_addr_t addrs[ZIG_ROUTE_ADDRS];
+    ZB_LOCK();
+    stats = route_stats;
+    memcpy(addrs, route_addrs, sizeof(addrs));
+    bool running = route_running;
+    uint32_t interval_s = route_interval_s;
+    if (args[ARG_clear].u_bool) {
+        memset(&route_stats, 0, sizeof(route_stats));
+        memset(route_addrs, 0, sizeof(route_addrs));
+    }
+    ZB_UNLOCK();
+
+    mp_obj_t failures = mp_obj_new_dict(0);
+    for (int i = 0; i < ZIG_ROUTE_ADDRS; i++) {
+        if (addrs[i].in_use) {
+            mp_obj_dict_store(failures, MP_OBJ_NEW_SMALL_INT(addrs[i].short_addr), MP_OBJ_NEW_SMALL_INT(addrs[i].failures));
+        }
+    }
+
+    mp_obj_t last = mp_const_none;
+    if (stats.last_ms) {
+        mp_obj_t item[3] = {
+            MP_OBJ_NEW_SMALL_INT(stats.last_status),
+            MP_OBJ_NEW_SMALL_INT(stats.last_addr),
+            mp_obj_new_int_from_uint(route_now_ms() - stats.last_ms),
+        };
+        last = mp_obj_new_tuple(3, item);
+    }
+
+    mp_obj_t dict = mp_obj_new_dict(13);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_concentrator), mp_obj_new_bool(running));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_interval), mp_obj_new_int_from_uint(interval_s));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_requests), mp_obj_new_int_from_uint(stats.requests));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_repairs), mp_obj_new_int_from_uint(stats.repairs));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_no_route), mp_obj_new_int_from_uint(stats.no_route));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_link_failures), mp_obj_new_int_from_uint(stats.link_failures));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_source_route_failures), mp_obj_new_int_from_uint(stats.source_route_failures));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_many_to_one_failures), mp_obj_new_int_from_uint(stats.many_to_one_failures));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_address_conflicts), mp_obj_new_int_from_uint(stats.address_conflicts));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_other), mp_obj_new_int_from_uint(stats.other));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_failures), failures);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_last), last);
+    return dict;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_route_stats_obj, 1, esp32_zig_route_stats);
@@ -0,0 +1,44 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Many-to-one routing (concentrator mode) and route failure statistics
+#ifndef MOD_ZIG_ROUTE_H
+#define MOD_ZIG_ROUTE_H
+
+#include "py/obj.h"
+
+#define ZIG_CONCENTRATOR_INTERVAL_S     60      /* Default pause between many-to-one route requests */
+#define ZIG_CONCENTRATOR_RADIUS         0       /* Route request radius, 0 = stack default (twice the max depth) */
+#define ZIG_ROUTE_REPAIR_MIN_MS         10000   /* Shortest pause between two route requests sent after failures */
+#define ZIG_ROUTE_ADDRS                 16      /* Destinations with their own failure count */
+
+/**
+ * @brief Set up concentrator mode, started once the network is up
+ *
+ * Called from init_zigbee_gateway before the stack starts.
+ *
+ * @param enabled Act as many-to-one concentrator
+ * @param interval_s Seconds between many-to-one route requests
+ */
+void zig_route_configure(bool enabled, uint32_t interval_s);
+
+/**
+ * @brief Network formed or restored: start the concentrator if configured
+ *
+ * Called from the Zigbee task.
+ */
+void zig_route_start(void);
+
+/**
+ * @brief Count a network status from the NLME status indication
+ *
+ * A many-to-one or source route failure sends a new route request right away,
+ * at most once per ZIG_ROUTE_REPAIR_MIN_MS. Called from the Zigbee task.
+ *
+ * @param status ZB_NWK_COMMAND_STATUS_*
+ * @param short_addr Destination the status is about
+ */
+void zig_route_status(uint8_t status, uint16_t short_addr);
+
+// Python API function objects
+extern const mp_obj_fun_builtin_var_t esp32_zig_route_stats_obj;     // Concentrator state and route failure counts
+
+#endif // MOD_ZIG_ROUTE_H
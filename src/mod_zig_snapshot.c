@@ -0,0 +1,424 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Whole-network snapshot export and import
+#include <string.h>
+#include <stdio.h>
+#include "py/runtime.h"
+#include "py/obj.h"
+#include "py/stream.h"
+#include "esp_log.h"
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#include "main.h"
+#include "mod_zig_snapshot.h"
+#include "device_manager.h"
+#include "device_storage.h"
+#include "device_json.h"
+
+#define LOG_TAG "MOD_ZIG_SNAPSHOT"
+
+#define SNAPSHOT_HEADER_LEN         8
+#define SNAPSHOT_ENTRY_LEN          12
+#define SNAPSHOT_PREAMBLE_LEN(n)    (SNAPSHOT_HEADER_LEN + (n) * SNAPSHOT_ENTRY_LEN + 4)
+
+typedef struct {
+    uint16_t type;
+    uint16_t flags;
+    uint32_t length;
+    uint32_t crc;
+    const uint8_t *data;
+} snapshot_section_t;
+
+extern mp_obj_t global_esp32_zig_obj_ptr;
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, v & 0xffff);
+    put_u16(p + 2, v >> 16);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static const esp_partition_t *zb_storage_partition(void) {
+    return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_FAT, "zb_storage");
+}
+
+// Stack is running once the gateway task exists; zb_storage must not change under it
+static bool zb_stack_running(void) {
+    esp32_zig_obj_t *self = (esp32_zig_obj_t *)MP_OBJ_TO_PTR(global_esp32_zig_obj_ptr);
+    return self && self->gateway_task != NULL;
+}
+
+// The registry is shared with the Zigbee task once the stack has started
+static bool snapshot_lock(void) {
+    bool locked = esp_zb_is_started();
+    if (locked) {
+        ZB_LOCK();
+    }
+    return locked;
+}
+
+static void snapshot_unlock(bool locked) {
+    if (locked) {
+        ZB_UNLOCK();
+    }
+}
+
+static void snapshot_emit(mp_obj_t stream, vstr_t *out, const void *data, size_t len) {
+    if (stream == mp_const_none) {
+        vstr_add_strn(out, data, len);
+        return;
+    }
+    int errcode;
+    if (mp_stream_write_exactly(stream, data, len, &errcode) != len) {
+        mp_raise_OSError(errcode);
+    }
+}
+
+// export_snapshot(stream=None, zb_storage=False) -> bytes | int
+static mp_obj_t esp32_zig_export_snapshot(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_stream, ARG_zb_storage };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_stream,       MP_ARG_OBJ,                     {.u_obj = mp_const_none} },
+        { MP_QSTR_zb_storage,   MP_ARG_KW_ONLY | MP_ARG_BOOL,   {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_obj_t stream = args[ARG_stream].u_obj;
+    if (stream != mp_const_none) {
+        mp_get_stream_raise(stream, MP_STREAM_OP_WRITE);
+    }
+
+    snapshot_section_t sections[SNAPSHOT_MAX_SECTIONS];
+    size_t n_sections = 0;
+
+    // Details are loaded through storage_cb, before the lock is taken
+    size_t count;
+    const zigbee_device_t *devices = device_manager_get_list(&count);
+    uint16_t pending[MAX_DEVICES];
+    size_t n_pending = 0;
+    bool locked = snapshot_lock();
+    for (size_t i = 0; i < count; i++) {
+        if (devices[i].detail_pending) {
+            pending[n_pending++] = devices[i].short_addr;
+        }
+    }
+    snapshot_unlock(locked);
+    for (size_t i = 0; i < n_pending; i++) {
+        device_storage_ensure_detail(pending[i]);
+    }
+
+    // Devices: one JSON record per line, report configs are part of the record.
+    // Volatile state is taken at the same moment as the records.
+    vstr_t devs;
+    vstr_t vol;
+    vstr_init(&devs, 256);
+    nlr_buf_t nlr;
+    locked = snapshot_lock();
+    if (nlr_push(&nlr) == 0) {
+        devices = device_manager_get_list(&count);
+        for (size_t i = 0; i < count; i++) {
+            size_t n = device_to_json(&devices[i], NULL, 0);
+            if (n == 0) {
+                ESP_LOGW(LOG_TAG, "Device 0x%04x skipped, serialization failed", devices[i].short_addr);
+                continue;
+            }
+            char *p = vstr_add_len(&devs, n + 1);
+            device_to_json(&devices[i], p, n + 1);
+            p[n] = '\n';
+        }
+        size_t cap = device_storage_volatile_size();
+        vstr_init_len(&vol, cap);
+        vol.len = device_storage_volatile_write(vol.buf, cap + 1);
+        nlr_pop();
+        snapshot_unlock(locked);
+    } else {
+        snapshot_unlock(locked);
+        nlr_jump(nlr.ret_val);
+    }
+    sections[n_sections++] = (snapshot_section_t){
+        .type = SNAPSHOT_SECTION_DEVICES, .length = devs.len, .data = (const uint8_t *)devs.buf
+    };
+    sections[n_sections++] = (snapshot_section_t){
+        .type = SNAPSHOT_SECTION_VOLATILE, .length = vol.len, .data = (const uint8_t *)vol.buf
+    };
+
+    // Coordinator NVRAM: network key, PAN, neighbor tables
+    vstr_t zbs;
+    vstr_init(&zbs, 0);
+    if (args[ARG_zb_storage].u_bool) {
+        const esp_partition_t *part = zb_storage_partition();
+        if (!part) {
+            mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("zb_storage partition not found"));
+        }
+        vstr_init_len(&zbs, part->size);
+
+        bool running = zb_stack_running();
+        if (running) {
+            ZB_LOCK();
+        }
+        esp_err_t err = esp_partition_read(part, 0, zbs.buf, part->size);
+        if (running) {
+            ZB_UNLOCK();
+        }
+        if (err != ESP_OK) {
+            mp_raise_msg_varg(&mp_type_RuntimeError, MP_ERROR_TEXT("zb_storage read failed: %s"), esp_err_to_name(err));
+        }
+        sections[n_sections++] = (snapshot_section_t){
+            .type = SNAPSHOT_SECTION_ZB_STORAGE, .length = zbs.len, .data = (const uint8_t *)zbs.buf
+        };
+    }
+
+    // Header and manifest
+    uint8_t preamble[SNAPSHOT_PREAMBLE_LEN(SNAPSHOT_MAX_SECTIONS)];
+    memcpy(preamble, SNAPSHOT_MAGIC, 4);
+    put_u16(preamble + 4, SNAPSHOT_VERSION);
+    put_u16(preamble + 6, n_sections);
+    size_t total = SNAPSHOT_PREAMBLE_LEN(n_sections);
+    for (size_t i = 0; i < n_sections; i++) {
+        uint8_t *e = preamble + SNAPSHOT_HEADER_LEN + i * SNAPSHOT_ENTRY_LEN;
+        sections[i].crc = esp_rom_crc32_le(0, sections[i].data, sections[i].length);
+        put_u16(e, sections[i].type);
+        put_u16(e + 2, sections[i].flags);
+        put_u32(e + 4, sections[i].length);
+        put_u32(e + 8, sections[i].crc);
+        total += sections[i].length;
+    }
+    size_t manifest_len = SNAPSHOT_PREAMBLE_LEN(n_sections) - 4;
+    put_u32(preamble + manifest_len, esp_rom_crc32_le(0, preamble, manifest_len));
+
+    vstr_t out;
+    vstr_init(&out, stream == mp_const_none ? total : 0);
+    snapshot_emit(stream, &out, preamble, SNAPSHOT_PREAMBLE_LEN(n_sections));
+    for (size_t i = 0; i < n_sections; i++) {
+        snapshot_emit(stream, &out, sections[i].data, sections[i].length);
+    }
+
+    vstr_clear(&devs);
+    vstr_clear(&vol);
+    vstr_clear(&zbs);
+
+    ESP_LOGI(LOG_TAG, "Snapshot exported: %u devices, %u sections, %u bytes",
+             (unsigned)count, (unsigned)n_sections, (unsigned)total);
+
+    if (stream != mp_const_none) {
+        vstr_clear(&out);
+        return mp_obj_new_int_from_uint(total);
+    }
+    return mp_obj_new_bytes_from_vstr(&out);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_export_snapshot_obj, 1, esp32_zig_export_snapshot);
+
+// Verify header, manifest and every section checksum; nothing is applied on failure
+static size_t snapshot_parse(const uint8_t *buf, size_t len, snapshot_section_t *sections) {
+    if (len < SNAPSHOT_PREAMBLE_LEN(0) || memcmp(buf, SNAPSHOT_MAGIC, 4) != 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("not a snapshot"));
+    }
+    if (get_u16(buf + 4) != SNAPSHOT_VERSION) {
+        mp_raise_ValueError(MP_ERROR_TEXT("unsupported snapshot version"));
+    }
+    size_t n_sections = get_u16(buf + 6);
+    if (n_sections > SNAPSHOT_MAX_SECTIONS || len < SNAPSHOT_PREAMBLE_LEN(n_sections)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("snapshot manifest truncated"));
+    }
+
+    size_t manifest_len = SNAPSHOT_PREAMBLE_LEN(n_sections) - 4;
+    if (get_u32(buf + manifest_len) != esp_rom_crc32_le(0, buf, manifest_len)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("snapshot manifest checksum mismatch"));
+    }
+
+    size_t offset = SNAPSHOT_PREAMBLE_LEN(n_sections);
+    for (size_t i = 0; i < n_sections; i++) {
+        const uint8_t *e = buf + SNAPSHOT_HEADER_LEN + i * SNAPSHOT_ENTRY_LEN;
+        sections[i].type = get_u16(e);
+        sections[i].flags = get_u16(e + 2);
+        sections[i].length = get_u32(e + 4);
+        sections[i].crc = get_u32(e + 8);
+        if (sections[i].length > len - offset) {
+            mp_raise_ValueError(MP_ERROR_TEXT("snapshot section truncated"));
+        }
+        sections[i].data = buf + offset;
+        if (esp_rom_crc32_le(0, sections[i].data, sections[i].length) != sections[i].crc) {
+            mp_raise_msg_varg(&mp_type_ValueError, MP_ERROR_TEXT("snapshot section %u checksum mismatch"), sections[i].type);
+        }
+        offset += sections[i].length;
+    }
+    return n_sections;
+}
+
+static const snapshot_section_t *snapshot_find(const snapshot_section_t *sections, size_t n, uint16_t type) {
+    for (size_t i = 0; i < n; i++) {
+        if (sections[i].type == type) {
+            return &sections[i];
+        }
+    }
+    return NULL;
+}
+
+// Walk device records; with apply=false only validates and counts them
+static size_t snapshot_devices(const snapshot_section_t *sec, bool apply, uint32_t gen) {
+    zigbee_device_t record;
+    size_t n = 0;
+    const char *line = (const char *)sec->data;
+    const char *end = line + sec->length;
+
+    while (line < end) {
+        const char *eol = memchr(line, '\n', end - line);
+        if (!eol) {
+            eol = end;
+        }
+        if (eol > line) {
+            memset(&record, 0, sizeof(record));
+            if (device_from_json(line, eol - line, &record) != ESP_OK) {
+                mp_raise_msg_varg(&mp_type_ValueError, MP_ERROR_TEXT("snapshot device record %u invalid"), (unsigned)n);
+            }
+            if (apply) {
+                record.storage_gen = gen;
+                if (device_manager_restore(&record) != ESP_OK) {
+                    mp_raise_msg_varg(&mp_type_RuntimeError, MP_ERROR_TEXT("Failed to restore device 0x%04x"), record.short_addr);
+                }
+            }
+            n++;
+        }
+        line = eol + 1;
+    }
+    return n;
+}
+
+// import_snapshot(src, zb_storage=True) -> dict
+static mp_obj_t esp32_zig_import_snapshot(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_src, ARG_zb_storage };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_src,          MP_ARG_REQUIRED | MP_ARG_OBJ,   {.u_obj = mp_const_none} },
+        { MP_QSTR_zb_storage,   MP_ARG_KW_ONLY | MP_ARG_BOOL,   {.u_bool = true} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+
+    // Buffer as is, anything else is read as a stream in one go
+    mp_obj_t src = args[ARG_src].u_obj;
+    mp_buffer_info_t bufinfo;
+    if (!mp_get_buffer(src, &bufinfo, MP_BUFFER_READ)) {
+        mp_obj_t dest[2];
+        mp_load_method(src, MP_QSTR_read, dest);
+        src = mp_call_method_n_kw(0, 0, dest);
+        mp_get_buffer_raise(src, &bufinfo, MP_BUFFER_READ);
+    }
+
+    snapshot_section_t sections[SNAPSHOT_MAX_SECTIONS];
+    size_t n_sections = snapshot_parse(bufinfo.buf, bufinfo.len, sections);
+
+    const snapshot_section_t *devs = snapshot_find(sections, n_sections, SNAPSHOT_SECTION_DEVICES);
+    const snapshot_section_t *vol = snapshot_find(sections, n_sections, SNAPSHOT_SECTION_VOLATILE);
+    const snapshot_section_t *zbs = snapshot_find(sections, n_sections, SNAPSHOT_SECTION_ZB_STORAGE);
+    if (!devs) {
+        mp_raise_ValueError(MP_ERROR_TEXT("snapshot has no device section"));
+    }
+    if (snapshot_devices(devs, false, 0) > MAX_DEVICES) {
+        mp_raise_ValueError(MP_ERROR_TEXT("snapshot has too many devices"));
+    }
+
+    const esp_partition_t *part = NULL;
+    bool restore_zbs = zbs && args[ARG_zb_storage].u_bool;
+    if (restore_zbs) {
+        part = zb_storage_partition();
+        if (!part || part->size != zbs->length) {
+            mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("zb_storage partition missing or size differs"));
+        }
+        if (zb_stack_running()) {
+            ESP_LOGW(LOG_TAG, "Stack running, zb_storage not restored; use init(start=False) first");
+            restore_zbs = false;
+        }
+    }
+
+    bool persist = self->storage_cb && self->storage_cb != mp_const_none;
+
+    // Replace the registry: drop current devices, new records get a generation
+    // above anything on disk so stale files cannot win at the next load
+    size_t count;
+    zigbee_device_t *current = device_manager_get_list(&count);
+    uint16_t addrs[MAX_DEVICES];
+    size_t n_addrs = 0;
+    uint32_t gen = 0;
+    bool locked = snapshot_lock();
+    for (size_t i = 0; i < count; i++) {
+        if (current[i].storage_gen > gen) {
+            gen = current[i].storage_gen;
+        }
+        addrs[n_addrs++] = current[i].short_addr;
+    }
+    snapshot_unlock(locked);
+
+    // Files go through storage_cb, which never runs under the lock
+    if (persist) {
+        for (size_t i = 0; i < n_addrs; i++) {
+            device_storage_remove_now(addrs[i]);
+        }
+    }
+
+    size_t restored = 0;
+    size_t applied = 0;
+    nlr_buf_t nlr;
+    locked = snapshot_lock();
+    if (nlr_push(&nlr) == 0) {
+        for (size_t i = 0; i < n_addrs; i++) {
+            device_manager_remove(addrs[i]);
+        }
+        restored = snapshot_devices(devs, true, gen);
+        if (vol) {
+            applied = device_storage_volatile_apply((const char *)vol->data, vol->length);
+        }
+        current = device_manager_get_list(&count);
+        n_addrs = 0;
+        for (size_t i = 0; i < count; i++) {
+            addrs[n_addrs++] = current[i].short_addr;
+        }
+        nlr_pop();
+        snapshot_unlock(locked);
+    } else {
+        snapshot_unlock(locked);
+        nlr_jump(nlr.ret_val);
+    }
+
+    if (persist) {
+        for (size_t i = 0; i < n_addrs; i++) {
+            device_storage_save_now(addrs[i]);
+        }
+        device_storage_flush_volatile();
+    }
+
+    if (restore_zbs) {
+        esp_err_t err = esp_partition_erase_range(part, 0, part->size);
+        if (err == ESP_OK) {
+            err = esp_partition_write(part, 0, zbs->data, zbs->length);
+        }
+        if (err != ESP_OK) {
+            mp_raise_msg_varg(&mp_type_RuntimeError, MP_ERROR_TEXT("zb_storage write failed: %s"), esp_err_to_name(err));
+        }
+    }
+
+    ESP_LOGI(LOG_TAG, "Snapshot imported: %u devices, volatile %u, zb_storage %d",
+             (unsigned)restored, (unsigned)applied, restore_zbs);
+
+    mp_obj_t dict = mp_obj_new_dict(4);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_devices), mp_obj_new_int_from_uint(restored));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_volatile), mp_obj_new_int_from_uint(applied));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_zb_storage), mp_obj_new_bool(restore_zbs));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_persisted), mp_obj_new_bool(persist));
+    return dict;
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_import_snapshot_obj, 2, esp32_zig_import_snapshot);
@@ -0,0 +1,30 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Whole-network snapshot: device registry, volatile state and zb_storage in one blob
+#ifndef MOD_ZIG_SNAPSHOT_H
+#define MOD_ZIG_SNAPSHOT_H
+
+#include "mod_zig_types.h"
+#include "esp_err.h"
+#include "py/obj.h"
+#include "py/runtime.h"
+
+// Blob layout (little endian):
+//   "ZSNP" u16 version u16 section_count
+//   section_count x { u16 type, u16 flags, u32 length, u32 crc32 }
+//   u32 crc32 of everything above
+//   section payloads in manifest order
+#define SNAPSHOT_MAGIC          "ZSNP"
+#define SNAPSHOT_VERSION        1
+#define SNAPSHOT_MAX_SECTIONS   8
+
+typedef enum {
+    SNAPSHOT_SECTION_DEVICES    = 1,   // Device JSON records (incl. report configs), one per line
+    SNAPSHOT_SECTION_VOLATILE   = 2,   // Volatile state body, same text as volatile.dat
+    SNAPSHOT_SECTION_ZB_STORAGE = 3,   // Raw copy of the zb_storage partition
+} snapshot_section_type_t;
+
+// Python API function objects
+extern const mp_obj_fun_builtin_var_t esp32_zig_export_snapshot_obj;       // Export snapshot to bytes or stream
+extern const mp_obj_fun_builtin_var_t esp32_zig_import_snapshot_obj;       // Import snapshot from buffer or stream
+
+#endif // MOD_ZIG_SNAPSHOT_H
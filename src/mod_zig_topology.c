@@ -0,0 +1,464 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Background mesh crawler: neighbour and routing tables of every router
+//
+// Starting at the gateway, each router's neighbour table is read page by page
+// with Mgmt_Lqi_req, then its routing table with Mgmt_Rtg_req. Routers found
+// in a neighbour table are queued and visited in turn. Only one request is in
+// flight and requests are spaced by the crawl interval, so the crawl never
+// competes with device traffic. The link quality a router or the gateway sees
+// for a known device goes into its registry entry.
+// Everything here runs in the Zigbee task, or in MicroPython under ZB_LOCK.
+#include <string.h>
+
+// ESP-IDF headers
+#include "esp_log.h"
+#include "esp_timer.h"
+
+// Zigbee headers
+#include "esp_zigbee_core.h"
+#include "zdo/esp_zigbee_zdo_command.h"
+
+// MicroPython headers
+#include "py/obj.h"
+#include "py/runtime.h"
+
+//Project headers
+#include "main.h"
+#include "device_manager.h"
+#include "device_storage.h"
+#include "mod_zig_handlers.h"
+#include "mod_zig_msg.h"
+#include "mod_zig_topology.h"
+
+#define LOG_TAG "ZIG_TOPOLOGY"
+
+// Neighbour table device types
+#define TOPOLOGY_TYPE_COORDINATOR   0
+#define TOPOLOGY_TYPE_ROUTER        1
+
+// One neighbour table entry of a router
+typedef struct {
+    uint16_t src;               /* Router that reported it */
+    uint16_t dst;               /* Neighbour */
+    uint8_t lqi;
+    uint8_t depth;              /* Neighbour's depth in the tree */
+    uint8_t relationship;       /* ZIG_TOPOLOGY_* */
+    uint8_t device_type;        /* 0 coordinator, 1 router, 2 end device, 3 unknown */
+} topology_link_t;
+
+// One routing table entry of a router
+typedef struct {
+    uint16_t router;
+    uint16_t dst;
+    uint16_t next_hop;
+    uint8_t status;             /* 0 active, 1 discovery underway, 2 discovery failed, 3 inactive */
+} topology_route_t;
+
+typedef enum {
+    TOPOLOGY_IDLE,
+    TOPOLOGY_LQI,               /* Reading the neighbour table of the current router */
+    TOPOLOGY_RTG,               /* Reading its routing table */
+} topology_phase_t;
+
+static struct {
+    topology_phase_t phase;
+    uint16_t nodes[ZIG_TOPOLOGY_NODES];     /* Routers in visit order */
+    bool failed[ZIG_TOPOLOGY_NODES];        /* Router did not answer */
+    uint8_t node_count;
+    uint8_t node;                           /* Router being read */
+    uint8_t start_index;                    /* Next page */
+    uint8_t seq;                            /* Request in flight, late answers are dropped */
+    uint8_t round;                          /* Periodic restart that is still wanted */
+    uint16_t interval_ms;
+    uint32_t period_ms;                     /* Restart after a finished crawl, 0 once only */
+    bool routes;                            /* Read routing tables too */
+    uint16_t dropped;                       /* Entries lost to full tables */
+    uint32_t started_ms;
+    uint32_t finished_ms;                   /* End of the last complete crawl, 0 if none */
+} crawl;
+
+// Map of the last complete crawl, what topology() returns
+static topology_link_t topology_links[ZIG_TOPOLOGY_LINKS];
+static uint16_t topology_link_count;
+static topology_route_t topology_routes[ZIG_TOPOLOGY_ROUTES];
+static uint16_t topology_route_count;
+static uint16_t topology_failed[ZIG_TOPOLOGY_NODES];
+static uint8_t topology_failed_count;
+
+// Crawl in progress, published by topology_finish()
+static topology_link_t crawl_links[ZIG_TOPOLOGY_LINKS];
+static uint16_t crawl_link_count;
+static topology_route_t crawl_routes[ZIG_TOPOLOGY_ROUTES];
+static uint16_t crawl_route_count;
+
+static void topology_send(void);
+static void topology_step_cb(uint8_t seq);
+static void topology_timeout_cb(uint8_t seq);
+
+
+static uint32_t topology_now_ms(void) {
+    return esp_timer_get_time() / 1000;
+}
+
+static void topology_begin(void) {
+    crawl_link_count = 0;
+    crawl_route_count = 0;
+    memset(crawl.failed, 0, sizeof(crawl.failed));
+    crawl.nodes[0] = 0x0000;
+    crawl.node_count = 1;
+    crawl.node = 0;
+    crawl.start_index = 0;
+    crawl.dropped = 0;
+    crawl.phase = TOPOLOGY_LQI;
+    crawl.started_ms = topology_now_ms();
+    ESP_LOGI(LOG_TAG, "Crawl started, interval %u ms", crawl.interval_ms);
+    topology_send();
+}
+
+static void topology_restart_cb(uint8_t round) {
+    if (round == crawl.round && crawl.phase == TOPOLOGY_IDLE && crawl.period_ms) {
+        topology_begin();
+    }
+}
+
+// Crawl done: routers(1) + failed(1) + links(2) + routes(2) + ms(4), little endian
+static void topology_finish(void) {
+    crawl.phase = TOPOLOGY_IDLE;
+    crawl.finished_ms = topology_now_ms();
+    uint32_t took_ms = crawl.finished_ms - crawl.started_ms;
+
+    // Publish the whole map at once, readers never see a crawl half done
+    memcpy(topology_links, crawl_links, sizeof(topology_link_t) * crawl_link_count);
+    topology_link_count = crawl_link_count;
+    memcpy(topology_routes, crawl_routes, sizeof(topology_route_t) * crawl_route_count);
+    topology_route_count = crawl_route_count;
+    uint8_t failed = 0;
+    for (int i = 0; i < crawl.node_count; i++) {
+        if (crawl.failed[i]) {
+            topology_failed[failed++] = crawl.nodes[i];
+        }
+    }
+    topology_failed_count = failed;
+    ESP_LOGI(LOG_TAG, "Crawl finished: %u routers (%u failed), %u links, %u routes in %lu ms",
+             crawl.node_count, failed, topology_link_count, topology_route_count, (unsigned long)took_ms);
+    if (crawl.dropped) {
+        ESP_LOGW(LOG_TAG, "Tables full, %u entries not recorded", crawl.dropped);
+    }
+
+    uint8_t data[10] = {
+        crawl.node_count, failed,
+        topology_link_count & 0xFF, topology_link_count >> 8,
+        topology_route_count & 0xFF, topology_route_count >> 8,
+        took_ms & 0xFF, (took_ms >> 8) & 0xFF, (took_ms >> 16) & 0xFF, took_ms >> 24,
+    };
+    send_msg_to_micropython_queue(ZIG_MSG_TOPOLOGY, 0, 0, 0, 0, data, sizeof(data));
+
+    if (crawl.period_ms) {
+        esp_zb_scheduler_alarm((esp_zb_callback_t)topology_restart_cb, ++crawl.round, crawl.period_ms);
+    }
+}
+
+// Page answered or given up: wait out the interval before the next request
+static void topology_schedule(void) {
+    esp_zb_scheduler_alarm((esp_zb_callback_t)topology_step_cb, crawl.seq, crawl.interval_ms);
+}
+
+static void topology_next_node(void) {
+    crawl.node++;
+    crawl.start_index = 0;
+    crawl.phase = TOPOLOGY_LQI;
+    if (crawl.node >= crawl.node_count) {
+        topology_finish();
+        return;
+    }
+    topology_schedule();
+}
+
+// Answer of the request in flight, false for a late one
+static bool topology_answer(void *user_ctx) {
+    if (crawl.phase == TOPOLOGY_IDLE || (uint8_t)(uintptr_t)user_ctx != crawl.seq) {
+        return false;
+    }
+    esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)topology_timeout_cb, crawl.seq);
+    crawl.seq++;
+    return true;
+}
+
+static void topology_add_node(uint16_t short_addr) {
+    for (int i = 0; i < crawl.node_count; i++) {
+        if (crawl.nodes[i] == short_addr) {
+            return;
+        }
+    }
+    if (crawl.node_count < ZIG_TOPOLOGY_NODES) {
+        crawl.nodes[crawl.node_count++] = short_addr;
+    } else {
+        crawl.dropped++;
+    }
+}
+
+// Zigbee task: one page of a neighbour table
+static void topology_lqi_cb(const esp_zb_zdo_mgmt_lqi_rsp_t *rsp, void *user_ctx) {
+    if (!topology_answer(user_ctx)) {
+        return;
+    }
+    uint16_t router = crawl.nodes[crawl.node];
+    if (rsp->status != ESP_ZB_ZDP_STATUS_SUCCESS) {
+        ESP_LOGW(LOG_TAG, "Neighbour table of 0x%04x not read, status=%d", router, rsp->status);
+        crawl.failed[crawl.node] = true;
+        topology_next_node();
+        return;
+    }
+
+    for (int i = 0; i < rsp->neighbor_table_list_count; i++) {
+        const esp_zb_zdo_neighbor_table_list_record_t *rec = &rsp->neighbor_table_list[i];
+        if (crawl_link_count < ZIG_TOPOLOGY_LINKS) {
+            crawl_links[crawl_link_count++] = (topology_link_t){
+                .src          = router,
+                .dst          = rec->network_addr,
+                .lqi          = rec->lqi,
+                .depth        = rec->depth,
+                .relationship = rec->relationship,
+                .device_type  = rec->device_type,
+            };
+        } else {
+            crawl.dropped++;
+        }
+        if (rec->device_type == TOPOLOGY_TYPE_ROUTER || rec->device_type == TOPOLOGY_TYPE_COORDINATOR) {
+            topology_add_node(rec->network_addr);
+        }
+
+        // The parent's and the gateway's view of a device is its link quality
+        if (router == 0x0000 || rec->relationship == ZIG_TOPOLOGY_CHILD) {
+            zigbee_device_t *device = device_manager_get(rec->network_addr);
+            if (device && device->last_lqi != rec->lqi) {
+                device->last_lqi = rec->lqi;
+                device_storage_mark_volatile(rec->network_addr);
+            }
+        }
+    }
+
+    uint16_t next = rsp->start_index + rsp->neighbor_table_list_count;
+    if (rsp->neighbor_table_list_count > 0 && next < rsp->neighbor_table_entries) {
+        crawl.start_index = next;
+        topology_schedule();
+    } else if (crawl.routes) {
+        crawl.start_index = 0;
+        crawl.phase = TOPOLOGY_RTG;
+        topology_schedule();
+    } else {
+        topology_next_node();
+    }
+}
+
+// Zigbee task: one page of a routing table
+static void topology_rtg_cb(const esp_zb_zdo_mgmt_rtg_rsp_t *rsp, void *user_ctx) {
+    if (!topology_answer(user_ctx)) {
+        return;
+    }
+    uint16_t router = crawl.nodes[crawl.node];
+    if (rsp->status != ESP_ZB_ZDP_STATUS_SUCCESS) {
+        // Routers may not support Mgmt_Rtg, the neighbour table still counts
+        ESP_LOGD(LOG_TAG, "Routing table of 0x%04x not read, status=%d", router, rsp->status);
+        topology_next_node();
+        return;
+    }
+
+    for (int i = 0; i < rsp->routing_table_list_count; i++) {
+        const esp_zb_zdo_routing_table_record_t *rec = &rsp->routing_table_list[i];
+        if (crawl_route_count < ZIG_TOPOLOGY_ROUTES) {
+            crawl_routes[crawl_route_count++] = (topology_route_t){
+                .router   = router,
+                .dst      = rec->dest_addr,
+                .next_hop = rec->next_hop_addr,
+                .status   = rec->status,
+            };
+        } else {
+            crawl.dropped++;
+        }
+    }
+
+    uint16_t next = rsp->start_index + rsp->routing_table_list_count;
+    if (rsp->routing_table_list_count > 0 && next < rsp->routing_table_entries) {
+        crawl.start_index = next;
+        topology_schedule();
+    } else {
+        topology_next_node();
+    }
+}
+
+// Zigbee task: page never came, skip the rest of this router
+static void topology_timeout_cb(uint8_t seq) {
+    if (crawl.phase == TOPOLOGY_IDLE || seq != crawl.seq) {
+        return;
+    }
+    ESP_LOGW(LOG_TAG, "No answer from 0x%04x", crawl.nodes[crawl.node]);
+    crawl.seq++;
+    if (crawl.phase == TOPOLOGY_LQI) {
+        crawl.failed[crawl.node] = true;
+    }
+    topology_next_node();
+}
+
+static void topology_step_cb(uint8_t seq) {
+    if (crawl.phase != TOPOLOGY_IDLE && seq == crawl.seq) {
+        topology_send();
+    }
+}
+
+static void topology_send(void) {
+    uint16_t router = crawl.nodes[crawl.node];
+    void *ctx = (void *)(uintptr_t)crawl.seq;
+    if (crawl.phase == TOPOLOGY_LQI) {
+        esp_zb_zdo_mgmt_lqi_req_param_t req = {
+            .start_index = crawl.start_index,
+            .dst_addr    = router,
+        };
+        esp_zb_zdo_mgmt_lqi_req(&req, topology_lqi_cb, ctx);
+    } else {
+        esp_zb_zdo_mgmt_rtg_req_param_t req = {
+            .start_index = crawl.start_index,
+            .dst_addr    = router,
+        };
+        esp_zb_zdo_mgmt_rtg_req(&req, topology_rtg_cb, ctx);
+    }
+    esp_zb_scheduler_alarm((esp_zb_callback_t)topology_timeout_cb, crawl.seq, ZIG_TOPOLOGY_TIMEOUT_MS);
+}
+
+void zig_topology_reset(void) {
+    if (crawl.phase != TOPOLOGY_IDLE) {
+        esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)topology_timeout_cb, crawl.seq);
+    }
+    crawl.phase = TOPOLOGY_IDLE;
+    crawl.seq++;
+    crawl.round++;
+    crawl.period_ms = 0;
+    crawl.finished_ms = 0;
+    crawl_link_count = 0;
+    crawl_route_count = 0;
+    topology_link_count = 0;
+    topology_route_count = 0;
+    topology_failed_count = 0;
+}
+
+
+// crawl_topology(interval=1000, *, routes=True, period=0, stop=False)
+// Start the crawl, False if one is running; MSG.TOPOLOGY follows each crawl
+static mp_obj_t esp32_zig_crawl_topology(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_interval, ARG_routes, ARG_period, ARG_stop };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_interval, MP_ARG_INT,                   {.u_int = ZIG_TOPOLOGY_INTERVAL_MS} },
+        { MP_QSTR_routes,   MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = true} },
+        { MP_QSTR_period,   MP_ARG_KW_ONLY | MP_ARG_INT,  {.u_int = 0} },
+        { MP_QSTR_stop,     MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+
+    esp32_zig_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_stop].u_bool) {
+        // Stop: the map of the last complete crawl stays
+        ZB_LOCK();
+        bool running = crawl.phase != TOPOLOGY_IDLE || crawl.period_ms;
+        if (crawl.phase != TOPOLOGY_IDLE) {
+            esp_zb_scheduler_alarm_cancel((esp_zb_callback_t)topology_timeout_cb, crawl.seq);
+        }
+        crawl.phase = TOPOLOGY_IDLE;
+        crawl.seq++;
+        crawl.round++;
+        crawl.period_ms = 0;
+        ZB_UNLOCK();
+        return mp_obj_new_bool(running);
+    }
+
+    if (!self->config->network_formed) {
+        mp_raise_msg(&mp_type_RuntimeError, "Network is not formed");
+    }
+    if (args[ARG_interval].u_int < 100 || args[ARG_interval].u_int > 60000) {
+        mp_raise_ValueError("interval must be 100-60000 ms");
+    }
+    if (args[ARG_period].u_int < 0 || args[ARG_period].u_int > 86400) {
+        mp_raise_ValueError("period must be 0-86400 s");
+    }
+
+    ZB_LOCK();
+    bool start = crawl.phase == TOPOLOGY_IDLE;
+    if (start) {
+        crawl.interval_ms = args[ARG_interval].u_int;
+        crawl.routes = args[ARG_routes].u_bool;
+        crawl.period_ms = (uint32_t)args[ARG_period].u_int * 1000;
+        crawl.round++;
+        topology_begin();
+    }
+    ZB_UNLOCK();
+
+    return mp_obj_new_bool(start);
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(esp32_zig_crawl_topology_obj, 1, esp32_zig_crawl_topology);
+
+
+// topology()
+// Map of the last complete crawl, a running one replaces it when it finishes
+// {"links": [(src, dst, lqi, depth, relationship, device_type)], "routes": [(router, dst, next_hop, status)],
+//  "failed": [addr], "running": bool, "age": ms since the last complete crawl or None}
+static mp_obj_t esp32_zig_topology(mp_obj_t self_in) {
+    (void)self_in;
+
+    // Copy under the lock, build objects without it
+    topology_link_t *links = m_new(topology_link_t, ZIG_TOPOLOGY_LINKS);
+    topology_route_t *routes = m_new(topology_route_t, ZIG_TOPOLOGY_ROUTES);
+    uint16_t failed[ZIG_TOPOLOGY_NODES];
+    ZB_LOCK();
+    uint16_t link_count = topology_link_count;
+    uint16_t route_count = topology_route_count;
+    uint8_t failed_count = topology_failed_count;
+    memcpy(links, topology_links, sizeof(topology_link_t) * link_count);
+    memcpy(routes, topology_routes, sizeof(topology_route_t) * route_count);
+    memcpy(failed, topology_failed, sizeof(uint16_t) * failed_count);
+    bool running = crawl.phase != TOPOLOGY_IDLE;
+    uint32_t finished_ms = crawl.finished_ms;
+    ZB_UNLOCK();
+
+    mp_obj_t link_list = mp_obj_new_list(0, NULL);
+    for (int i = 0; i < link_count; i++) {
+        topology_link_t *l = &links[i];
+        mp_obj_t item[6] = {
+            MP_OBJ_NEW_SMALL_INT(l->src),
+            MP_OBJ_NEW_SMALL_INT(l->dst),
+            MP_OBJ_NEW_SMALL_INT(l->lqi),
+            MP_OBJ_NEW_SMALL_INT(l->depth),
+            MP_OBJ_NEW_SMALL_INT(l->relationship),
+            MP_OBJ_NEW_SMALL_INT(l->device_type),
+        };
+        mp_obj_list_append(link_list, mp_obj_new_tuple(6, item));
+    }
+    mp_obj_t route_list = mp_obj_new_list(0, NULL);
+    for (int i = 0; i < route_count; i++) {
+        topology_route_t *r = &routes[i];
+        mp_obj_t item[4] = {
+            MP_OBJ_NEW_SMALL_INT(r->router),
+            MP_OBJ_NEW_SMALL_INT(r->dst),
+            MP_OBJ_NEW_SMALL_INT(r->next_hop),
+            MP_OBJ_NEW_SMALL_INT(r->status),
+        };
+        mp_obj_list_append(route_list, mp_obj_new_tuple(4, item));
+    }
+    mp_obj_t failed_list = mp_obj_new_list(0, NULL);
+    for (int i = 0; i < failed_count; i++) {
+        mp_obj_list_append(failed_list, MP_OBJ_NEW_SMALL_INT(failed[i]));
+    }
+
+    mp_obj_t dict = mp_obj_new_dict(5);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_links), link_list);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_routes), route_list);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_failed), failed_list);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_running), mp_obj_new_bool(running));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_age),
+                      finished_ms ? mp_obj_new_int_from_uint(topology_now_ms() - finished_ms) : mp_const_none);
+
+    m_del(topology_link_t, links, ZIG_TOPOLOGY_LINKS);
+    m_del(topology_route_t, routes, ZIG_TOPOLOGY_ROUTES);
+    return dict;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(esp32_zig_topology_obj, esp32_zig_topology);
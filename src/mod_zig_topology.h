@@ -0,0 +1,32 @@
+// Copyright (c) 2025 Viktor Vorobjov
+// Background mesh crawler: neighbour and routing tables of every router
+#ifndef MOD_ZIG_TOPOLOGY_H
+#define MOD_ZIG_TOPOLOGY_H
+
+#include "py/obj.h"
+
+#define ZIG_TOPOLOGY_NODES          32      /* Routers visited in one crawl, the gateway included */
+#define ZIG_TOPOLOGY_LINKS          256     /* Neighbour table entries, all routers */
+#define ZIG_TOPOLOGY_ROUTES         64      /* Routing table entries, all routers */
+#define ZIG_TOPOLOGY_INTERVAL_MS    1000    /* Default pause between two requests */
+#define ZIG_TOPOLOGY_TIMEOUT_MS     5000    /* Router given up when a page never comes */
+
+// Neighbour relationship in a link, Mgmt_Lqi_rsp encoding
+#define ZIG_TOPOLOGY_PARENT         0
+#define ZIG_TOPOLOGY_CHILD          1
+#define ZIG_TOPOLOGY_SIBLING        2
+#define ZIG_TOPOLOGY_NONE           3
+#define ZIG_TOPOLOGY_PREV_CHILD     4
+
+/**
+ * @brief Stop the crawl and forget the map
+ *
+ * Called when the network is formed again. Zigbee task, or MicroPython with ZB_LOCK held.
+ */
+void zig_topology_reset(void);
+
+// Python API function objects
+extern const mp_obj_fun_builtin_var_t esp32_zig_crawl_topology_obj;  // Start, repeat or stop the crawl
+extern const mp_obj_fun_builtin_fixed_t esp32_zig_topology_obj;      // Snapshot of the last crawl
+
+#endif // MOD_ZIG_TOPOLOGY_H
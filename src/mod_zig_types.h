@@ -20,6 +20,10 @@ typedef struct _esp32_zig_config_t {
     bool network_formed;     // Network formation status
     uint16_t pan_id;         // PAN ID for the network
     uint8_t channel;         // Channel number
+    uint32_t channel_mask;   // Channels allowed for formation and change_channel()
+    bool energy_scan;        // Pick the quietest channel of the mask at formation
+    bool concentrator;       // Many-to-one routing towards the gateway
+    uint32_t discovery_interval; // Seconds between many-to-one route requests
 } esp32_zig_config_t;
 
 // Forward declaration of main structure
@@ -123,6 +127,14 @@ typedef struct {
     uint8_t prod_config_version;                    // Production config version
     uint8_t last_lqi;                               // Link Quality Indicator (0-255)
     int8_t last_rssi;                               // Received Signal Strength Indicator (dBm)
+    uint32_t storage_gen;                           // Generation of the last persisted record
+    uint16_t stored_addr;                           // Short address the stored record is filed under (RAM only)
+    bool volatile_dirty;                            // Volatile fields changed since last flush
+    bool detail_pending;                            // Loaded from the index only: endpoints and reports follow
+    bool rx_off_when_idle;                          // Sleepy end device (MAC capability from announcement)
+    bool interview_complete;                        // Interview finished, descriptors and bindings in place
+    uint32_t desc_hash;                             // Endpoint descriptors at the end of the last interview
+    uint32_t bind_hash;                             // Bound (ep, cluster) pairs at the end of the last interview
 } zigbee_device_t;
 
 // Structure for managing a list of Zigbee devices
@@ -138,6 +150,7 @@ typedef struct {
     uint16_t src_addr;      // Source address
     uint8_t endpoint;       // Endpoint
     uint16_t cluster_id;    // Cluster ID
+    int16_t tsn;            // ZCL transaction sequence number, -1 if none
     uint8_t data[256];      // Message data
     uint8_t data_len;       // Data length
 } zigbee_message_t;
@@ -147,6 +160,9 @@ typedef struct {
     uint16_t short_addr;    // Short address of the device
     uint8_t endpoint;       // Endpoint number
     uint16_t cluster_id;    // Cluster ID
+    uint8_t src_ieee[8];    // Source device, key of the binding mirror
+    uint8_t dst_ieee[8];    // Destination device
+    uint8_t dst_endpoint;   // Destination endpoint
 } bind_ctx_t;
 
 #endif // MOD_ZIG_TYPES_H